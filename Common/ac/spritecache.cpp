@@ -29,6 +29,8 @@
 #include "gfx/bitmap.h"
 #include "util/compress.h"
 #include "util/file.h"
+#include "util/lz4block.h"
+#include "util/memorystream.h"
 #include "util/stream.h"
 
 using namespace AGS::Common;
@@ -44,6 +46,16 @@ extern int spritewidth[], spriteheight[];
 #define END_OF_LIST   -1
 
 const char *spindexid = "SPRINDEX";
+// Sprite index file versions
+enum SpriteIndexVersion
+{
+  kSpridxVersion_Initial    = 1,
+  kSpridxVersion_FileID     = 2,
+  // also has sprite codecs and data sizes, which are not needed because
+  // the sprite headers have them; still accepted, but no longer written
+  kSpridxVersion_Codecs     = 3,
+  kSpridxVersion_Current    = kSpridxVersion_FileID
+};
 const char *spindexfilename = "sprindex.dat";
 
 
@@ -54,6 +66,7 @@ SpriteCache::SpriteCache(int32_t maxElements)
   offsets = NULL;
   sprite0InitialOffset = 0;
   spritesAreCompressed = false;
+  spriteFileVersion = kSprfVersion_Current;
   init();
 }
 
@@ -204,6 +217,13 @@ Bitmap *SpriteCache::operator [] (int index)
   if (offsets[index] == SPRITE_LOCKED)
     return images[index];
 
+  markRecentlyUsed(index);
+  return images[index];
+}
+
+// Move the sprite to the newest end of the MRU list
+void SpriteCache::markRecentlyUsed(int index)
+{
   if (liststart < 0) {
     liststart = index;
     listend = index;
@@ -228,8 +248,6 @@ Bitmap *SpriteCache::operator [] (int index)
     mrubacklink[index] = listend;
     listend = index;
   }
-
-  return images[index];
 }
 
 // Remove the oldest cache element
@@ -338,7 +356,7 @@ void SpriteCache::seekToSprite(int index) {
       cache_stream->Seek(offsets[index], kSeekBegin);
 }
 
-int SpriteCache::loadSprite(int index)
+void SpriteCache::freeUpMem()
 {
   int hh = 0;
 
@@ -351,6 +369,11 @@ int SpriteCache::loadSprite(int index)
     }
 
   }
+}
+
+int SpriteCache::loadSprite(int index)
+{
+  freeUpMem();
 
   if ((index < 0) || (index >= elements))
     quit("sprite cache array index out of bounds");
@@ -358,60 +381,87 @@ int SpriteCache::loadSprite(int index)
   // If we didn't just load the previous sprite, seek to it
   seekToSprite(index);
 
-  int coldep = cache_stream->ReadInt16();
-
-  if (coldep == 0) {
+  bool is_empty;
+  Bitmap *image = readSprite(cache_stream, index, is_empty, compressedBuffer, pixelBuffer);
+  if (is_empty) {
     lastLoad = index;
     return 0;
   }
-
-  int wdd = cache_stream->ReadInt16();
-  int htt = cache_stream->ReadInt16();
-  // update the stored width/height
-  spritewidth[index] = wdd;
-  spriteheight[index] = htt;
-
-  images[index] = BitmapHelper::CreateBitmap(wdd, htt, coldep * 8);
-  if (images[index] == NULL) {
+  if (image == NULL) {
     offsets[index] = 0;
     return 0;
   }
 
-  if (this->spritesAreCompressed) 
+  lastLoad = index;
+  return addLoadedSprite(index, image);
+}
+
+Bitmap *SpriteCache::readSprite(Stream *in, int index, bool &is_empty,
+  std::vector<unsigned char> &data_buf, std::vector<unsigned char> &pixel_buf) const
+{
+  int hh;
+  int coldep = in->ReadInt16();
+
+  is_empty = coldep == 0;
+  if (is_empty)
+    return NULL;
+
+  int wdd = in->ReadInt16();
+  int htt = in->ReadInt16();
+
+  Bitmap *image = BitmapHelper::CreateBitmap(wdd, htt, coldep * 8);
+  if (image == NULL)
+    return NULL;
+
+  int codec = this->spritesAreCompressed ? kSprCodec_RLE : kSprCodec_None;
+  int32_t data_size = 0;
+  if (spriteFileVersion >= kSprfVersion_Codecs) {
+    codec = in->ReadInt8();
+    data_size = in->ReadInt32();
+  }
+  else if (this->spritesAreCompressed) {
+    data_size = in->ReadInt32();
+  }
+
+  if (codec != kSprCodec_None)
   {
-    cache_stream->ReadInt32(); // skip data size
-    if (coldep == 1) {
-      for (hh = 0; hh < htt; hh++)
-        cunpackbitl(&images[index]->GetScanLineForWriting(hh)[0], wdd, cache_stream);
-    }
-    else if (coldep == 2) {
-      for (hh = 0; hh < htt; hh++)
-        cunpackbitl16((unsigned short*)&images[index]->GetScanLine(hh)[0], wdd, cache_stream);
-    }
-    else {
-      for (hh = 0; hh < htt; hh++)
-        cunpackbitl32((unsigned int*)&images[index]->GetScanLine(hh)[0], wdd, cache_stream);
+    // read all of the compressed data at once, and decode it from memory
+    size_t read_size = 0;
+    if (data_size > 0) {
+      if ((size_t)data_size > data_buf.size())
+        data_buf.resize(data_size);
+      read_size = in->Read(&data_buf[0], data_size);
     }
+    if (!unpackSprite(image, codec, read_size > 0 ? &data_buf[0] : NULL, read_size, pixel_buf))
+      Debug::Printf(kDbgGroup_SprCache, kDbgMsg_Error, "Sprite %d: compressed data is corrupt", index);
   }
   else {
     if (coldep == 1)
     {
       for (hh = 0; hh < htt; hh++)
-        cache_stream->ReadArray(&images[index]->GetScanLineForWriting(hh)[0], coldep, wdd);
+        in->ReadArray(&image->GetScanLineForWriting(hh)[0], coldep, wdd);
     }
     else if (coldep == 2)
     {
       for (hh = 0; hh < htt; hh++)
-        cache_stream->ReadArrayOfInt16((int16_t*)&images[index]->GetScanLineForWriting(hh)[0], wdd);
+        in->ReadArrayOfInt16((int16_t*)&image->GetScanLineForWriting(hh)[0], wdd);
     }
     else
     {
       for (hh = 0; hh < htt; hh++)
-        cache_stream->ReadArrayOfInt32((int32_t*)&images[index]->GetScanLineForWriting(hh)[0], wdd);
+        in->ReadArrayOfInt32((int32_t*)&image->GetScanLineForWriting(hh)[0], wdd);
     }
   }
+  return image;
+}
 
-  lastLoad = index;
+int SpriteCache::addLoadedSprite(int index, Bitmap *image)
+{
+  const int coldep = image->GetColorDepth() / 8;
+  images[index] = image;
+  // update the stored width/height
+  spritewidth[index] = image->GetWidth();
+  spriteheight[index] = image->GetHeight();
 
   // Stop it adding the sprite to the used list just because it's loaded
   int32_t offs = offsets[index];
@@ -434,6 +484,28 @@ int SpriteCache::loadSprite(int index)
   return sizes[index];
 }
 
+bool SpriteCache::needsLoading(int index) const
+{
+  return (index >= 0) && (index < elements) && (images[index] == NULL) && (offsets[index] > 0);
+}
+
+bool SpriteCache::addPrefetchedSprite(int index, int32_t offset, Bitmap *image)
+{
+  // the slot could have been loaded, replaced or deleted in the meantime
+  if (!needsLoading(index) || (offsets[index] != offset))
+    return false;
+
+  freeUpMem();
+  addLoadedSprite(index, image);
+  if (offsets[index] != SPRITE_LOCKED)
+    markRecentlyUsed(index);
+
+#ifdef DEBUG_SPRITECACHE
+  Debug::Printf(kDbgGroup_SprCache, kDbgMsg_Debug, "Prefetched %d", index);
+#endif
+  return true;
+}
+
 const char *spriteFileSig = " Sprite File ";
 
 void SpriteCache::compressSprite(Bitmap *sprite, Stream *out) {
@@ -455,6 +527,113 @@ void SpriteCache::compressSprite(Bitmap *sprite, Stream *out) {
 
 }
 
+// Converts pixels between the native and little-endian byte order
+static void SwapPixelBytesLE(unsigned char *pixels, int count, int depth) {
+#if defined (BITBYTE_BIG_ENDIAN)
+  if (depth == 2) {
+    for (int i = 0; i < count; i++)
+      ((int16_t*)pixels)[i] = BBOp::Int16FromLE(((int16_t*)pixels)[i]);
+  }
+  else if (depth == 4) {
+    for (int i = 0; i < count; i++)
+      ((int32_t*)pixels)[i] = BBOp::Int32FromLE(((int32_t*)pixels)[i]);
+  }
+#endif
+}
+
+int SpriteCache::packSprite(Bitmap *sprite, std::vector<unsigned char> &data) {
+  const int depth = sprite->GetColorDepth() / 8;
+  const int width = sprite->GetWidth();
+  const int height = sprite->GetHeight();
+  const size_t line_size = width * depth;
+  const size_t image_size = line_size * height;
+
+  // legacy RLE, which is best for the large areas of single color
+  data.clear();
+  VectorStream rle_out(data);
+  compressSprite(sprite, &rle_out);
+  int codec = kSprCodec_RLE;
+  if (image_size == 0)
+    return codec;
+
+  // gather the pixels in the file byte order, and try LZ4 on them as they are,
+  // and with each pixel made relative to the previous one
+  std::vector<unsigned char> pixels(image_size);
+  for (int y = 0; y < height; y++)
+    memcpy(&pixels[y * line_size], sprite->GetScanLine(y), line_size);
+  SwapPixelBytesLE(&pixels[0], width * height, depth);
+
+  std::vector<unsigned char> packed(lz4block_compress_bound(image_size));
+  const int num_tries = depth > 1 ? 2 : 1;
+  for (int attempt = 0; attempt < num_tries; attempt++) {
+    if (attempt == 1) {
+      for (int y = 0; y < height; y++) {
+        unsigned char *line = &pixels[y * line_size];
+        for (size_t x = line_size - 1; x >= (size_t)depth; x--)
+          line[x] -= line[x - depth];
+      }
+    }
+    size_t packed_size = lz4block_compress(&pixels[0], image_size, &packed[0], packed.size());
+    if (packed_size > 0 && packed_size < data.size()) {
+      data.assign(packed.begin(), packed.begin() + packed_size);
+      codec = attempt == 0 ? kSprCodec_LZ4 : kSprCodec_DeltaLZ4;
+    }
+  }
+  return codec;
+}
+
+bool SpriteCache::unpackSprite(Bitmap *sprite, int codec, const unsigned char *data, size_t data_size,
+                               std::vector<unsigned char> &pixel_buf) const {
+  const int depth = sprite->GetColorDepth() / 8;
+  const int width = sprite->GetWidth();
+  const int height = sprite->GetHeight();
+  const unsigned char *data_end = data + data_size;
+  int hh;
+
+  switch (codec) {
+  case kSprCodec_RLE:
+    {
+      int result = 0;
+      if (depth == 1) {
+        for (hh = 0; hh < height && result == 0; hh++)
+          result = cunpackbitl(&sprite->GetScanLineForWriting(hh)[0], width, data, data_end);
+      }
+      else if (depth == 2) {
+        for (hh = 0; hh < height && result == 0; hh++)
+          result = cunpackbitl16((unsigned short*)&sprite->GetScanLineForWriting(hh)[0], width, data, data_end);
+      }
+      else {
+        for (hh = 0; hh < height && result == 0; hh++)
+          result = cunpackbitl32((unsigned int*)&sprite->GetScanLineForWriting(hh)[0], width, data, data_end);
+      }
+      return result == 0;
+    }
+  case kSprCodec_LZ4:
+  case kSprCodec_DeltaLZ4:
+    {
+      const size_t line_size = width * depth;
+      const size_t image_size = line_size * height;
+      if (pixel_buf.size() < image_size)
+        pixel_buf.resize(image_size);
+      if (image_size == 0 || data == NULL ||
+          lz4block_decompress(data, data_size, &pixel_buf[0], image_size) != (int)image_size)
+        return false;
+      for (hh = 0; hh < height; hh++) {
+        unsigned char *line = &pixel_buf[hh * line_size];
+        if (codec == kSprCodec_DeltaLZ4) {
+          for (size_t x = depth; x < line_size; x++)
+            line[x] += line[x - depth];
+        }
+        SwapPixelBytesLE(line, width, depth);
+        memcpy(&sprite->GetScanLineForWriting(hh)[0], line, line_size);
+      }
+      return true;
+    }
+  default:
+    return false;
+  }
+}
+
 int SpriteCache::saveToFile(const char *filnam, int lastElement, bool compressOutput)
 {
   Stream *output = Common::File::CreateFile(filnam);
@@ -471,8 +650,7 @@ int SpriteCache::saveToFile(const char *filnam, int lastElement, bool compressOu
 
   int spriteFileIDCheck = (int)time(NULL);
 
-  // version 6
-  output->WriteInt16(6);
+  output->WriteInt16(kSprfVersion_Current);
 
   output->WriteArray(spriteFileSig, strlen(spriteFileSig), 1);
 
@@ -496,6 +674,7 @@ int SpriteCache::saveToFile(const char *filnam, int lastElement, bool compressOu
   short *spritewidths = (short*)malloc(numsprits * sizeof(short));
   short *spriteheights = (short*)malloc(numsprits * sizeof(short));
   int32_t *spriteoffs = (int32_t*)malloc(numsprits * sizeof(int32_t));
+  std::vector<unsigned char> packedData;
 
   const int memBufferSize = 100000;
   char *memBuffer = (char*)malloc(memBufferSize);
@@ -504,8 +683,10 @@ int SpriteCache::saveToFile(const char *filnam, int lastElement, bool compressOu
 
     spriteoffs[i] = output->GetPosition();
 
-    // if compressing uncompressed sprites, load the sprite into memory
-    if ((images[i] == NULL) && (this->spritesAreCompressed != compressOutput))
+    // if compressing uncompressed sprites, load the sprite into memory;
+    // also recompress sprites from the older files, which only had RLE
+    if ((images[i] == NULL) && ((this->spritesAreCompressed != compressOutput) ||
+        (compressOutput && spriteFileVersion < kSprfVersion_Codecs)))
       (*this)[i];
 
     if (images[i] != NULL) {
@@ -519,20 +700,16 @@ int SpriteCache::saveToFile(const char *filnam, int lastElement, bool compressOu
       output->WriteInt16(spriteheights[i]);
 
       if (compressOutput) {
-        size_t lenloc = output->GetPosition();
-        // write some space for the length data
-        output->WriteInt32(0);
-
-        compressSprite(images[i], output);
-
-        size_t fileSizeSoFar = output->GetPosition();
-        // write the length of the compressed data
-        output->Seek(lenloc, kSeekBegin);
-        output->WriteInt32((fileSizeSoFar - lenloc) - 4);
-        output->Seek(0, kSeekEnd);
+        output->WriteInt8(packSprite(images[i], packedData));
+        output->WriteInt32(packedData.size());
+        if (!packedData.empty())
+          output->Write(&packedData[0], packedData.size());
       }
-      else
+      else {
+        output->WriteInt8(kSprCodec_None);
+        output->WriteInt32(spritewidths[i] * bpss * spriteheights[i]);
         output->WriteArray(images[i]->GetDataForWriting(), spritewidths[i] * bpss, spriteheights[i]);
+      }
 
       continue;
     }
@@ -574,14 +751,22 @@ int SpriteCache::saveToFile(const char *filnam, int lastElement, bool compressOu
     output->WriteInt16(width);
     output->WriteInt16(height);
 
+    int codec;
     int sizeToCopy;
-    if (this->spritesAreCompressed) {
+    if (spriteFileVersion >= kSprfVersion_Codecs) {
+      codec = cache_stream->ReadInt8();
+      sizeToCopy = cache_stream->ReadInt32();
+    }
+    else if (this->spritesAreCompressed) {
+      codec = kSprCodec_RLE;
       sizeToCopy = cache_stream->ReadInt32();
-      output->WriteInt32(sizeToCopy);
     }
     else {
+      codec = kSprCodec_None;
       sizeToCopy = width * height * (int)colDepth;
     }
+    output->WriteInt8(codec);
+    output->WriteInt32(sizeToCopy);
 
     while (sizeToCopy > memBufferSize) {
       cache_stream->ReadArray(memBuffer, memBufferSize, 1);
@@ -601,8 +786,8 @@ int SpriteCache::saveToFile(const char *filnam, int lastElement, bool compressOu
   Stream *spindex_out = File::CreateFile(spindexfilename);
   // write "SPRINDEX" id
   spindex_out->WriteArray(&spindexid[0], strlen(spindexid), 1);
-  // write version (1)
-  spindex_out->WriteInt32(2);
+  // write version
+  spindex_out->WriteInt32(kSpridxVersion_Current);
   spindex_out->WriteInt32(spriteFileIDCheck);
   // write last sprite number and num sprites, to verify that
   // it matches the spr file
@@ -644,7 +829,7 @@ int SpriteCache::initFile(const char *filnam)
   // read the "Sprite File" signature
   cache_stream->ReadArray(&buff[0], 13, 1);
 
-  if ((vers < 4) || (vers > 6)) {
+  if ((vers < kSprfVersion_Uncompressed) || (vers > kSprfVersion_Current)) {
     delete cache_stream;
     cache_stream = NULL;
     return -1;
@@ -658,11 +843,12 @@ int SpriteCache::initFile(const char *filnam)
     return -1;
   }
 
-  if (vers == 4)
+  spriteFileVersion = vers;
+  if (vers == kSprfVersion_Uncompressed)
     this->spritesAreCompressed = false;
-  else if (vers == 5)
+  else if (vers == kSprfVersion_Compressed)
     this->spritesAreCompressed = true;
-  else if (vers >= 6)
+  else if (vers >= kSprfVersion_Last32bit)
   {
     this->spritesAreCompressed = (cache_stream->ReadInt8() == 1);
     spriteFileID = cache_stream->ReadInt32();
@@ -727,10 +913,14 @@ int SpriteCache::initFile(const char *filnam)
     get_new_size_for_sprite(vv, wdd, htt, spritewidth[vv], spriteheight[vv]);
 
     int32_t spriteDataSize;
-    if (vers == 5) {
+    if (vers == kSprfVersion_Compressed) {
+      spriteDataSize = cache_stream->ReadInt32();
+    }
+    else if (vers >= kSprfVersion_Codecs) {
+      cache_stream->ReadInt8(); // codec
       spriteDataSize = cache_stream->ReadInt32();
     }
-    else if (vers >= 6)
+    else if (vers >= kSprfVersion_Last32bit)
     {
       spriteDataSize = this->spritesAreCompressed ? cache_stream->ReadInt32() :
         wdd * coldep * htt;
@@ -766,11 +956,11 @@ bool SpriteCache::loadSpriteIndexFile(int expectedFileID, int32_t spr_initial_of
   }
   // check version
   int fileVersion = fidx->ReadInt32();
-  if ((fileVersion < 1) || (fileVersion > 2)) {
+  if ((fileVersion < kSpridxVersion_Initial) || (fileVersion > kSpridxVersion_Current)) {
     delete fidx;
     return false;
   }
-  if (fileVersion >= 2)
+  if (fileVersion >= kSpridxVersion_FileID)
   {
     if (fidx->ReadInt32() != expectedFileID)
     {
@@ -798,6 +988,8 @@ bool SpriteCache::loadSpriteIndexFile(int expectedFileID, int32_t spr_initial_of
   fidx->ReadArrayOfInt16(&rspritewidths[0], numsprits);
   fidx->ReadArrayOfInt16(&rspriteheights[0], numsprits);
   fidx->ReadArrayOfInt32(&offsets[0], numsprits);
+  // version 3 files also have sprite codecs and data sizes, but these are
+  // read from the sprite headers when loading
 
   for (vv = 0; vv <= numspri; vv++) {
     flags[vv] = 0;
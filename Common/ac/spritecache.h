@@ -19,6 +19,7 @@
 #ifndef __SPRCACHE_H
 #define __SPRCACHE_H
 
+#include <vector>
 #include "core/types.h"
 
 namespace AGS { namespace Common { class Stream; class Bitmap; } }
@@ -29,6 +30,25 @@ using namespace AGS; // FIXME later
 // a definite way of knowing whether the sprite existed in the sprite file.
 #define SPRCACHEFLAG_DOESNOTEXIST 1
 
+// Sprite file format versions
+enum SpriteFileVersion
+{
+  kSprfVersion_Uncompressed = 4,
+  kSprfVersion_Compressed   = 5,
+  kSprfVersion_Last32bit    = 6,  // optional compression, file ID
+  kSprfVersion_Codecs       = 7,  // per-sprite codec and data size
+  kSprfVersion_Current      = kSprfVersion_Codecs
+};
+
+// Methods of storing sprite pixel data in the sprite file
+enum SpriteCodec
+{
+  kSprCodec_None      = 0,  // raw pixels
+  kSprCodec_RLE       = 1,  // byte run-length encoding by scanlines
+  kSprCodec_LZ4       = 2,  // LZ4 block of the whole image
+  kSprCodec_DeltaLZ4  = 3   // LZ4 block of the pixel bytes, each minus the same byte of the previous pixel
+};
+
 // Max size of the sprite cache, in bytes
 #if defined (PSP_VERSION)
 // PSP: Use smaller sprite cache due to limited total memory.
@@ -65,6 +85,19 @@ public:
 
   Common::Bitmap *operator[] (int index);
 
+  // Reads the sprite at the current stream position, without putting it into
+  // the cache; returns NULL if the slot is empty or the bitmap could not be
+  // created. Only uses the given stream and buffers, and so may be called
+  // from another thread, while the file is not being reinitialized.
+  Common::Bitmap *readSprite(Common::Stream *in, int index, bool &is_empty,
+    std::vector<unsigned char> &data_buf, std::vector<unsigned char> &pixel_buf) const;
+  // Tells if the sprite is in the file but not loaded yet
+  bool needsLoading(int index) const;
+  // Puts the sprite read ahead of time into the cache, if the slot still
+  // has the same file offset and no image; returns false if the image
+  // was not taken, in which case the caller must delete it
+  bool addPrefetchedSprite(int index, int32_t offset, Common::Bitmap *image);
+
   int32_t *offsets;
   int32_t sprite0InitialOffset;
   int32_t elements;                // size of offsets/images arrays
@@ -73,6 +106,7 @@ public:
   unsigned char *flags;
   Common::Stream *cache_stream;
   bool spritesAreCompressed;
+  short spriteFileVersion;
   int32_t cachesize;               // size in bytes of currently cached images
   int *mrulist, *mrubacklink;
   int liststart, listend;
@@ -82,10 +116,25 @@ public:
 
 private:
     void compressSprite(Common::Bitmap *sprite, Common::Stream *out);
+  // Compresses sprite with the codec giving the smallest data; returns the codec
+  int  packSprite(Common::Bitmap *sprite, std::vector<unsigned char> &data);
+  // Decodes pixel data read from the sprite file; returns false if it is malformed
+  bool unpackSprite(Common::Bitmap *sprite, int codec, const unsigned char *data, size_t data_size,
+                    std::vector<unsigned char> &pixel_buf) const;
   bool loadSpriteIndexFile(int expectedFileID, int32_t spr_initial_offs, short numspri);
 
+  // Puts the loaded image into the slot and initializes it; returns its size
+  int  addLoadedSprite(int index, Common::Bitmap *image);
+  // Removes the oldest sprites until the cache fits into the limit
+  void freeUpMem();
+  void markRecentlyUsed(int index);
+
   void initFile_adjustBuffers(short numspri);
   void initFile_initNullSpriteParams(int vv);
+
+  // buffers for reading and decompressing sprite data
+  std::vector<unsigned char> compressedBuffer;
+  std::vector<unsigned char> pixelBuffer;
 };
 
 extern SpriteCache spriteset;
@@ -17,6 +17,7 @@
 #include "core/asset.h"
 #include "core/assetmanager.h"
 #include "debug/assert.h"
+#include "util/mappedfile.h"
 #include "util/misc.h"
 #include "util/multifilelib.h"
 #include "util/path.h"
@@ -177,8 +178,25 @@ AssetError AssetManager::ReadDataFileTOC(const String &data_file, AssetLibInfo &
     return _theAssetManager->OpenAssetAsStream(asset_name, open_mode, work_mode);
 }
 
+/* static */ void AssetManager::SetMemoryMapping(bool use)
+{
+    assert(_theAssetManager != NULL);
+    if (!_theAssetManager)
+    {
+        return;
+    }
+    _theAssetManager->_useMemoryMapping = use && MappedFile::IsSupported();
+    if (!_theAssetManager->_useMemoryMapping)
+    {
+        // streams that are still open keep their files mapped
+        _theAssetManager->_mappedFiles.clear();
+    }
+}
+
 AssetManager::AssetManager()
     : _assetLib(*new AssetLibInfo())
+    , _lastAssetSize(0)
+    , _useMemoryMapping(false)
 {
 }
 
@@ -289,6 +307,16 @@ AssetError AssetManager::RegisterAssetLib(const String &data_file, const String
 {
     // base path is current directory
     _basePath = ".";
+    _assetIndex.clear();
+    // the mapped files are only checked here, so drop those which were
+    // changed on disk; the unchanged ones may still be used by the new library
+    for (size_t i = 0; i < _mappedFiles.size(); )
+    {
+        if (_mappedFiles[i]->IsModified())
+            _mappedFiles.erase(_mappedFiles.begin() + i);
+        else
+            ++i;
+    }
 
     // open data library
     Stream *in = ci_fopen(data_file, Common::kFile_Open, Common::kFile_Read);
@@ -326,19 +354,29 @@ AssetError AssetManager::RegisterAssetLib(const String &data_file, const String
     // make a backup of the original file name
     _assetLib.BaseFileName = _assetLib.LibFileNames[0];
     _assetLib.BaseFileName.MakeLower();
+    BuildAssetIndex();
     return kAssetNoError;
 }
 
-AssetInfo *AssetManager::FindAssetByFileName(const String &asset_name)
+void AssetManager::BuildAssetIndex()
 {
+    _assetIndex.clear();
+    _assetIndex.rehash(_assetLib.AssetInfos.size());
     for (size_t i = 0; i < _assetLib.AssetInfos.size(); ++i)
     {
-        if (_assetLib.AssetInfos[i].FileName.CompareNoCase(asset_name) == 0)
-        {
-            return &_assetLib.AssetInfos[i];
-        }
+        // if several assets have the same name, the first one is found
+        _assetIndex.insert(std::make_pair(_assetLib.AssetInfos[i].FileName, i));
     }
-    return NULL;
+}
+
+AssetInfo *AssetManager::FindAssetByFileName(const String &asset_name)
+{
+    AssetIndexMap::const_iterator it = _assetIndex.find(asset_name);
+    if (it == _assetIndex.end())
+    {
+        return NULL;
+    }
+    return &_assetLib.AssetInfos[it->second];
 }
 
 String AssetManager::MakeLibraryFileNameForAsset(const AssetInfo *asset)
@@ -398,6 +436,16 @@ Stream *AssetManager::OpenAssetAsStream(const String &asset_name, FileOpenMode o
     AssetLocation loc;
     if (GetAssetByPriority(asset_name, loc, open_mode, work_mode))
     {
+        if (_useMemoryMapping && open_mode == kFile_Open && work_mode == kFile_Read)
+        {
+            Stream *s = OpenMappedAsset(loc);
+            if (s)
+            {
+                _lastAssetSize = loc.Size;
+                return s;
+            }
+        }
+
         Stream *s = File::OpenFile(loc.FileName, open_mode, work_mode);
         if (s)
         {
@@ -409,5 +457,38 @@ Stream *AssetManager::OpenAssetAsStream(const String &asset_name, FileOpenMode o
     return NULL;
 }
 
+Stream *AssetManager::OpenMappedAsset(const AssetLocation &loc)
+{
+    PMappedFile file;
+    for (size_t i = 0; i < _mappedFiles.size(); ++i)
+    {
+        if (_mappedFiles[i]->GetFileName().Compare(loc.FileName) == 0)
+        {
+            // the files are checked for changes when the library is registered;
+            // between that only remap if the asset does not fit the mapping anymore
+            if (loc.Offset >= 0 && loc.Size >= 0 &&
+                (size_t)loc.Offset + loc.Size <= _mappedFiles[i]->GetSize())
+                file = _mappedFiles[i];
+            else
+                _mappedFiles.erase(_mappedFiles.begin() + i);
+            break;
+        }
+    }
+    if (!file)
+    {
+        file.reset(new MappedFile());
+        if (!file->Open(loc.FileName))
+        {
+            return NULL;
+        }
+        _mappedFiles.push_back(file);
+    }
+    if (loc.Offset < 0 || loc.Size < 0 || (size_t)loc.Offset + loc.Size > file->GetSize())
+    {
+        return NULL;
+    }
+    return new MappedFileStream(file, loc.Offset, loc.Size);
+}
+
 } // namespace Common
 } // namespace AGS
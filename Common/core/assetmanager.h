@@ -36,7 +36,11 @@
 #ifndef __AGS_CN_CORE__ASSETMANAGER_H
 #define __AGS_CN_CORE__ASSETMANAGER_H
 
+#include <vector>
 #include "util/file.h"
+#include "util/stdtr1compat.h"
+#include TR1INCLUDE(memory)
+#include "util/string_types.h"
 
 namespace AGS
 {
@@ -44,6 +48,7 @@ namespace Common
 {
 
 class Stream;
+class MappedFile;
 struct MultiFileLib;
 struct AssetLibInfo;
 struct AssetInfo;
@@ -84,6 +89,10 @@ public:
 
     static bool     SetSearchPriority(AssetSearchPriority priority);
     static AssetSearchPriority GetSearchPriority();
+    // Sets whether the assets should be read from memory mapped files,
+    // where this is supported by the platform; affects only assets
+    // opened for reading afterwards
+    static void     SetMemoryMapping(bool use);
 
     // Test if given file is main data file
     static bool         IsDataFile(const String &data_file);
@@ -99,7 +108,8 @@ public:
     static String       GetAssetFileByIndex(int index);
     static long         GetAssetOffset(const String &asset_name);
     static long         GetAssetSize(const String &asset_name);
-    // TODO: instead of this support streams that work in a file subsection, limited by size
+    // NOTE: streams over memory mapped files are limited to the asset subsection,
+    // but the regular file streams are not, so the size is still necessary
     static long         GetLastAssetSize();
     // TODO: this is a workaround that lets us use back-end specific kind of streams
     // to read the asset data. This is not ideal, because it limits us to reading from file.
@@ -129,6 +139,8 @@ private:
     long        _GetLastAssetSize();
 
     AssetError  RegisterAssetLib(const String &data_file, const String &password);
+    // Builds the lookup index of the library assets
+    void        BuildAssetIndex();
 
     bool        _DoesAssetExist(const String &asset_name);
 
@@ -139,6 +151,9 @@ private:
     bool        GetAssetFromDir(const String &asset_name, AssetLocation &loc, Common::FileOpenMode open_mode, Common::FileWorkMode work_mode);
     bool        GetAssetByPriority(const String &asset_name, AssetLocation &loc, Common::FileOpenMode open_mode, Common::FileWorkMode work_mode);
     Stream      *OpenAssetAsStream(const String &asset_name, FileOpenMode open_mode, FileWorkMode work_mode);
+    // Creates stream over the asset in the memory mapped file; returns NULL if
+    // the file could not be mapped
+    Stream      *OpenMappedAsset(const AssetLocation &loc);
 
     static AssetManager     *_theAssetManager;
     AssetSearchPriority     _searchPriority;
@@ -146,6 +161,13 @@ private:
     AssetLibInfo            &_assetLib;
     String                  _basePath;          // library's parent path (directory)
     long                    _lastAssetSize;     // size of asset that was opened last time
+    // asset index in the library table of contents, by case-insensitive name
+    typedef stdtr1compat::unordered_map<String, size_t, HashStrNoCase, StrCmpNoCase> AssetIndexMap;
+    AssetIndexMap           _assetIndex;
+    bool                    _useMemoryMapping;
+    // files mapped for reading assets; the open streams share them too;
+    // they are checked for changes on disk when a library is registered
+    std::vector< stdtr1compat::shared_ptr<MappedFile> > _mappedFiles;
 };
 
 } // namespace Common
@@ -45,6 +45,10 @@ class IAGSFontRenderer2
 public:
   // Load font, applying extended font rendering parameters
   virtual bool LoadFromDiskEx(int fontNumber, int fontSize, const FontRenderParams *params) = 0;
+  // Draw the text with the outline around it in one go; returns false if the
+  // renderer cannot do that here, and the outline has to be drawn separately
+  virtual bool RenderTextOutlined(const char *text, int fontNumber, BITMAP *destination, int x, int y,
+      int colour, int outline_colour, int outline_dist) = 0;
 };
 
 #endif // __AC_AGSFONTRENDERER_H
@@ -17,12 +17,14 @@
 #endif
 
 #include <stdio.h>
+#include <vector>
 #include "alfont.h"
 
 #include "ac/common.h"
 #include "ac/gamestructdefines.h"
 #include "font/fonts.h"
 #include "font/agsfontrenderer.h"
+#include "font/textlayout.h"
 #include "font/ttffontrenderer.h"
 #include "font/wfnfontrenderer.h"
 #include "gfx/bitmap.h"
@@ -42,6 +44,12 @@ struct Font
     IAGSFontRenderer   *Renderer;
     IAGSFontRenderer2  *Renderer2;
     FontInfo            Info;
+    // Text width is the sum of character widths
+    bool                AdditiveWidths;
+    // Cached widths of single characters, -1 for not measured yet
+    std::vector<int>    CharWidths;
+    // Text multiplier the widths were measured with
+    int                 CharWidthsMultiply;
 
     Font();
 };
@@ -49,6 +57,8 @@ struct Font
 Font::Font()
     : Renderer(NULL)
     , Renderer2(NULL)
+    , AdditiveWidths(false)
+    , CharWidthsMultiply(0)
 {}
 
 } // Common
@@ -58,6 +68,13 @@ static AGS::Common::Font fonts[MAX_FONTS];
 static TTFFontRenderer ttfRenderer;
 static WFNFontRenderer wfnRenderer;
 
+// Drops the measurements made with the font's previous renderer
+static void reset_font_widths(int fontNumber)
+{
+  fonts[fontNumber].CharWidths.clear();
+  clear_text_layout_cache();
+}
+
 
 FontInfo::FontInfo()
     : Flags(0)
@@ -93,11 +110,13 @@ bool font_first_renderer_loaded() {
   return fonts[0].Renderer != NULL;
 }
 
-IAGSFontRenderer* font_replace_renderer(int fontNumber, IAGSFontRenderer* renderer)
+IAGSFontRenderer* font_replace_renderer(int fontNumber, IAGSFontRenderer* renderer, bool additive_widths)
 {
   IAGSFontRenderer* oldRender = fonts[fontNumber].Renderer;
   fonts[fontNumber].Renderer = renderer;
   fonts[fontNumber].Renderer2 = NULL;
+  fonts[fontNumber].AdditiveWidths = additive_widths;
+  reset_font_widths(fontNumber);
   return oldRender;
 }
 
@@ -116,6 +135,28 @@ int wgettextwidth(const char *texx, int fontNumber)
   return fonts[fontNumber].Renderer->GetTextWidth(texx, fontNumber);
 }
 
+bool font_has_additive_widths(int fontNumber)
+{
+  return fonts[fontNumber].AdditiveWidths;
+}
+
+int wgetcharwidth(unsigned char ch, int fontNumber)
+{
+  Font &font = fonts[fontNumber];
+  if (font.CharWidths.empty() || font.CharWidthsMultiply != wtext_multiply)
+  {
+    font.CharWidths.assign(256, -1);
+    font.CharWidthsMultiply = wtext_multiply;
+  }
+  int &width = font.CharWidths[ch];
+  if (width < 0)
+  {
+    const char text[2] = { (char)ch, 0 };
+    width = font.Renderer->GetTextWidth(text, fontNumber);
+  }
+  return width;
+}
+
 int wgettextheight(const char *text, int fontNumber)
 {
   return fonts[fontNumber].Renderer->GetTextHeight(text, fontNumber);
@@ -129,6 +170,8 @@ int get_font_outline(int font_number)
 void set_font_outline(int font_number, int outline_type)
 {
     fonts[font_number].Info.Outline = FONT_OUTLINE_AUTO;
+    // outline is added to the measured text width
+    clear_text_layout_cache();
 }
 
 int getfontheight(int fontNumber)
@@ -166,6 +209,20 @@ void wouttextxy(Common::Bitmap *ds, int xxx, int yyy, int fontNumber, color_t te
   }
 }
 
+bool wouttextxy_outlined(Common::Bitmap *ds, int xxx, int yyy, int fontNumber, color_t text_color,
+                         color_t outline_color, int outline_dist, const char *texx)
+{
+  if (fonts[fontNumber].Renderer2 == NULL)
+    return false;
+
+  yyy += fonts[fontNumber].Info.YOffset;
+  if (yyy - outline_dist > ds->GetClip().Bottom)
+    return true;              // every layer is clipped
+
+  return fonts[fontNumber].Renderer2->RenderTextOutlined(texx, fontNumber, (BITMAP*)ds->GetAllegroBitmap(),
+      xxx, yyy, text_color, outline_color, outline_dist);
+}
+
 // Loads a font from disk
 bool wloadfont_size(int fontNumber, const FontInfo &font_info, const FontRenderParams *params)
 {
@@ -183,6 +240,9 @@ bool wloadfont_size(int fontNumber, const FontInfo &font_info, const FontRenderP
   if (fonts[fontNumber].Renderer)
   {
       fonts[fontNumber].Info = font_info;
+      // the built-in renderers do not apply kerning
+      fonts[fontNumber].AdditiveWidths = true;
+      reset_font_widths(fontNumber);
       return true;
   }
   return false;
@@ -205,4 +265,5 @@ void wfreefont(int fontNumber)
     fonts[fontNumber].Renderer->FreeMemory(fontNumber);
 
   fonts[fontNumber].Renderer = NULL;
+  reset_font_widths(fontNumber);
 }
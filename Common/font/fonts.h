@@ -53,11 +53,18 @@ struct FontRenderParams {};
 void init_font_renderer();
 void shutdown_font_renderer();
 void adjust_y_coordinate_for_text(int* ypos, int fontnum);
-IAGSFontRenderer* font_replace_renderer(int fontNumber, IAGSFontRenderer* renderer);
+// Replaces the font's renderer; additive_widths tells that the width of any text
+// is the sum of its characters' widths, letting the text be measured per character
+IAGSFontRenderer* font_replace_renderer(int fontNumber, IAGSFontRenderer* renderer, bool additive_widths = false);
 bool font_first_renderer_loaded();
 bool font_supports_extended_characters(int fontNumber);
 void ensure_text_valid_for_font(char *text, int fontnum);
 int wgettextwidth(const char *texx, int fontNumber);
+// Tells if the width of a text in this font is always the sum of its characters'
+// widths; true for the built-in renderers, but unknown for the plugin ones
+bool font_has_additive_widths(int fontNumber);
+// Gets the width of a single character; the widths are measured once per font
+int wgetcharwidth(unsigned char ch, int fontNumber);
 // Calculates actual height of a line of text
 int wgettextheight(const char *text, int fontNumber);
 // Get font's height (maximal height of any line of text printed with this font)
@@ -71,6 +78,10 @@ void set_font_outline(int font_number, int outline_type);
 // Outputs a single line of text on the defined position on bitmap, using defined font, color and parameters
 int getfontlinespacing(int fontNumber);
 void wouttextxy(Common::Bitmap *ds, int xxx, int yyy, int fontNumber, color_t text_color, const char *texx);
+// Outputs the text with the outline of outline_dist pixels around it, in one pass;
+// returns false if the font's renderer cannot do that, and nothing was drawn
+bool wouttextxy_outlined(Common::Bitmap *ds, int xxx, int yyy, int fontNumber, color_t text_color,
+                         color_t outline_color, int outline_dist, const char *texx);
 // Loads a font from disk
 bool wloadfont_size(int fontNumber, const FontInfo &font_info, const FontRenderParams *params = NULL);
 void wgtprintf(Common::Bitmap *ds, int xxx, int yyy, int fontNumber, color_t text_color, char *fmt, ...);
@@ -0,0 +1,364 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#include <limits.h>
+#include <allegro.h>
+#include "font/glyphcache.h"
+#include "util/math.h"
+
+// The blenders which the TTF library uses for the anti-aliased text; these
+// skip blending over the transparent pixels and keep the destination alpha
+extern "C"
+{
+unsigned long __skiptranspixels_blender_trans15(unsigned long x, unsigned long y, unsigned long n);
+unsigned long __skiptranspixels_blender_trans16(unsigned long x, unsigned long y, unsigned long n);
+unsigned long __preservedalpha_blender_trans24(unsigned long x, unsigned long y, unsigned long n);
+}
+
+#define GLYPH_CHAR_COUNT 256
+#define GLYPH_OUTLINE_LAYERS 8
+
+// Coverage of the whole text, reused by the outlined text drawing
+static std::vector<uint8_t> text_mask;
+
+// Paints the pixel, or blends it with the colour if partly covered
+static inline void PutCoveredPixel(BITMAP *ds, int depth, int x, int y, int colour, uint8_t coverage)
+{
+    switch (depth)
+    {
+    case 8:
+        ds->line[y][x] = colour;
+        break;
+    case 15:
+    case 16:
+        {
+            uint16_t &px = ((uint16_t*)ds->line[y])[x];
+            if (coverage == 255)
+                px = colour;
+            else if (depth == 15)
+                px = __skiptranspixels_blender_trans15(colour, px, coverage);
+            else
+                px = __skiptranspixels_blender_trans16(colour, px, coverage);
+        }
+        break;
+    case 24:
+        if (coverage == 255)
+            _putpixel24(ds, x, y, colour);
+        else
+            _putpixel24(ds, x, y, __preservedalpha_blender_trans24(colour, _getpixel24(ds, x, y), coverage));
+        break;
+    case 32:
+        {
+            uint32_t &px = ((uint32_t*)ds->line[y])[x];
+            if (coverage == 255)
+                px = colour;
+            else
+                px = __preservedalpha_blender_trans24(colour, px, coverage);
+        }
+        break;
+    }
+}
+
+namespace AGS
+{
+namespace Common
+{
+
+GlyphCache::GlyphCache()
+{
+    Clear();
+}
+
+void GlyphCache::Clear()
+{
+    CachedGlyph empty = { false, 0, 0, 0, 0 };
+    _glyphs.assign(GLYPH_CHAR_COUNT, empty);
+    _spans.clear();
+    _coverage.clear();
+    _lastGlyph = 0;
+}
+
+bool GlyphCache::HasGlyphs(const char *text) const
+{
+    for (; *text; ++text)
+    {
+        if (!_glyphs[(unsigned char)*text].Cached)
+            return false;
+    }
+    return true;
+}
+
+void GlyphCache::BeginGlyph(unsigned char ch, int advance, int height)
+{
+    CachedGlyph &glyph = _glyphs[ch];
+    glyph.Cached = true;
+    glyph.Advance = advance;
+    glyph.Height = height;
+    glyph.FirstSpan = _spans.size();
+    glyph.SpanCount = 0;
+    _lastGlyph = ch;
+}
+
+void GlyphCache::AddSpan(int x, int y, int length, const uint8_t *coverage)
+{
+    GlyphSpan span;
+    span.X = x;
+    span.Y = y;
+    span.Length = length;
+    span.Coverage = _coverage.size();
+    if (coverage)
+        _coverage.insert(_coverage.end(), coverage, coverage + length);
+    _spans.push_back(span);
+    _glyphs[_lastGlyph].SpanCount++;
+}
+
+void GlyphCache::AddImage(int x, int y, int width, int height, const uint8_t *pixels, int pitch, bool anti_alias)
+{
+    for (int row = 0; row < height; ++row)
+    {
+        const uint8_t *line = pixels + row * pitch;
+        for (int col = 0; col < width;)
+        {
+            if (line[col] == 0)
+            {
+                col++;
+                continue;
+            }
+            int end = col + 1;
+            for (; end < width && line[end] != 0; ++end);
+            AddSpan(x + col, y + row, end - col, anti_alias ? line + col : NULL);
+            col = end;
+        }
+    }
+}
+
+int GlyphCache::GetTextWidth(const char *text) const
+{
+    int width = 0;
+    for (; *text; ++text)
+        width += _glyphs[(unsigned char)*text].Advance;
+    return width;
+}
+
+int GlyphCache::GetTextHeight(const char *text) const
+{
+    int height = 0;
+    for (; *text; ++text)
+    {
+        const int char_height = _glyphs[(unsigned char)*text].Height;
+        if (char_height > height)
+            height = char_height;
+    }
+    return height;
+}
+
+void GlyphCache::DrawText(BITMAP *ds, const char *text, int x, int y, int colour, int multiply) const
+{
+    for (; *text; ++text)
+    {
+        const CachedGlyph &glyph = _glyphs[(unsigned char)*text];
+        const GlyphSpan *span = glyph.SpanCount > 0 ? &_spans[glyph.FirstSpan] : NULL;
+        for (size_t i = 0; i < glyph.SpanCount; ++i, ++span)
+        {
+            if (multiply > 1)
+            {
+                const int span_x = x + span->X * multiply;
+                const int span_y = y + span->Y * multiply;
+                rectfill(ds, span_x, span_y, span_x + span->Length * multiply - 1, span_y + multiply - 1, colour);
+            }
+            else
+            {
+                hline(ds, x + span->X, y + span->Y, x + span->X + span->Length - 1, colour);
+            }
+        }
+        x += glyph.Advance * multiply;
+    }
+}
+
+void GlyphCache::DrawTextAntiAliased(BITMAP *ds, const char *text, int x, int y, int colour) const
+{
+    int clip_left = 0, clip_top = 0, clip_right = ds->w, clip_bottom = ds->h;
+    if (ds->clip)
+    {
+        clip_left = ds->cl;
+        clip_top = ds->ct;
+        clip_right = ds->cr;
+        clip_bottom = ds->cb;
+    }
+    const int depth = bitmap_color_depth(ds);
+
+    for (; *text; ++text)
+    {
+        const CachedGlyph &glyph = _glyphs[(unsigned char)*text];
+        const GlyphSpan *span = glyph.SpanCount > 0 ? &_spans[glyph.FirstSpan] : NULL;
+        for (size_t i = 0; i < glyph.SpanCount; ++i, ++span)
+        {
+            const int span_y = y + span->Y;
+            if (span_y < clip_top || span_y >= clip_bottom)
+                continue;
+            int left = x + span->X;
+            int right = left + span->Length;
+            const uint8_t *coverage = &_coverage[span->Coverage];
+            if (left < clip_left)
+            {
+                coverage += clip_left - left;
+                left = clip_left;
+            }
+            if (right > clip_right)
+                right = clip_right;
+
+            // fully covered pixels are painted over, the rest are blended
+            // with the alpha of their coverage
+            switch (depth)
+            {
+            case 15:
+            case 16:
+                {
+                    uint16_t *px = (uint16_t*)ds->line[span_y] + left;
+                    for (int px_x = left; px_x < right; ++px_x, ++px, ++coverage)
+                    {
+                        if (*coverage == 255)
+                            *px = colour;
+                        else if (depth == 15)
+                            *px = __skiptranspixels_blender_trans15(colour, *px, *coverage);
+                        else
+                            *px = __skiptranspixels_blender_trans16(colour, *px, *coverage);
+                    }
+                }
+                break;
+            case 24:
+                for (int px_x = left; px_x < right; ++px_x, ++coverage)
+                {
+                    if (*coverage == 255)
+                        _putpixel24(ds, px_x, span_y, colour);
+                    else
+                        _putpixel24(ds, px_x, span_y,
+                            __preservedalpha_blender_trans24(colour, _getpixel24(ds, px_x, span_y), *coverage));
+                }
+                break;
+            case 32:
+                {
+                    uint32_t *px = (uint32_t*)ds->line[span_y] + left;
+                    for (int px_x = left; px_x < right; ++px_x, ++px, ++coverage)
+                    {
+                        if (*coverage == 255)
+                            *px = colour;
+                        else
+                            *px = __preservedalpha_blender_trans24(colour, *px, *coverage);
+                    }
+                }
+                break;
+            }
+        }
+        x += glyph.Advance;
+    }
+}
+
+void GlyphCache::DrawTextOutlined(BITMAP *ds, const char *text, int x, int y, int colour,
+                                  int outline_colour, int outline_dist, int multiply, bool anti_alias) const
+{
+    // find the box of all the glyphs' pixels, relative to the pen
+    int left = INT_MAX, top = INT_MAX, right = INT_MIN, bottom = INT_MIN;
+    int pen_x = 0;
+    for (const char *ch = text; *ch; ++ch)
+    {
+        const CachedGlyph &glyph = _glyphs[(unsigned char)*ch];
+        for (size_t i = 0; i < glyph.SpanCount; ++i)
+        {
+            const GlyphSpan &span = _spans[glyph.FirstSpan + i];
+            left = Math::Min(left, pen_x + span.X * multiply);
+            right = Math::Max(right, pen_x + (span.X + span.Length) * multiply);
+            top = Math::Min(top, span.Y * multiply);
+            bottom = Math::Max(bottom, (span.Y + 1) * multiply);
+        }
+        pen_x += glyph.Advance * multiply;
+    }
+    if (left >= right)
+        return;
+
+    // make the coverage of the whole text; where the glyphs overlap, the
+    // most covering one is taken
+    const int mask_width = right - left;
+    const int mask_height = bottom - top;
+    text_mask.assign(mask_width * mask_height, 0);
+    pen_x = 0;
+    for (const char *ch = text; *ch; ++ch)
+    {
+        const CachedGlyph &glyph = _glyphs[(unsigned char)*ch];
+        for (size_t i = 0; i < glyph.SpanCount; ++i)
+        {
+            const GlyphSpan &span = _spans[glyph.FirstSpan + i];
+            const int span_x = pen_x + span.X * multiply - left;
+            const int span_y = span.Y * multiply - top;
+            for (int px = 0; px < span.Length; ++px)
+            {
+                const uint8_t coverage = anti_alias ? _coverage[span.Coverage + px] : 255;
+                for (int my = span_y; my < span_y + multiply; ++my)
+                {
+                    uint8_t *mask = &text_mask[my * mask_width + span_x + px * multiply];
+                    for (int mx = 0; mx < multiply; ++mx, ++mask)
+                        *mask = Math::Max(*mask, coverage);
+                }
+            }
+        }
+        pen_x += glyph.Advance * multiply;
+    }
+
+    // the outline layers, in the order they used to be drawn in
+    const int d = outline_dist;
+    const int layer_x[GLYPH_OUTLINE_LAYERS] = { -d, d, 0,  0, -d, -d, d,  d };
+    const int layer_y[GLYPH_OUTLINE_LAYERS] = {  0, 0, d, -d, -d,  d, d, -d };
+
+    int clip_left = 0, clip_top = 0, clip_right = ds->w, clip_bottom = ds->h;
+    if (ds->clip)
+    {
+        clip_left = ds->cl;
+        clip_top = ds->ct;
+        clip_right = ds->cr;
+        clip_bottom = ds->cb;
+    }
+    const int draw_left = Math::Max(clip_left, x + left - d);
+    const int draw_right = Math::Min(clip_right, x + right + d);
+    const int draw_top = Math::Max(clip_top, y + top - d);
+    const int draw_bottom = Math::Min(clip_bottom, y + bottom + d);
+    const int depth = bitmap_color_depth(ds);
+
+    for (int py = draw_top; py < draw_bottom; ++py)
+    {
+        for (int px = draw_left; px < draw_right; ++px)
+        {
+            // position of the pixel on the text's mask
+            const int mx = px - x - left;
+            const int my = py - y - top;
+            for (int layer = 0; layer < GLYPH_OUTLINE_LAYERS; ++layer)
+            {
+                const int lx = mx - layer_x[layer];
+                const int ly = my - layer_y[layer];
+                if (lx < 0 || lx >= mask_width || ly < 0 || ly >= mask_height)
+                    continue;
+                const uint8_t coverage = text_mask[ly * mask_width + lx];
+                if (coverage)
+                    PutCoveredPixel(ds, depth, px, py, outline_colour, coverage);
+            }
+            if (mx < 0 || mx >= mask_width || my < 0 || my >= mask_height)
+                continue;
+            const uint8_t coverage = text_mask[my * mask_width + mx];
+            if (coverage)
+                PutCoveredPixel(ds, depth, px, py, colour, coverage);
+        }
+    }
+}
+
+} // namespace Common
+} // namespace AGS
@@ -0,0 +1,109 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Glyph cache: the images of a font's characters, rasterized once and kept
+// as horizontal spans of drawn pixels, with the coverage (alpha) of each
+// pixel for the anti-aliased glyphs. Strings are drawn by going through
+// the spans of each character, and their widths and heights are summed up
+// from the cached metrics, without asking the font library again.
+//
+//=============================================================================
+#ifndef __AGS_CN_FONT__GLYPHCACHE_H
+#define __AGS_CN_FONT__GLYPHCACHE_H
+
+#include <vector>
+#include "core/types.h"
+
+struct BITMAP;
+
+namespace AGS
+{
+namespace Common
+{
+
+// A row of drawn pixels, relative to the pen position
+struct GlyphSpan
+{
+    int16_t X;
+    int16_t Y;
+    int16_t Length;
+    // index of the first pixel's coverage, for the anti-aliased glyphs
+    size_t  Coverage;
+};
+
+struct CachedGlyph
+{
+    bool   Cached;
+    // pen movement after the character
+    int    Advance;
+    int    Height;
+    size_t FirstSpan;
+    size_t SpanCount;
+};
+
+class GlyphCache
+{
+public:
+    GlyphCache();
+
+    // Removes all the glyphs
+    void Clear();
+
+    inline bool HasGlyph(unsigned char ch) const { return _glyphs[ch].Cached; }
+    // Tells if all the characters of the text are cached
+    bool HasGlyphs(const char *text) const;
+    inline const CachedGlyph &GetGlyph(unsigned char ch) const { return _glyphs[ch]; }
+
+    // Starts the glyph for the given character, replacing the old one
+    void BeginGlyph(unsigned char ch, int advance, int height);
+    // Adds the row of drawn pixels to the last started glyph; coverage is
+    // either NULL for the fully drawn pixels, or has the alpha of each one
+    void AddSpan(int x, int y, int length, const uint8_t *coverage = NULL);
+    // Finds the drawn pixels in the 8-bit rows of the glyph image, where
+    // zero is not drawn, and adds them as spans starting at the (x, y)
+    // offset from the pen; if anti_alias is set, the values are coverage
+    void AddImage(int x, int y, int width, int height, const uint8_t *pixels, int pitch, bool anti_alias);
+
+    // Sums up the advances of all the characters
+    int GetTextWidth(const char *text) const;
+    // Gets the height of the highest character
+    int GetTextHeight(const char *text) const;
+
+    // Fills the glyphs' spans with the colour, using current drawing mode;
+    // every pixel of the glyph is scaled to the multiply x multiply square
+    void DrawText(BITMAP *ds, const char *text, int x, int y, int colour, int multiply = 1) const;
+    // Blends the glyphs' pixels by their coverage, the way the anti-aliased
+    // text is drawn by the TTF library; ds must be a memory bitmap of
+    // 15-bit colour depth or higher
+    void DrawTextAntiAliased(BITMAP *ds, const char *text, int x, int y, int colour) const;
+    // Draws the text surrounded by the outline, the way it looks when the
+    // text is drawn eight times shifted by outline_dist pixels in every
+    // direction and then once more on top; the text's coverage is made
+    // once and all the layers are put onto each pixel in the same pass.
+    // ds must be a memory bitmap
+    void DrawTextOutlined(BITMAP *ds, const char *text, int x, int y, int colour,
+                          int outline_colour, int outline_dist, int multiply, bool anti_alias) const;
+
+private:
+    std::vector<CachedGlyph> _glyphs;
+    std::vector<GlyphSpan>   _spans;
+    std::vector<uint8_t>     _coverage;
+    // the glyph which the new spans are added to
+    int                      _lastGlyph;
+};
+
+} // namespace Common
+} // namespace AGS
+
+#endif // __AGS_CN_FONT__GLYPHCACHE_H
@@ -0,0 +1,205 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#include <string.h>
+#include <list>
+#include <map>
+#include "font/fonts.h"
+#include "font/textlayout.h"
+#include "util/string.h"
+#include "util/string_utils.h"
+
+using namespace AGS::Common;
+
+// Project-dependent implementation
+extern int wgettextwidth_compensate(const char *tex, int font);
+
+// Max number of layouts kept in the cache
+#define TEXT_LAYOUT_CACHE_SIZE 32
+
+namespace AGS
+{
+namespace Common
+{
+
+TextLayout::TextLayout()
+    : _truncated(false)
+{
+    _text.push_back(0);
+}
+
+void TextLayout::Layout(const char *text, int max_width, int font, size_t max_lines)
+{
+    _lines.clear();
+    _truncated = false;
+    // make a copy, since unescaping and measuring change the characters
+    _text.assign(text, text + strlen(text) + 1);
+    char *buf = &_text.front();
+    unescape(buf);
+
+    const bool additive = font_has_additive_widths(font);
+    // compensation for the outline, added to any text width
+    const int base_width = additive ? wgettextwidth_compensate("", font) : 0;
+    size_t start = 0;      // first character of the current line
+    size_t i = 0;          // current character, relative to line start
+    size_t last_space = 0; // last space after the line's first character
+    int width = base_width;
+    for (;;)
+    {
+        const char c = buf[start + i];
+        if (c == 0)
+        {
+            // end of the text, add the last line if necessary
+            if (i > 0)
+            {
+                TextLine line = { start, i };
+                _lines.push_back(line);
+            }
+            break;
+        }
+
+        int split_at = -1;
+        // force end of line with the \n character
+        if (c == '\n')
+        {
+            split_at = (int)i;
+        }
+        // otherwise, see if we are too wide
+        else
+        {
+            if (c == ' ' && i > 0)
+                last_space = i;
+            bool too_wide;
+            if (additive)
+            {
+                width += wgetcharwidth((unsigned char)c, font);
+                too_wide = width >= max_width;
+            }
+            else
+            {
+                too_wide = IsTooWide(start, i, max_width, font);
+            }
+            // break at the last space, or display as much as possible
+            // of a single very wide word
+            if (too_wide)
+                split_at = last_space > 0 ? (int)last_space : (int)i - 1;
+        }
+
+        if (split_at >= 0)
+        {
+            TextLine line = { start, (size_t)split_at };
+            _lines.push_back(line);
+            if (_lines.size() >= max_lines)
+            {
+                _truncated = true;
+                break;
+            }
+            // the next line starts from here, skipping the space or
+            // new line that caused the line break
+            start += split_at;
+            if ((buf[start] == ' ') || (buf[start] == '\n'))
+                start++;
+            i = 0;
+            last_space = 0;
+            width = base_width;
+            continue;
+        }
+        i++;
+    }
+}
+
+bool TextLayout::IsTooWide(size_t start, size_t end, int max_width, int font)
+{
+    // temporarily terminate the line here and test its width
+    char *line = &_text[start];
+    const char next_char = line[end + 1];
+    line[end + 1] = 0;
+    const bool too_wide = wgettextwidth_compensate(line, font) >= max_width;
+    line[end + 1] = next_char;
+    return too_wide;
+}
+
+} // namespace Common
+} // namespace AGS
+
+struct TextLayoutKey
+{
+    String Text;
+    int    MaxWidth;
+    int    Font;
+    size_t MaxLines;
+    int    Multiply;
+
+    bool operator <(const TextLayoutKey &other) const
+    {
+        if (MaxWidth != other.MaxWidth)
+            return MaxWidth < other.MaxWidth;
+        if (Font != other.Font)
+            return Font < other.Font;
+        if (MaxLines != other.MaxLines)
+            return MaxLines < other.MaxLines;
+        if (Multiply != other.Multiply)
+            return Multiply < other.Multiply;
+        return Text.Compare(other.Text.GetCStr()) < 0;
+    }
+};
+
+struct CachedTextLayout
+{
+    TextLayoutKey Key;
+    TextLayout    Layout;
+};
+
+typedef std::list<CachedTextLayout> TextLayoutList;
+typedef std::map<TextLayoutKey, TextLayoutList::iterator> TextLayoutMap;
+
+// Layouts in the order of use, the most recently used first
+static TextLayoutList layoutList;
+static TextLayoutMap layoutMap;
+
+const TextLayout &get_text_layout(const char *text, int max_width, int font, size_t max_lines)
+{
+    TextLayoutKey key;
+    key.Text = text;
+    key.MaxWidth = max_width;
+    key.Font = font;
+    key.MaxLines = max_lines;
+    key.Multiply = wtext_multiply;
+
+    TextLayoutMap::iterator found = layoutMap.find(key);
+    if (found != layoutMap.end())
+    {
+        // move to the front of the list
+        layoutList.splice(layoutList.begin(), layoutList, found->second);
+        return found->second->Layout;
+    }
+
+    if (layoutMap.size() >= TEXT_LAYOUT_CACHE_SIZE)
+    {
+        layoutMap.erase(layoutList.back().Key);
+        layoutList.pop_back();
+    }
+    layoutList.push_front(CachedTextLayout());
+    CachedTextLayout &item = layoutList.front();
+    item.Key = key;
+    item.Layout.Layout(text, max_width, font, max_lines);
+    layoutMap[key] = layoutList.begin();
+    return item.Layout;
+}
+
+void clear_text_layout_cache()
+{
+    layoutMap.clear();
+    layoutList.clear();
+}
@@ -0,0 +1,76 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Word wrapping of the text. The text is broken into lines in one pass,
+// summing up the widths of single characters, which are measured once per
+// font. Fonts from the plugin renderers, which may not tell the width of a
+// text by its characters, are measured by the whole line as before.
+// The recently made layouts are kept, so that the same speech, labels
+// and wrapped strings drawn again every frame are not wrapped again.
+//
+//=============================================================================
+#ifndef __AGS_CN_FONT__TEXTLAYOUT_H
+#define __AGS_CN_FONT__TEXTLAYOUT_H
+
+#include <stddef.h>
+#include <vector>
+
+namespace AGS
+{
+namespace Common
+{
+
+// A line of the laid out text, as a range of the layout's characters
+struct TextLine
+{
+    size_t Offset;
+    size_t Length;
+};
+
+class TextLayout
+{
+public:
+    TextLayout();
+
+    // Breaks the text into lines narrower than max_width, stopping after
+    // max_lines; '[' in the text starts a new line and "\[" stands for '['
+    void Layout(const char *text, int max_width, int font, size_t max_lines);
+
+    // Gets the unescaped text which the lines refer to
+    inline const char *GetText() const { return &_text.front(); }
+    inline size_t GetLineCount() const { return _lines.size(); }
+    inline const TextLine &GetLine(size_t index) const { return _lines[index]; }
+    // Tells if the text did not fit into the allowed number of lines
+    inline bool IsTruncated() const { return _truncated; }
+
+private:
+    // Tells if the line, starting at given position and ending at the
+    // given character inclusive, is too wide
+    bool IsTooWide(size_t start, size_t end, int max_width, int font);
+
+    std::vector<char>     _text;
+    std::vector<TextLine> _lines;
+    bool                  _truncated;
+};
+
+} // namespace Common
+} // namespace AGS
+
+// Gets the layout of the text, reusing the one made recently for the same
+// text and parameters; the reference is valid until the next call
+const AGS::Common::TextLayout &get_text_layout(const char *text, int max_width, int font, size_t max_lines);
+// Removes all the cached layouts, after the fonts are changed
+void clear_text_layout_cache();
+
+#endif // __AGS_CN_FONT__TEXTLAYOUT_H
@@ -17,6 +17,7 @@
 #endif
 
 #include <stdio.h>
+#include <vector>
 #include "alfont.h"
 #include "ac/gamestructdefines.h" //FONT_OUTLINE_AUTO
 #include "core/assetmanager.h"
@@ -26,6 +27,7 @@
 #include "util/string.h"
 
 using AGS::Common::AssetManager;
+using AGS::Common::GlyphCache;
 using AGS::Common::Stream;
 using AGS::Common::String;
 
@@ -60,14 +62,77 @@ void TTFFontRenderer::EnsureTextValidForFont(char *text, int fontNumber)
   // do nothing, TTF can handle all characters
 }
 
+// Draws the single character with the font library and stores the drawn
+// pixels in the cache, with their coverage if anti-aliased
+static void CacheGlyph(GlyphCache &cache, ALFONT_FONT *alfont, unsigned char ch, bool anti_alias)
+{
+  const char text[2] = { (char)ch, 0 };
+  const int advance = alfont_text_length(alfont, text);
+  const int height = alfont_text_height(alfont);
+  // leave enough room for the parts of the glyph outside of its box
+  const int pad = height;
+  const int width = advance + pad * 2;
+  const int full_height = height + pad * 2;
+  std::vector<uint8_t> pixels(width * full_height);
+
+  BITMAP *scratch = create_bitmap_ex(anti_alias ? 32 : 8, width, full_height);
+  if (anti_alias)
+  {
+    // the blender writes the alpha into the pixels drawn over the mask
+    // colour; solid pixels are written as they are, with zero alpha
+    clear_to_color(scratch, bitmap_mask_color(scratch));
+    alfont_textout_aa(scratch, alfont, text, pad, pad, 0xFFFFFF);
+    for (int py = 0; py < full_height; ++py)
+    {
+      const uint32_t *line = (const uint32_t*)scratch->line[py];
+      for (int px = 0; px < width; ++px)
+      {
+        if ((line[px] & 0xFFFFFF) == MASK_COLOR_32)
+          continue;
+        const int alpha = line[px] >> 24;
+        pixels[py * width + px] = alpha > 0 ? alpha : 255;
+      }
+    }
+  }
+  else
+  {
+    clear_to_color(scratch, 0);
+    alfont_textout(scratch, alfont, text, pad, pad, 1);
+    for (int py = 0; py < full_height; ++py)
+      memcpy(&pixels[py * width], scratch->line[py], width);
+  }
+  destroy_bitmap(scratch);
+
+  cache.BeginGlyph(ch, advance, height);
+  cache.AddImage(-pad, -pad, width, full_height, &pixels.front(), width, anti_alias);
+}
+
+GlyphCache *TTFFontRenderer::GetGlyphs(FontData &font, const char *text, bool anti_alias)
+{
+  // the glyphs are cached for single byte characters only
+  if (get_uformat() != U_ASCII)
+    return NULL;
+  GlyphCache &cache = anti_alias ? font.AAGlyphs : font.MonoGlyphs;
+  for (const char *ch = text; *ch; ++ch)
+  {
+    if (!cache.HasGlyph(*ch))
+      CacheGlyph(cache, font.AlFont, *ch, anti_alias);
+  }
+  return &cache;
+}
+
 int TTFFontRenderer::GetTextWidth(const char *text, int fontNumber)
 {
-  return alfont_text_length(_fontData[fontNumber].AlFont, text);
+  FontData &font = _fontData[fontNumber];
+  GlyphCache *glyphs = GetGlyphs(font, text, ShouldAntiAliasText());
+  if (glyphs)
+    return glyphs->GetTextWidth(text);
+  return alfont_text_length(font.AlFont, text);
 }
 
 int TTFFontRenderer::GetTextHeight(const char *text, int fontNumber)
 {
-  return alfont_text_height(_fontData[fontNumber].AlFont);
+  return _fontData[fontNumber].Height;
 }
 
 void TTFFontRenderer::RenderText(const char *text, int fontNumber, BITMAP *destination, int x, int y, int colour)
@@ -75,11 +140,42 @@ void TTFFontRenderer::RenderText(const char *text, int fontNumber, BITMAP *desti
   if (y > destination->cb)  // optimisation
     return;
 
+  FontData &font = _fontData[fontNumber];
   // Y - 1 because it seems to get drawn down a bit
   if ((ShouldAntiAliasText()) && (bitmap_color_depth(destination) > 8))
-    alfont_textout_aa(destination, _fontData[fontNumber].AlFont, text, x, y - 1, colour);
+  {
+    GlyphCache *glyphs = is_memory_bitmap(destination) ? GetGlyphs(font, text, true) : NULL;
+    if (glyphs)
+      glyphs->DrawTextAntiAliased(destination, text, x, y - 1, colour);
+    else
+      alfont_textout_aa(destination, font.AlFont, text, x, y - 1, colour);
+  }
   else
-    alfont_textout(destination, _fontData[fontNumber].AlFont, text, x, y - 1, colour);
+  {
+    GlyphCache *glyphs = GetGlyphs(font, text, false);
+    if (glyphs)
+    {
+      // the font library always draws the plain text in solid mode
+      drawing_mode(DRAW_MODE_SOLID, NULL, 0, 0);
+      glyphs->DrawText(destination, text, x, y - 1, colour);
+    }
+    else
+      alfont_textout(destination, font.AlFont, text, x, y - 1, colour);
+  }
+}
+
+bool TTFFontRenderer::RenderTextOutlined(const char *text, int fontNumber, BITMAP *destination, int x, int y,
+                                         int colour, int outline_colour, int outline_dist)
+{
+  if (!is_memory_bitmap(destination))
+    return false;
+  const bool anti_alias = ShouldAntiAliasText() && (bitmap_color_depth(destination) > 8);
+  GlyphCache *glyphs = GetGlyphs(_fontData[fontNumber], text, anti_alias);
+  if (!glyphs)
+    return false;
+  // Y - 1 because it seems to get drawn down a bit
+  glyphs->DrawTextOutlined(destination, text, x, y - 1, colour, outline_colour, outline_dist, 1, anti_alias);
+  return true;
 }
 
 bool TTFFontRenderer::LoadFromDisk(int fontNumber, int fontSize)
@@ -127,8 +223,12 @@ bool TTFFontRenderer::LoadFromDiskEx(int fontNumber, int fontSize, const FontRen
   if (fontSize > 0)
     alfont_set_font_size(alfptr, fontSize);
 
-  _fontData[fontNumber].AlFont = alfptr;
-  _fontData[fontNumber].Params = params ? *params : FontRenderParams();
+  FontData &font = _fontData[fontNumber];
+  font.AlFont = alfptr;
+  font.Params = params ? *params : FontRenderParams();
+  font.Height = alfont_text_height(alfptr);
+  font.AAGlyphs.Clear();
+  font.MonoGlyphs.Clear();
   return true;
 }
 
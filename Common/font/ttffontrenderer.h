@@ -16,6 +16,7 @@
 #define __AC_TTFFONTRENDERER_H
 
 #include "font/agsfontrenderer.h"
+#include "font/glyphcache.h"
 
 #include <map>
 
@@ -36,13 +37,24 @@ public:
 
   // IAGSFontRenderer2 implementation
   virtual bool LoadFromDiskEx(int fontNumber, int fontSize, const FontRenderParams *params);
+  virtual bool RenderTextOutlined(const char *text, int fontNumber, BITMAP *destination, int x, int y,
+      int colour, int outline_colour, int outline_dist);
 
 private:
     struct FontData
     {
         ALFONT_FONT     *AlFont;
         FontRenderParams Params;
+        int              Height;
+        // glyphs rasterized by the font library, for both ways of drawing
+        AGS::Common::GlyphCache AAGlyphs;
+        AGS::Common::GlyphCache MonoGlyphs;
     };
+
+    // Gets the glyph cache with all the characters of the text rasterized,
+    // or NULL if the text has to be drawn by the font library directly
+    AGS::Common::GlyphCache *GetGlyphs(FontData &font, const char *text, bool anti_alias);
+
     std::map<int, FontData> _fontData;
 };
 
@@ -34,7 +34,31 @@ static unsigned char GetCharCode(unsigned char wanted_code, const WFNFont* font)
     return wanted_code < font->GetCharCount() ? wanted_code : '?';
 }
 
-static int RenderChar(Common::Bitmap *ds, const int at_x, const int at_y, const WFNChar &wfn_char, const color_t text_color);
+// Puts the pixels of every character code into the cache; the codes which
+// the font does not have are replaced with the question mark
+static void CacheGlyphs(GlyphCache &cache, const WFNFont *font)
+{
+  cache.Clear();
+  std::vector<uint8_t> pixels;
+  for (int code = 0; code < 256; ++code)
+  {
+    const WFNChar &wfn_char = font->GetChar(GetCharCode(code, font));
+    const int width = wfn_char.Width;
+    const int height = wfn_char.Height;
+    const int bytewid = wfn_char.GetRowByteCount();
+    pixels.assign(width * height + 1, 0);
+    for (int h = 0; h < height; ++h)
+    {
+      for (int w = 0; w < width; ++w)
+      {
+        if ((wfn_char.Data[h * bytewid + (w / 8)] & (0x80 >> (w % 8))) != 0)
+          pixels[h * width + w] = 1;
+      }
+    }
+    cache.BeginGlyph(code, width, height);
+    cache.AddImage(0, 0, width, height, &pixels.front(), width, false);
+  }
+}
 
 void WFNFontRenderer::AdjustYCoordinateForFont(int *ycoord, int fontNumber)
 {
@@ -56,78 +80,37 @@ void WFNFontRenderer::EnsureTextValidForFont(char *text, int fontNumber)
 
 int WFNFontRenderer::GetTextWidth(const char *text, int fontNumber)
 {
-  const WFNFont* font = _fontData[fontNumber].Font;
-  int text_width = 0;
-
-  for (; *text; ++text)
-  {
-    const WFNChar &wfn_char = font->GetChar(GetCharCode(*text, font));
-    text_width += wfn_char.Width;
-  }
-  return text_width * wtext_multiply;
+  return _fontData[fontNumber].Glyphs.GetTextWidth(text) * wtext_multiply;
 }
 
 int WFNFontRenderer::GetTextHeight(const char *text, int fontNumber)
 {
-  const WFNFont* font = _fontData[fontNumber].Font;
-  int max_height = 0;
-
-  for (; *text; ++text) 
-  {
-    const WFNChar &wfn_char = font->GetChar(GetCharCode(*text, font));
-    const uint16_t height = wfn_char.Height;
-    if (height > max_height)
-      max_height = height;
-  }
-  return max_height * wtext_multiply;
+  return _fontData[fontNumber].Glyphs.GetTextHeight(text) * wtext_multiply;
 }
 
-Common::Bitmap render_wrapper;
 void WFNFontRenderer::RenderText(const char *text, int fontNumber, BITMAP *destination, int x, int y, int colour)
 {
   int oldeip = get_our_eip();
   set_our_eip(415);
 
-  const WFNFont* font = _fontData[fontNumber].Font;
-  render_wrapper.WrapAllegroBitmap(destination, true);
-
-  for (; *text; ++text)
-    x += RenderChar(&render_wrapper, x, y, font->GetChar(GetCharCode(*text, font)), colour);
+  _fontData[fontNumber].Glyphs.DrawText(destination, text, x, y, colour, wtext_multiply);
 
   set_our_eip(oldeip);
 }
 
-int RenderChar(Common::Bitmap *ds, const int at_x, const int at_y, const WFNChar &wfn_char, const color_t text_color)
+bool WFNFontRenderer::RenderTextOutlined(const char *text, int fontNumber, BITMAP *destination, int x, int y,
+                                         int colour, int outline_colour, int outline_dist)
 {
-  const int width = wfn_char.Width;
-  const int height = wfn_char.Height;
-  const unsigned char *actdata = wfn_char.Data;
-  const int bytewid = wfn_char.GetRowByteCount();
-
-  int x = at_x;
-  int y = at_y;
-  for (int h = 0; h < height; ++h)
-  {
-    for (int w = 0; w < width; ++w)
-    {
-      if (((actdata[h * bytewid + (w / 8)] & (0x80 >> (w % 8))) != 0)) {
-        if (wtext_multiply > 1)
-        {
-          ds->FillRect(Rect(x + w, y + h, x + w + (wtext_multiply - 1),
-              y + h + (wtext_multiply - 1)), text_color);
-        } 
-        else
-        {
-          ds->PutPixel(x + w, y + h, text_color);
-        }
-      }
+  if (!is_memory_bitmap(destination))
+    return false;
 
-      x += wtext_multiply - 1;
-    }
-    y += wtext_multiply - 1;
-    x = at_x;
-  }
-  return width * wtext_multiply;
+  int oldeip = get_our_eip();
+  set_our_eip(415);
+
+  _fontData[fontNumber].Glyphs.DrawTextOutlined(destination, text, x, y, colour, outline_colour, outline_dist, wtext_multiply, false);
+
+  set_our_eip(oldeip);
+  return true;
 }
 
 bool WFNFontRenderer::LoadFromDisk(int fontNumber, int fontSize)
@@ -163,6 +146,7 @@ bool WFNFontRenderer::LoadFromDiskEx(int fontNumber, int fontSize, const FontRen
   }
   _fontData[fontNumber].Font = font;
   _fontData[fontNumber].Params = params ? *params : FontRenderParams();
+  CacheGlyphs(_fontData[fontNumber].Glyphs, font);
   return true;
 }
 
@@ -16,6 +16,7 @@
 #define __AC_WFNFONTRENDERER_H
 
 #include "font/agsfontrenderer.h"
+#include "font/glyphcache.h"
 #include "font/wfnfont.h"
 
 #include <map>
@@ -32,12 +33,16 @@ public:
   virtual void EnsureTextValidForFont(char *text, int fontNumber);
 
   virtual bool LoadFromDiskEx(int fontNumber, int fontSize, const FontRenderParams *params);
+  virtual bool RenderTextOutlined(const char *text, int fontNumber, BITMAP *destination, int x, int y,
+      int colour, int outline_colour, int outline_dist);
 
 private:
   struct FontData
   {
     WFNFont         *Font;
     FontRenderParams Params;
+    // all the characters, unpacked into spans of set pixels
+    AGS::Common::GlyphCache Glyphs;
   };
   std::map<int, FontData> _fontData;
 };
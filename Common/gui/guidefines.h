@@ -142,6 +142,8 @@ enum GUIControlType
 } // namespace Common
 } // namespace AGS
 
-extern int guis_need_update;
+// Marks every gui as changed; used when something that may be displayed on
+// any of them (score, inventory, location name, disabled state) was altered
+extern void mark_all_guis_changed();
 
 #endif // __AC_GUIDEFINES_H
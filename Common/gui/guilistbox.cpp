@@ -114,7 +114,7 @@ int GUIListBox::AddItem(const char *toadd)
   if (numItems >= MAX_LISTBOX_ITEMS)
     return -1;
 
-  guis_need_update = 1;
+  MarkChanged();
   items[numItems] = toadd;
   saveGameIndex[numItems] = -1;
   numItems++;
@@ -131,7 +131,7 @@ int GUIListBox::InsertItem(int index, const char *toadd)
   if ((index < 0) || (index > numItems))
     return -1;
 
-  guis_need_update = 1;
+  MarkChanged();
 
   for (aa = numItems; aa > index; aa--) {
     items[aa] = items[aa - 1];
@@ -153,7 +153,7 @@ void GUIListBox::SetItemText(int item, const char *newtext)
   if ((item >= numItems) || (item < 0))
     return;
 
-  guis_need_update = 1;
+  MarkChanged();
   items[item] = newtext;
 }
 
@@ -166,7 +166,7 @@ void GUIListBox::Clear()
   numItems = 0;
   selected = 0;
   topItem = 0;
-  guis_need_update = 1;
+  MarkChanged();
 }
 
 void GUIListBox::RemoveItem(int index)
@@ -187,7 +187,7 @@ void GUIListBox::RemoveItem(int index)
   if (selected >= numItems)
     selected = -1;
 
-  guis_need_update = 1;
+  MarkChanged();
 }
 
 void GUIListBox::Draw(Common::Bitmap *ds)
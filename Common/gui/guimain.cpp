@@ -35,7 +35,6 @@ using namespace AGS::Common;
 
 #define MOVER_MOUSEDOWNLOCKED -4000
 
-int guis_need_update = 1;
 int all_buttons_disabled = 0, gui_inv_pic = -1;
 int gui_disabled_style = 0;
 
@@ -86,6 +85,7 @@ void GUIMain::Init()
     OnClickHandler.Empty();
 
     ControlCount  = 0;
+    _hasChanged   = true;
 }
 
 int GUIMain::FindControlUnderMouse(int leeway, bool must_be_clickable) const
@@ -136,6 +136,18 @@ GUIControlType GUIMain::GetControlType(int index) const
     return (GUIControlType)((CtrlRefs[index] >> 16) & 0x0000ffff);
 }
 
+bool GUIMain::HasChanged() const
+{
+    if (_hasChanged)
+        return true;
+    for (int i = 0; i < ControlCount; ++i)
+    {
+        if (Controls[i]->HasChanged())
+            return true;
+    }
+    return false;
+}
+
 bool GUIMain::IsInteractableAt(int x, int y) const
 {
     if (!IsVisible())
@@ -157,6 +169,13 @@ bool GUIMain::BringControlToFront(int index)
     return SetControlZOrder(index, ControlCount - 1);
 }
 
+void GUIMain::ClearChanged()
+{
+    _hasChanged = false;
+    for (int i = 0; i < ControlCount; ++i)
+        Controls[i]->ClearChanged();
+}
+
 void GUIMain::Draw(Common::Bitmap *ds)
 {
     DrawAt(ds, X, Y);
@@ -249,6 +268,11 @@ void GUIMain::DrawBlob(Common::Bitmap *ds, int x, int y, color_t draw_color)
     ds->FillRect(Rect(x, y, x + get_fixed_pixel_size(1), y + get_fixed_pixel_size(1)), draw_color);
 }
 
+void GUIMain::MarkChanged()
+{
+    _hasChanged = true;
+}
+
 void GUIMain::Poll()
 {
     int mxwas = mousex, mywas = mousey;
@@ -282,7 +306,7 @@ void GUIMain::Poll()
                     Controls[MouseOverCtrl]->MouseMove(mousex, mousey);
                 }
             }
-            guis_need_update = 1;
+            MarkChanged();
         } 
         else if (MouseOverCtrl >= 0)
             Controls[MouseOverCtrl]->MouseMove(mousex, mousey);
@@ -388,6 +412,9 @@ void GUIMain::SetTransparencyAsPercentage(int percent)
 
 void GUIMain::SetVisibility(GUIVisibilityState visibility)
 {
+    // gui is not redrawn while hidden, so refresh it when it shows up again
+    if (visibility == kGUIVisibility_On && _visibility != kGUIVisibility_On)
+        _hasChanged = true;
     _visibility = visibility;
 }
 
@@ -412,7 +439,7 @@ void GUIMain::OnMouseButtonDown()
     if (Controls[MouseOverCtrl]->MouseDown())
         MouseOverCtrl = MOVER_MOUSEDOWNLOCKED;
     Controls[MouseDownCtrl]->MouseMove(mousex - X, mousey - Y);
-    guis_need_update = 1;
+    MarkChanged();
 }
 
 void GUIMain::OnMouseButtonUp()
@@ -430,7 +457,7 @@ void GUIMain::OnMouseButtonUp()
 
     Controls[MouseDownCtrl]->MouseUp();
     MouseDownCtrl = -1;
-    guis_need_update = 1;
+    MarkChanged();
 }
 
 void GUIMain::ReadFromFile(Stream *in, GuiVersion gui_version)
@@ -548,6 +575,13 @@ void GUIMain::WriteToFile(Stream *out, GuiVersion gui_version) const
 } // namespace AGS
 
 GuiVersion GameGuiVersion = kGuiVersion_Initial;
+
+void mark_all_guis_changed()
+{
+  for (size_t i = 0; i < guis.size(); ++i)
+    guis[i].MarkChanged();
+}
+
 void read_gui(Stream *in, std::vector<GUIMain> &guiread, GameSetupStruct * gss)
 {
   int ee;
@@ -659,9 +693,8 @@ void read_gui(Stream *in, std::vector<GUIMain> &guiread, GameSetupStruct * gss)
     }
 
     guiread[ee].ResortZOrder();
+    guiread[ee].MarkChanged();
   }
-
-  guis_need_update = 1;
 }
 
 void write_gui(Stream *out, const std::vector<GUIMain> &guiwrite, GameSetupStruct * gss, bool savedgame)
@@ -61,6 +61,9 @@ public:
 
     // Tells if the gui background supports alpha channel
     bool        HasAlphaChannel() const;
+    // Tells if the gui itself or any of its controls have changed since
+    // the gui was last drawn
+    bool        HasChanged() const;
     // Tells if gui is allowed to be displayed, but is currently hidden off-screen
     inline bool IsConcealed() const { return _visibility == kGUIVisibility_Concealed; }
     // Tells if given coordinates are within interactable area of gui
@@ -81,8 +84,12 @@ public:
 
     // Operations
     bool    BringControlToFront(int index);
+    // Resets changed state of the gui and its controls, after it was redrawn
+    void    ClearChanged();
     void    Draw(Bitmap *ds);
     void    DrawAt(Bitmap *ds, int x, int y);
+    // Marks the gui as changed, so that it is redrawn on the next update
+    void    MarkChanged();
     void    Poll();
     void    RebuildArray();
     void    ResortZOrder();
@@ -140,6 +147,7 @@ public:
 
 private:
     GUIVisibilityState _visibility;
+    bool               _hasChanged; // the gui needs to be redrawn
 };
 
 } // namespace Common
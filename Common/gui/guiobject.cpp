@@ -29,6 +29,7 @@ GUIObject::GUIObject()
   wid = hit = 0;
   zorder = 0;
   activated = 0;
+  hasChanged = true;
   init();
 }
 
@@ -113,10 +113,23 @@ struct GUIObject
      return (flags & GUIF_TRANSLATED) != 0;
   }
 
+  // Tells if the control's looks have changed since its gui was last drawn
+  bool HasChanged() const {
+    return hasChanged;
+  }
+  // Marks the control as changed, which makes its parent gui redraw itself
+  void MarkChanged() {
+    hasChanged = true;
+  }
+  void ClearChanged() {
+    hasChanged = false;
+  }
+
 protected:
   const char *supportedEvents[MAX_GUIOBJ_EVENTS];
   const char *supportedEventArgs[MAX_GUIOBJ_EVENTS];
   int numSupportedEvents;
+  bool hasChanged;
 };
 
 #endif // __AC_GUIOBJECT_H
@@ -192,6 +192,6 @@ void GUISlider::MouseMove(int xp, int yp)
   if (value < min)
     value = min;
 
-  guis_need_update = 1;
+  MarkChanged();
   activated = 1;
 }
@@ -14,6 +14,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "ac/common.h"	// quit()
 #include "ac/roomstruct.h"
 #include "util/compress.h"
@@ -28,7 +29,6 @@
 
 #include "util/misc.h"
 #include "util/stream.h"
-#include "util/filestream.h"
 #include "gfx/bitmap.h"
 
 using namespace AGS::Common;
@@ -204,9 +204,9 @@ int cunpackbitl(unsigned char *line, int size, Stream *in)
 
   while (n < size) {
     int ix = in->ReadByte();     // get index byte
-    // TODO: revise when new error handling system is implemented
-    if (ferror(((Common::FileStream*)in)->GetHandle()))
-      break;
+    // stream ended or failed to read
+    if (ix < 0)
+      return -1;
 
     char cx = ix;
     if (cx == -128)
@@ -234,8 +234,7 @@ int cunpackbitl(unsigned char *line, int size, Stream *in)
     }
   }
 
-  // TODO: revise when new error handling system is implemented
-  return ferror(((Common::FileStream*)in)->GetHandle());
+  return 0;
 }
 
 int cunpackbitl16(unsigned short *line, int size, Stream *in)
@@ -244,9 +243,9 @@ int cunpackbitl16(unsigned short *line, int size, Stream *in)
 
   while (n < size) {
     int ix = in->ReadByte();     // get index byte
-    // TODO: revise when new error handling system is implemented
-    if (ferror(((Common::FileStream*)in)->GetHandle()))
-      break;
+    // stream ended or failed to read
+    if (ix < 0)
+      return -1;
 
     char cx = ix;
     if (cx == -128)
@@ -274,8 +273,7 @@ int cunpackbitl16(unsigned short *line, int size, Stream *in)
     }
   }
 
-  // TODO: revise when new error handling system is implemented
-  return ferror(((Common::FileStream*)in)->GetHandle());
+  return 0;
 }
 
 int cunpackbitl32(unsigned int *line, int size, Stream *in)
@@ -284,9 +282,9 @@ int cunpackbitl32(unsigned int *line, int size, Stream *in)
 
   while (n < size) {
     int ix = in->ReadByte();     // get index byte
-    // TODO: revise when new error handling system is implemented
-    if (ferror(((Common::FileStream*)in)->GetHandle()))
-      break;
+    // stream ended or failed to read
+    if (ix < 0)
+      return -1;
 
     char cx = ix;
     if (cx == -128)
@@ -314,8 +312,115 @@ int cunpackbitl32(unsigned int *line, int size, Stream *in)
     }
   }
 
-  // TODO: revise when new error handling system is implemented
-  return ferror(((Common::FileStream*)in)->GetHandle());
+  return 0;
+}
+
+// Memory buffer versions of the RLE decoders; these read compressed data
+// starting at the src pointer, which is then advanced past the decoded line
+
+int cunpackbitl(unsigned char *line, int size, const unsigned char *&src, const unsigned char *src_end)
+{
+  int n = 0;                    // number of bytes decoded
+
+  while (n < size) {
+    if (src >= src_end)
+      return -1;
+    char cx = (char)*src++;     // get index byte
+    if (cx == -128)
+      cx = 0;
+
+    if (cx < 0) {                //.............run
+      int i = 1 - cx;
+      if (src >= src_end || n + i > size)
+        return -1;
+      memset(line + n, *src++, i);
+      n += i;
+    } else {                     //.....................seq
+      int i = cx + 1;
+      if (src + i > src_end || n + i > size)
+        return -1;
+      memcpy(line + n, src, i);
+      src += i;
+      n += i;
+    }
+  }
+  return 0;
+}
+
+int cunpackbitl16(unsigned short *line, int size, const unsigned char *&src, const unsigned char *src_end)
+{
+  int n = 0;                    // number of pixels decoded
+
+  while (n < size) {
+    if (src >= src_end)
+      return -1;
+    char cx = (char)*src++;     // get index byte
+    if (cx == -128)
+      cx = 0;
+
+    if (cx < 0) {                //.............run
+      int i = 1 - cx;
+      if (src + sizeof(short) > src_end || n + i > size)
+        return -1;
+      int16_t ch;
+      memcpy(&ch, src, sizeof(ch));
+      src += sizeof(ch);
+      ch = BBOp::Int16FromLE(ch);
+      while (i--)
+        line[n++] = ch;
+    } else {                     //.....................seq
+      int i = cx + 1;
+      if (src + i * sizeof(short) > src_end || n + i > size)
+        return -1;
+      memcpy(line + n, src, i * sizeof(short));
+      src += i * sizeof(short);
+#if defined (BITBYTE_BIG_ENDIAN)
+      for (; i > 0; --i, ++n)
+        line[n] = BBOp::Int16FromLE(line[n]);
+#else
+      n += i;
+#endif
+    }
+  }
+  return 0;
+}
+
+int cunpackbitl32(unsigned int *line, int size, const unsigned char *&src, const unsigned char *src_end)
+{
+  int n = 0;                    // number of pixels decoded
+
+  while (n < size) {
+    if (src >= src_end)
+      return -1;
+    char cx = (char)*src++;     // get index byte
+    if (cx == -128)
+      cx = 0;
+
+    if (cx < 0) {                //.............run
+      int i = 1 - cx;
+      if (src + sizeof(int) > src_end || n + i > size)
+        return -1;
+      int32_t ch;
+      memcpy(&ch, src, sizeof(ch));
+      src += sizeof(ch);
+      ch = BBOp::Int32FromLE(ch);
+      while (i--)
+        line[n++] = ch;
+    } else {                     //.....................seq
+      int i = cx + 1;
+      if (src + i * sizeof(int) > src_end || n + i > size)
+        return -1;
+      memcpy(line + n, src, i * sizeof(int));
+      src += i * sizeof(int);
+#if defined (BITBYTE_BIG_ENDIAN)
+      for (; i > 0; --i, ++n)
+        line[n] = BBOp::Int32FromLE(line[n]);
+#else
+      n += i;
+#endif
+    }
+  }
+  return 0;
 }
 
 //=============================================================================
@@ -35,6 +35,11 @@ void cpackbitl32(unsigned int *line, int size, Common::Stream *out);
 int  cunpackbitl(unsigned char *line, int size, Common::Stream *in);
 int  cunpackbitl16(unsigned short *line, int size, Common::Stream *in);
 int  cunpackbitl32(unsigned int *line, int size, Common::Stream *in);
+// Decode scanline from the memory buffer, advancing src pointer;
+// return 0 on success and -1 if data is malformed
+int  cunpackbitl(unsigned char *line, int size, const unsigned char *&src, const unsigned char *src_end);
+int  cunpackbitl16(unsigned short *line, int size, const unsigned char *&src, const unsigned char *src_end);
+int  cunpackbitl32(unsigned int *line, int size, const unsigned char *&src, const unsigned char *src_end);
 
 //=============================================================================
 
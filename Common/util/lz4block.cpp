@@ -0,0 +1,217 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// The compressed block is a sequence of commands, each made of:
+//  - token byte: high 4 bits are literal count, low 4 bits are match length
+//    minus 4; value 15 means that the length continues in the next bytes,
+//    each adding up to 255, until the byte which is less than 255;
+//  - literal bytes;
+//  - 16-bit little-endian offset of the match back from the current position,
+//    followed by the rest of match length, if any.
+// The last command only has literals. As in the original format, last 5 bytes
+// are always literals, and the last match starts at least 12 bytes before end.
+//
+//=============================================================================
+
+#include <string.h>
+#include <vector>
+#include "util/lz4block.h"
+
+#define LZ4_MIN_MATCH       4
+#define LZ4_LAST_LITERALS   5
+#define LZ4_MATCH_LIMIT     12
+#define LZ4_MAX_OFFSET      65535
+#define LZ4_HASH_BITS       14
+
+inline uint32_t lz4_read32(const uint8_t *p)
+{
+    uint32_t val;
+    memcpy(&val, p, sizeof(val));
+    return val;
+}
+
+inline uint32_t lz4_hash(uint32_t val)
+{
+    return (val * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+// Writes extended length bytes; returns false if there's not enough space
+inline bool lz4_write_length(uint8_t *&op, const uint8_t *oend, size_t len)
+{
+    for (; len >= 255; len -= 255)
+    {
+        if (op >= oend)
+            return false;
+        *op++ = 255;
+    }
+    if (op >= oend)
+        return false;
+    *op++ = (uint8_t)len;
+    return true;
+}
+
+// Writes a command of literals, optionally followed by match
+static bool lz4_write_sequence(uint8_t *&op, const uint8_t *oend, const uint8_t *literals,
+                               size_t lit_len, size_t offset, size_t match_len)
+{
+    if (op >= oend)
+        return false;
+    uint8_t *token = op++;
+    *token = (uint8_t)((lit_len >= 15 ? 15 : lit_len) << 4);
+    if (lit_len >= 15 && !lz4_write_length(op, oend, lit_len - 15))
+        return false;
+    if ((size_t)(oend - op) < lit_len)
+        return false;
+    memcpy(op, literals, lit_len);
+    op += lit_len;
+
+    if (match_len == 0)
+        return true; // last literals
+    if (oend - op < 2)
+        return false;
+    *op++ = (uint8_t)(offset & 0xFF);
+    *op++ = (uint8_t)(offset >> 8);
+    match_len -= LZ4_MIN_MATCH;
+    *token |= (uint8_t)(match_len >= 15 ? 15 : match_len);
+    if (match_len >= 15 && !lz4_write_length(op, oend, match_len - 15))
+        return false;
+    return true;
+}
+
+size_t lz4block_compress_bound(size_t src_size)
+{
+    return src_size + src_size / 255 + 16;
+}
+
+size_t lz4block_compress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size)
+{
+    uint8_t *op = dst;
+    const uint8_t *oend = dst + dst_size;
+    size_t anchor = 0;
+
+    if (src_size > LZ4_MATCH_LIMIT)
+    {
+        // positions of the last seen 4-byte sequences, plus one (0 is none)
+        std::vector<uint32_t> table(1 << LZ4_HASH_BITS, 0);
+        const size_t ip_limit = src_size - LZ4_MATCH_LIMIT;
+        const size_t match_limit = src_size - LZ4_LAST_LITERALS;
+        size_t ip = 0;
+        while (ip <= ip_limit)
+        {
+            const uint32_t seq = lz4_read32(src + ip);
+            const uint32_t h = lz4_hash(seq);
+            const size_t last_pos = table[h];
+            table[h] = (uint32_t)ip + 1;
+            if (last_pos == 0)
+            {
+                ip++;
+                continue;
+            }
+            size_t ref = last_pos - 1;
+            if (ip - ref > LZ4_MAX_OFFSET || lz4_read32(src + ref) != seq)
+            {
+                ip++;
+                continue;
+            }
+            // extend the match backwards and forwards
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1])
+            {
+                ip--;
+                ref--;
+            }
+            size_t match_len = LZ4_MIN_MATCH;
+            while (ip + match_len < match_limit && src[ip + match_len] == src[ref + match_len])
+                match_len++;
+
+            if (!lz4_write_sequence(op, oend, src + anchor, ip - anchor, ip - ref, match_len))
+                return 0;
+            ip += match_len;
+            anchor = ip;
+        }
+    }
+
+    if (!lz4_write_sequence(op, oend, src + anchor, src_size - anchor, 0, 0))
+        return 0;
+    return op - dst;
+}
+
+int lz4block_decompress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size)
+{
+    const uint8_t *ip = src;
+    const uint8_t *iend = src + src_size;
+    uint8_t *op = dst;
+    const uint8_t *oend = dst + dst_size;
+
+    while (ip < iend)
+    {
+        const uint8_t token = *ip++;
+        size_t lit_len = token >> 4;
+        if (lit_len == 15)
+        {
+            uint8_t b;
+            do
+            {
+                if (ip >= iend)
+                    return -1;
+                b = *ip++;
+                lit_len += b;
+            }
+            while (b == 255);
+        }
+        if ((size_t)(iend - ip) < lit_len || (size_t)(oend - op) < lit_len)
+            return -1;
+        memcpy(op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+        if (ip >= iend)
+            break; // last literals
+
+        if (iend - ip < 2)
+            return -1;
+        const size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst))
+            return -1;
+        size_t match_len = token & 0xF;
+        if (match_len == 15)
+        {
+            uint8_t b;
+            do
+            {
+                if (ip >= iend)
+                    return -1;
+                b = *ip++;
+                match_len += b;
+            }
+            while (b == 255);
+        }
+        match_len += LZ4_MIN_MATCH;
+        if ((size_t)(oend - op) < match_len)
+            return -1;
+
+        const uint8_t *match = op - offset;
+        if (offset >= match_len)
+        {
+            memcpy(op, match, match_len);
+            op += match_len;
+        }
+        else
+        {
+            // overlapping copy repeats the last bytes
+            for (; match_len > 0; --match_len)
+                *op++ = *match++;
+        }
+    }
+    return (int)(op - dst);
+}
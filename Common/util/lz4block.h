@@ -0,0 +1,33 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Compression in the LZ4 block format: a byte-oriented LZ77 variant, which
+// trades some of the compression ratio for the very fast decoding.
+//
+//=============================================================================
+#ifndef __AGS_CN_UTIL__LZ4BLOCK_H
+#define __AGS_CN_UTIL__LZ4BLOCK_H
+
+#include "core/types.h"
+
+// Returns maximal size of compressed data for the given input size
+size_t lz4block_compress_bound(size_t src_size);
+// Compresses data into the dst buffer; returns compressed size,
+// or 0 if the buffer is not large enough
+size_t lz4block_compress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size);
+// Decompresses data into the dst buffer; returns decompressed size,
+// or -1 if the data is malformed or does not fit into the buffer
+int    lz4block_decompress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size);
+
+#endif // __AGS_CN_UTIL__LZ4BLOCK_H
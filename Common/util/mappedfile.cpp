@@ -0,0 +1,145 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#if defined (LINUX_VERSION)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "util/mappedfile.h"
+
+namespace AGS
+{
+namespace Common
+{
+
+MappedFile::MappedFile()
+    : _data(NULL)
+    , _size(0)
+    , _modTime(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::IsSupported()
+{
+#if defined (LINUX_VERSION)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool MappedFile::Open(const String &filename)
+{
+    Close();
+#if defined (LINUX_VERSION)
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+    _fileName = filename;
+    _data = (const uint8_t*)data;
+    _size = st.st_size;
+    _modTime = st.st_mtime;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void MappedFile::Close()
+{
+#if defined (LINUX_VERSION)
+    if (_data)
+    {
+        munmap((void*)_data, _size);
+    }
+#endif
+    _fileName.Empty();
+    _data = NULL;
+    _size = 0;
+    _modTime = 0;
+}
+
+bool MappedFile::IsModified() const
+{
+#if defined (LINUX_VERSION)
+    struct stat st;
+    if (stat(_fileName, &st) != 0)
+    {
+        return true;
+    }
+    return (size_t)st.st_size != _size || st.st_mtime != _modTime;
+#else
+    return true;
+#endif
+}
+
+
+MappedFileStream::MappedFileStream(PMappedFile file, size_t offset, size_t size)
+    : MemoryStream(file->GetData() + offset, size)
+    , _file(file)
+    , _offset(offset)
+{
+}
+
+void MappedFileStream::Close()
+{
+    MemoryStream::Close();
+    _file.reset();
+    _offset = 0;
+}
+
+size_t MappedFileStream::GetLength() const
+{
+    return _offset + _len;
+}
+
+size_t MappedFileStream::GetPosition() const
+{
+    return _offset + _pos;
+}
+
+size_t MappedFileStream::Seek(int offset, StreamSeek origin)
+{
+    if (origin == kSeekBegin)
+    {
+        offset -= (int)_offset;
+    }
+    size_t pos = MemoryStream::Seek(offset, origin);
+    return pos == (size_t)-1 ? pos : _offset + pos;
+}
+
+} // namespace Common
+} // namespace AGS
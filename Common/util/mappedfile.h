@@ -0,0 +1,95 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// MappedFile maps a whole file into the memory for reading; this is only
+// supported on Linux, elsewhere Open always fails and callers should fall
+// back to reading the file with a FileStream.
+//
+// MappedFileStream reads a subsection of the mapped file, e.g. one asset in
+// the game data library, directly from the mapped memory. It keeps the file
+// mapped for as long as it exists. Stream positions are reported as offsets
+// from the beginning of the file, the same way as when reading the asset
+// with a FileStream, but the stream cannot seek or read outside of the
+// subsection.
+//
+//=============================================================================
+#ifndef __AGS_CN_UTIL__MAPPEDFILE_H
+#define __AGS_CN_UTIL__MAPPEDFILE_H
+
+#include <time.h>
+#include "util/stdtr1compat.h"
+#include TR1INCLUDE(memory)
+#include "util/memorystream.h"
+#include "util/string.h"
+
+namespace AGS
+{
+namespace Common
+{
+
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // Tells if memory mapping is supported on this platform
+    static bool     IsSupported();
+
+    bool            Open(const String &filename);
+    void            Close();
+    // Tells if the file on disk was changed since it was mapped; this
+    // stats the file, so should not be called every time it is read
+    bool            IsModified() const;
+
+    const String   &GetFileName() const { return _fileName; }
+    const uint8_t  *GetData() const { return _data; }
+    size_t          GetSize() const { return _size; }
+
+private:
+    // not copyable
+    MappedFile(const MappedFile &);
+    MappedFile &operator =(const MappedFile &);
+
+    String          _fileName;
+    const uint8_t  *_data;
+    size_t          _size;
+    time_t          _modTime;
+};
+
+typedef stdtr1compat::shared_ptr<MappedFile> PMappedFile;
+
+
+class MappedFileStream : public MemoryStream
+{
+public:
+    // Creates stream over the file subsection, positioned at its beginning
+    MappedFileStream(PMappedFile file, size_t offset, size_t size);
+
+    virtual void    Close();
+
+    virtual size_t  GetLength() const;
+    virtual size_t  GetPosition() const;
+
+    virtual size_t  Seek(int offset, StreamSeek origin);
+
+private:
+    PMappedFile     _file;
+    size_t          _offset;
+};
+
+} // namespace Common
+} // namespace AGS
+
+#endif // __AGS_CN_UTIL__MAPPEDFILE_H
@@ -0,0 +1,182 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#include <string.h>
+#include "util/memorystream.h"
+
+namespace AGS
+{
+namespace Common
+{
+
+MemoryStream::MemoryStream(const void *data, size_t len, DataEndianess stream_endianess)
+    : DataStream(stream_endianess)
+    , _data((const uint8_t*)data)
+    , _len(len)
+    , _pos(0)
+{
+}
+
+MemoryStream::~MemoryStream()
+{
+}
+
+void MemoryStream::Close()
+{
+    _data = NULL;
+    _len = 0;
+    _pos = 0;
+}
+
+bool MemoryStream::Flush()
+{
+    return true;
+}
+
+bool MemoryStream::IsValid() const
+{
+    return _data != NULL || CanWrite();
+}
+
+bool MemoryStream::EOS() const
+{
+    return _pos >= _len;
+}
+
+size_t MemoryStream::GetLength() const
+{
+    return _len;
+}
+
+size_t MemoryStream::GetPosition() const
+{
+    return _pos;
+}
+
+bool MemoryStream::CanRead() const
+{
+    return IsValid();
+}
+
+bool MemoryStream::CanWrite() const
+{
+    return false;
+}
+
+bool MemoryStream::CanSeek() const
+{
+    return IsValid();
+}
+
+size_t MemoryStream::Read(void *buffer, size_t size)
+{
+    if (EOS() || !buffer)
+    {
+        return 0;
+    }
+    size_t remain = _len - _pos;
+    if (size > remain)
+    {
+        size = remain;
+    }
+    memcpy(buffer, _data + _pos, size);
+    _pos += size;
+    return size;
+}
+
+int32_t MemoryStream::ReadByte()
+{
+    if (EOS())
+    {
+        return -1;
+    }
+    return _data[_pos++];
+}
+
+size_t MemoryStream::Write(const void *buffer, size_t size)
+{
+    return 0;
+}
+
+int32_t MemoryStream::WriteByte(uint8_t b)
+{
+    return -1;
+}
+
+size_t MemoryStream::Seek(int offset, StreamSeek origin)
+{
+    if (!CanSeek())
+    {
+        return -1;
+    }
+
+    int base;
+    switch (origin)
+    {
+    case kSeekBegin:    base = 0; break;
+    case kSeekCurrent:  base = _pos; break;
+    case kSeekEnd:      base = _len; break;
+    default:
+        return -1;
+    }
+    int pos = base + offset;
+    _pos = pos < 0 ? 0 : ((size_t)pos > _len ? _len : pos);
+    return _pos;
+}
+
+
+VectorStream::VectorStream(std::vector<uint8_t> &buf, DataEndianess stream_endianess)
+    : MemoryStream(buf.empty() ? NULL : &buf[0], buf.size(), stream_endianess)
+    , _vec(&buf)
+{
+}
+
+void VectorStream::Close()
+{
+    _vec = NULL;
+    MemoryStream::Close();
+}
+
+bool VectorStream::CanWrite() const
+{
+    return _vec != NULL;
+}
+
+size_t VectorStream::Write(const void *buffer, size_t size)
+{
+    if (!_vec || !buffer)
+    {
+        return 0;
+    }
+    if (_pos + size > _vec->size())
+    {
+        _vec->resize(_pos + size);
+    }
+    if (size > 0)
+    {
+        memcpy(&(*_vec)[_pos], buffer, size);
+    }
+    _pos += size;
+    _data = _vec->empty() ? NULL : &(*_vec)[0];
+    _len = _vec->size();
+    return size;
+}
+
+int32_t VectorStream::WriteByte(uint8_t b)
+{
+    return Write(&b, 1) == 1 ? b : -1;
+}
+
+} // namespace Common
+} // namespace AGS
@@ -70,98 +70,121 @@ char *ci_find_file(const char *dir_name, const char *file_name)
 }
 
 #else
+#include <map>
+#include "util/string_types.h"
+
+using AGS::Common::String;
+
+#if defined (MAC_VERSION) || defined (IOS_VERSION)
+#define STAT_MTIME_NSEC(st) ((st).st_mtimespec.tv_nsec)
+#else
+#define STAT_MTIME_NSEC(st) ((st).st_mtim.tv_nsec)
+#endif
+
+/* Cached list of the files in a directory, which lets find files ignoring
+   case without scanning the directory each time. The listing is rebuilt
+   when the directory modification time changes. */
+struct DirListing
+{
+  time_t mtime;
+  long   mtime_nsec;
+  AGS::Common::StringIMap files; /* any case name -> real name */
+};
+
+static std::map<String, DirListing> dir_listings;
+
+static DirListing *get_dir_listing(const String &directory)
+{
+  struct stat statbuf;
+  if (stat(directory, &statbuf) != 0) {
+    dir_listings.erase(directory);
+    return NULL;
+  }
+
+  std::map<String, DirListing>::iterator it = dir_listings.find(directory);
+  if (it != dir_listings.end() && it->second.mtime == statbuf.st_mtime &&
+      it->second.mtime_nsec == STAT_MTIME_NSEC(statbuf))
+    return &it->second;
+
+  DIR *rough = opendir(directory);
+  if (rough == NULL) {
+    fprintf(stderr, "ci_find_file: cannot open directory: %s\n", directory.GetCStr());
+    return NULL;
+  }
+
+  DirListing &listing = dir_listings[directory];
+  listing.mtime = statbuf.st_mtime;
+  listing.mtime_nsec = STAT_MTIME_NSEC(statbuf);
+  listing.files.clear();
+  struct dirent *entry;
+  while ((entry = readdir(rough)) != NULL) {
+    struct stat entrybuf;
+    String entry_path = String::FromFormat("%s/%s", directory.GetCStr(), entry->d_name);
+    if (lstat(entry_path, &entrybuf) != 0)
+      continue;
+    if (S_ISREG(entrybuf.st_mode) || S_ISLNK(entrybuf.st_mode)) {
+      /* keep the first of the names differing only in case, as the directory scan did */
+      listing.files.insert(std::make_pair(String(entry->d_name), String(entry->d_name)));
+    }
+  }
+  closedir(rough);
+  return &listing;
+}
+
 /* Case Insensitive File Find */
 char *ci_find_file(const char *dir_name, const char *file_name)
 {
-  struct stat   statbuf;
-  struct dirent *entry     = NULL;
-  DIR           *rough     = NULL;
-  DIR           *prevdir   = NULL;
-  char          *diamond   = NULL;
-  char          *directory = NULL;
-  char          *filename  = NULL;
+  String directory;
+  String filename;
 
   if (dir_name == NULL && file_name == NULL)
       return NULL;
 
   if (dir_name != NULL) {
-    directory = (char *)malloc(strlen(dir_name) + 1);
-    strcpy(directory, dir_name);
-
-    fix_filename_case(directory);
-    fix_filename_slashes(directory);
+    char *buf = strdup(dir_name);
+    fix_filename_case(buf);
+    fix_filename_slashes(buf);
+    directory = buf;
+    free(buf);
   }
 
   if (file_name != NULL) {
-    filename = (char *)malloc(strlen(file_name) + 1);
-    strcpy(filename, file_name);
-
-    fix_filename_case(filename);
-    fix_filename_slashes(filename);
+    char *buf = strdup(file_name);
+    fix_filename_case(buf);
+    fix_filename_slashes(buf);
+    filename = buf;
+    free(buf);
   }
 
-  if (directory == NULL) {
-    char  *match    = NULL;
-    int   match_len = 0;
-    int   dir_len   = 0;
-
-    match = get_filename(filename);
+  if (dir_name == NULL) {
+    const char *match = get_filename(filename);
     if (match == NULL)
       return NULL;
 
-    match_len = strlen(match);
-    dir_len   = (match - filename);
-
+    size_t dir_len = match - filename.GetCStr();
     if (dir_len == 0) {
-      directory = (char *)malloc(2);
-      strcpy(directory,".");
+      directory = ".";
     } else {
-      directory = (char *)malloc(dir_len + 1);
-      strncpy(directory, file_name, dir_len);
-      directory[dir_len] = '\0';
+      directory.SetString(file_name, dir_len);
     }
-
-    filename = (char *)malloc(match_len + 1);
-    strncpy(filename, match, match_len);
-    filename[match_len] = '\0';
+    filename = String(match);
   }
 
-  if ((prevdir = opendir(".")) == NULL) {
-    fprintf(stderr, "ci_find_file: cannot open current working directory\n");
+  DirListing *listing = get_dir_listing(directory);
+  if (listing == NULL)
     return NULL;
-  }
 
-  if (chdir(directory) == -1) {
-    fprintf(stderr, "ci_find_file: cannot change to directory: %s\n", directory);
-    return NULL;
-  }
-  
-  if ((rough = opendir(directory)) == NULL) {
-    fprintf(stderr, "ci_find_file: cannot open directory: %s\n", directory);
+  AGS::Common::StringIMap::const_iterator found = listing->files.find(filename);
+  if (found == listing->files.end())
     return NULL;
-  }
 
-  while ((entry = readdir(rough)) != NULL) {
-    lstat(entry->d_name, &statbuf);
-    if (S_ISREG(statbuf.st_mode) || S_ISLNK(statbuf.st_mode)) {
-      if (strcasecmp(filename, entry->d_name) == 0) {
 #ifdef _DEBUG
-        fprintf(stderr, "ci_find_file: Looked for %s in rough %s, found diamond %s.\n", filename, directory, entry->d_name);
+  fprintf(stderr, "ci_find_file: Looked for %s in rough %s, found diamond %s.\n",
+    filename.GetCStr(), directory.GetCStr(), found->second.GetCStr());
 #endif // _DEBUG
-        diamond = (char *)malloc(strlen(directory) + strlen(entry->d_name) + 2);
-        append_filename(diamond, directory, entry->d_name, strlen(directory) + strlen(entry->d_name) + 2);
-        break;
-      }
-    }
-  }
-  closedir(rough);
-
-  fchdir(dirfd(prevdir));
-  closedir(prevdir);
-
-  free(directory);
-  free(filename);
-
+  size_t diamond_len = directory.GetLength() + found->second.GetLength() + 2;
+  char *diamond = (char *)malloc(diamond_len);
+  append_filename(diamond, directory, found->second, diamond_len);
   return diamond;
 }
 #endif
@@ -1908,6 +1908,12 @@ builtin managed struct AudioClip {
   readonly import attribute bool IsAvailable;
   /// Gets the type of audio that this clip contains.
   readonly import attribute AudioType Type;
+#ifdef SCRIPT_API_v341
+  /// Reads this audio clip into memory in the background, so that it starts playing without delay.
+  import bool Preload();
+  /// Gets whether this audio clip is in memory, ready to start playing without delay.
+  readonly import attribute bool IsPreloaded;
+#endif
 };
 
 builtin struct System {
@@ -580,7 +580,8 @@ const char* save_sprites(bool compressSprites)
   char backupname[100];
   sprintf(backupname, "backup_%s", sprsetname);
 
-  if ((spritesModified) || (compressSprites != spriteset.spritesAreCompressed))
+  if ((spritesModified) || (compressSprites != spriteset.spritesAreCompressed) ||
+      (compressSprites && spriteset.spriteFileVersion < kSprfVersion_Codecs))
   {
     spriteset.detachFile();
     if (exists(backupname) && (unlink(backupname) != 0)) {
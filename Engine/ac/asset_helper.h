@@ -21,7 +21,8 @@
 #include <utility>
 #include "util/string.h"
 
-namespace AGS { namespace Common {class Stream;}}
+namespace AGS { namespace Common {class Stream; struct AssetLocation;}}
+using AGS::Common::AssetLocation;
 using AGS::Common::Stream;
 using AGS::Common::String;
 
@@ -43,10 +44,15 @@ typedef std::pair<String, String> AssetPath;
 // Returns the name of audio asset library, corresponding to the given bundling type
 AssetPath get_audio_clip_assetpath(int bundling_type, const String &filename);
 
+// Finds the file and the position of the asset's data
+bool LocateAsset(const AssetPath &path, AssetLocation &loc);
 // Creates PACKFILE stream from AGS asset.
 // This function is supposed to be used only when you have to create Allegro
 // object, passing PACKFILE stream to constructor.
 PACKFILE *PackfileFromAsset(const AssetPath &path);
+// Creates PACKFILE stream from the asset's data at the known location;
+// does not use the AssetManager, so may be called from any thread
+PACKFILE *PackfileFromLocation(const char *file_name, int offset, int size);
 // Creates DUMBFILE stream from AGS asset. Used for creating DUMB objects
 DUMBFILE *DUMBfileFromAsset(const AssetPath &path);
 bool DoesAssetExistInLib(const AssetPath &assetname);
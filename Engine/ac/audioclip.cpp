@@ -68,6 +68,16 @@ ScriptAudioChannel* AudioClip_PlayQueued(ScriptAudioClip *clip, int priority, in
     return sc_ch;
 }
 
+bool AudioClip_Preload(ScriptAudioClip *clip)
+{
+    return preload_audio_clip(clip);
+}
+
+bool AudioClip_GetIsPreloaded(ScriptAudioClip *clip)
+{
+    return is_audio_clip_preloaded(clip);
+}
+
 //=============================================================================
 //
 // Script API Functions
@@ -120,14 +130,28 @@ RuntimeScriptValue Sc_AudioClip_PlayQueued(void *self, const RuntimeScriptValue
     API_OBJCALL_OBJ_PINT2(ScriptAudioClip, ScriptAudioChannel, ccDynamicAudio, AudioClip_PlayQueued);
 }
 
+// bool | ScriptAudioClip *clip
+RuntimeScriptValue Sc_AudioClip_Preload(void *self, const RuntimeScriptValue *params, int32_t param_count)
+{
+    API_OBJCALL_BOOL(ScriptAudioClip, AudioClip_Preload);
+}
+
+// bool | ScriptAudioClip *clip
+RuntimeScriptValue Sc_AudioClip_GetIsPreloaded(void *self, const RuntimeScriptValue *params, int32_t param_count)
+{
+    API_OBJCALL_BOOL(ScriptAudioClip, AudioClip_GetIsPreloaded);
+}
+
 void RegisterAudioClipAPI()
 {
     ccAddExternalObjectFunction("AudioClip::Play^2",            Sc_AudioClip_Play);
     ccAddExternalObjectFunction("AudioClip::PlayFrom^3",        Sc_AudioClip_PlayFrom);
     ccAddExternalObjectFunction("AudioClip::PlayQueued^2",      Sc_AudioClip_PlayQueued);
+    ccAddExternalObjectFunction("AudioClip::Preload^0",         Sc_AudioClip_Preload);
     ccAddExternalObjectFunction("AudioClip::Stop^0",            Sc_AudioClip_Stop);
     ccAddExternalObjectFunction("AudioClip::get_FileType",      Sc_AudioClip_GetFileType);
     ccAddExternalObjectFunction("AudioClip::get_IsAvailable",   Sc_AudioClip_GetIsAvailable);
+    ccAddExternalObjectFunction("AudioClip::get_IsPreloaded",   Sc_AudioClip_GetIsPreloaded);
     ccAddExternalObjectFunction("AudioClip::get_Type",          Sc_AudioClip_GetType);
 
     /* ----------------------- Registering unsafe exports for plugins -----------------------*/
@@ -135,8 +159,10 @@ void RegisterAudioClipAPI()
     ccAddExternalFunctionForPlugin("AudioClip::Play^2",            (void*)AudioClip_Play);
     ccAddExternalFunctionForPlugin("AudioClip::PlayFrom^3",        (void*)AudioClip_PlayFrom);
     ccAddExternalFunctionForPlugin("AudioClip::PlayQueued^2",      (void*)AudioClip_PlayQueued);
+    ccAddExternalFunctionForPlugin("AudioClip::Preload^0",         (void*)AudioClip_Preload);
     ccAddExternalFunctionForPlugin("AudioClip::Stop^0",            (void*)AudioClip_Stop);
     ccAddExternalFunctionForPlugin("AudioClip::get_FileType",      (void*)AudioClip_GetFileType);
     ccAddExternalFunctionForPlugin("AudioClip::get_IsAvailable",   (void*)AudioClip_GetIsAvailable);
+    ccAddExternalFunctionForPlugin("AudioClip::get_IsPreloaded",   (void*)AudioClip_GetIsPreloaded);
     ccAddExternalFunctionForPlugin("AudioClip::get_Type",          (void*)AudioClip_GetType);
 }
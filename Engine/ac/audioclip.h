@@ -28,5 +28,7 @@ void    AudioClip_Stop(ScriptAudioClip *clip);
 ScriptAudioChannel* AudioClip_Play(ScriptAudioClip *clip, int priority, int repeat);
 ScriptAudioChannel* AudioClip_PlayFrom(ScriptAudioClip *clip, int position, int priority, int repeat);
 ScriptAudioChannel* AudioClip_PlayQueued(ScriptAudioClip *clip, int priority, int repeat);
+bool    AudioClip_Preload(ScriptAudioClip *clip);
+bool    AudioClip_GetIsPreloaded(ScriptAudioClip *clip);
 
 #endif // __AGS_EE_AC__AUDIOCLIP_H
@@ -39,7 +39,9 @@
 #include "ac/overlay.h"
 #include "ac/path.h"
 #include "ac/properties.h"
+#include "ac/roomindex.h"
 #include "ac/screenoverlay.h"
+#include "ac/spriteprefetch.h"
 #include "ac/string.h"
 #include "ac/system.h"
 #include "ac/viewframe.h"
@@ -53,6 +55,7 @@
 #include "ac/spritecache.h"
 #include "util/string_utils.h"
 #include <math.h>
+#include <vector>
 #include "gfx/graphicsdriver.h"
 #include "platform/base/override_defines.h"
 #include "script/runtimescriptvalue.h"
@@ -159,7 +162,7 @@ void Character_AddInventory(CharacterInfo *chaa, ScriptInvItem *invi, int addInd
         charextra[charid].invorder[addIndex] = inum;
     }
     charextra[charid].invorder_count++;
-    guis_need_update = 1;
+    mark_all_guis_changed();
     if (chaa == playerchar)
         run_on_event (GE_ADD_INV, RuntimeScriptValue().SetInt32(inum));
 
@@ -250,6 +253,7 @@ void Character_ChangeRoomSetLoop(CharacterInfo *chaa, int room, int x, int y, in
         }
         chaa->prevroom = chaa->room;
         chaa->room = room;
+        invalidate_room_characters();
 
 		debug_script_log("%s moved to room %d, location %d,%d, loop %d",
 			chaa->scrname, room, chaa->x, chaa->y, chaa->loop);
@@ -305,6 +309,8 @@ void Character_ChangeView(CharacterInfo *chap, int vii) {
     chap->walkwait = 0;
     charextra[chap->index_id].animwait = 0;
     FindReasonableLoopForCharacter(chap);
+    prefetch_view_loop(chap->view, chap->loop);
+    prefetch_view(chap->view);
 }
 
 enum DirectionalLoop
@@ -619,6 +625,8 @@ void Character_LockViewEx(CharacterInfo *chap, int vii, int stopMoving) {
     chap->view=vii;
     chap->animating=0;
     FindReasonableLoopForCharacter(chap);
+    prefetch_view_loop(chap->view, chap->loop);
+    prefetch_view(chap->view);
     chap->frame=0;
     chap->wait=0;
     chap->flags|=CHF_FIXVIEW;
@@ -730,7 +738,7 @@ void Character_LoseInventory(CharacterInfo *chap, ScriptInvItem *invi) {
             }
         }
     }
-    guis_need_update = 1;
+    mark_all_guis_changed();
 
     if (chap == playerchar)
         run_on_event (GE_LOSE_INV, RuntimeScriptValue().SetInt32(inum));
@@ -811,7 +819,10 @@ void Character_SetAsPlayer(CharacterInfo *chaa) {
     // the current room for 2.x. Following script calls to NewRoom() will
     // make sure this still works as intended.
     if ((loaded_game_file_version <= kGameVersion_272) && (playerchar->room < 0))
+    {
         playerchar->room = displayed_room;
+        invalidate_room_characters();
+    }
 
     if (displayed_room != playerchar->room)
         NewRoom(playerchar->room);
@@ -1107,7 +1118,7 @@ ScriptInvItem* Character_GetActiveInventory(CharacterInfo *chaa) {
 }
 
 void Character_SetActiveInventory(CharacterInfo *chaa, ScriptInvItem* iit) {
-    guis_need_update = 1;
+    mark_all_guis_changed();
 
     if (iit == NULL) {
         chaa->activeinv = -1;
@@ -1647,7 +1658,21 @@ int Character_GetSpeakingFrame(CharacterInfo *chaa) {
 // order of loops to turn character in circle from down to down
 int turnlooporder[8] = {0, 6, 1, 7, 3, 5, 2, 4};
 
-void walk_character(int chac,int tox,int toy,int ignwal, bool autoWalkAnims) {
+// State of the character's walk between stopping the previous move and
+// finding the route
+struct CharacterWalkState
+{
+    int  charX, charY;
+    int  tox, toy;
+    int  waitWas, animWaitWas;
+    bool needRoute;
+};
+
+// Stops the character's current move in preparation for the walk; tells
+// whether the route has to be found
+static bool begin_character_walk(const CharacterWalkRequest &req, CharacterWalkState &state) {
+    int chac = req.character;
+    int tox = req.x, toy = req.y;
     CharacterInfo*chin=&game.chars[chac];
     if (chin->room!=displayed_room)
         quit("!MoveCharacter: character not in current room");
@@ -1663,10 +1688,10 @@ void walk_character(int chac,int tox,int toy,int ignwal, bool autoWalkAnims) {
     if ((tox == charX) && (toy == charY)) {
         StopMoving(chac);
         debug_script_log("%s already at destination, not moving", chin->scrname);
-        return;
+        return false;
     }
 
-    if ((chin->animating) && (autoWalkAnims))
+    if ((chin->animating) && (req.autoWalkAnims))
         chin->animating = 0;
 
     if (chin->idleleft < 0) {
@@ -1691,6 +1716,21 @@ void walk_character(int chac,int tox,int toy,int ignwal, bool autoWalkAnims) {
     // are still displayed as such
     debug_script_log("%s: Start move to %d,%d", chin->scrname, toxPassedIn, toyPassedIn);
 
+    state.charX = charX;
+    state.charY = charY;
+    state.tox = tox;
+    state.toy = toy;
+    state.waitWas = waitWas;
+    state.animWaitWas = animWaitWas;
+    return true;
+}
+
+// Finds the route over the prepared blocking areas and starts the move
+static void finish_character_walk(const CharacterWalkRequest &req, const CharacterWalkState &state) {
+    int chac = req.character;
+    int ignwal = req.ignwal;
+    CharacterInfo*chin=&game.chars[chac];
+
     int move_speed_x = chin->walkspeed;
     int move_speed_y = chin->walkspeed;
 
@@ -1703,7 +1743,7 @@ void walk_character(int chac,int tox,int toy,int ignwal, bool autoWalkAnims) {
 
     set_route_move_speed(move_speed_x, move_speed_y);
     set_color_depth(8);
-    int mslot=find_route(charX, charY, tox, toy, prepare_walkable_areas(chac), chac+CHMLSOFFS, 1, ignwal);
+    int mslot=find_route(state.charX, state.charY, state.tox, state.toy, prepare_walkable_areas_for(chac), chac+CHMLSOFFS, 1, ignwal);
     set_color_depth(System_GetColorDepth());
     if (mslot>0) {
         chin->walking = mslot;
@@ -1718,10 +1758,10 @@ void walk_character(int chac,int tox,int toy,int ignwal, bool autoWalkAnims) {
         // or if they were already moving, keep the current wait - 
         // this prevents a glitch if MoveCharacter is called when they
         // are already moving
-        if (autoWalkAnims)
+        if (req.autoWalkAnims)
         {
-            chin->walkwait = waitWas;
-            charextra[chac].animwait = animWaitWas;
+            chin->walkwait = state.waitWas;
+            charextra[chac].animwait = state.animWaitWas;
 
             if (mls[mslot].pos[0] != mls[mslot].pos[1]) {
                 fix_player_sprite(&mls[mslot],chin);
@@ -1730,10 +1770,60 @@ void walk_character(int chac,int tox,int toy,int ignwal, bool autoWalkAnims) {
         else
             chin->flags |= CHF_MOVENOTWALK;
     }
-    else if (autoWalkAnims) // pathfinder couldn't get a route, stand them still
+    else if (req.autoWalkAnims) // pathfinder couldn't get a route, stand them still
         chin->frame = 0;
 }
 
+void walk_character(int chac,int tox,int toy,int ignwal, bool autoWalkAnims) {
+    CharacterWalkRequest req;
+    req.character = chac;
+    req.x = tox;
+    req.y = toy;
+    req.ignwal = ignwal;
+    req.autoWalkAnims = autoWalkAnims;
+    walk_characters(&req, 1);
+}
+
+void walk_characters(const CharacterWalkRequest *requests, int count) {
+    std::vector<CharacterWalkState> states(count);
+    int num_routes = 0;
+    // stop all of them first, so that the blocking areas are only updated
+    // once, at their final positions
+    for (int i = 0; i < count; i++) {
+        states[i].needRoute = begin_character_walk(requests[i], states[i]);
+        if (states[i].needRoute)
+            num_routes++;
+    }
+    if (num_routes == 0)
+        return;
+
+    update_blocking_areas();
+    for (int i = 0; i < count; i++) {
+        if (states[i].needRoute)
+            finish_character_walk(requests[i], states[i]);
+    }
+}
+
+// Walks requested during the characters update, started all at once after it
+static std::vector<CharacterWalkRequest> queued_walks;
+
+void queue_character_walk(int chac,int tox,int toy,int ignwal, bool autoWalkAnims) {
+    CharacterWalkRequest req;
+    req.character = chac;
+    req.x = tox;
+    req.y = toy;
+    req.ignwal = ignwal;
+    req.autoWalkAnims = autoWalkAnims;
+    queued_walks.push_back(req);
+}
+
+void walk_queued_characters() {
+    if (queued_walks.empty())
+        return;
+    walk_characters(&queued_walks[0], (int)queued_walks.size());
+    queued_walks.clear();
+}
+
 int find_looporder_index (int curloop) {
     int rr;
     for (rr = 0; rr < 8; rr++) {
@@ -1846,7 +1936,9 @@ int has_hit_another_character(int sourceChar) {
     if (game.chars[sourceChar].flags & CHF_NOBLOCKING)
         return -1;
 
-    for (int ww = 0; ww < game.numcharacters; ww++) {
+    const std::vector<int> &room_chars = get_room_characters();
+    for (size_t i = 0; i < room_chars.size(); i++) {
+        int ww = room_chars[i];
         if (game.chars[ww].on != 1) continue;
         if (game.chars[ww].room != displayed_room) continue;
         if (ww == sourceChar) continue;
@@ -2183,37 +2275,51 @@ CharacterInfo *GetCharacterAtLocation(int xx, int yy) {
 }
 
 extern int char_lowest_yp, obj_lowest_yp;
+// Characters found at the tested location, kept between calls
+static std::vector<int> pos_test_chars;
+
+bool get_char_interaction_rect(int charid, int *x1, int *y1, int *width, int *height) {
+    CharacterInfo*chin=&game.chars[charid];
+    if ((chin->view < 0) || 
+        (chin->loop >= views[chin->view].numLoops) ||
+        (chin->frame >= views[chin->view].loops[chin->loop].numFrames))
+    {
+        return false;
+    }
+
+    int sppic=views[chin->view].loops[chin->loop].frames[chin->frame].pic;
+    int usewid = charextra[charid].width;
+    int usehit = charextra[charid].height;
+    if (usewid==0) usewid=spritewidth[sppic];
+    if (usehit==0) usehit=spriteheight[sppic];
+    *width = divide_down_coordinate(usewid);
+    *height = divide_down_coordinate(usehit);
+    *x1 = chin->x - *width / 2;
+    *y1 = chin->get_effective_y() - *height;
+    return true;
+}
 
 int is_pos_on_character(int xx,int yy) {
-    int cc,sppic,lowestyp=0,lowestwas=-1;
-    for (cc=0;cc<game.numcharacters;cc++) {
+    int lowestyp=0,lowestwas=-1;
+    // only test the characters whose box contains the location
+    find_room_characters_at(xx, yy, pos_test_chars);
+    for (size_t i = 0; i < pos_test_chars.size(); ++i) {
+        int cc = pos_test_chars[i];
         if (game.chars[cc].room!=displayed_room) continue;
         if (game.chars[cc].on==0) continue;
         if (game.chars[cc].flags & CHF_NOINTERACT) continue;
         if (game.chars[cc].view < 0) continue;
         CharacterInfo*chin=&game.chars[cc];
 
-        if ((chin->view < 0) || 
-            (chin->loop >= views[chin->view].numLoops) ||
-            (chin->frame >= views[chin->view].loops[chin->loop].numFrames))
-        {
+        int xxx, yyy, usewid, usehit;
+        if (!get_char_interaction_rect(cc, &xxx, &yyy, &usewid, &usehit))
             continue;
-        }
-
-        sppic=views[chin->view].loops[chin->loop].frames[chin->frame].pic;
-        int usewid = charextra[cc].width;
-        int usehit = charextra[cc].height;
-        if (usewid==0) usewid=spritewidth[sppic];
-        if (usehit==0) usehit=spriteheight[sppic];
-        int xxx = chin->x - divide_down_coordinate(usewid) / 2;
-        int yyy = chin->get_effective_y() - divide_down_coordinate(usehit);
 
         int mirrored = views[chin->view].loops[chin->loop].frames[chin->frame].flags & VFLG_FLIPSPRITE;
         Bitmap *theImage = GetCharacterImage(cc, &mirrored);
 
         if (is_pos_in_sprite(xx,yy,xxx,yyy, theImage,
-            divide_down_coordinate(usewid),
-            divide_down_coordinate(usehit), mirrored) == FALSE)
+            usewid, usehit, mirrored) == FALSE)
             continue;
 
         int use_base = chin->get_baseline();
@@ -159,8 +159,23 @@ struct MoveList;
 namespace AGS { namespace Common { class Bitmap; } }
 using namespace AGS; // FIXME later
 
+// Request to walk the character to the given room location
+struct CharacterWalkRequest
+{
+    int  character;
+    int  x, y;
+    int  ignwal;
+    bool autoWalkAnims;
+};
+
 void animate_character(CharacterInfo *chap, int loopn,int sppd,int rept, int noidleoverride, int direction);
 void walk_character(int chac,int tox,int toy,int ignwal, bool autoWalkAnims);
+// Starts several characters walking at once; the pathfinder's blocking
+// areas are updated a single time for all of their routes
+void walk_characters(const CharacterWalkRequest *requests, int count);
+// Adds the walk to the ones started together by walk_queued_characters
+void queue_character_walk(int chac,int tox,int toy,int ignwal, bool autoWalkAnims);
+void walk_queued_characters();
 int  find_looporder_index (int curloop);
 // returns 0 to use diagonal, 1 to not
 int  useDiagonal (CharacterInfo *char1);
@@ -183,6 +198,9 @@ void animate_character(CharacterInfo *chap, int loopn,int sppd,int rept, int noi
 void CheckViewFrameForCharacter(CharacterInfo *chi);
 Common::Bitmap *GetCharacterImage(int charid, int *isFlipped);
 CharacterInfo *GetCharacterAtLocation(int xx, int yy);
+// Gets the box of the character's current frame tested for interaction,
+// in 320x200 co-ordinates; returns false if the frame is not valid
+bool get_char_interaction_rect(int charid, int *x1, int *y1, int *width, int *height);
 int is_pos_on_character(int xx,int yy);
 void get_char_blocking_rect(int charid, int *x1, int *y1, int *width, int *y2);
 // Check whether the source char has walked onto character ww
@@ -22,6 +22,7 @@
 #include "ac/gamestate.h"
 #include "ac/global_character.h"
 #include "ac/math.h"
+#include "ac/roomindex.h"
 #include "ac/viewframe.h"
 #include "debug/debug_log.h"
 #include "main/maindefines_ex.h"	// RETURN_CONTINUE
@@ -101,6 +102,8 @@ void CharacterInfo::UpdateFollowingExactlyCharacter()
 	x = game.chars[following].x;
     y = game.chars[following].y;
     z = game.chars[following].z;
+    if (room != game.chars[following].room)
+        invalidate_room_characters();
     room = game.chars[following].room;
     prevroom = game.chars[following].prevroom;
 
@@ -397,6 +400,7 @@ void CharacterInfo::update_character_follower(int &aa, int &numSheep, int *follo
         if (room == 0) {
           // appear in the new room
           room = game.chars[following].room;
+          invalidate_room_characters();
           x = play.entered_at_x;
           y = play.entered_at_y;
         }
@@ -410,6 +414,7 @@ void CharacterInfo::update_character_follower(int &aa, int &numSheep, int *follo
       else if (room != game.chars[following].room) {
         prevroom = room;
         room = game.chars[following].room;
+        invalidate_room_characters();
 
         if (room == displayed_room) {
           // only move to the room-entered position if coming into
@@ -453,7 +458,8 @@ void CharacterInfo::update_character_follower(int &aa, int &numSheep, int *follo
         // make sure he's not standing on top of the other man
         if (goxoffs < 0) goxoffs-=distaway;
         else goxoffs+=distaway;
-        walk_character(aa,game.chars[following].x + goxoffs,
+        // the followers which fell behind are walked together after the update
+        queue_character_walk(aa,game.chars[following].x + goxoffs,
           game.chars[following].y + (Random(50)-25),0, true);
         doing_nothing = 0;
       }
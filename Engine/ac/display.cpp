@@ -448,6 +448,10 @@ void wouttext_outline(Common::Bitmap *ds, int xxp, int yyp, int usingfont, color
         xxp += outlineDist;
         yyp += outlineDist;
 
+        // draw the outline and the text together, if the font can do that
+        if (wouttextxy_outlined(ds, xxp, yyp, usingfont, text_color, outline_color, outlineDist, texx))
+            return;
+
         wouttextxy(ds, xxp - outlineDist, yyp, usingfont, outline_color, texx);
         wouttextxy(ds, xxp + outlineDist, yyp, usingfont, outline_color, texx);
         wouttextxy(ds, xxp, yyp + outlineDist, usingfont, outline_color, texx);
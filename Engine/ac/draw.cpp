@@ -12,6 +12,8 @@
 //
 //=============================================================================
 
+#include <algorithm>
+#include <vector>
 #include "aastr.h"
 #include "ac/common.h"
 #include "util/compress.h"
@@ -32,12 +34,14 @@
 #include "ac/objectcache.h"
 #include "ac/overlay.h"
 #include "ac/record.h"
+#include "ac/roomindex.h"
 #include "ac/roomobject.h"
 #include "ac/roomstatus.h"
 #include "ac/roomstruct.h"
 #include "ac/runtime_defines.h"
 #include "ac/screenoverlay.h"
 #include "ac/spritelistentry.h"
+#include "ac/spritetransformcache.h"
 #include "ac/string.h"
 #include "ac/system.h"
 #include "ac/viewframe.h"
@@ -47,6 +51,7 @@
 #include "ac/dynobj/scriptsystem.h"
 #include "debug/debugger.h"
 #include "debug/debug_log.h"
+#include "debug/out.h"
 #include "font/fonts.h"
 #include "gui/guimain.h"
 #include "media/audio/audio.h"
@@ -59,6 +64,8 @@
 #include "gfx/graphicsdriver.h"
 #include "gfx/ali3dexception.h"
 #include "gfx/blender.h"
+#include "util/perf_timer.h"
+#include "util/workerpool.h"
 
 using namespace AGS::Common;
 using namespace AGS::Engine;
@@ -95,6 +102,7 @@ extern int spritewidth[MAX_SPRITES],spriteheight[MAX_SPRITES];
 extern SpriteCache spriteset;
 extern RoomStatus*croom;
 extern int our_eip;
+extern int frames_per_second;
 extern int in_new_room;
 extern RoomObject*objs;
 extern ViewStruct*views;
@@ -448,6 +456,9 @@ int _dirtyRowSize;
 InvalidRect dirtyRegions[MAXDIRTYREGIONS];
 int numDirtyRegions = 0;
 int numDirtyBytes = 0;
+// Graphics driver compares the sprites between the frames, and restores
+// the background under them itself
+bool dirtyRectsTracked = false;
 
 int IRSpan::mergeSpan(int tx1, int tx2) {
     if ((tx1 > x2) || (tx2 < x1))
@@ -544,12 +555,10 @@ void update_invalid_region(Bitmap *ds, int x, int y, Bitmap *src) {
 }
 
 
-void update_invalid_region_and_reset(Bitmap *ds, int x, int y, Bitmap *src) {
+void reset_invalid_region() {
 
     int i;
 
-    update_invalid_region(ds, x, y, src);
-
     // screen has been updated, no longer dirty
     numDirtyRegions = 0;
     numDirtyBytes = 0;
@@ -559,6 +568,38 @@ void update_invalid_region_and_reset(Bitmap *ds, int x, int y, Bitmap *src) {
 
 }
 
+void update_invalid_region_and_reset(Bitmap *ds, int x, int y, Bitmap *src) {
+
+    update_invalid_region(ds, x, y, src);
+    reset_invalid_region();
+}
+
+// passes the invalid region to the graphics driver, which will restore
+// the background there when the frame is rendered
+void flush_invalid_region_to_driver() {
+
+    if (numDirtyRegions == WHOLESCREENDIRTY) {
+        gfxDriver->InvalidateRect(RectWH(0, 0, play.viewport.GetWidth(), play.viewport.GetHeight()));
+    }
+    else if (numDirtyRegions > 0) {
+        int rowsInOne;
+        for (int i = 0; i < play.viewport.GetHeight(); i++) {
+            rowsInOne = 1;
+
+            // if there are rows with identical masks, pass them as one rect
+            while ((i+rowsInOne < play.viewport.GetHeight()) && (memcmp(&dirtyRow[i], &dirtyRow[i+rowsInOne], sizeof(IRRow)) == 0))
+                rowsInOne++;
+
+            const IRRow &dirty_row = dirtyRow[i];
+            for (int k = 0; k < dirty_row.numSpans; k++)
+                gfxDriver->InvalidateRect(Rect(dirty_row.span[k].x1, i, dirty_row.span[k].x2, i + rowsInOne - 1));
+
+            i += (rowsInOne - 1);
+        }
+    }
+    reset_invalid_region();
+}
+
 int combine_new_rect(InvalidRect *r1, InvalidRect *r2) {
 
     // check if new rect is within old rect X-wise
@@ -672,6 +713,9 @@ void invalidate_rect(int x1, int y1, int x2, int y2) {
 
 
 void invalidate_sprite(int x1, int y1, IDriverDependantBitmap *pic) {
+    // the driver finds the changed sprites itself
+    if (dirtyRectsTracked)
+        return;
     invalidate_rect(x1, y1, x1 + pic->GetWidth(), y1 + pic->GetHeight());
 }
 
@@ -879,6 +923,150 @@ void invalidate_cached_walkbehinds()
     memset(&actspswbcache[0], 0, sizeof(CachedActSpsData) * actSpsCount);
 }
 
+// Walk-behinds to cut out of the sprite, see sort_out_walk_behinds
+struct WalkBehindJob
+{
+    Bitmap *Sprite;
+    int     X;
+    int     Y;
+    int     Baseline;
+    Bitmap *CopyPixelsFrom;
+    Bitmap *CheckPixelsFrom;
+    int     Zoom;
+    int     PixelsChanged;
+};
+
+// Room object or character sprite, which walk-behinds are being cut out;
+// it is added to the sprite list when all the walk-behind jobs are done
+struct PreparedSprite
+{
+    int  Index;         // object or character number
+    int  ActspsIndex;
+    int  X;             // position on the room background
+    int  Y;
+    int  Baseline;
+    bool Intact;        // actsps has not changed since the last frame
+    int  WalkBehindJob; // index in walkBehindJobs, or -1
+    bool SeparateWalkBehind;
+    // Following are only used for characters
+    int  SpriteNum;
+    int  Width;
+    int  Height;
+    int  Mirrored;
+    int  TintRed, TintGreen, TintBlue, TintAmount, TintLight, LightLevel;
+};
+
+// The walk-behinds are cut out of all the sprites of the frame together,
+// on the drawing threads; anything else involving allegro or the graphics
+// driver stays on the main thread
+static WorkerPool drawWorkers;
+static std::vector<WalkBehindJob> walkBehindJobs;
+static std::vector<PreparedSprite> preparedSprites;
+
+// Time spent on preparing the room sprites, for the frame time display
+struct SpritePrepTiming
+{
+    int64_t TransformUs;    // constructing the sprites
+    int64_t WalkBehindsUs;  // cutting out the walk-behinds
+    int64_t FinishUs;       // creating the DDBs and adding to the sprite list
+    int64_t FrameUs;        // whole frame drawing
+    int     Sprites;
+    int     Frames;
+};
+static SpritePrepTiming prepTiming;
+static SpritePrepTiming prepTimingShown;
+
+void init_draw_workers(int numThreads)
+{
+    if (numThreads < 0)
+        numThreads = std::min(WorkerPool::GetProcessorCount() - 1, MAX_DRAW_THREADS);
+    if (numThreads > 0 && drawWorkers.Start(numThreads))
+        Debug::Printf(kDbgMsg_Init, "Drawing threads started: %d", drawWorkers.GetThreadCount());
+}
+
+void shutdown_draw_workers()
+{
+    drawWorkers.Stop();
+}
+
+// Walk-behind masking kernels, which process a whole row of the sprite;
+// each mask byte is either 0xFF or 0, so that the pixels are selected
+// without branching and the loops could be vectorized by the compiler.
+// They return non-zero if any pixel was cut.
+template <typename T>
+static int mask_row_clear(T *dst, const unsigned char *mask, int count, T maskcol)
+{
+    int changed = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        const T sel = (T)(signed char)mask[i];
+        dst[i] = (T)((dst[i] & ~sel) | (maskcol & sel));
+        changed |= mask[i];
+    }
+    return changed;
+}
+
+template <typename T>
+static int mask_row_copy(T *dst, const T *src, const T *check, const unsigned char *mask, int count, T maskcol)
+{
+    int changed = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        const T sel = (T)(signed char)mask[i] & ((T)0 - (T)(check[i] != maskcol));
+        dst[i] = (T)((dst[i] & ~sel) | (src[i] & sel));
+        changed |= (int)(sel & 1);
+    }
+    return changed;
+}
+
+// 24-bit pixels are selected by bytes
+static int mask_row_clear24(unsigned char *dst, const unsigned char *mask, int count, int maskcol)
+{
+    const unsigned char mc[3] = { (unsigned char)maskcol, (unsigned char)(maskcol >> 8), (unsigned char)(maskcol >> 16) };
+    int changed = 0;
+    for (int i = 0; i < count; ++i, dst += 3)
+    {
+        const unsigned char sel = mask[i];
+        dst[0] = (dst[0] & ~sel) | (mc[0] & sel);
+        dst[1] = (dst[1] & ~sel) | (mc[1] & sel);
+        dst[2] = (dst[2] & ~sel) | (mc[2] & sel);
+        changed |= sel;
+    }
+    return changed;
+}
+
+static int mask_row_copy24(unsigned char *dst, const unsigned char *src, const unsigned char *check,
+                           const unsigned char *mask, int count, int maskcol)
+{
+    const unsigned char mc[3] = { (unsigned char)maskcol, (unsigned char)(maskcol >> 8), (unsigned char)(maskcol >> 16) };
+    int changed = 0;
+    for (int i = 0; i < count; ++i, dst += 3, src += 3, check += 3)
+    {
+        const unsigned char sel = mask[i] &
+            (unsigned char)(0 - ((check[0] != mc[0]) | (check[1] != mc[1]) | (check[2] != mc[2])));
+        dst[0] = (dst[0] & ~sel) | (src[0] & sel);
+        dst[1] = (dst[1] & ~sel) | (src[1] & sel);
+        dst[2] = (dst[2] & ~sel) | (src[2] & sel);
+        changed |= sel;
+    }
+    return changed;
+}
+
+// Gathers the pixels of the scaled sprite row, which correspond to the
+// pixels of the walk-behind sprite
+template <typename T>
+static void gather_row(T *dst, const T *src, const int *cols, int count)
+{
+    for (int i = 0; i < count; ++i)
+        dst[i] = src[cols[i]];
+}
+
+static void gather_row24(unsigned char *dst, const unsigned char *src, const int *cols, int count)
+{
+    for (int i = 0; i < count; ++i, dst += 3)
+        memcpy(dst, &src[cols[i] * 3], 3);
+}
+
 // sort_out_walk_behinds: modifies the supplied sprite by overwriting parts
 // of it with transparent pixels where there are walk-behind areas
 // Returns whether any pixels were updated
@@ -890,120 +1078,194 @@ int sort_out_walk_behinds(Bitmap *sprit,int xx,int yy,int basel, Bitmap *copyPix
         (!sprit->IsMemoryBitmap()))
         quit("!sort_out_walk_behinds: wb bitmap not linear");
 
-    int rr,tmm, toheight;//,tcol;
-    // precalculate this to try and shave some time off
-    int maskcol = sprit->GetMaskColor();
-    int spcoldep = sprit->GetColorDepth();
-    int screenhit = thisroom.object->GetHeight();
-    short *shptr, *shptr2;
-    int *loptr, *loptr2;
-    int pixelsChanged = 0;
-    int ee = 0;
-    if (xx < 0)
-        ee = 0 - xx;
-
+    const int maskcol = sprit->GetMaskColor();
+    const int spcoldep = sprit->GetColorDepth();
     if ((checkPixelsFrom != NULL) && (checkPixelsFrom->GetColorDepth() != spcoldep))
         quit("sprite colour depth does not match background colour depth");
+    if (spcoldep > 32)
+        quit("!Sprite colour depth >32 ??");
+
+    // part of the sprite inside the room, in the room co-ordinates
+    const int left = std::max(xx, 0);
+    const int top = std::max(yy, 0);
+    const int right = std::min(xx + sprit->GetWidth(), thisroom.object->GetWidth());
+    const int bottom = std::min(yy + sprit->GetHeight(), thisroom.object->GetHeight());
+    if ((left >= right) || (top >= bottom))
+        return 0;
 
-    for ( ; ee < sprit->GetWidth(); ee++) {
-        if (ee + xx >= thisroom.object->GetWidth())
-            break;
-
-        if ((!walkBehindExists[ee+xx]) ||
-            (walkBehindEndY[ee+xx] <= yy) ||
-            (walkBehindStartY[ee+xx] > yy+sprit->GetHeight()))
+    // find the walk-behinds in front of the sprite
+    const WalkBehindMask *masks[MAX_OBJ];
+    int numMasks = 0;
+    for (int wb = 1; wb < MAX_OBJ; wb++)
+    {
+        const WalkBehindMask &mask = get_walk_behind_mask(wb);
+        if ((mask.Width == 0) || (croom->walkbehind_base[wb] <= basel))
+            continue;
+        if ((mask.Left >= right) || (mask.Left + mask.Width <= left) ||
+            (mask.Top >= bottom) || (mask.Top + mask.Height <= top))
             continue;
+        masks[numMasks++] = &mask;
+    }
+    if (numMasks == 0)
+        return 0;
+
+    const int bpp = (spcoldep + 7) / 8;
+    // the walk-behinds overlapping on a row are merged into this one
+    std::vector<unsigned char> rowMask;
+    if (numMasks > 1)
+        rowMask.resize(right - left);
+    // scaled sprite's columns, and the row gathered from them
+    std::vector<int> checkCols;
+    std::vector<unsigned char> checkRow;
+    if ((copyPixelsFrom != NULL) && (zoom != 100))
+    {
+        checkCols.resize(right - left);
+        for (int ee = left; ee < right; ee++)
+            checkCols[ee - left] = ((ee - xx) * 100) / zoom;
+        checkRow.resize((right - left) * bpp);
+    }
 
-        toheight = sprit->GetHeight();
+    int pixelsChanged = 0;
+    for (int ry = top; ry < bottom; ry++)
+    {
+        // span of the row covered by the walk-behinds
+        const WalkBehindMask *rowMasks[MAX_OBJ];
+        int numRowMasks = 0;
+        int x1 = right, x2 = left;
+        for (int i = 0; i < numMasks; i++)
+        {
+            const WalkBehindMask &wbm = *masks[i];
+            if ((ry < wbm.Top) || (ry >= wbm.Top + wbm.Height))
+                continue;
+            rowMasks[numRowMasks++] = &wbm;
+            x1 = std::min(x1, std::max(left, wbm.Left));
+            x2 = std::max(x2, std::min(right, wbm.Left + wbm.Width));
+        }
+        if (numRowMasks == 0)
+            continue;
 
-        if (walkBehindStartY[ee+xx] < yy)
-            rr = 0;
+        const unsigned char *mask;
+        if (numRowMasks == 1)
+        {
+            mask = rowMasks[0]->GetRow(ry) + (x1 - rowMasks[0]->Left);
+        }
         else
-            rr = (walkBehindStartY[ee+xx] - yy);
-
-        // Since we will use _getpixel, ensure we only check within the screen
-        if (rr + yy < 0)
-            rr = 0 - yy;
-        if (toheight + yy > screenhit)
-            toheight = screenhit - yy;
-        if (toheight + yy > walkBehindEndY[ee+xx])
-            toheight = walkBehindEndY[ee+xx] - yy;
-        if (rr < 0)
-            rr = 0;
-
-        for ( ; rr < toheight;rr++) {
-
-            // we're ok with _getpixel because we've checked the screen edges
-            //tmm = _getpixel(thisroom.object,ee+xx,rr+yy);
-            // actually, _getpixel is well inefficient, do it ourselves
-            // since we know it's 8-bit bitmap
-            tmm = thisroom.object->GetScanLine(rr+yy)[ee+xx];
-            if (tmm<1) continue;
-            if (croom->walkbehind_base[tmm] <= basel) continue;
-
-            if (copyPixelsFrom != NULL)
+        {
+            // merge the overlapping walk-behinds
+            unsigned char *merged = &rowMask[x1 - left];
+            memset(merged, 0, x2 - x1);
+            for (int i = 0; i < numRowMasks; i++)
             {
-                if (spcoldep <= 8)
-                {
-                    if (checkPixelsFrom->GetScanLine((rr * 100) / zoom)[(ee * 100) / zoom] != maskcol) {
-                        sprit->GetScanLineForWriting(rr)[ee] = copyPixelsFrom->GetScanLine(rr + yy)[ee + xx];
-                        pixelsChanged = 1;
-                    }
-                }
-                else if (spcoldep <= 16) {
-                    shptr = (short*)&sprit->GetScanLine(rr)[0];
-                    shptr2 = (short*)&checkPixelsFrom->GetScanLine((rr * 100) / zoom)[0];
-                    if (shptr2[(ee * 100) / zoom] != maskcol) {
-                        shptr[ee] = ((short*)(&copyPixelsFrom->GetScanLine(rr + yy)[0]))[ee + xx];
-                        pixelsChanged = 1;
-                    }
-                }
-                else if (spcoldep == 24) {
-                    char *chptr = (char*)&sprit->GetScanLine(rr)[0];
-                    char *chptr2 = (char*)&checkPixelsFrom->GetScanLine((rr * 100) / zoom)[0];
-                    if (memcmp(&chptr2[((ee * 100) / zoom) * 3], &maskcol, 3) != 0) {
-                        memcpy(&chptr[ee * 3], &copyPixelsFrom->GetScanLine(rr + yy)[(ee + xx) * 3], 3);
-                        pixelsChanged = 1;
-                    }
-                }
-                else if (spcoldep <= 32) {
-                    loptr = (int*)&sprit->GetScanLine(rr)[0];
-                    loptr2 = (int*)&checkPixelsFrom->GetScanLine((rr * 100) / zoom)[0];
-                    if (loptr2[(ee * 100) / zoom] != maskcol) {
-                        loptr[ee] = ((int*)(&copyPixelsFrom->GetScanLine(rr + yy)[0]))[ee + xx];
-                        pixelsChanged = 1;
-                    }
-                }
+                const WalkBehindMask &wbm = *rowMasks[i];
+                const int mx1 = std::max(x1, wbm.Left);
+                const int mx2 = std::min(x2, wbm.Left + wbm.Width);
+                const unsigned char *mrow = wbm.GetRow(ry) + (mx1 - wbm.Left);
+                unsigned char *mdst = merged + (mx1 - x1);
+                for (int mx = 0; mx < mx2 - mx1; mx++)
+                    mdst[mx] |= mrow[mx];
             }
+            mask = merged;
+        }
+
+        const int count = x2 - x1;
+        const int rr = ry - yy;
+        unsigned char *dst = sprit->GetScanLineForWriting(rr) + (x1 - xx) * bpp;
+        if (copyPixelsFrom == NULL)
+        {
+            if (bpp == 1)
+                pixelsChanged |= mask_row_clear<unsigned char>(dst, mask, count, (unsigned char)maskcol);
+            else if (bpp == 2)
+                pixelsChanged |= mask_row_clear<unsigned short>((unsigned short*)dst, mask, count, (unsigned short)maskcol);
+            else if (bpp == 3)
+                pixelsChanged |= mask_row_clear24(dst, mask, count, maskcol);
             else
-            {
-                pixelsChanged = 1;
-                if (spcoldep <= 8)
-                    sprit->GetScanLineForWriting(rr)[ee] = maskcol;
-                else if (spcoldep <= 16) {
-                    shptr = (short*)&sprit->GetScanLine(rr)[0];
-                    shptr[ee] = maskcol;
-                }
-                else if (spcoldep == 24) {
-                    char *chptr = (char*)&sprit->GetScanLine(rr)[0];
-                    memcpy(&chptr[ee * 3], &maskcol, 3);
-                }
-                else if (spcoldep <= 32) {
-                    loptr = (int*)&sprit->GetScanLine(rr)[0];
-                    loptr[ee] = maskcol;
-                }
-                else
-                    quit("!Sprite colour depth >32 ??");
-            }
+                pixelsChanged |= mask_row_clear<unsigned int>((unsigned int*)dst, mask, count, (unsigned int)maskcol);
+            continue;
+        }
+
+        const unsigned char *src = copyPixelsFrom->GetScanLine(ry) + x1 * bpp;
+        const unsigned char *check;
+        if (zoom == 100)
+        {
+            check = checkPixelsFrom->GetScanLine(rr) + (x1 - xx) * bpp;
         }
+        else
+        {
+            const unsigned char *checkLine = checkPixelsFrom->GetScanLine((rr * 100) / zoom);
+            const int *cols = &checkCols[x1 - left];
+            if (bpp == 1)
+                gather_row<unsigned char>(&checkRow[0], checkLine, cols, count);
+            else if (bpp == 2)
+                gather_row<unsigned short>((unsigned short*)&checkRow[0], (const unsigned short*)checkLine, cols, count);
+            else if (bpp == 3)
+                gather_row24(&checkRow[0], checkLine, cols, count);
+            else
+                gather_row<unsigned int>((unsigned int*)&checkRow[0], (const unsigned int*)checkLine, cols, count);
+            check = &checkRow[0];
+        }
+        if (bpp == 1)
+            pixelsChanged |= mask_row_copy<unsigned char>(dst, src, check, mask, count, (unsigned char)maskcol);
+        else if (bpp == 2)
+            pixelsChanged |= mask_row_copy<unsigned short>((unsigned short*)dst, (const unsigned short*)src,
+                (const unsigned short*)check, mask, count, (unsigned short)maskcol);
+        else if (bpp == 3)
+            pixelsChanged |= mask_row_copy24(dst, src, check, mask, count, maskcol);
+        else
+            pixelsChanged |= mask_row_copy<unsigned int>((unsigned int*)dst, (const unsigned int*)src,
+                (const unsigned int*)check, mask, count, (unsigned int)maskcol);
     }
-    return pixelsChanged;
+    return pixelsChanged != 0 ? 1 : 0;
 }
 
-void sort_out_char_sprite_walk_behind(int actspsIndex, int xx, int yy, int basel, int zoom, int width, int height)
-{
+// Queues the walk-behinds to be cut out of the sprite, see sort_out_walk_behinds;
+// returns the job index, or -1 if there are no walk-behinds in the room
+int queue_walk_behind_job(Bitmap *sprit, int xx, int yy, int basel, Bitmap *copyPixelsFrom = NULL, Bitmap *checkPixelsFrom = NULL, int zoom = 100) {
     if (noWalkBehindsAtAll)
+        return -1;
+
+    // the jobs are not run on the main thread, so check for errors here
+    if ((!thisroom.object->IsMemoryBitmap()) ||
+        (!sprit->IsMemoryBitmap()))
+        quit("!sort_out_walk_behinds: wb bitmap not linear");
+    if ((checkPixelsFrom != NULL) && (checkPixelsFrom->GetColorDepth() != sprit->GetColorDepth()))
+        quit("sprite colour depth does not match background colour depth");
+    if (sprit->GetColorDepth() > 32)
+        quit("!Sprite colour depth >32 ??");
+
+    WalkBehindJob job;
+    job.Sprite = sprit;
+    job.X = xx;
+    job.Y = yy;
+    job.Baseline = basel;
+    job.CopyPixelsFrom = copyPixelsFrom;
+    job.CheckPixelsFrom = checkPixelsFrom;
+    job.Zoom = zoom;
+    job.PixelsChanged = 0;
+    walkBehindJobs.push_back(job);
+    return (int)walkBehindJobs.size() - 1;
+}
+
+static void run_walk_behind_job(void *data, int index)
+{
+    WalkBehindJob &job = ((WalkBehindJob*)data)[index];
+    job.PixelsChanged = sort_out_walk_behinds(job.Sprite, job.X, job.Y, job.Baseline,
+        job.CopyPixelsFrom, job.CheckPixelsFrom, job.Zoom);
+}
+
+// Runs the queued walk-behind jobs on the drawing threads
+void run_walk_behind_jobs()
+{
+    if (walkBehindJobs.empty())
         return;
+    drawWorkers.Run(run_walk_behind_job, &walkBehindJobs[0], (int)walkBehindJobs.size());
+}
+
+// Queues the walk-behind job for the separate walk-behind sprite of the
+// actsps, if it has moved; returns the job index, or -1 if not needed
+int prepare_char_sprite_walk_behind(int actspsIndex, int xx, int yy, int basel, int zoom, int width, int height)
+{
+    if (noWalkBehindsAtAll)
+        return -1;
 
     if ((!actspswbcache[actspsIndex].valid) ||
         (actspswbcache[actspsIndex].xWas != xx) ||
@@ -1013,12 +1275,26 @@ void sort_out_char_sprite_walk_behind(int actspsIndex, int xx, int yy, int basel
         actspswb[actspsIndex] = recycle_bitmap(actspswb[actspsIndex], thisroom.ebscene[play.bg_frame]->GetColorDepth(), width, height, true);
         Bitmap *wbSprite = actspswb[actspsIndex];
 
-        actspswbcache[actspsIndex].isWalkBehindHere = sort_out_walk_behinds(wbSprite, xx, yy, basel, thisroom.ebscene[play.bg_frame], actsps[actspsIndex], zoom);
+        actspswbcache[actspsIndex].isWalkBehindHere = 0;
         actspswbcache[actspsIndex].xWas = xx;
         actspswbcache[actspsIndex].yWas = yy;
         actspswbcache[actspsIndex].baselineWas = basel;
         actspswbcache[actspsIndex].valid = 1;
+        return queue_walk_behind_job(wbSprite, xx, yy, basel, thisroom.ebscene[play.bg_frame], actsps[actspsIndex], zoom);
+    }
+    return -1;
+}
+
+// Adds the separate walk-behind sprite of the actsps to the sprite list,
+// after its walk-behind job was run
+void finish_char_sprite_walk_behind(int actspsIndex, int xx, int yy, int basel, int wbJob)
+{
+    if (noWalkBehindsAtAll)
+        return;
 
+    if (wbJob >= 0)
+    {
+        actspswbcache[actspsIndex].isWalkBehindHere = walkBehindJobs[wbJob].PixelsChanged;
         if (actspswbcache[actspsIndex].isWalkBehindHere)
         {
             actspswbbmp[actspsIndex] = recycle_ddb_bitmap(actspswbbmp[actspsIndex], actspswb[actspsIndex], false);
@@ -1458,6 +1734,63 @@ int scale_and_flip_sprite(int useindx, int coldept, int zoom_level,
 
 
 
+// Draws the specified 'sppic' sprite onto actsps[useindx], scaled,
+// flipped, tinted or lit as required, reusing the image from the
+// sprite transform cache if it was already drawn the same way
+void transform_sprite(int useindx, int coldept, int zoom_level,
+                      int sppic, int newwidth, int newheight, int isMirrored,
+                      int light_level, int tint_amount, int tint_red,
+                      int tint_green, int tint_blue, int tint_light) {
+
+  const bool tinted = (light_level != 0) || (tint_amount != 0);
+  SpriteTransform transform;
+  transform.Sprite = sppic;
+  transform.Width = newwidth;
+  transform.Height = newheight;
+  transform.Mirrored = isMirrored != 0;
+  transform.Antialiased = (zoom_level != 100) && (IS_ANTIALIAS_SPRITES);
+  transform.TintRed = tint_red;
+  transform.TintGreen = tint_green;
+  transform.TintBlue = tint_blue;
+  transform.TintAmount = tint_amount;
+  transform.TintLight = tint_light;
+  transform.LightLevel = light_level;
+
+  const bool transformed = (zoom_level != 100) || isMirrored || tinted;
+  if (transformed) {
+      Bitmap *cached = get_transformed_sprite(transform);
+      if (cached) {
+          actsps[useindx] = recycle_bitmap(actsps[useindx], cached->GetColorDepth(), cached->GetWidth(), cached->GetHeight());
+          actsps[useindx]->Blit(cached, 0, 0, 0, 0, cached->GetWidth(), cached->GetHeight());
+          return;
+      }
+  }
+
+  // draw the base sprite, scaled and flipped as appropriate
+  int actspsUsed = scale_and_flip_sprite(useindx, coldept, zoom_level,
+      sppic, newwidth, newheight, isMirrored);
+
+  if (tinted) {
+      // apply the lightening or tinting
+      Bitmap *comeFrom = NULL;
+      // if possible, direct read from the source image
+      if (!actspsUsed)
+          comeFrom = spriteset[sppic];
+
+      apply_tint_or_light(useindx, light_level, tint_amount, tint_red,
+          tint_green, tint_blue, tint_light, coldept,
+          comeFrom);
+  }
+  else if (!actspsUsed) {
+      // no scaling, flipping or tinting was done, so just blit it normally
+      actsps[useindx]->Blit (spriteset[sppic], 0, 0, 0, 0, actsps[useindx]->GetWidth(), actsps[useindx]->GetHeight());
+  }
+
+  if (transformed)
+      put_transformed_sprite(transform, actsps[useindx]);
+}
+
+
 // create the actsps[aa] image with the object drawn correctly
 // returns 1 if nothing at all has changed and actsps is still
 // intact from last time; 0 otherwise
@@ -1596,34 +1929,17 @@ int construct_object_gfx(int aa, int *drawnWidth, int *drawnHeight, bool alwaysU
 
     // Not cached, so draw the image
 
-    int actspsUsed = 0;
     if (!hardwareAccelerated)
     {
-        // draw the base sprite, scaled and flipped as appropriate
-        actspsUsed = scale_and_flip_sprite(useindx, coldept, zoom_level,
-            objs[aa].num, sprwidth, sprheight, isMirrored);
+        // draw the sprite, scaled, flipped and tinted as appropriate
+        transform_sprite(useindx, coldept, zoom_level, objs[aa].num,
+            sprwidth, sprheight, isMirrored, light_level, tint_level,
+            tint_red, tint_green, tint_blue, tint_light);
     }
     else
     {
-        // ensure actsps exists
+        // ensure actsps exists, and copy the source bitmap
         actsps[useindx] = recycle_bitmap(actsps[useindx], coldept, spritewidth[objs[aa].num], spriteheight[objs[aa].num]);
-    }
-
-    // direct read from source bitmap, where possible
-    Bitmap *comeFrom = NULL;
-    if (!actspsUsed)
-        comeFrom = spriteset[objs[aa].num];
-
-    // apply tints or lightenings where appropriate, else just copy
-    // the source bitmap
-    if (((tint_level > 0) || (light_level != 0)) &&
-        (!hardwareAccelerated))
-    {
-        apply_tint_or_light(useindx, light_level, tint_level, tint_red,
-            tint_green, tint_blue, tint_light, coldept,
-            comeFrom);
-    }
-    else if (!actspsUsed) {
         actsps[useindx]->Blit(spriteset[objs[aa].num],0,0,0,0,spritewidth[objs[aa].num],spriteheight[objs[aa].num]);
     }
 
@@ -1654,6 +1970,10 @@ void prepare_objects_for_drawing() {
     int aa,atxp,atyp,useindx;
     our_eip=32;
 
+    int64_t startTime = GetPerfTimeUs();
+    walkBehindJobs.clear();
+    preparedSprites.clear();
+
     for (aa=0;aa<croom->numobj;aa++) {
         if (objs[aa].on != 1) continue;
         // offscreen, don't draw
@@ -1672,25 +1992,48 @@ void prepare_objects_for_drawing() {
         atxp = multiply_up_coordinate(objs[aa].x) - offsetx;
         atyp = (multiply_up_coordinate(objs[aa].y) - tehHeight) - offsety;
 
-        int usebasel = objs[aa].get_baseline();
+        PreparedSprite spr;
+        spr.Index = aa;
+        spr.ActspsIndex = useindx;
+        spr.X = atxp + offsetx;
+        spr.Y = atyp + offsety;
+        spr.Baseline = objs[aa].get_baseline();
+        spr.Intact = actspsIntact != 0;
+        spr.WalkBehindJob = -1;
+        spr.SeparateWalkBehind = false;
 
         if (objs[aa].flags & OBJF_NOWALKBEHINDS) {
             // ignore walk-behinds, do nothing
             if (walkBehindMethod == DrawAsSeparateSprite)
             {
-                usebasel += thisroom.height;
+                spr.Baseline += thisroom.height;
             }
         }
         else if (walkBehindMethod == DrawAsSeparateCharSprite) 
         {
-            sort_out_char_sprite_walk_behind(useindx, atxp+offsetx, atyp+offsety, usebasel, objs[aa].last_zoom, objs[aa].last_width, objs[aa].last_height);
+            spr.SeparateWalkBehind = true;
+            spr.WalkBehindJob = prepare_char_sprite_walk_behind(useindx, spr.X, spr.Y, spr.Baseline, objs[aa].last_zoom, objs[aa].last_width, objs[aa].last_height);
         }
         else if ((!actspsIntact) && (walkBehindMethod == DrawOverCharSprite))
         {
-            sort_out_walk_behinds(actsps[useindx],atxp+offsetx,atyp+offsety,usebasel);
+            spr.WalkBehindJob = queue_walk_behind_job(actsps[useindx], spr.X, spr.Y, spr.Baseline);
         }
+        preparedSprites.push_back(spr);
+    }
+
+    int64_t transformTime = GetPerfTimeUs();
+    run_walk_behind_jobs();
+    int64_t walkBehindsTime = GetPerfTimeUs();
+
+    for (size_t i = 0; i < preparedSprites.size(); i++) {
+        const PreparedSprite &spr = preparedSprites[i];
+        aa = spr.Index;
+        useindx = spr.ActspsIndex;
 
-        if ((!actspsIntact) || (actspsbmp[useindx] == NULL))
+        if (spr.SeparateWalkBehind)
+            finish_char_sprite_walk_behind(useindx, spr.X, spr.Y, spr.Baseline, spr.WalkBehindJob);
+
+        if ((!spr.Intact) || (actspsbmp[useindx] == NULL))
         {
             bool hasAlpha = (game.spriteflags[objs[aa].num] & SPF_ALPHACHANNEL) != 0;
 
@@ -1720,9 +2063,14 @@ void prepare_objects_for_drawing() {
                 actspsbmp[useindx]->SetLightLevel(0);
         }
 
-        add_to_sprite_list(actspsbmp[useindx],atxp,atyp,usebasel,objs[aa].transparent,objs[aa].num);
+        add_to_sprite_list(actspsbmp[useindx],spr.X - offsetx,spr.Y - offsety,spr.Baseline,objs[aa].transparent,objs[aa].num);
     }
 
+    int64_t finishTime = GetPerfTimeUs();
+    prepTiming.TransformUs += transformTime - startTime;
+    prepTiming.WalkBehindsUs += walkBehindsTime - transformTime;
+    prepTiming.FinishUs += finishTime - walkBehindsTime;
+    prepTiming.Sprites += (int)preparedSprites.size();
 }
 
 
@@ -1780,8 +2128,14 @@ void prepare_characters_for_drawing() {
     int tint_red, tint_green, tint_blue, tint_amount, tint_light = 255;
 
     our_eip=33;
+    int64_t startTime = GetPerfTimeUs();
+    walkBehindJobs.clear();
+    preparedSprites.clear();
+
     // draw characters
-    for (aa=0;aa<game.numcharacters;aa++) {
+    const std::vector<int> &room_chars = get_room_characters();
+    for (size_t ci = 0; ci < room_chars.size(); ci++) {
+        aa = room_chars[ci];
         if (game.chars[aa].on==0) continue;
         if (game.chars[aa].room!=displayed_room) continue;
         eip_guinum = aa;
@@ -1933,40 +2287,23 @@ void prepare_characters_for_drawing() {
         // If cache needs to be re-drawn
         if (!charcache[aa].inUse) {
 
-            // create the base sprite in actsps[useindx], which will
-            // be scaled and/or flipped, as appropriate
-            int actspsUsed = 0;
+            // create the sprite in actsps[useindx], which will
+            // be scaled, flipped and tinted, as appropriate
             if (!gfxDriver->HasAcceleratedStretchAndFlip())
             {
-                actspsUsed = scale_and_flip_sprite(
-                    useindx, coldept, zoom_level, sppic,
-                    newwidth, newheight, isMirrored);
+                transform_sprite(useindx, coldept, zoom_level, sppic,
+                    newwidth, newheight, isMirrored, light_level, tint_amount,
+                    tint_red, tint_green, tint_blue, tint_light);
             }
             else 
             {
-                // ensure actsps exists
+                // ensure actsps exists, and blit the sprite normally
                 actsps[useindx] = recycle_bitmap(actsps[useindx], coldept, spritewidth[sppic], spriteheight[sppic]);
+                actsps[useindx]->Blit (spriteset[sppic], 0, 0, 0, 0, actsps[useindx]->GetWidth(), actsps[useindx]->GetHeight());
             }
 
             our_eip = 335;
 
-            if (((light_level != 0) || (tint_amount != 0)) &&
-                (!gfxDriver->HasAcceleratedStretchAndFlip())) {
-                    // apply the lightening or tinting
-                    Bitmap *comeFrom = NULL;
-                    // if possible, direct read from the source image
-                    if (!actspsUsed)
-                        comeFrom = spriteset[sppic];
-
-                    apply_tint_or_light(useindx, light_level, tint_amount, tint_red,
-                        tint_green, tint_blue, tint_light, coldept,
-                        comeFrom);
-            }
-            else if (!actspsUsed) {
-                // no scaling, flipping or tinting was done, so just blit it normally
-                actsps[useindx]->Blit (spriteset[sppic], 0, 0, 0, 0, actsps[useindx]->GetWidth(), actsps[useindx]->GetHeight());
-            }
-
             // update the character cache with the new image
             charcache[aa].inUse = 1;
             //charcache[aa].image = BitmapHelper::CreateBitmap_ (coldept, actsps[useindx]->GetWidth(), actsps[useindx]->GetHeight());
@@ -1982,49 +2319,85 @@ void prepare_characters_for_drawing() {
 
         our_eip = 336;
 
-        int bgX = atxp + offsetx + chin->pic_xoffs;
-        int bgY = atyp + offsety + chin->pic_yoffs;
+        PreparedSprite spr;
+        spr.Index = aa;
+        spr.ActspsIndex = useindx;
+        spr.X = atxp + offsetx + chin->pic_xoffs;
+        spr.Y = atyp + offsety + chin->pic_yoffs;
+        spr.Baseline = usebasel;
+        spr.Intact = usingCachedImage;
+        spr.WalkBehindJob = -1;
+        spr.SeparateWalkBehind = false;
+        spr.SpriteNum = sppic;
+        spr.Width = newwidth;
+        spr.Height = newheight;
+        spr.Mirrored = isMirrored;
+        spr.TintRed = tint_red;
+        spr.TintGreen = tint_green;
+        spr.TintBlue = tint_blue;
+        spr.TintAmount = tint_amount;
+        spr.TintLight = tint_light;
+        spr.LightLevel = light_level;
 
         if (chin->flags & CHF_NOWALKBEHINDS) {
             // ignore walk-behinds, do nothing
             if (walkBehindMethod == DrawAsSeparateSprite)
             {
-                usebasel += thisroom.height;
+                spr.Baseline += thisroom.height;
             }
         }
         else if (walkBehindMethod == DrawAsSeparateCharSprite) 
         {
-            sort_out_char_sprite_walk_behind(useindx, bgX, bgY, usebasel, charextra[aa].zoom, newwidth, newheight);
+            spr.SeparateWalkBehind = true;
+            spr.WalkBehindJob = prepare_char_sprite_walk_behind(useindx, spr.X, spr.Y, spr.Baseline, charextra[aa].zoom, newwidth, newheight);
         }
         else if (walkBehindMethod == DrawOverCharSprite)
         {
-            sort_out_walk_behinds(actsps[useindx], bgX, bgY, usebasel);
+            spr.WalkBehindJob = queue_walk_behind_job(actsps[useindx], spr.X, spr.Y, spr.Baseline);
         }
+        preparedSprites.push_back(spr);
 
-        if ((!usingCachedImage) || (actspsbmp[useindx] == NULL))
+        chin->actx=atxp+offsetx;
+        chin->acty=atyp+offsety;
+    }
+
+    int64_t transformTime = GetPerfTimeUs();
+    run_walk_behind_jobs();
+    int64_t walkBehindsTime = GetPerfTimeUs();
+
+    for (size_t i = 0; i < preparedSprites.size(); i++) {
+        const PreparedSprite &spr = preparedSprites[i];
+        aa = spr.Index;
+        useindx = spr.ActspsIndex;
+        CharacterInfo*chin=&game.chars[aa];
+
+        if (spr.SeparateWalkBehind)
+            finish_char_sprite_walk_behind(useindx, spr.X, spr.Y, spr.Baseline, spr.WalkBehindJob);
+
+        if ((!spr.Intact) || (actspsbmp[useindx] == NULL))
         {
-            bool hasAlpha = (game.spriteflags[sppic] & SPF_ALPHACHANNEL) != 0;
+            bool hasAlpha = (game.spriteflags[spr.SpriteNum] & SPF_ALPHACHANNEL) != 0;
 
             actspsbmp[useindx] = recycle_ddb_bitmap(actspsbmp[useindx], actsps[useindx], hasAlpha);
         }
 
         if (gfxDriver->HasAcceleratedStretchAndFlip()) 
         {
-            actspsbmp[useindx]->SetStretch(newwidth, newheight);
-            actspsbmp[useindx]->SetFlippedLeftRight(isMirrored != 0);
-            actspsbmp[useindx]->SetTint(tint_red, tint_green, tint_blue, (tint_amount * 256) / 100);
+            actspsbmp[useindx]->SetStretch(spr.Width, spr.Height);
+            actspsbmp[useindx]->SetFlippedLeftRight(spr.Mirrored != 0);
+            actspsbmp[useindx]->SetTint(spr.TintRed, spr.TintGreen, spr.TintBlue, (spr.TintAmount * 256) / 100);
 
-            if (tint_amount != 0)
+            if (spr.TintAmount != 0)
             {
-                if (tint_light == 0) // tint with 0 luminance, pass as 1 instead
+                if (spr.TintLight == 0) // tint with 0 luminance, pass as 1 instead
                     actspsbmp[useindx]->SetLightLevel(1);
-                else if (tint_light < 250)
-                    actspsbmp[useindx]->SetLightLevel(tint_light);
+                else if (spr.TintLight < 250)
+                    actspsbmp[useindx]->SetLightLevel(spr.TintLight);
                 else
                     actspsbmp[useindx]->SetLightLevel(0);
             }
-            else if (light_level != 0)
-                actspsbmp[useindx]->SetLightLevel((light_level * 25) / 10 + 256);
+            else if (spr.LightLevel != 0)
+                actspsbmp[useindx]->SetLightLevel((spr.LightLevel * 25) / 10 + 256);
             else
                 actspsbmp[useindx]->SetLightLevel(0);
 
@@ -2035,11 +2408,14 @@ void prepare_characters_for_drawing() {
         // alpha channel was lost in the tinting process)
         //if (((tint_level) && (tint_amount < 100)) || (light_level))
         //sppic = -1;
-        add_to_sprite_list(actspsbmp[useindx], atxp + chin->pic_xoffs, atyp + chin->pic_yoffs, usebasel, chin->transparency, sppic);
-
-        chin->actx=atxp+offsetx;
-        chin->acty=atyp+offsety;
+        add_to_sprite_list(actspsbmp[useindx], spr.X - offsetx, spr.Y - offsety, spr.Baseline, chin->transparency, spr.SpriteNum);
     }
+
+    int64_t finishTime = GetPerfTimeUs();
+    prepTiming.TransformUs += transformTime - startTime;
+    prepTiming.WalkBehindsUs += walkBehindsTime - transformTime;
+    prepTiming.FinishUs += finishTime - walkBehindsTime;
+    prepTiming.Sprites += (int)preparedSprites.size();
 }
 
 
@@ -2108,7 +2484,10 @@ void draw_screen_background(Bitmap *ds) {
         // the following line takes up to 50% of the game CPU time at
         // high resolutions and colour depths - if we can optimise it
         // somehow, significant performance gains to be had
-        update_invalid_region_and_reset(ds, -offsetx, -offsety, thisroom.ebscene[play.bg_frame]);
+        if (dirtyRectsTracked)
+            flush_invalid_region_to_driver();
+        else
+            update_invalid_region_and_reset(ds, -offsetx, -offsety, thisroom.ebscene[play.bg_frame]);
     }
 
     clear_sprite_list();
@@ -2135,21 +2514,35 @@ void draw_fps()
     static IDriverDependantBitmap* ddb = NULL;
     static Bitmap *fpsDisplay = NULL;
 
+    // all the lines are drawn on a sprite, so that the graphics driver could
+    // tell when they change
+    const int line_height = getfontheight_outlined(FONT_SPEECH);
     if (fpsDisplay == NULL)
     {
-        fpsDisplay = BitmapHelper::CreateBitmap(get_fixed_pixel_size(100), (getfontheight_outlined(FONT_SPEECH) + get_fixed_pixel_size(5)), System_GetColorDepth());
+        fpsDisplay = BitmapHelper::CreateBitmap(play.viewport.GetWidth(), (line_height * 2 + get_fixed_pixel_size(5)), System_GetColorDepth());
         fpsDisplay = ReplaceBitmapWithSupportedFormat(fpsDisplay);
     }
     fpsDisplay->ClearTransparent();
-    //Bitmap *oldAbuf = ds;
-    //ds = fpsDisplay;
     char tbuffer[60];
     sprintf(tbuffer,"FPS: %d",fps);
     color_t text_color = fpsDisplay->GetCompatibleColor(14);
-    wouttext_outline(fpsDisplay, 1, 1, FONT_SPEECH, text_color, tbuffer);
-    //ds = oldAbuf;
+    wouttext_outline(fpsDisplay, 2, line_height + 1, FONT_SPEECH, text_color, tbuffer);
 
-    Bitmap *ds = GetVirtualScreen();
+    sprintf(tbuffer,"Loop %u", loopcounter);
+    wouttext_outline(fpsDisplay, get_fixed_pixel_size(250), line_height, FONT_SPEECH, text_color, tbuffer);
+
+    // average time spent on the room sprites per frame, in milliseconds
+    if (prepTimingShown.Frames > 0)
+    {
+        const double frames = prepTimingShown.Frames * 1000.0;
+        char tbuffer2[100];
+        sprintf(tbuffer2, "%d spr: xf %.1f wb %.1f/%dt ddb %.1f | %.1f ms",
+            prepTimingShown.Sprites / prepTimingShown.Frames,
+            prepTimingShown.TransformUs / frames, prepTimingShown.WalkBehindsUs / frames,
+            drawWorkers.GetThreadCount() + 1, prepTimingShown.FinishUs / frames,
+            prepTimingShown.FrameUs / frames);
+        wouttext_outline(fpsDisplay, 1, 0, FONT_SPEECH, text_color, tbuffer2);
+    }
 
     if (ddb == NULL)
         ddb = gfxDriver->CreateDDBFromBitmap(fpsDisplay, false);
@@ -2158,11 +2551,8 @@ void draw_fps()
 
     int yp = play.viewport.GetHeight() - fpsDisplay->GetHeight();
 
-    gfxDriver->DrawSprite(1, yp, ddb);
-    invalidate_sprite(1, yp, ddb);
-
-    sprintf(tbuffer,"Loop %u", loopcounter);
-    draw_and_invalidate_text(ds, get_fixed_pixel_size(250), yp, FONT_SPEECH, text_color, tbuffer);
+    gfxDriver->DrawSprite(0, yp, ddb);
+    invalidate_sprite(0, yp, ddb);
 }
 
 // draw_screen_overlay: draws any stuff currently on top of the background,
@@ -2203,46 +2593,45 @@ void draw_screen_overlay() {
         guis[aa].poll();
         }*/
         our_eip = 37;
-        if (guis_need_update) {
-            //Bitmap *abufwas = ds;
-            guis_need_update = 0;
-            for (aa=0;aa<game.numgui;aa++) {
-                if (!guis[aa].IsVisible()) continue;
-
-                if (guibg[aa] == NULL)
-                    recreate_guibg_image(&guis[aa]);
-
-                eip_guinum = aa;
-                our_eip = 370;
-                guibg[aa]->ClearTransparent();
-                //ds = guibg[aa];
-                our_eip = 372;
-                guis[aa].DrawAt(guibg[aa], 0,0);
-                our_eip = 373;
-
-                bool isAlpha = false;
-                if (guis[aa].HasAlphaChannel()) 
-                {
-                    isAlpha = true;
-
-                    if ((game.options[OPT_NEWGUIALPHA] == kGuiAlphaRender_Classic) && (guis[aa].BgImage > 0))
-                    {
-                        // old-style (pre-3.0.2) GUI alpha rendering
-                        repair_alpha_channel(guibg[aa], spriteset[guis[aa].BgImage]);
-                    }
-                }
+        for (aa=0;aa<game.numgui;aa++) {
+            if (!guis[aa].IsVisible()) continue;
+            // only redraw the guis that have changed since the last time;
+            // hidden guis keep their changed state until they are shown
+            if (!guis[aa].HasChanged() && guibg[aa] != NULL && guibgbmp[aa] != NULL) continue;
+
+            if (guibg[aa] == NULL)
+                recreate_guibg_image(&guis[aa]);
+
+            eip_guinum = aa;
+            our_eip = 370;
+            guibg[aa]->ClearTransparent();
+            //ds = guibg[aa];
+            our_eip = 372;
+            guis[aa].DrawAt(guibg[aa], 0,0);
+            our_eip = 373;
+
+            bool isAlpha = false;
+            if (guis[aa].HasAlphaChannel()) 
+            {
+                isAlpha = true;
 
-                if (guibgbmp[aa] != NULL) 
-                {
-                    gfxDriver->UpdateDDBFromBitmap(guibgbmp[aa], guibg[aa], isAlpha);
-                }
-                else
+                if ((game.options[OPT_NEWGUIALPHA] == kGuiAlphaRender_Classic) && (guis[aa].BgImage > 0))
                 {
-                    guibgbmp[aa] = gfxDriver->CreateDDBFromBitmap(guibg[aa], isAlpha);
+                    // old-style (pre-3.0.2) GUI alpha rendering
+                    repair_alpha_channel(guibg[aa], spriteset[guis[aa].BgImage]);
                 }
-                our_eip = 374;
             }
-            //ds = abufwas;
+
+            if (guibgbmp[aa] != NULL) 
+            {
+                gfxDriver->UpdateDDBFromBitmap(guibgbmp[aa], guibg[aa], isAlpha);
+            }
+            else
+            {
+                guibgbmp[aa] = gfxDriver->CreateDDBFromBitmap(guibg[aa], isAlpha);
+            }
+            guis[aa].ClearChanged();
+            our_eip = 374;
         }
         our_eip = 38;
         // Draw the GUIs
@@ -2362,6 +2751,16 @@ bool GfxDriverNullSpriteCallback(int x, int y)
     return (pl_run_plugin_hooks(x, y) != 0);
 }
 
+void GfxDriverRestoreBgCallback(Bitmap *ds, const Rect &rc)
+{
+    if (displayed_room < 0)
+    {
+        ds->FillRect(rc, 0);
+        return;
+    }
+    ds->Blit(thisroom.ebscene[play.bg_frame], rc.Left + offsetx, rc.Top + offsety, rc.Left, rc.Top, rc.GetWidth(), rc.GetHeight());
+}
+
 void GfxDriverOnInitCallback(void *data)
 {
     pl_run_plugin_init_gfx_hooks(gfxDriver->GetDriverID(), data);
@@ -2509,6 +2908,22 @@ void update_screen() {
 
 extern volatile int psp_audio_multithreaded; // in ac_audio
 
+// Lets the graphics driver redraw only the changed parts of the screen,
+// unless something is going to draw on the virtual screen directly
+void update_dirty_rect_tracking(bool fullRedraw)
+{
+    const bool track = usetup.dirty_rects && !gfxDriver->RequiresFullRedrawEachFrame() &&
+        (displayed_room >= 0) && !fullRedraw &&
+        !play.recording && !play.playback &&
+        !pl_any_want_hook(AGSE_PRERENDER | AGSE_PRESCREENDRAW | AGSE_PREGUIDRAW | AGSE_POSTSCREENDRAW | AGSE_FINALSCREENDRAW);
+    const bool wasTracked = dirtyRectsTracked;
+    dirtyRectsTracked = gfxDriver->EnableDirtyRects(track);
+    // the areas of the sprites were not invalidated while the driver
+    // was tracking them
+    if (wasTracked && !dirtyRectsTracked)
+        numDirtyRegions = WHOLESCREENDIRTY;
+}
+
 
 void construct_virtual_screen(bool fullRedraw) 
 {
@@ -2526,6 +2941,8 @@ void construct_virtual_screen(bool fullRedraw)
         (game.options[OPT_RENDERATSCREENRES] == kRenderAtScreenRes_UserDefined && usetup.Screen.RenderAtScreenRes) ||
          game.options[OPT_RENDERATSCREENRES] == kRenderAtScreenRes_Enabled);
 
+    update_dirty_rect_tracking(fullRedraw);
+
     pl_run_plugin_hooks(AGSE_PRERENDER, 0);
 
     if (displayed_room >= 0) {
@@ -2565,6 +2982,7 @@ void construct_virtual_screen(bool fullRedraw)
 // Draw everything 
 void render_graphics(IDriverDependantBitmap *extraBitmap, int extraX, int extraY) {
 
+    int64_t startTime = GetPerfTimeUs();
     construct_virtual_screen(false);
     our_eip=5;
 
@@ -2574,4 +2992,13 @@ void render_graphics(IDriverDependantBitmap *extraBitmap, int extraX, int extraY
     }
 
     update_screen();
+
+    // the frame time display shows the average of about a second
+    prepTiming.FrameUs += GetPerfTimeUs() - startTime;
+    prepTiming.Frames++;
+    if (prepTiming.Frames >= frames_per_second)
+    {
+        prepTimingShown = prepTiming;
+        memset(&prepTiming, 0, sizeof(prepTiming));
+    }
 }
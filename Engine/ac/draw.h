@@ -21,6 +21,7 @@
 #include "core/types.h"
 #include "ac/common_defines.h"
 #include "gfx/gfx_def.h"
+#include "util/geometry.h"
 #include "util/wgt2allg.h"
 
 namespace AGS { namespace Common { class Bitmap; } }
@@ -28,6 +29,8 @@ namespace AGS { namespace Engine { class IDriverDependantBitmap; } }
 using namespace AGS; // FIXME later
 
 #define IS_ANTIALIAS_SPRITES usetup.enable_antialiasing && (play.disable_antialiasing == 0)
+// Max number of threads started to help preparing the room sprites
+#define MAX_DRAW_THREADS 4
 
 // Allegro 4 has switched 15-bit colour to BGR instead of RGB, so
 // in this case we need to convert the graphics on load
@@ -53,6 +56,10 @@ struct CachedActSpsData {
     int valid;
 };
 
+// Starts the threads which cut walk-behinds out of the room sprites;
+// if the number is negative, it is chosen by the number of processors
+void init_draw_workers(int numThreads);
+void shutdown_draw_workers();
 void invalidate_screen();
 void mark_current_background_dirty();
 void invalidate_cached_walkbehinds();
@@ -79,6 +86,7 @@ void draw_screen_callback();
 void write_screen();
 void GfxDriverOnInitCallback(void *data);
 bool GfxDriverNullSpriteCallback(int x, int y);
+void GfxDriverRestoreBgCallback(Common::Bitmap *ds, const Rect &rc);
 void init_invalid_regions(int scrnHit);
 void destroy_invalid_regions();
 void putpixel_compensate (Common::Bitmap *g, int xx,int yy, int col);
@@ -22,6 +22,7 @@
 #include "ac/gamesetupstruct.h"
 #include "ac/gamestate.h"
 #include "ac/global_translation.h"
+#include "ac/gui.h"
 #include "ac/objectcache.h"
 #include "ac/roomobject.h"
 #include "ac/roomstatus.h"
@@ -30,6 +31,7 @@
 #include "font/fonts.h"
 #include "gui/guimain.h"
 #include "ac/spritecache.h"
+#include "ac/spritetransformcache.h"
 #include "script/runtimescriptvalue.h"
 #include "gfx/gfx_def.h"
 #include "gfx/gfx_util.h"
@@ -73,6 +75,7 @@ void DrawingSurface_Release(ScriptDrawingSurface* sds)
         {
             int tt;
             // force a refresh of any cached object or character images
+            invalidate_transformed_sprite(sds->dynamicSpriteNumber);
             if (croom != NULL) 
             {
                 for (tt = 0; tt < croom->numobj; tt++) 
@@ -86,15 +89,7 @@ void DrawingSurface_Release(ScriptDrawingSurface* sds)
                 if (charcache[tt].sppic == sds->dynamicSpriteNumber)
                     charcache[tt].sppic = -31999;
             }
-            for (tt = 0; tt < game.numgui; tt++) 
-            {
-                if ((guis[tt].BgImage == sds->dynamicSpriteNumber) &&
-                    (guis[tt].IsVisible()))
-                {
-                    guis_need_update = 1;
-                    break;
-                }
-            }
+            mark_guis_using_sprite_changed(sds->dynamicSpriteNumber);
         }
 
         sds->dynamicSpriteNumber = -1;
@@ -20,6 +20,7 @@
 #include "ac/gamesetupstruct.h"
 #include "ac/global_dynamicsprite.h"
 #include "ac/global_game.h"
+#include "ac/gui.h"
 #include "ac/math.h"    // M_PI
 #include "ac/objectcache.h"
 #include "ac/path_helper.h"
@@ -30,6 +31,7 @@
 #include "debug/debug_log.h"
 #include "gui/guibutton.h"
 #include "ac/spritecache.h"
+#include "ac/spritetransformcache.h"
 #include "platform/base/override_defines.h"
 #include "gfx/graphicsdriver.h"
 #include "script/runtimescriptvalue.h"
@@ -169,6 +171,8 @@ void DynamicSprite_CopyTransparencyMask(ScriptDynamicSprite *sds, int sourceSpri
     }
 
     BitmapHelper::CopyTransparency(target, source, dst_has_alpha, src_has_alpha);
+    invalidate_transformed_sprite(sds->slot);
+    mark_guis_using_sprite_changed(sds->slot);
 }
 
 void DynamicSprite_ChangeCanvasSize(ScriptDynamicSprite *sds, int width, int height, int x, int y) 
@@ -474,6 +478,8 @@ ScriptDynamicSprite* DynamicSprite_CreateFromBackground(int frame, int x1, int y
 void add_dynamic_sprite(int gotSlot, Bitmap *redin, bool hasAlpha) {
 
   spriteset.set(gotSlot, redin);
+  invalidate_transformed_sprite(gotSlot);
+  mark_guis_using_sprite_changed(gotSlot);
 
   game.spriteflags[gotSlot] = SPF_DYNAMICALLOC;
 
@@ -499,12 +505,14 @@ void free_dynamic_sprite (int gotSlot) {
 
   delete spriteset[gotSlot];
   spriteset.set(gotSlot, NULL);
+  invalidate_transformed_sprite(gotSlot);
 
   game.spriteflags[gotSlot] = 0;
   spritewidth[gotSlot] = 0;
   spriteheight[gotSlot] = 0;
 
   // ensure it isn't still on any GUI buttons
+  mark_guis_using_sprite_changed(gotSlot);
   for (tt = 0; tt < numguibuts; tt++) {
     if (guibuts[tt].IsDeleted())
       continue;
@@ -17,6 +17,7 @@
 #include "ac/global_character.h"
 #include "ac/gamesetupstruct.h"
 #include "ac/game_version.h"
+#include "ac/roomindex.h"
 
 extern GameSetupStruct game;
 
@@ -56,3 +57,14 @@ void CCCharacter::WriteInt16(const char *address, intptr_t offset, int16_t val)
         }
     }
 }
+
+void CCCharacter::WriteInt32(const char *address, intptr_t offset, int32_t val)
+{
+    *(int32_t*)(address + offset) = val;
+
+    // Detect when an old-style game script moves the character to another
+    // room by changing the field directly
+    const int roomoffset = 12;
+    if (offset == roomoffset)
+        invalidate_room_characters();
+}
@@ -12,18 +12,37 @@
 //
 //=============================================================================
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "ac/dynobj/managedobjectpool.h"
 #include "ac/dynobj/cc_dynamicarray.h" // globalDynamicArray, constants
+#include "ac/dynobj/scriptuserobject.h"
 #include "debug/out.h"
 #include "util/string_utils.h"               // fputstring, etc
 #include "script/cc_error.h"
 #include "script/script_common.h"
+#include "util/perf_timer.h"
 #include "util/stream.h"
 
 using namespace AGS::Common;
+using namespace AGS::Engine;
+
+// Accesses header and elements of a dynamic array by its address
+inline int32_t *DynamicArrayHeader(const char *address) { return (int32_t*)(address - 8); }
+inline int32_t *DynamicArrayElements(const char *address) { return (int32_t*)address; }
+
+ManagedPoolGCStats::ManagedPoolGCStats()
+    : Steps(0)
+    , FullSweeps(0)
+    , ObjectsFreed(0)
+    , CycleObjectsFreed(0)
+    , LastPauseUs(0)
+    , MaxPauseUs(0)
+    , TotalPauseUs(0)
+{
+}
 
 void ManagedObjectPool::ManagedObject::init(int32_t theHandle, const char *theAddress,
                                             ICCDynamicObject *theCallback, ScriptValueType objType) {
@@ -32,6 +51,10 @@ void ManagedObjectPool::ManagedObject::init(int32_t theHandle, const char *theAd
     addr = theAddress;
     callback = theCallback;
     refCount = 0;
+    // only the arrays may refer to other objects, and the user objects
+    // are the ones which may be kept only by the arrays
+    collectable = (theCallback == &globalDynamicArray) ||
+        (theCallback != NULL && theCallback->GetType() == ScriptUserObject::TypeName);
 
     ManagedObjectLog("Allocated managed object handle=%d, type=%s", theHandle, theCallback->GetType());
 }
@@ -55,57 +78,39 @@ int ManagedObjectPool::ManagedObject::AddRef() {
     return ++refCount;
 }
 
-int ManagedObjectPool::ManagedObject::CheckDispose() {
-    if ((refCount < 1) && (callback != NULL)) {
-        if (remove(false))
-            return 1;
-    }
-    return 0;
-}
-
-int ManagedObjectPool::ManagedObject::SubRef() {
-    refCount--;
-    ManagedObjectLog("Line %d SubRef: handle=%d new refcount=%d", currentline, handle, refCount);
-
-    return CheckDispose();
-}
-
 void ManagedObjectPool::ManagedObject::SubRefNoDispose() {
     refCount--;
     ManagedObjectLog("Line %d SubRefNoDispose: handle=%d new refcount=%d", currentline, handle, refCount);
 }
 
 int32_t ManagedObjectPool::AddRef(int32_t handle) {
+        MarkChanged(handle);
         return objects[handle].AddRef();
 }
 
 int ManagedObjectPool::CheckDispose(int32_t handle) {
-    return objects[handle].CheckDispose();
+    if ((objects[handle].refCount < 1) && (objects[handle].callback != NULL))
+        return RemoveAt(handle, false);
+    return 0;
 }
 
 int32_t ManagedObjectPool::SubRef(int32_t handle) {
-    if ((disableDisposeForObject != NULL) && 
-        (objects[handle].addr == disableDisposeForObject))
-        objects[handle].SubRefNoDispose();
-    else
-        objects[handle].SubRef();
-    return objects[handle].refCount;
+    MarkChanged(handle);
+    objects[handle].SubRefNoDispose();
+    // the object may be disposed and its slot reused, so remember the count
+    const int refCount = objects[handle].refCount;
+    if ((disableDisposeForObject == NULL) ||
+        (objects[handle].addr != disableDisposeForObject))
+        CheckDispose(handle);
+    return refCount;
 }
 
 int32_t ManagedObjectPool::AddressToHandle(const char *addr) {
     // this function is only called when a pointer is set
-    // SLOW LOOP ALERT, improve at some point
-    // [IKM] 2013-01-01: search in reverse order, as suggested by rofl0r:
-    // it appears that, statistically, the given address is more often
-    // located closer to the end of the managed array.
-    for (size_t i = numObjects - 1; i >= 1; --i)
-    {
-        if (objects[i].addr == addr)
-        {
-            return objects[i].handle;
-        }
-    }
-    return 0;
+    AddressToHandleMap::const_iterator it = handleByAddress.find(addr);
+    if (it == handleByAddress.end())
+        return 0;
+    return it->second;
 }
 
 const char* ManagedObjectPool::HandleToAddress(int32_t handle) {
@@ -135,7 +140,19 @@ int ManagedObjectPool::RemoveObject(const char *address) {
     if (handl == 0)
         return 0;
 
-    objects[handl].remove(true);
+    RemoveAt(handl, true);
+    return 1;
+}
+
+int ManagedObjectPool::RemoveAt(int32_t handle, bool force) {
+    const char *address = objects[handle].addr;
+    if (objects[handle].remove(force) == 0)
+        return 0;
+
+    AddressToHandleMap::iterator it = handleByAddress.find(address);
+    if ((it != handleByAddress.end()) && (it->second == handle))
+        handleByAddress.erase(it);
+    freeSlots.push_back(handle);
     return 1;
 }
 
@@ -144,7 +161,7 @@ void ManagedObjectPool::RunGarbageCollectionIfAppropriate()
     if (objectCreationCounter > GARBAGE_COLLECTION_INTERVAL)
     {
         objectCreationCounter = 0;
-        RunGarbageCollection();
+        RunGarbageCollectionStep(GARBAGE_COLLECTION_SLOTS_PER_STEP);
     }
 }
 
@@ -156,48 +173,287 @@ void ManagedObjectPool::RunGarbageCollection()
     {
         if ((objects[i].refCount < 1) && (objects[i].callback != NULL)) 
         {
-            objects[i].remove(false);
+            RemoveAt(i, false);
         }
     }
 }
 
-int ManagedObjectPool::AddObject(const char *address, ICCDynamicObject *callback, bool plugin_object, int useSlot) {
-    if (useSlot == -1)
-        useSlot = numObjects;
+void ManagedObjectPool::RunGarbageCollectionStep(int max_slots)
+{
+    const int64_t start_time = GetPerfTimeUs();
+    if (cyclePhase != kCycles_Idle)
+    {
+        gcStats.CycleObjectsFreed += RunCycleCollectionStep(max_slots);
+    }
+    else
+    {
+        for (int checked = 0; checked < max_slots; checked++)
+        {
+            if (gcCursor >= numObjects)
+            {
+                gcCursor = 1;
+                gcStats.FullSweeps++;
+                BeginCycleCollection();
+                break;
+            }
+            const int32_t slot = gcCursor++;
+            if ((objects[slot].refCount < 1) && (objects[slot].callback != NULL))
+            {
+                gcStats.ObjectsFreed += RemoveAt(slot, false);
+            }
+        }
+    }
 
-    objectCreationCounter++;
+    const uint32_t pause = (uint32_t)(GetPerfTimeUs() - start_time);
+    gcStats.Steps++;
+    gcStats.LastPauseUs = pause;
+    gcStats.MaxPauseUs = pause > gcStats.MaxPauseUs ? pause : gcStats.MaxPauseUs;
+    gcStats.TotalPauseUs += pause;
+}
+
+bool ManagedObjectPool::IsManagedArray(int32_t handle) const
+{
+    return objects[handle].handle != 0 && objects[handle].callback == &globalDynamicArray &&
+        (DynamicArrayHeader(objects[handle].addr)[0] & ARRAY_MANAGED_TYPE_FLAG) != 0;
+}
 
-    if (useSlot < arrayAllocLimit) {
-        // still space in the array, so use it
-        objects[useSlot].init(useSlot, address, callback, plugin_object ? kScValPluginObject : kScValDynamicObject);
-        if (useSlot == numObjects)
-            numObjects++;
-        return useSlot;
+// The cycle collection pass is spread over several steps, while the script
+// keeps running. Only the objects which are not referenced by script can be
+// garbage, and the script can't change any references to them; so every
+// object which references are changed during the pass is simply kept alive,
+// and the references counted before that do not matter.
+void ManagedObjectPool::MarkChanged(int32_t handle)
+{
+    if ((cyclePhase != kCycles_Idle) && (handle < cycleObjects) && !reachable[handle])
+    {
+        reachable[handle] = 1;
+        pending.push_back(handle);
     }
-    else {
-        // array has been used up
-        if (useSlot == numObjects) {
-            // if adding new (not un-serializing) check for empty slot
-            // check backwards, since newer objects don't tend to last
-            // long
-            for (int i = arrayAllocLimit - 1; i >= 1; i--) {
-                if (objects[i].handle == 0) {
-                    objects[i].init(i, address, callback, plugin_object ? kScValPluginObject : kScValDynamicObject);
-                    return i;
+}
+
+void ManagedObjectPool::BeginCycleCollection()
+{
+    cycleObjects = numObjects;
+    arrayRefs.assign(cycleObjects, 0);
+    reachable.assign(cycleObjects, 0);
+    pending.clear();
+    garbage.clear();
+    cycleCursor = 1;
+    cycleArray = 0;
+    cycleElement = 0;
+    cycleHasArrays = false;
+    cyclePhase = kCycles_CountRefs;
+}
+
+bool ManagedObjectPool::ScanArrayElements(int32_t handle, bool count_refs, int &work, int max_work)
+{
+    const int32_t count = DynamicArrayHeader(objects[handle].addr)[0] & ~ARRAY_MANAGED_TYPE_FLAG;
+    const int32_t *elements = DynamicArrayElements(objects[handle].addr);
+    for (; cycleElement < count; cycleElement++, work++)
+    {
+        if (work >= max_work)
+            return false;
+        const int32_t ref = elements[cycleElement];
+        if ((ref <= 0) || (ref >= cycleObjects))
+            continue;
+        if (count_refs)
+        {
+            arrayRefs[ref]++;
+        }
+        else if (!reachable[ref])
+        {
+            reachable[ref] = 1;
+            pending.push_back(ref);
+        }
+    }
+    cycleElement = 0;
+    return true;
+}
+
+int ManagedObjectPool::RunCycleCollectionStep(int max_work)
+{
+    // Only the dynamic arrays of managed handles are known to hold references
+    // to other objects. Count references that come from the arrays: if an object
+    // has more than that, then it is also referenced from the script memory or
+    // by the engine, and everything it refers to is alive. Objects which are
+    // not arrays or user structs are always considered alive, and so are the
+    // ones with zero refcount, which may be temporarily held by script.
+    int work = 0;
+    while (work < max_work)
+    {
+        switch (cyclePhase)
+        {
+        case kCycles_CountRefs:
+            if (cycleCursor >= cycleObjects)
+            {
+                if (!cycleHasArrays)
+                {
+                    cyclePhase = kCycles_Idle;
+                    return 0;
+                }
+                cycleCursor = 1;
+                cyclePhase = kCycles_MarkRoots;
+                break;
+            }
+            if (IsManagedArray(cycleCursor))
+            {
+                cycleHasArrays = true;
+                if (!ScanArrayElements(cycleCursor, true, work, max_work))
+                    return 0;
+            }
+            cycleCursor++;
+            work++;
+            break;
+        case kCycles_MarkRoots:
+            if (cycleCursor >= cycleObjects)
+            {
+                cyclePhase = kCycles_Trace;
+                break;
+            }
+            if ((objects[cycleCursor].handle != 0) && !reachable[cycleCursor] &&
+                (!objects[cycleCursor].collectable || (objects[cycleCursor].refCount < 1) ||
+                 (objects[cycleCursor].refCount > arrayRefs[cycleCursor])))
+            {
+                reachable[cycleCursor] = 1;
+                pending.push_back(cycleCursor);
+            }
+            cycleCursor++;
+            work++;
+            break;
+        case kCycles_Trace:
+            if (cycleArray == 0)
+            {
+                if (pending.empty())
+                {
+                    cycleCursor = 1;
+                    cyclePhase = kCycles_Sweep;
+                    break;
                 }
+                cycleArray = pending.back();
+                pending.pop_back();
+                cycleElement = 0;
+                work++;
             }
+            // the array could have been disposed since it was found
+            if (IsManagedArray(cycleArray) && !ScanArrayElements(cycleArray, false, work, max_work))
+                return 0;
+            cycleArray = 0;
+            break;
+        case kCycles_Sweep:
+            if (cycleCursor >= cycleObjects)
+                return FreeCycleGarbage();
+            if ((objects[cycleCursor].handle != 0) && !reachable[cycleCursor])
+                garbage.push_back(cycleCursor);
+            cycleCursor++;
+            work++;
+            break;
+        default:
+            return 0;
         }
-        // no empty slots, expand array
-        while (useSlot >= arrayAllocLimit)
-            arrayAllocLimit += ARRAY_INCREMENT_SIZE;
-
-        objects = (ManagedObject*)realloc(objects, sizeof(ManagedObject) * arrayAllocLimit);
-        memset(&objects[useSlot], 0, sizeof(ManagedObject) * ARRAY_INCREMENT_SIZE);
-        objects[useSlot].init(useSlot, address, callback, plugin_object ? kScValPluginObject : kScValDynamicObject);
-        if (useSlot == numObjects)
-            numObjects++;
-        return useSlot;
     }
+    return 0;
+}
+
+int ManagedObjectPool::FreeCycleGarbage()
+{
+    // stop tracking the changes before releasing the references below
+    cyclePhase = kCycles_Idle;
+    pending.clear();
+
+    // skip the objects disposed meanwhile; if any object was found to be
+    // still in use, then the pass cannot be trusted
+    size_t num_garbage = 0;
+    for (size_t i = 0; i < garbage.size(); i++)
+    {
+        if (reachable[garbage[i]])
+            return 0;
+        if (objects[garbage[i]].handle != 0)
+            garbage[num_garbage++] = garbage[i];
+    }
+    garbage.resize(num_garbage);
+    if (garbage.empty())
+        return 0;
+
+    // Hold the garbage objects while releasing references between them,
+    // so that none is disposed before the others are detached
+    for (size_t i = 0; i < garbage.size(); i++)
+        objects[garbage[i]].AddRef();
+    for (size_t i = 0; i < garbage.size(); i++)
+    {
+        if (!IsManagedArray(garbage[i]))
+            continue;
+        int32_t *header = DynamicArrayHeader(objects[garbage[i]].addr);
+        header[0] &= ~ARRAY_MANAGED_TYPE_FLAG;
+        int32_t *elements = DynamicArrayElements(objects[garbage[i]].addr);
+        for (int32_t e = 0; e < header[0]; e++)
+        {
+            const int32_t ref = elements[e];
+            elements[e] = 0;
+            if (HandleToAddress(ref) != NULL)
+                SubRef(ref);
+        }
+    }
+    int freed = 0;
+    for (size_t i = 0; i < garbage.size(); i++)
+        freed += RemoveAt(garbage[i], true);
+    garbage.clear();
+    ManagedObjectLog("Cycle collection disposed %d objects", freed);
+    return freed;
+}
+
+int ManagedObjectPool::CollectCycles()
+{
+    BeginCycleCollection();
+    return RunCycleCollectionStep(INT_MAX);
+}
+
+const ManagedPoolGCStats &ManagedObjectPool::GetGCStats() const
+{
+    return gcStats;
+}
+
+void ManagedObjectPool::EnsureCapacity(int slot) {
+    if (slot < arrayAllocLimit)
+        return;
+    // grow geometrically, so that registering many objects takes linear time
+    int newAllocLimit = arrayAllocLimit;
+    while (slot >= newAllocLimit)
+        newAllocLimit *= 2;
+
+    objects = (ManagedObject*)realloc(objects, sizeof(ManagedObject) * newAllocLimit);
+    memset(&objects[arrayAllocLimit], 0, sizeof(ManagedObject) * (newAllocLimit - arrayAllocLimit));
+    arrayAllocLimit = newAllocLimit;
+}
+
+int ManagedObjectPool::AddObject(const char *address, ICCDynamicObject *callback, bool plugin_object, int useSlot) {
+    if (useSlot == -1) {
+        // reuse the most recently freed slot, since newer objects don't
+        // tend to last long; skip the ones taken by restored objects
+        while (!freeSlots.empty()) {
+            int32_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            if ((slot < numObjects) && (objects[slot].handle == 0)) {
+                useSlot = slot;
+                break;
+            }
+        }
+        if (useSlot == -1)
+            useSlot = numObjects;
+    }
+
+    objectCreationCounter++;
+
+    EnsureCapacity(useSlot);
+    objects[useSlot].init(useSlot, address, callback, plugin_object ? kScValPluginObject : kScValDynamicObject);
+    MarkChanged(useSlot);
+    handleByAddress[address] = useSlot;
+    if (useSlot >= numObjects) {
+        // slots skipped over by the restored object are free to use
+        for (int i = numObjects; i < useSlot; i++)
+            freeSlots.push_back(i);
+        numObjects = useSlot + 1;
+    }
+    return useSlot;
 }
 
 void ManagedObjectPool::WriteToDisk(Stream *out) {
@@ -254,11 +510,9 @@ int ManagedObjectPool::ReadFromDisk(Stream *in, ICCObjectReader *reader) {
 
     int numObjs = in->ReadInt32();
 
-    if (numObjs >= arrayAllocLimit) {
-        arrayAllocLimit = numObjs + ARRAY_INCREMENT_SIZE;
-        free(objects);
-        objects = (ManagedObject*)calloc(sizeof(ManagedObject), arrayAllocLimit);
-    }
+    // the restored references were not tracked
+    cyclePhase = kCycles_Idle;
+    EnsureCapacity(numObjs);
     numObjects = numObjs;
 
     for (int i = 1; i < numObjs; i++) {
@@ -284,6 +538,13 @@ int ManagedObjectPool::ReadFromDisk(Stream *in, ICCObjectReader *reader) {
         }
     }
 
+    // gather slots that were not used by the restored objects
+    freeSlots.clear();
+    for (int i = numObjects - 1; i >= 1; i--) {
+        if (objects[i].handle == 0)
+            freeSlots.push_back(i);
+    }
+
     free(serializeBuffer);
     return 0;
 }
@@ -296,12 +557,24 @@ void ManagedObjectPool::reset() {
     }
     memset(&objects[0], 0, sizeof(ManagedObject) * arrayAllocLimit);
     numObjects = 1;
+    handleByAddress.clear();
+    freeSlots.clear();
+    gcCursor = 1;
+    cyclePhase = kCycles_Idle;
 }
 
 ManagedObjectPool::ManagedObjectPool() {
     numObjects = 1;
-    arrayAllocLimit = 10;
+    arrayAllocLimit = ARRAY_INITIAL_SIZE;
     objects = (ManagedObject*)calloc(sizeof(ManagedObject), arrayAllocLimit);
+    objectCreationCounter = 0;
+    gcCursor = 1;
+    cyclePhase = kCycles_Idle;
+    cycleObjects = 0;
+    cycleCursor = 0;
+    cycleArray = 0;
+    cycleElement = 0;
+    cycleHasArrays = false;
     disableDisposeForObject = NULL;
 }
 
@@ -15,6 +15,9 @@
 #ifndef __CC_MANAGEDOBJECTPOOL_H
 #define __CC_MANAGEDOBJECTPOOL_H
 
+#include <vector>
+#include "util/stdtr1compat.h"
+#include TR1INCLUDE(unordered_map)
 #include "ac/dynobj/cc_dynamicobject.h"   // ICCDynamicObject
 
 namespace AGS { namespace Common { class Stream; }}
@@ -22,8 +25,24 @@ using namespace AGS; // FIXME later
 
 #define OBJECT_CACHE_MAGIC_NUMBER 0xa30b
 #define SERIALIZE_BUFFER_SIZE 10240
-const int ARRAY_INCREMENT_SIZE = 100;
+const int ARRAY_INITIAL_SIZE = 100;
 const int GARBAGE_COLLECTION_INTERVAL = 100;
+// Number of slots (and array elements, when looking for unreachable
+// cycles) checked by a single incremental garbage collection step
+const int GARBAGE_COLLECTION_SLOTS_PER_STEP = 256;
+
+// Statistics of the managed objects garbage collection
+struct ManagedPoolGCStats {
+    uint32_t Steps;         // incremental steps run
+    uint32_t FullSweeps;    // complete passes over the object slots
+    uint32_t ObjectsFreed;  // objects disposed because nothing refers to them
+    uint32_t CycleObjectsFreed; // objects disposed as parts of unreachable cycles
+    uint32_t LastPauseUs;   // duration of the last step, in microseconds
+    uint32_t MaxPauseUs;    // longest step duration
+    uint64_t TotalPauseUs;  // total time spent in the collector
+
+    ManagedPoolGCStats();
+};
 
 struct ManagedObjectPool {
     struct ManagedObject {
@@ -32,21 +51,66 @@ struct ManagedObjectPool {
         const char *addr;
         ICCDynamicObject * callback;
         int  refCount;
+        bool collectable;   // may be a part of an unreachable cycle
 
         void init(int32_t theHandle, const char *theAddress,
             ICCDynamicObject *theCallback, ScriptValueType objType);
         int remove(bool force);
         int AddRef();
-        int CheckDispose();
-        int SubRef();
         void SubRefNoDispose();
     };
 private:
+    typedef stdtr1compat::unordered_map<const char*, int32_t> AddressToHandleMap;
 
     ManagedObject *objects;
     int arrayAllocLimit;
     int numObjects;  // not actually numObjects, but the highest index used
     int objectCreationCounter;  // used to do garbage collection every so often
+    // Handles of the registered objects, indexed by their address
+    AddressToHandleMap handleByAddress;
+    // Unused slots below numObjects; may contain stale entries for the slots
+    // that were taken explicitly when restoring objects, these are skipped
+    std::vector<int32_t> freeSlots;
+    int gcCursor;   // next slot to check by the incremental collector
+    ManagedPoolGCStats gcStats;
+
+    // Phases of the pass looking for the unreachable cycles
+    enum CyclePhase
+    {
+        kCycles_Idle,
+        kCycles_CountRefs,  // counting references held by the arrays
+        kCycles_MarkRoots,  // finding objects referenced from elsewhere
+        kCycles_Trace,      // marking everything reachable from those
+        kCycles_Sweep       // listing the unreachable objects
+    };
+    CyclePhase cyclePhase;
+    int32_t cycleObjects;   // number of slots when the pass has begun
+    int32_t cycleCursor;    // next slot to check in the current phase
+    int32_t cycleArray;     // array which elements are being traced
+    int32_t cycleElement;   // next element of the array being processed
+    bool cycleHasArrays;
+    // State of the pass, kept between the passes to reuse the memory
+    std::vector<int32_t> arrayRefs;
+    std::vector<char> reachable;
+    std::vector<int32_t> pending;
+    std::vector<int32_t> garbage;
+
+    // Disposes object and releases its slot; returns 1 if object was removed
+    int RemoveAt(int32_t handle, bool force);
+    // Makes sure that there's enough space for the given slot index
+    void EnsureCapacity(int slot);
+    // Tells if the object is a dynamic array of managed handles
+    bool IsManagedArray(int32_t handle) const;
+    // Keeps the object alive through the current cycle collection pass,
+    // because the references to it were changed since the pass began
+    void MarkChanged(int32_t handle);
+    // Starts a new pass looking for the unreachable cycles
+    void BeginCycleCollection();
+    // Counts or traces the array elements from cycleElement on, within the
+    // work limit; returns false if the limit was reached before the end
+    bool ScanArrayElements(int32_t handle, bool count_refs, int &work, int max_work);
+    // Disposes the unreachable objects found by the finished pass
+    int FreeCycleGarbage();
 
 public:
 
@@ -59,6 +123,17 @@ public:
     int RemoveObject(const char *address);
     void RunGarbageCollectionIfAppropriate();
     void RunGarbageCollection();
+    // Checks up to max_slots slots, continuing where the previous step
+    // stopped; starts cycle collection each time all slots were checked,
+    // and lets it take the following steps until it is done
+    void RunGarbageCollectionStep(int max_slots);
+    // Advances the cycle collection pass by up to max_work slots and array
+    // elements; returns number of objects disposed if the pass was finished
+    int  RunCycleCollectionStep(int max_work);
+    // Disposes groups of objects that only refer to each other in one go,
+    // returns number of the disposed objects
+    int  CollectCycles();
+    const ManagedPoolGCStats &GetGCStats() const;
     int AddObject(const char *address, ICCDynamicObject *callback, bool plugin_object, int useSlot = -1);
     void WriteToDisk(Common::Stream *out);
     int ReadFromDisk(Common::Stream *in, ICCObjectReader *reader);
@@ -15,10 +15,12 @@
 #include <memory.h>
 #include "scriptuserobject.h"
 
+const char *ScriptUserObject::TypeName = "UserObject";
+
 // return the type name of the object
 const char *ScriptUserObject::GetType()
 {
-    return "UserObject";
+    return TypeName;
 }
 
 ScriptUserObject::ScriptUserObject()
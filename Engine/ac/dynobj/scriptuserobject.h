@@ -26,6 +26,9 @@ public:
     ScriptUserObject();
     virtual ~ScriptUserObject();
 
+    // type name returned by every user object, may be compared by pointer
+    static const char *TypeName;
+
     static ScriptUserObject *CreateManaged(size_t size);
     void            Create(const char *data, size_t size);
 
@@ -382,16 +382,19 @@ PACKFILE *PackfileFromAsset(const AssetPath &path)
 {
     AssetLocation loc;
     if (LocateAsset(path, loc))
+        return PackfileFromLocation(loc.FileName, loc.Offset, loc.Size);
+    return NULL;
+}
+
+PACKFILE *PackfileFromLocation(const char *file_name, int offset, int size)
+{
+    PACKFILE *pf = pack_fopen(file_name, File::GetCMode(kFile_Open, kFile_Read));
+    if (pf)
     {
-        PACKFILE *pf = pack_fopen(loc.FileName, File::GetCMode(kFile_Open, kFile_Read));
-        if (pf)
-        {
-            pack_fseek(pf, loc.Offset);
-            pf->normal.todo = loc.Size;
-        }
-        return pf;
+        pack_fseek(pf, offset);
+        pf->normal.todo = size;
     }
-    return NULL;
+    return pf;
 }
 
 DUMBFILE *DUMBfileFromAsset(const AssetPath &path)
@@ -22,9 +22,14 @@ GameSetup::GameSetup()
     mod_player=1;
     mp3_player=1;
     no_speech_pack = false;
+    audio_load_latency = 200;
     enable_antialiasing = false;
     force_hicolor_mode = false;
     disable_exception_handling = false;
+    mmap_assets = false;
+    draw_threads = -1;
+    dirty_rects = true;
+    show_dirty_rects = false;
     mouse_auto_lock = false;
     override_script_os = -1;
     override_multitasking = -1;
@@ -42,9 +42,14 @@ struct GameSetup {
     int textheight; // text height used on the certain built-in GUI
     int mp3_player;
     bool  no_speech_pack;
+    int   audio_load_latency; // max ms a clip may wait to be read in background, 0 to read clips right away
     bool  enable_antialiasing;
     bool  force_hicolor_mode;
     bool  disable_exception_handling;
+    bool  mmap_assets; // read game data from memory mapped files
+    int   draw_threads; // threads preparing room sprites, -1 to choose automatically
+    bool  dirty_rects; // software renderer redraws only the changed parts of the screen
+    bool  show_dirty_rects; // outline the redrawn parts of the screen
     AGS::Common::String data_files_dir;
     AGS::Common::String main_data_filename;
     AGS::Common::String install_dir; // optional custom install dir path
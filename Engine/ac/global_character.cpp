@@ -481,7 +481,7 @@ void update_invorder() {
     // backwards compatibility
     play.obsolete_inv_numorder = charextra[game.playercharacter].invorder_count;
 
-    guis_need_update = 1;
+    mark_all_guis_changed();
 }
 
 void add_inventory(int inum) {
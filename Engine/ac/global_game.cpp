@@ -40,6 +40,8 @@
 #include "ac/room.h"
 #include "ac/roomstatus.h"
 #include "ac/roomstruct.h"
+#include "ac/spriteprefetch.h"
+#include "ac/spritetransformcache.h"
 #include "ac/string.h"
 #include "ac/system.h"
 #include "debug/debugger.h"
@@ -89,7 +91,7 @@ extern int psp_gfx_renderer;
 
 void GiveScore(int amnt) 
 {
-    guis_need_update = 1;
+    mark_all_guis_changed();
     play.score += amnt;
 
     if ((amnt > 0) && (play.score_sound >= 0))
@@ -276,9 +278,12 @@ int RunAGSGame (const char *newgame, unsigned int mode, int data) {
     if (!load_game_file(err_str))
         quitprintf("!RunAGSGame: error loading new game file:\n%s", err_str.GetCStr());
 
+    shutdown_sprite_prefetch();
+    clear_sprite_transform_cache();
     spriteset.reset();
     if (spriteset.initFile ("acsprset.spr"))
         quit("!RunAGSGame: error loading new sprites");
+    init_sprite_prefetch("acsprset.spr");
 
     if ((mode & RAGMODE_PRESERVEGLOBALINT) == 0) {
         // reset GlobalInts
@@ -539,13 +544,13 @@ void GetLocationName(int xxx,int yyy,char*tempo) {
         int mover = GetInvAt (xxx, yyy);
         if (mover > 0) {
             if (play.get_loc_name_last_time != 1000 + mover)
-                guis_need_update = 1;
+                mark_all_guis_changed();
             play.get_loc_name_last_time = 1000 + mover;
             strcpy(tempo,get_translation(game.invinfo[mover].name));
         }
         else if ((play.get_loc_name_last_time > 1000) && (play.get_loc_name_last_time < 1000 + MAX_INV)) {
             // no longer selecting an item
-            guis_need_update = 1;
+            mark_all_guis_changed();
             play.get_loc_name_last_time = -1;
         }
         return;
@@ -561,7 +566,7 @@ void GetLocationName(int xxx,int yyy,char*tempo) {
     if (loctype == 0) {
         if (play.get_loc_name_last_time != 0) {
             play.get_loc_name_last_time = 0;
-            guis_need_update = 1;
+            mark_all_guis_changed();
         }
         return;
     }
@@ -571,7 +576,7 @@ void GetLocationName(int xxx,int yyy,char*tempo) {
         onhs = getloctype_index;
         strcpy(tempo,get_translation(game.chars[onhs].name));
         if (play.get_loc_name_last_time != 2000+onhs)
-            guis_need_update = 1;
+            mark_all_guis_changed();
         play.get_loc_name_last_time = 2000+onhs;
         return;
     }
@@ -586,14 +591,14 @@ void GetLocationName(int xxx,int yyy,char*tempo) {
             tempo[1] = 0;
         }
         if (play.get_loc_name_last_time != 3000+aa)
-            guis_need_update = 1;
+            mark_all_guis_changed();
         play.get_loc_name_last_time = 3000+aa;
         return;
     }
     onhs = getloctype_index;
     if (onhs>0) strcpy(tempo,get_translation(thisroom.hotspotnames[onhs]));
     if (play.get_loc_name_last_time != onhs)
-        guis_need_update = 1;
+        mark_all_guis_changed();
     play.get_loc_name_last_time = onhs;
 }
 
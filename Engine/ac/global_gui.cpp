@@ -62,7 +62,7 @@ void InterfaceOn(int ifn) {
     debug_script_log("GUIOn(%d) ignored (already on)", ifn);
     return;
   }
-  guis_need_update = 1;
+  guis[ifn].MarkChanged();
   guis[ifn].SetVisibility(kGUIVisibility_On);
   debug_script_log("GUI %d turned on", ifn);
   // modal interface
@@ -87,7 +87,7 @@ void InterfaceOff(int ifn) {
     guis[ifn].MouseOverCtrl = -1;
   }
   guis[ifn].OnControlPositionChanged();
-  guis_need_update = 1;
+  guis[ifn].MarkChanged();
   // modal interface
   if (guis[ifn].PopupStyle==kGUIPopupModal) UnPauseGame();
   else if (guis[ifn].PopupStyle==kGUIPopupMouseY) guis[ifn].SetVisibility(kGUIVisibility_Concealed);
@@ -205,12 +205,12 @@ void SetGUIBackgroundPic (int guin, int slotn) {
 
 void DisableInterface() {
   play.disabled_user_interface++;
-  guis_need_update = 1;
+  mark_all_guis_changed();
   set_mouse_cursor(CURS_WAIT);
   }
 
 void EnableInterface() {
-  guis_need_update = 1;
+  mark_all_guis_changed();
   play.disabled_user_interface--;
   if (play.disabled_user_interface<1) {
     play.disabled_user_interface=0;
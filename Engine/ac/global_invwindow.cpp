@@ -35,6 +35,6 @@ void SetInvDimensions(int ww,int hh) {
         guiinv[i].itemWidth = ww;
         guiinv[i].itemHeight = hh;
         guiinv[i].Resized();
+        guiinv[i].MarkChanged();
     }
-    guis_need_update = 1;
 }
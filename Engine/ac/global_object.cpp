@@ -13,6 +13,7 @@
 //=============================================================================
 
 #include <stdio.h>
+#include <vector>
 #include "ac/global_object.h"
 #include "ac/common.h"
 #include "ac/object.h"
@@ -26,6 +27,7 @@
 #include "ac/object.h"
 #include "ac/objectcache.h"
 #include "ac/properties.h"
+#include "ac/roomindex.h"
 #include "ac/roomobject.h"
 #include "ac/roomstatus.h"
 #include "ac/roomstruct.h"
@@ -61,13 +63,18 @@ extern IGraphicsDriver *gfxDriver;
 // Used for deciding whether a char or obj was closer
 int obj_lowest_yp;
 
+// Room objects found at the tested location, kept between calls
+static std::vector<int> pos_test_objects;
+
 int GetObjectAt(int xx,int yy) {
     int aa,bestshotyp=-1,bestshotwas=-1;
     // translate screen co-ordinates to room co-ordinates
     xx += divide_down_coordinate(offsetx);
     yy += divide_down_coordinate(offsety);
-    // Iterate through all objects in the room
-    for (aa=0;aa<croom->numobj;aa++) {
+    // Iterate through the room objects whose box contains the location
+    find_room_objects_at(xx, yy, pos_test_objects);
+    for (size_t i = 0; i < pos_test_objects.size(); i++) {
+        aa = pos_test_objects[i];
         if (objs[aa].on != 1) continue;
         if (objs[aa].flags & OBJF_NOINTERACT)
             continue;
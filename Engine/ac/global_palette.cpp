@@ -17,11 +17,18 @@
 #include "ac/gamesetupstruct.h"
 #include "ac/gamestate.h"
 #include "ac/global_palette.h"
+#include "ac/spritetransformcache.h"
 
 extern GameSetupStruct game;
 extern GameState play;
 extern color palette[256];
 
+// In 256-colour games the transformed sprites depend on the palette
+static void on_palette_change()
+{
+    if (game.color_depth == 1)
+        clear_sprite_transform_cache();
+}
 
 void CyclePalette(int strt,int eend) {
     // hi-color game must invalidate screen since the palette changes
@@ -42,7 +49,7 @@ void CyclePalette(int strt,int eend) {
         wcolrotate(eend, strt, 1, palette);
         set_palette_range(palette, eend, strt, 0);
     }
-
+    on_palette_change();
 }
 void SetPalRGB(int inndx,int rr,int gg,int bb) {
     if (game.color_depth > 1)
@@ -50,6 +57,7 @@ void SetPalRGB(int inndx,int rr,int gg,int bb) {
 
     wsetrgb(inndx,rr,gg,bb,palette);
     set_palette_range(palette, inndx, inndx, 0);
+    on_palette_change();
 }
 /*void scSetPal(color*pptr) {
 wsetpalette(0,255,pptr);
@@ -64,4 +72,5 @@ void UpdatePalette() {
 
     if (!play.fast_forward)  
         setpal();
+    on_palette_change();
 }
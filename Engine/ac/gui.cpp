@@ -38,7 +38,9 @@
 #include "device/mousew32.h"
 #include "gfx/gfxfilter.h"
 #include "gui/guibutton.h"
+#include "gui/guiinv.h"
 #include "gui/guimain.h"
+#include "gui/guislider.h"
 #include "script/script.h"
 #include "script/script_runtime.h"
 #include "gfx/graphicsdriver.h"
@@ -133,7 +135,7 @@ void GUI_SetSize(ScriptGUI *sgui, int widd, int hitt) {
   
   recreate_guibg_image(tehgui);
 
-  guis_need_update = 1;
+  tehgui->MarkChanged();
 }
 
 int GUI_GetWidth(ScriptGUI *sgui) {
@@ -212,7 +214,7 @@ void GUI_Centre(ScriptGUI *sgui) {
 void GUI_SetBackgroundGraphic(ScriptGUI *tehgui, int slotn) {
   if (guis[tehgui->id].BgImage != slotn) {
     guis[tehgui->id].BgImage = slotn;
-    guis_need_update = 1;
+    guis[tehgui->id].MarkChanged();
   }
 }
 
@@ -266,7 +268,7 @@ void remove_popup_interface(int ifacenum) {
         set_default_cursor();
 
     if (ifacenum==mouse_on_iface) mouse_on_iface=-1;
-    guis_need_update = 1;
+    guis[ifacenum].MarkChanged();
 }
 
 void process_interface_click(int ifce, int btn, int mbut) {
@@ -451,11 +453,35 @@ void update_gui_disabled_status() {
         for (int aa = 0; aa < game.numgui; aa++) {
             guis[aa].OnControlPositionChanged();
         }
-        guis_need_update = 1;
+        mark_all_guis_changed();
         invalidate_screen();
     }
 }
 
+void mark_guis_using_sprite_changed(int sprite) {
+    for (int aa = 0; aa < game.numgui; aa++) {
+        if (guis[aa].BgImage == sprite)
+            guis[aa].MarkChanged();
+    }
+    for (int aa = 0; aa < numguibuts; aa++) {
+        if ((guibuts[aa].pic == sprite) || (guibuts[aa].usepic == sprite) ||
+            (guibuts[aa].overpic == sprite) || (guibuts[aa].pushedpic == sprite))
+            guibuts[aa].MarkChanged();
+    }
+    for (int aa = 0; aa < numguislider; aa++) {
+        if ((guislider[aa].handlepic == sprite) || (guislider[aa].bgimage == sprite))
+            guislider[aa].MarkChanged();
+    }
+    // inventory windows may show any item
+    for (int aa = 1; aa < game.numinvitems; aa++) {
+        if (game.invinfo[aa].pic == sprite) {
+            for (int bb = 0; bb < numguiinv; bb++)
+                guiinv[bb].MarkChanged();
+            break;
+        }
+    }
+}
+
 
 int adjust_x_for_guis (int xx, int yy) {
     if ((game.options[OPT_DISABLEOFF]==3) && (all_buttons_disabled > 0))
@@ -551,7 +577,7 @@ int gui_on_mouse_move()
 
             if (mousey < guis[guin].PopupAtMouseY) {
                 set_mouse_cursor(CURS_ARROW);
-                guis[guin].SetVisibility(kGUIVisibility_On); guis_need_update = 1;
+                guis[guin].SetVisibility(kGUIVisibility_On);
                 ifacepopped=guin; PauseGame();
                 break;
             }
@@ -57,6 +57,9 @@ void	export_gui_controls(int ee);
 void	unexport_gui_controls(int ee);
 int		convert_gui_disabled_style(int oldStyle);
 void	update_gui_disabled_status();
+// Marks the guis and controls which display the sprite as changed, after
+// the sprite's image was changed
+void	mark_guis_using_sprite_changed(int sprite);
 int		adjust_x_for_guis (int xx, int yy);
 int		adjust_y_for_guis ( int yy);
 void	recreate_guibg_image(GUIMain *tehgui);
@@ -67,7 +67,7 @@ void GUIControl_SetVisible(GUIObject *guio, int visible)
       guio->Hide();
 
     guis[guio->guin].OnControlPositionChanged();
-    guis_need_update = 1;
+    guio->MarkChanged();
   }
 }
 
@@ -84,7 +84,7 @@ void GUIControl_SetClickable(GUIObject *guio, int enabled) {
     guio->SetClickable(false);
 
   guis[guio->guin].OnControlPositionChanged();
-  guis_need_update = 1;
+  guio->MarkChanged();
 }
 
 int GUIControl_GetEnabled(GUIObject *guio) {
@@ -100,7 +100,7 @@ void GUIControl_SetEnabled(GUIObject *guio, int enabled) {
     guio->Disable();
 
   guis[guio->guin].OnControlPositionChanged();
-  guis_need_update = 1;
+  guio->MarkChanged();
 }
 
 
@@ -161,7 +161,7 @@ int GUIControl_GetX(GUIObject *guio) {
 void GUIControl_SetX(GUIObject *guio, int xx) {
   guio->x = multiply_up_coordinate(xx);
   guis[guio->guin].OnControlPositionChanged();
-  guis_need_update = 1;
+  guio->MarkChanged();
 }
 
 int GUIControl_GetY(GUIObject *guio) {
@@ -171,7 +171,7 @@ int GUIControl_GetY(GUIObject *guio) {
 void GUIControl_SetY(GUIObject *guio, int yy) {
   guio->y = multiply_up_coordinate(yy);
   guis[guio->guin].OnControlPositionChanged();
-  guis_need_update = 1;
+  guio->MarkChanged();
 }
 
 int GUIControl_GetZOrder(GUIObject *guio)
@@ -182,7 +182,7 @@ int GUIControl_GetZOrder(GUIObject *guio)
 void GUIControl_SetZOrder(GUIObject *guio, int zorder)
 {
     if (guis[guio->guin].SetControlZOrder(guio->objn, zorder))
-        guis_need_update = 1;
+        guis[guio->guin].MarkChanged();
 }
 
 void GUIControl_SetPosition(GUIObject *guio, int xx, int yy) {
@@ -199,7 +199,7 @@ void GUIControl_SetWidth(GUIObject *guio, int newwid) {
   guio->wid = multiply_up_coordinate(newwid);
   guio->Resized();
   guis[guio->guin].OnControlPositionChanged();
-  guis_need_update = 1;
+  guio->MarkChanged();
 }
 
 int GUIControl_GetHeight(GUIObject *guio) {
@@ -210,7 +210,7 @@ void GUIControl_SetHeight(GUIObject *guio, int newhit) {
   guio->hit = multiply_up_coordinate(newhit);
   guio->Resized();
   guis[guio->guin].OnControlPositionChanged();
-  guis_need_update = 1;
+  guio->MarkChanged();
 }
 
 void GUIControl_SetSize(GUIObject *guio, int newwid, int newhit) {
@@ -224,12 +224,12 @@ void GUIControl_SetSize(GUIObject *guio, int newwid, int newhit) {
 
 void GUIControl_SendToBack(GUIObject *guio) {
   if (guis[guio->guin].SendControlToBack(guio->objn))
-    guis_need_update = 1;
+    guis[guio->guin].MarkChanged();
 }
 
 void GUIControl_BringToFront(GUIObject *guio) {
   if (guis[guio->guin].BringControlToFront(guio->objn))
-    guis_need_update = 1;
+    guis[guio->guin].MarkChanged();
 }
 
 //=============================================================================
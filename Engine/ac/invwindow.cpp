@@ -65,7 +65,7 @@ void InvWindow_SetCharacterToUse(GUIInv *guii, CharacterInfo *chaa) {
   // reset to top of list
   guii->topIndex = 0;
 
-  guis_need_update = 1;
+  guii->MarkChanged();
 }
 
 CharacterInfo* InvWindow_GetCharacterToUse(GUIInv *guii) {
@@ -96,7 +96,7 @@ int InvWindow_GetItemHeight(GUIInv *guii) {
 void InvWindow_SetTopItem(GUIInv *guii, int topitem) {
   if (guii->topIndex != topitem) {
     guii->topIndex = topitem;
-    guis_need_update = 1;
+    guii->MarkChanged();
   }
 }
 
@@ -120,7 +120,7 @@ void InvWindow_ScrollDown(GUIInv *guii) {
   if ((charextra[guii->CharToDisplay()].invorder_count) >
       (guii->topIndex + (guii->itemsPerLine * guii->numLines))) { 
     guii->topIndex += guii->itemsPerLine;
-    guis_need_update = 1;
+    guii->MarkChanged();
   }
 }
 
@@ -130,7 +130,7 @@ void InvWindow_ScrollUp(GUIInv *guii) {
     if (guii->topIndex < 0)
       guii->topIndex = 0;
 
-    guis_need_update = 1;
+    guii->MarkChanged();
   }
 }
 
@@ -507,7 +507,7 @@ int invscreen() {
     int selt=__actual_invscreen();
     if (selt<0) return -1;
     playerchar->activeinv=selt;
-    guis_need_update = 1;
+    mark_all_guis_changed();
     set_cursor_mode(MODE_USE);
     return selt;
 }
@@ -35,7 +35,7 @@ void Label_SetText(GUILabel *labl, const char *newtx) {
     newtx = get_translation(newtx);
 
     if (strcmp(labl->GetText(), newtx)) {
-        guis_need_update = 1;
+        labl->MarkChanged();
         labl->SetText(newtx);
     }
 }
@@ -47,7 +47,7 @@ int Label_GetColor(GUILabel *labl) {
 void Label_SetColor(GUILabel *labl, int colr) {
     if (labl->textcol != colr) {
         labl->textcol = colr;
-        guis_need_update = 1;
+        labl->MarkChanged();
     }
 }
 
@@ -61,7 +61,7 @@ void Label_SetFont(GUILabel *guil, int fontnum) {
 
     if (fontnum != guil->font) {
         guil->font = fontnum;
-        guis_need_update = 1;
+        guil->MarkChanged();
     }
 }
 
@@ -210,7 +210,7 @@ void set_cursor_mode(int newmode) {
     if ((newmode < 0) || (newmode >= game.numcursors))
         quit("!SetCursorMode: invalid cursor mode specified");
 
-    guis_need_update = 1;
+    mark_all_guis_changed();
     if (game.mcurs[newmode].flags & MCF_DISABLED) {
         find_next_enabled_cursor(newmode);
         return; }
@@ -239,9 +239,9 @@ void enable_cursor_mode(int modd) {
             if (gbpt->leftclick!=IBACT_SETMODE) continue;
             if (gbpt->lclickdata!=modd) continue;
             gbpt->Enable();
+            gbpt->MarkChanged();
         }
     }
-    guis_need_update = 1;
 }
 
 void disable_cursor_mode(int modd) {
@@ -256,10 +256,10 @@ void disable_cursor_mode(int modd) {
             if (gbpt->leftclick!=IBACT_SETMODE) continue;
             if (gbpt->lclickdata!=modd) continue;
             gbpt->Disable();
+            gbpt->MarkChanged();
         }
     }
     if (cur_mode==modd) find_next_enabled_cursor(modd);
-    guis_need_update = 1;
 }
 
 void RefreshMouse() {
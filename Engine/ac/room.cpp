@@ -36,9 +36,13 @@
 #include "ac/region.h"
 #include "ac/record.h"
 #include "ac/room.h"
+#include "ac/roomindex.h"
 #include "ac/roomobject.h"
 #include "ac/roomstatus.h"
+#include "ac/route_finder.h"
 #include "ac/screen.h"
+#include "ac/spriteprefetch.h"
+#include "ac/spritetransformcache.h"
 #include "ac/string.h"
 #include "ac/system.h"
 #include "ac/viewport.h"
@@ -266,6 +270,11 @@ void unload_old_room() {
     ds->Fill(0);
     for (ff=0;ff<croom->numobj;ff++)
         objs[ff].moving = 0;
+    set_room_navigation_mask(NULL);
+    invalidate_room_characters();
+    // in 256-colour games the transformed sprites depend on the room palette
+    if (game.color_depth == 1)
+        clear_sprite_transform_cache();
 
     if (!play.ambient_sounds_persist) {
         for (ff = 1; ff < MAX_SOUND_CHANNELS; ff++)
@@ -604,6 +613,7 @@ void load_new_room(int newnum, CharacterInfo*forchar) {
     our_eip=204;
     update_polled_stuff_if_runtime();
     redo_walkable_areas();
+    set_room_navigation_mask(thisroom.walls);
     // fix walk-behinds to current screen resolution
     thisroom.object = fix_bitmap_size(thisroom.object);
     update_polled_stuff_if_runtime();
@@ -817,6 +827,7 @@ void load_new_room(int newnum, CharacterInfo*forchar) {
             StopMoving(cc);
 
     }
+    invalidate_room_characters();
 
     update_polled_stuff_if_runtime();
 
@@ -955,6 +966,8 @@ void load_new_room(int newnum, CharacterInfo*forchar) {
         forchar->frame=0;   // make him standing
     }
     color_map = NULL;
+    // start reading the sprites which are about to be drawn
+    prefetch_room_sprites();
 
     our_eip = 209;
     update_polled_stuff_if_runtime();
@@ -979,7 +992,7 @@ void load_new_room(int newnum, CharacterInfo*forchar) {
     our_eip=220;
     update_polled_stuff_if_runtime();
     debug_script_log("Now in room %d", displayed_room);
-    guis_need_update = 1;
+    mark_all_guis_changed();
     pl_run_plugin_hooks(AGSE_ENTERROOM, displayed_room);
     //  MoveToWalkableArea(game.playercharacter);
     //  MSS_CHECK_ALL_BLOCKS;
@@ -1035,7 +1048,7 @@ void new_room(int newnum,CharacterInfo*forchar) {
                 gfxDriver->DestroyDDB(guibgbmp[i]);
             guibgbmp[i] = NULL;
         }
-        guis_need_update = 1;
+        mark_all_guis_changed();
     }
 
     update_polled_stuff_if_runtime();
@@ -1128,9 +1141,13 @@ void on_background_frame_change () {
         return;
 
     // 256-colours, tell it to update the palette (will actually be done as
-    // close as possible to the screen update to prevent flicker problem)
+    // close as possible to the screen update to prevent flicker problem);
+    // the transformed sprites depend on the palette too
     if (game.color_depth == 1)
+    {
         bg_just_changed = 1;
+        clear_sprite_transform_cache();
+    }
 }
 
 void croom_ptr_clear()
@@ -0,0 +1,228 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#include <algorithm>
+#include <vector>
+#include "ac/roomindex.h"
+#include "ac/character.h"
+#include "ac/draw.h"
+#include "ac/gamesetupstruct.h"
+#include "ac/roomobject.h"
+#include "ac/roomstatus.h"
+#include "ac/roomstruct.h"
+
+extern GameSetupStruct game;
+extern roomstruct thisroom;
+extern RoomStatus *croom;
+extern RoomObject *objs;
+extern int displayed_room;
+
+// Size of the location index cells, in room co-ordinates
+#define ROOM_INDEX_CELL_SIZE 32
+
+// Interaction box of an indexed item, with the inclusive edges
+struct IndexBox
+{
+    int x1, y1, x2, y2;
+
+    bool operator ==(const IndexBox &other) const
+    {
+        return x1 == other.x1 && y1 == other.y1 && x2 == other.x2 && y2 == other.y2;
+    }
+    bool operator !=(const IndexBox &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// Which items are not in the index
+static const IndexBox NoIndexBox = { 0, 0, -1, -1 };
+// Which items have no known size, and are tested at any location
+static const IndexBox AnyIndexBox = { -1, -1, -1, -1 };
+
+// Uniform grid of the items' boxes; the ones outside of the room are put
+// into the cells at its edges, where the locations outside are searched
+class LocationIndex
+{
+public:
+    LocationIndex()
+        : _room(-1)
+        , _cols(0)
+        , _rows(0)
+    {
+    }
+
+    int GetRoom() const
+    {
+        return _room;
+    }
+
+    void Reset(int room, int width, int height, int num_items)
+    {
+        _room = room;
+        _cols = std::max(1, (width + ROOM_INDEX_CELL_SIZE - 1) / ROOM_INDEX_CELL_SIZE);
+        _rows = std::max(1, (height + ROOM_INDEX_CELL_SIZE - 1) / ROOM_INDEX_CELL_SIZE);
+        _cells.assign(_cols * _rows, std::vector<int>());
+        _anywhere.clear();
+        _boxes.assign(num_items, NoIndexBox);
+    }
+
+    void Update(int item, const IndexBox &box)
+    {
+        if (_boxes[item] == box)
+            return;
+        Remove(item, _boxes[item]);
+        _boxes[item] = box;
+        Add(item, box);
+    }
+
+    void Find(int x, int y, std::vector<int> &items) const
+    {
+        items.clear();
+        if (_cells.empty())
+            return;
+        const std::vector<int> &cell = _cells[CellRow(y) * _cols + CellCol(x)];
+        for (size_t i = 0; i < cell.size(); ++i)
+        {
+            const IndexBox &box = _boxes[cell[i]];
+            if (x >= box.x1 && x <= box.x2 && y >= box.y1 && y <= box.y2)
+                items.push_back(cell[i]);
+        }
+        items.insert(items.end(), _anywhere.begin(), _anywhere.end());
+        std::sort(items.begin(), items.end());
+    }
+
+private:
+    int CellCol(int x) const
+    {
+        return std::min(std::max(x / ROOM_INDEX_CELL_SIZE, 0), _cols - 1);
+    }
+
+    int CellRow(int y) const
+    {
+        return std::min(std::max(y / ROOM_INDEX_CELL_SIZE, 0), _rows - 1);
+    }
+
+    void Add(int item, const IndexBox &box)
+    {
+        if (box == AnyIndexBox)
+        {
+            _anywhere.push_back(item);
+            return;
+        }
+        if (box.x2 < box.x1)
+            return;
+        for (int row = CellRow(box.y1); row <= CellRow(box.y2); ++row)
+            for (int col = CellCol(box.x1); col <= CellCol(box.x2); ++col)
+                _cells[row * _cols + col].push_back(item);
+    }
+
+    void Remove(int item, const IndexBox &box)
+    {
+        if (box == AnyIndexBox)
+        {
+            RemoveFromList(item, _anywhere);
+            return;
+        }
+        if (box.x2 < box.x1)
+            return;
+        for (int row = CellRow(box.y1); row <= CellRow(box.y2); ++row)
+            for (int col = CellCol(box.x1); col <= CellCol(box.x2); ++col)
+                RemoveFromList(item, _cells[row * _cols + col]);
+    }
+
+    static void RemoveFromList(int item, std::vector<int> &list)
+    {
+        std::vector<int>::iterator it = std::find(list.begin(), list.end(), item);
+        if (it != list.end())
+            list.erase(it);
+    }
+
+    int                             _room;
+    int                             _cols;
+    int                             _rows;
+    std::vector<std::vector<int> >  _cells;
+    std::vector<int>                _anywhere;
+    std::vector<IndexBox>           _boxes;
+};
+
+static std::vector<int> room_chars;
+static bool room_chars_valid = false;
+static LocationIndex char_index;
+static LocationIndex object_index;
+
+const std::vector<int> &get_room_characters()
+{
+    if (!room_chars_valid)
+    {
+        room_chars.clear();
+        for (int i = 0; i < game.numcharacters; ++i)
+        {
+            if (game.chars[i].room == displayed_room)
+                room_chars.push_back(i);
+        }
+        room_chars_valid = true;
+        // the characters which left the room are dropped from the location
+        // index along with the rest
+        char_index.Reset(displayed_room, thisroom.width, thisroom.height, game.numcharacters);
+    }
+    return room_chars;
+}
+
+void invalidate_room_characters()
+{
+    room_chars_valid = false;
+}
+
+static IndexBox make_index_box(int x, int y, int width, int height)
+{
+    if (width == 0 || height == 0)
+        return AnyIndexBox;
+    IndexBox box = { x, y, x + width, y + height };
+    return box;
+}
+
+void find_room_characters_at(int x, int y, std::vector<int> &chars)
+{
+    const std::vector<int> &in_room = get_room_characters();
+    if (char_index.GetRoom() != displayed_room)
+        char_index.Reset(displayed_room, thisroom.width, thisroom.height, game.numcharacters);
+
+    // TODO: the boxes of all the room's characters are still worked out on
+    // every search, because nothing reports when a character's position,
+    // frame or sprite changes; only the boxes which moved are re-indexed
+    for (size_t i = 0; i < in_room.size(); ++i)
+    {
+        int x1, y1, width, height;
+        if (get_char_interaction_rect(in_room[i], &x1, &y1, &width, &height))
+            char_index.Update(in_room[i], make_index_box(x1, y1, width, height));
+        else
+            char_index.Update(in_room[i], NoIndexBox);
+    }
+    char_index.Find(x, y, chars);
+}
+
+void find_room_objects_at(int x, int y, std::vector<int> &objects)
+{
+    if (object_index.GetRoom() != displayed_room)
+        object_index.Reset(displayed_room, thisroom.width, thisroom.height, MAX_INIT_SPR);
+
+    for (int i = 0; i < croom->numobj; ++i)
+    {
+        const int width = divide_down_coordinate(objs[i].get_width());
+        const int height = divide_down_coordinate(objs[i].get_height());
+        object_index.Update(i, make_index_box(objs[i].x, objs[i].y - height, width, height));
+    }
+    object_index.Find(x, y, objects);
+}
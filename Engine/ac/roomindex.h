@@ -0,0 +1,39 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Index of the characters in the displayed room, and of the interaction
+// boxes of the room's characters and objects by their location. The list of
+// characters is rebuilt only after a character may have changed room; the
+// location index is brought up to date on each search, moving
+// only the boxes which have changed between the grid cells.
+//
+//=============================================================================
+#ifndef __AGS_EE_AC__ROOMINDEX_H
+#define __AGS_EE_AC__ROOMINDEX_H
+
+#include <vector>
+
+// Returns the characters in the displayed room, in the order of their
+// numbers; the callers still have to check their other flags
+const std::vector<int> &get_room_characters();
+// Rebuilds the list of the room's characters when it is next requested
+void invalidate_room_characters();
+// Fills the list of the room's characters which interaction box contains
+// the location, in the order of their numbers
+void find_room_characters_at(int x, int y, std::vector<int> &chars);
+// Fills the list of the room objects which interaction box contains
+// the location, in the order of their numbers
+void find_room_objects_at(int x, int y, std::vector<int> &objects);
+
+#endif // __AGS_EE_AC__ROOMINDEX_H
@@ -24,6 +24,8 @@
 #include "ac/common_defines.h"
 #include <string.h>
 #include <math.h>
+#include <algorithm>
+#include <vector>
 #include "gfx/bitmap.h"
 
 using AGS::Common::Bitmap;
@@ -55,41 +57,59 @@ void init_pathfinder()
 Bitmap *wallscreen;
 //#define DEBUG_PATHFINDER
 char *movelibcopyright = "PathFinder library v3.1 (c) 1998, 1999, 2001, 2002 Chris Jones.";
-int line_failed = 0;
 int lastcx, lastcy;
 
-// TODO: find a way to reimpl this with Bitmap
-void line_callback(BITMAP *bmpp, int x, int y, int d)
+// Tells whether the pixel of the route mask can be walked on; the pixels
+// outside of the mask can not
+static inline bool is_mask_walkable(int x, int y)
 {
-/*  if ((x>=320) | (y>=200) | (x<0) | (y<0)) line_failed=1;
-  else */ if (getpixel(bmpp, x, y) < 1)
-    line_failed = 1;
-  else if (line_failed == 0) {
-    lastcx = x;
-    lastcy = y;
-  }
+  if ((x < 0) || (y < 0) || (x >= wallscreen->GetWidth()) || (y >= wallscreen->GetHeight()))
+    return false;
+  return wallscreen->GetScanLine(y)[x] != 0;
 }
 
-// check the copyright message is intact
-#ifdef _MSC_VER
-extern void winalert(char *, ...);
-#endif
-
+// Steps along the line over the same pixels as Allegro's do_line, reading the
+// mask directly and stopping at the first pixel which is not walkable;
+// lastcx/lastcy are set to the last walkable pixel before it
 int can_see_from(int x1, int y1, int x2, int y2)
 {
-  line_failed = 0;
   lastcx = x1;
   lastcy = y1;
 
   if ((x1 == x2) && (y1 == y2))
     return 1;
 
-  // TODO: need some way to use Bitmap with callback
-  do_line((BITMAP*)wallscreen->GetAllegroBitmap(), x1, y1, x2, y2, 0, line_callback);
-  if (line_failed == 0)
-    return 1;
+  const int stepx = (x2 >= x1) ? 1 : -1;
+  const int stepy = (y2 >= y1) ? 1 : -1;
+  const int lenx = abs(x2 - x1);
+  const int leny = abs(y2 - y1);
+  const bool x_major = lenx >= leny;
+  const int major = x_major ? lenx : leny;
+  const int minor = x_major ? leny : lenx;
+  int error = 2 * minor - major;
+  int x = x1, y = y1;
+  for (int i = 0; i <= major; i++) {
+    if (!is_mask_walkable(x, y))
+      return 0;
+    lastcx = x;
+    lastcy = y;
 
-  return 0;
+    if (error >= 0) {
+      if (x_major)
+        y += stepy;
+      else
+        x += stepx;
+      error += 2 * (minor - major);
+    }
+    else
+      error += 2 * minor;
+
+    if (x_major)
+      x += stepx;
+    else
+      y += stepy;
+  }
+  return 1;
 }
 
 int find_nearest_walkable_area(Bitmap *tempw, int fromX, int fromY, int toX, int toY, int destX, int destY, int granularity)
@@ -128,45 +148,31 @@ int find_nearest_walkable_area(Bitmap *tempw, int fromX, int fromY, int toX, int
 
 #define MAX_GRANULARITY 3
 int walk_area_granularity[MAX_WALK_AREAS + 1];
-int is_route_possible(int fromx, int fromy, int tox, int toy, Bitmap *wss)
-{
-  wallscreen = wss;
-  suggestx = -1;
-
-  // ensure it's a memory bitmap, so we can use direct access to line[] array
-  if ((wss == NULL) || (!wss->IsMemoryBitmap()) || (wss->GetColorDepth() != 8))
-    quit("is_route_possible: invalid walkable areas bitmap supplied");
-
-  if (wallscreen->GetPixel(fromx, fromy) < 1)
-    return 0;
-
-  Bitmap *tempw = BitmapHelper::CreateBitmapCopy(wallscreen, 8);
-
-  if (tempw == NULL)
-    quit("no memory for route calculation");
-  if (!tempw->IsMemoryBitmap())
-    quit("tempw is not memory bitmap");
 
+// Finds the average "width" of a path in each walkable area of the mask,
+// which is the step of the route search over that area
+void calculate_walk_area_granularity(Bitmap *mask, int *granularity)
+{
   int dd, ff;
   // initialize array for finding widths of walkable areas
   int thisar, inarow = 0, lastarea = 0;
   int walk_area_times[MAX_WALK_AREAS + 1];
   for (dd = 0; dd <= MAX_WALK_AREAS; dd++) {
     walk_area_times[dd] = 0;
-    walk_area_granularity[dd] = 0;
+    granularity[dd] = 0;
   }
 
-  for (ff = 0; ff < tempw->GetHeight(); ff++) {
-    const uint8_t *tempw_scanline = tempw->GetScanLine(ff);
-    for (dd = 0; dd < tempw->GetWidth(); dd++) {
-      thisar = tempw_scanline[dd];
+  for (ff = 0; ff < mask->GetHeight(); ff++) {
+    const uint8_t *mask_scanline = mask->GetScanLine(ff);
+    for (dd = 0; dd < mask->GetWidth(); dd++) {
+      thisar = mask_scanline[dd];
       // count how high the area is at this point
       if ((thisar == lastarea) && (thisar > 0))
         inarow++;
       else if (lastarea > MAX_WALK_AREAS)
         quit("!Calculate_Route: invalid colours in walkable area mask");
       else if (lastarea != 0) {
-        walk_area_granularity[lastarea] += inarow;
+        granularity[lastarea] += inarow;
         walk_area_times[lastarea]++;
         inarow = 0;
       }
@@ -174,17 +180,14 @@ int is_route_possible(int fromx, int fromy, int tox, int toy, Bitmap *wss)
     }
   }
 
-  for (dd = 0; dd < tempw->GetWidth(); dd++) {
-    for (ff = 0; ff < tempw->GetHeight(); ff++) {
-      uint8_t *tempw_scanline = tempw->GetScanLineForWriting(ff);
-      thisar = tempw_scanline[dd];
-      if (thisar > 0)
-        tempw_scanline[dd] = 1;
+  for (dd = 0; dd < mask->GetWidth(); dd++) {
+    for (ff = 0; ff < mask->GetHeight(); ff++) {
+      thisar = mask->GetScanLine(ff)[dd];
       // count how high the area is at this point
       if ((thisar == lastarea) && (thisar > 0))
         inarow++;
       else if (lastarea != 0) {
-        walk_area_granularity[lastarea] += inarow;
+        granularity[lastarea] += inarow;
         walk_area_times[lastarea]++;
         inarow = 0;
       }
@@ -195,23 +198,191 @@ int is_route_possible(int fromx, int fromy, int tox, int toy, Bitmap *wss)
   // find the average "width" of a path in this walkable area
   for (dd = 1; dd <= MAX_WALK_AREAS; dd++) {
     if (walk_area_times[dd] == 0) {
-      walk_area_granularity[dd] = MAX_GRANULARITY;
+      granularity[dd] = MAX_GRANULARITY;
       continue;
     }
 
-    walk_area_granularity[dd] /= walk_area_times[dd];
-    if (walk_area_granularity[dd] <= 4)
-      walk_area_granularity[dd] = 2;
-    else if (walk_area_granularity[dd] <= 15)
-      walk_area_granularity[dd] = 3;
+    granularity[dd] /= walk_area_times[dd];
+    if (granularity[dd] <= 4)
+      granularity[dd] = 2;
+    else if (granularity[dd] <= 15)
+      granularity[dd] = 3;
     else
-      walk_area_granularity[dd] = MAX_GRANULARITY;
+      granularity[dd] = MAX_GRANULARITY;
 
     /*char toprnt[200];
-       sprintf(toprnt,"area %d: Gran %d", dd, walk_area_granularity[dd]);
+       sprintf(toprnt,"area %d: Gran %d", dd, granularity[dd]);
        winalert(toprnt); */
   }
-  walk_area_granularity[0] = MAX_GRANULARITY;
+  granularity[0] = MAX_GRANULARITY;
+}
+
+// Navigation data of the room's walkable areas. It is built once from the
+// room mask and reused by all the route searches, until the walkable areas
+// are changed. The masks searched are the room mask with the characters and
+// objects removed, so the pixels in different regions are never connected.
+struct RoomNavigation
+{
+  Bitmap *mask;             // room mask the data is built from
+  bool    valid;            // whether the data matches the mask
+  int     granularity[MAX_WALK_AREAS + 1];
+  std::vector<int> region;  // connected region of each pixel, 0 if not walkable
+};
+static RoomNavigation room_nav;
+// Whether the last route check was only made over the room's regions
+static bool route_checked_region = false;
+
+void set_room_navigation_mask(Bitmap *walkable_areas)
+{
+  room_nav.mask = walkable_areas;
+  room_nav.valid = false;
+  if (!walkable_areas)
+    room_nav.region.clear();
+}
+
+void invalidate_room_navigation()
+{
+  room_nav.valid = false;
+}
+
+// Labels the 4-connected regions of walkable pixels, the same ones which
+// would be filled by a flood fill from any of their pixels
+static void build_room_navigation()
+{
+  Bitmap *mask = room_nav.mask;
+  const int width = mask->GetWidth();
+  const int height = mask->GetHeight();
+  calculate_walk_area_granularity(mask, room_nav.granularity);
+
+  room_nav.region.assign((size_t)width * height, 0);
+  std::vector<int> fill;
+  int num_regions = 0;
+  for (int y = 0; y < height; y++) {
+    const uint8_t *scanline = mask->GetScanLine(y);
+    for (int x = 0; x < width; x++) {
+      if ((scanline[x] == 0) || (room_nav.region[y * width + x] != 0))
+        continue;
+
+      num_regions++;
+      room_nav.region[y * width + x] = num_regions;
+      fill.push_back(y * width + x);
+      while (!fill.empty()) {
+        const int cell = fill.back();
+        fill.pop_back();
+        const int cx = cell % width;
+        const int cy = cell / width;
+        const int next[4] = { cell - 1, cell + 1, cell - width, cell + width };
+        const bool inside[4] = { cx > 0, cx < width - 1, cy > 0, cy < height - 1 };
+        for (int dir = 0; dir < 4; dir++) {
+          if (!inside[dir] || (room_nav.region[next[dir]] != 0) ||
+              (mask->GetScanLine(next[dir] / width)[next[dir] % width] == 0))
+            continue;
+          room_nav.region[next[dir]] = num_regions;
+          fill.push_back(next[dir]);
+        }
+      }
+    }
+  }
+  room_nav.valid = true;
+}
+
+// Tells whether the route mask is derived from the room's walkable areas,
+// so that their navigation data may be used; rebuilds it if necessary
+static bool use_room_navigation(Bitmap *wss)
+{
+  if ((room_nav.mask == NULL) || (room_nav.mask->GetWidth() != wss->GetWidth()) ||
+      (room_nav.mask->GetHeight() != wss->GetHeight()))
+    return false;
+  if (!room_nav.valid)
+    build_room_navigation();
+  return true;
+}
+
+int find_nearest_region_cell(int region, int fromX, int fromY, int toX, int toY, int destX, int destY, int granularity)
+{
+  int ex, ey, nearest = 99999, thisis, nearx, neary;
+  const int width = wallscreen->GetWidth();
+  if (fromX < 0) fromX = 0;
+  if (fromY < 0) fromY = 0;
+  if (toX >= width) toX = width - 1;
+  if (toY >= wallscreen->GetHeight()) toY = wallscreen->GetHeight() - 1;
+
+  for (ex = fromX; ex < toX; ex += granularity)
+  {
+    for (ey = fromY; ey < toY; ey += granularity)
+    {
+      if ((room_nav.region[ey * width + ex] != region) || (wallscreen->GetScanLine(ey)[ex] == 0))
+        continue;
+
+      thisis = (int)::sqrt((double)((ex - destX) * (ex - destX) + (ey - destY) * (ey - destY)));
+      if (thisis < nearest)
+      {
+        nearest = thisis;
+        nearx = ex;
+        neary = ey;
+      }
+    }
+  }
+
+  if (nearest < 90000) {
+    suggestx = nearx;
+    suggesty = neary;
+    return 1;
+  }
+
+  return 0;
+}
+
+int is_route_possible(int fromx, int fromy, int tox, int toy, Bitmap *wss)
+{
+  wallscreen = wss;
+  suggestx = -1;
+  route_checked_region = false;
+
+  // ensure it's a memory bitmap, so we can use direct access to line[] array
+  if ((wss == NULL) || (!wss->IsMemoryBitmap()) || (wss->GetColorDepth() != 8))
+    quit("is_route_possible: invalid walkable areas bitmap supplied");
+
+  if (wallscreen->GetPixel(fromx, fromy) < 1)
+    return 0;
+
+  if (use_room_navigation(wss)) {
+    memcpy(walk_area_granularity, room_nav.granularity, sizeof(walk_area_granularity));
+    const int width = wss->GetWidth();
+    const int region = room_nav.region[fromy * width + fromx];
+    if ((wss->GetPixel(tox, toy) > 0) && (room_nav.region[toy * width + tox] == region)) {
+      // characters or objects may still cut the region; the route search
+      // tells if they do
+      route_checked_region = true;
+      return 1;
+    }
+
+    // Destination pixel is not walkable
+    // Try the 100x100 square around the target first at 3-pixel granularity
+    if (!find_nearest_region_cell(region, tox - 50, toy - 50, tox + 50, toy + 50, tox, toy, 3))
+    {
+      // Nothing found, sweep the whole room at 5 pixel granularity
+      find_nearest_region_cell(region, 0, 0, wss->GetWidth(), wss->GetHeight(), tox, toy, 5);
+    }
+    return 0;
+  }
+
+  Bitmap *tempw = BitmapHelper::CreateBitmapCopy(wallscreen, 8);
+
+  if (tempw == NULL)
+    quit("no memory for route calculation");
+  if (!tempw->IsMemoryBitmap())
+    quit("tempw is not memory bitmap");
+
+  calculate_walk_area_granularity(tempw, walk_area_granularity);
+
+  for (int ff = 0; ff < tempw->GetHeight(); ff++) {
+    uint8_t *tempw_scanline = tempw->GetScanLineForWriting(ff);
+    for (int dd = 0; dd < tempw->GetWidth(); dd++) {
+      if (tempw_scanline[dd] > 0)
+        tempw_scanline[dd] = 1;
+    }
+  }
 
   tempw->FloodFill(fromx, fromy, 232);
   if (tempw->GetPixel(tox, toy) != 232) 
@@ -242,6 +413,8 @@ int pathbackstage = 0;
 int finalpartx = 0, finalparty = 0;
 short **beenhere = NULL;     //[200][320];
 int beenhere_array_size = 0;
+short *beenhere_buffer = NULL;
+int beenhere_buffer_size = 0;
 const int BEENHERE_SIZE = 2;
 
 #define DIR_LEFT  0
@@ -340,22 +513,6 @@ try_again:
 }
 
 
-#define CHECK_MIN(cellx, celly) { \
-  if (beenhere[celly][cellx] == -1) {\
-    adjcount = 0; \
-    if ((wallscreen->GetScanLine(celly)[cellx] != 0) && (beenhere[j][i]+modifier <= min)) {\
-      if (beenhere[j][i]+modifier < min) { \
-        min = beenhere[j][i]+modifier; \
-        numfound = 0; } \
-      if (numfound < 40) { \
-        newcell[numfound] = (celly) * wallscreen->GetWidth() + (cellx);\
-        cheapest[numfound] = j * wallscreen->GetWidth() + i;\
-        numfound++; \
-      }\
-    } \
-  }}
-
-#define MAX_TRAIL_LENGTH 5000
 
 // Round down the supplied co-ordinates to the area granularity,
 // and move a bit if this causes them to become non-walkable
@@ -382,19 +539,58 @@ void round_down_coords(int &tmpx, int &tmpy)
   }
 }
 
-int find_route_dijkstra(int fromx, int fromy, int destx, int desty)
+// Scratch buffers of the route search; these are kept between the calls,
+// and only grow when a larger walkable mask is used
+struct RouteNode
 {
-  int i, j;
+  int cost;     // cost of the path from start to this cell
+  int estimate; // cost plus the estimated remaining distance
+  int cell;
+};
+
+// Orders the heap by the lowest estimate, and prefers the cells which are
+// further from the start among the equal ones, to follow a single path
+struct RouteNodeGreater
+{
+  bool operator()(const RouteNode &a, const RouteNode &b) const
+  {
+    if (a.estimate != b.estimate)
+      return a.estimate > b.estimate;
+    return a.cost < b.cost;
+  }
+};
 
+static std::vector<int> route_cost;             // best known cost to reach the cell
+static std::vector<int> route_parent;           // previous cell on that path
+static std::vector<unsigned int> route_stamp;   // id of the search which reached the cell
+static unsigned int route_search_id = 0;
+static std::vector<RouteNode> route_open;       // heap of the cells to expand
+
+// Number of cells expanded between polling the game's audio and input
+#define ROUTE_POLL_INTERVAL 20000
+
+// Distance which the search has to cover at least, to get from the cell into
+// the square around the destination
+static inline int route_estimate(int x, int y, int destx, int desty)
+{
+  int dx = abs(x - destx) - MAX_GRANULARITY;
+  int dy = abs(y - desty) - MAX_GRANULARITY;
+  return (dx > 0 ? dx : 0) + (dy > 0 ? dy : 0);
+}
+
+// A* search over the walkable cells, stepping by the granularity of the
+// walkable area the cell belongs to. Fills pathbackx/y with the found path,
+// in reverse order, starting at the destination.
+int find_route_dijkstra(int fromx, int fromy, int destx, int desty)
+{
   // This algorithm doesn't behave differently the second time, so ignore
   if (leftorright == 1)
     return 0;
 
-  for (i = 0; i < wallscreen->GetHeight(); i++)
-    memset(&beenhere[i][0], 0xff, wallscreen->GetWidth() * BEENHERE_SIZE);
+  const int width = wallscreen->GetWidth();
+  const int height = wallscreen->GetHeight();
 
   round_down_coords(fromx, fromy);
-  beenhere[fromy][fromx] = 0;
 
   int temprd = destx, tempry = desty;
   round_down_coords(temprd, tempry);
@@ -404,135 +600,104 @@ int find_route_dijkstra(int fromx, int fromy, int destx, int desty)
     return 1;
   }
 
-  int allocsize = int (wallscreen->GetWidth()) * int (wallscreen->GetHeight()) * sizeof(int);
-  int *parent = (int *)malloc(allocsize);
-  int min = 999999, cheapest[40], newcell[40], replace[40];
-  int *visited = (int *)malloc(MAX_TRAIL_LENGTH * sizeof(int));
-  int iteration = 1;
-  visited[0] = fromy * wallscreen->GetWidth() + fromx;
-  parent[visited[0]] = -1;
+  const size_t num_cells = (size_t)width * height;
+  if (route_stamp.size() < num_cells) {
+    route_cost.resize(num_cells);
+    route_parent.resize(num_cells);
+    route_stamp.resize(num_cells, 0);
+  }
+  // mark the cells of the previous searches as not visited, without clearing
+  route_search_id++;
+  if (route_search_id == 0) {
+    std::fill(route_stamp.begin(), route_stamp.end(), 0);
+    route_search_id = 1;
+  }
 
-  int granularity = 3, newx = -1, newy, foundAnswer = -1, numreplace;
-  int changeiter, numfound, adjcount;
   int destxlow = destx - MAX_GRANULARITY;
   int destylow = desty - MAX_GRANULARITY;
   int destxhi = destxlow + MAX_GRANULARITY * 2;
   int destyhi = destylow + MAX_GRANULARITY * 2;
-  int modifier = 0;
-  int totalfound = 0;
-  int DIRECTION_BONUS = 0;
 
   update_polled_stuff_if_runtime();
 
-  while (foundAnswer < 0) {
-    min = 29999;
-    changeiter = iteration;
-    numfound = 0;
-    numreplace = 0;
-
-    for (int n = 0; n < iteration; n++) {
-      if (visited[n] == -1)
-        continue;
-
-      i = visited[n] % wallscreen->GetWidth();
-      j = visited[n] / wallscreen->GetWidth();
-      granularity = walk_area_granularity[wallscreen->GetScanLine(j)[i]];
-      adjcount = 1;
-
-      if (i >= granularity) {
-        modifier = (destx < i) ? DIRECTION_BONUS : 0;
-        CHECK_MIN(i - granularity, j)
-      }
-
-      if (j >= granularity) {
-        modifier = (desty < j) ? DIRECTION_BONUS : 0;
-        CHECK_MIN(i, j - granularity)
-      }
-
-      if (i < wallscreen->GetWidth() - granularity) {
-        modifier = (destx > i) ? DIRECTION_BONUS : 0;
-        CHECK_MIN(i + granularity, j)
-      }
-
-      if (j < wallscreen->GetHeight() - granularity) {
-        modifier = (desty > j) ? DIRECTION_BONUS : 0;
-        CHECK_MIN(i, j + granularity)
-      }
-
-      // If all the adjacent cells have been done, stop checking this one
-      if (adjcount) {
-        if (numreplace < 40) {
-          visited[numreplace] = -1;
-          replace[numreplace] = n;
-          numreplace++;
-        }
-      }
-    }
-
-    if (numfound == 0) {
-      free(visited);
-      free(parent);
-      return 0;
-    }
-
-    totalfound += numfound;
-    for (int p = 0; p < numfound; p++) {
-      newx = newcell[p] % wallscreen->GetWidth();
-      newy = newcell[p] / wallscreen->GetWidth();
-      beenhere[newy][newx] = beenhere[cheapest[p] / wallscreen->GetWidth()][cheapest[p] % wallscreen->GetWidth()] + 1;
-//      int wal = walk_area_granularity[->GetPixel(wallscreen, newx, newy)];
-//      beenhere[newy - newy%wal][newx - newx%wal] = beenhere[newy][newx];
-      parent[newcell[p]] = cheapest[p];
+  RouteNodeGreater node_greater;
+  route_open.clear();
+  RouteNode node;
+  node.cell = fromy * width + fromx;
+  node.cost = 0;
+  node.estimate = route_estimate(fromx, fromy, destx, desty);
+  route_stamp[node.cell] = route_search_id;
+  route_cost[node.cell] = 0;
+  route_parent[node.cell] = -1;
+  route_open.push_back(node);
+
+  const int offx[4] = { -1, 0, 1, 0 };
+  const int offy[4] = { 0, -1, 0, 1 };
+  int foundAnswer = -1;
+  int expanded = 0;
+  while (!route_open.empty()) {
+    std::pop_heap(route_open.begin(), route_open.end(), node_greater);
+    node = route_open.back();
+    route_open.pop_back();
+    // skip the cell if it was already reached by a cheaper path
+    if (node.cost != route_cost[node.cell])
+      continue;
 
+    const int i = node.cell % width;
+    const int j = node.cell / width;
+    if (node.cost > 0) {
       // edges of screen pose a problem, so if current and dest are within
       // certain distance of the edge, say we've got it
-      if ((newx >= wallscreen->GetWidth() - MAX_GRANULARITY) && (destx >= wallscreen->GetWidth() - MAX_GRANULARITY))
+      int newx = i, newy = j;
+      if ((newx >= width - MAX_GRANULARITY) && (destx >= width - MAX_GRANULARITY))
         newx = destx;
-
-      if ((newy >= wallscreen->GetHeight() - MAX_GRANULARITY) && (desty >= wallscreen->GetHeight() - MAX_GRANULARITY))
+      if ((newy >= height - MAX_GRANULARITY) && (desty >= height - MAX_GRANULARITY))
         newy = desty;
 
-      // Found the desination, abort loop
+      // Found the destination, abort loop
       if ((newx >= destxlow) && (newx <= destxhi) && (newy >= destylow)
           && (newy <= destyhi)) {
-        foundAnswer = newcell[p];
+        foundAnswer = node.cell;
         break;
       }
+    }
 
-      if (totalfound >= 1000) {
-        //Doesn't work cos it can see the destination from the point that's
-        //not nearest
-        // every so often, check if we can see the destination
-        if (can_see_from(newx, newy, destx, desty)) {
-          DIRECTION_BONUS -= 50;
-          totalfound = 0;
-        }
-
-      }
+    const int granularity = walk_area_granularity[wallscreen->GetScanLine(j)[i]];
+    for (int dir = 0; dir < 4; dir++) {
+      const int nx = i + offx[dir] * granularity;
+      const int ny = j + offy[dir] * granularity;
+      if ((nx < 0) || (ny < 0) || (nx >= width) || (ny >= height))
+        continue;
+      // keep the original limits of the right and bottom edges
+      if ((dir == 2 && i >= width - granularity) || (dir == 3 && j >= height - granularity))
+        continue;
+      if (wallscreen->GetScanLine(ny)[nx] == 0)
+        continue;
 
-      if (numreplace > 0) {
-        numreplace--;
-        changeiter = replace[numreplace];
-      } else
-        changeiter = iteration;
-
-      visited[changeiter] = newcell[p];
-      if (changeiter == iteration)
-        iteration++;
-
-      changeiter = iteration;
-      if (iteration >= MAX_TRAIL_LENGTH) {
-        free(visited);
-        free(parent);
-        return 0;
-      }
+      const int cell = ny * width + nx;
+      const int cost = node.cost + granularity;
+      if ((route_stamp[cell] == route_search_id) && (route_cost[cell] <= cost))
+        continue;
+      route_stamp[cell] = route_search_id;
+      route_cost[cell] = cost;
+      route_parent[cell] = node.cell;
+
+      RouteNode next;
+      next.cell = cell;
+      next.cost = cost;
+      next.estimate = cost + route_estimate(nx, ny, destx, desty);
+      route_open.push_back(next);
+      std::push_heap(route_open.begin(), route_open.end(), node_greater);
     }
-    if (totalfound >= 1000) {
+
+    if (++expanded >= ROUTE_POLL_INTERVAL) {
       update_polled_stuff_if_runtime();
-      totalfound = 0;
+      expanded = 0;
     }
   }
-  free(visited);
+
+  if (foundAnswer < 0)
+    return 0;
 
   int on;
   pathbackstage = 0;
@@ -540,25 +705,58 @@ int find_route_dijkstra(int fromx, int fromy, int destx, int desty)
   pathbacky[pathbackstage] = desty;
   pathbackstage++;
 
-  for (on = parent[foundAnswer];; on = parent[on]) {
+  for (on = route_parent[foundAnswer];; on = route_parent[on]) {
     if (on == -1)
       break;
 
-    newx = on % wallscreen->GetWidth();
-    newy = on / wallscreen->GetWidth();
+    int newx = on % width;
+    int newy = on / width;
     if ((newx >= destxlow) && (newx <= destxhi) && (newy >= destylow)
         && (newy <= destyhi))
       break;
 
-    pathbackx[pathbackstage] = on % wallscreen->GetWidth();
-    pathbacky[pathbackstage] = on / wallscreen->GetWidth();
+    pathbackx[pathbackstage] = newx;
+    pathbacky[pathbackstage] = newy;
     pathbackstage++;
-    if (pathbackstage >= MAXPATHBACK) {
-      free(parent);
+    if (pathbackstage >= MAXPATHBACK)
       return 0;
+  }
+  return 1;
+}
+
+// Finds the cell reached by the last route search which is nearest to the
+// destination, first in the 100x100 square around it, then in the whole room
+static int find_nearest_reached_cell(int destx, int desty)
+{
+  const int width = wallscreen->GetWidth();
+  const int height = wallscreen->GetHeight();
+  int nearest = -1;
+  int neardist = 0;
+  for (int pass = 0; (pass < 2) && (nearest < 0); pass++) {
+    int fromx = 0, fromy = 0, tox = width, toy = height;
+    if (pass == 0) {
+      fromx = std::max(0, destx - 50);
+      fromy = std::max(0, desty - 50);
+      tox = std::min(width, destx + 50);
+      toy = std::min(height, desty + 50);
+    }
+    for (int y = fromy; y < toy; y++) {
+      for (int x = fromx; x < tox; x++) {
+        if (route_stamp[y * width + x] != route_search_id)
+          continue;
+        const int dist = (x - destx) * (x - destx) + (y - desty) * (y - desty);
+        if ((nearest < 0) || (dist < neardist)) {
+          nearest = y * width + x;
+          neardist = dist;
+        }
+      }
     }
   }
-  free(parent);
+
+  if (nearest < 0)
+    return 0;
+  suggestx = nearest % width;
+  suggesty = nearest / width;
   return 1;
 }
 
@@ -568,6 +766,7 @@ int __find_route(int srcx, int srcy, short *tox, short *toy, int noredx)
     return 0; // clicked on a wall
 
   pathbackstage = 0;
+  bool went_nearest = false;
 
   if (leftorright == 0) {
     waspossible = 1;
@@ -598,6 +797,16 @@ findroutebk:
     return 1;
   }
 
+  // the route was only checked over the room's regions, and characters or
+  // objects cut it: go to the nearest point the search could reach instead
+  if ((leftorright == 0) && route_checked_region && !went_nearest &&
+      find_nearest_reached_cell(tox[0], toy[0])) {
+    went_nearest = true;
+    tox[0] = suggestx;
+    toy[0] = suggesty;
+    goto findroutebk;
+  }
+
   // if the new pathfinder failed, try the old one
   pathbackstage = 0;
   memset(&beenhere[0][0], 0, wallscreen->GetWidth() * wallscreen->GetHeight() * BEENHERE_SIZE);
@@ -728,6 +937,17 @@ int find_route(short srcx, short srcy, short xx, short yy, Bitmap *onscreen, int
     if (beenhere == NULL)
       quit("insufficient memory to allocate pathfinder beenhere buffer");
   }
+  // the buffer is kept for the next calls, and only grows
+  const int beenhere_size = wallscreen->GetWidth() * wallscreen->GetHeight();
+  if (beenhere_size > beenhere_buffer_size)
+  {
+    free(beenhere_buffer);
+    beenhere_buffer = (short *)malloc(beenhere_size * BEENHERE_SIZE);
+    beenhere_buffer_size = beenhere_size;
+
+    if (beenhere_buffer == NULL)
+      quit("insufficient memory to allocate pathfinder beenhere buffer");
+  }
 
   int orisrcx = srcx, orisrcy = srcy;
   finalpartx = -1;
@@ -739,7 +959,7 @@ int find_route(short srcx, short srcy, short xx, short yy, Bitmap *onscreen, int
     pathbackstage = 0;
   }
   else {
-    beenhere[0] = (short *)malloc((wallscreen->GetWidth()) * (wallscreen->GetHeight()) * BEENHERE_SIZE);
+    beenhere[0] = beenhere_buffer;
 
     for (aaa = 1; aaa < wallscreen->GetHeight(); aaa++)
       beenhere[aaa] = beenhere[0] + aaa * (wallscreen->GetWidth());
@@ -749,7 +969,6 @@ int find_route(short srcx, short srcy, short xx, short yy, Bitmap *onscreen, int
       if (__find_route(srcx, srcy, &xx, &yy, nocross) == 0)
         pathbackstage = -1;
     }
-    free(beenhere[0]);
   }
 
   if (pathbackstage >= 0) {
@@ -764,12 +983,14 @@ int find_route(short srcx, short srcy, short xx, short yy, Bitmap *onscreen, int
 stage_again:
     nearestpos = 0;
     aaa = 1;
-    // find the furthest point that can be seen from this stage
-    for (aaa = pathbackstage - 1; aaa >= 0; aaa--) {
+    // find the furthest point that can be seen from this stage; the path is
+    // stored from the destination backwards, so that's the first one found
+    for (aaa = 0; aaa < pathbackstage; aaa++) {
 //      fprintf(stderr,"stage %2d: %2d,%2d\n",aaa,pathbackx[aaa],pathbacky[aaa]);
       if (can_see_from(srcx, srcy, pathbackx[aaa], pathbacky[aaa])) {
         nearestpos = MAKE_INTCOORD(pathbackx[aaa], pathbacky[aaa]);
         nearestindx = aaa;
+        break;
       }
     }
 
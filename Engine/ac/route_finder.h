@@ -24,6 +24,12 @@ void init_pathfinder();
 void set_route_move_speed(int speed_x, int speed_y);
 int find_route(short srcx, short srcy, short xx, short yy, Common::Bitmap *onscreen, int movlst, int nocross =
                0, int ignore_walls = 0);
+// Sets the room's walkable areas, which the route masks are made from;
+// their navigation data is built on the next route search
+void set_room_navigation_mask(Common::Bitmap *walkable_areas);
+// Rebuilds the navigation data on the next route search, after the room's
+// walkable areas have changed
+void invalidate_room_navigation();
 
 extern Common::Bitmap *wallscreen;
 extern int lastcx, lastcy;
@@ -0,0 +1,240 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#include <deque>
+#include <vector>
+#include "ac/characterinfo.h"
+#include "ac/gamesetupstruct.h"
+#include "ac/roomstatus.h"
+#include "ac/spritecache.h"
+#include "ac/spriteprefetch.h"
+#include "ac/view.h"
+#include "core/assetmanager.h"
+#include "debug/out.h"
+#include "gfx/bitmap.h"
+#include "platform/base/agsplatformdriver.h"
+#include "util/mutex.h"
+#include "util/mutex_lock.h"
+#include "util/stream.h"
+#include "util/thread.h"
+
+using namespace AGS::Common;
+using namespace AGS::Engine;
+
+extern GameSetupStruct game;
+extern ViewStruct*views;
+extern RoomStatus*croom;
+extern int displayed_room;
+extern SpriteCache spriteset;
+extern AGSPlatformDriver *platform;
+
+// Max number of sprites waiting to be read, so that a large request
+// could not keep the thread busy with sprites which are not needed anymore
+#define SPRITE_PREFETCH_MAX_QUEUE   512
+// Time the thread sleeps when there is nothing to read, in milliseconds
+#define SPRITE_PREFETCH_IDLE_DELAY  5
+
+struct SpritePrefetchItem
+{
+    int     Index;
+    int32_t Offset; // file offset of the sprite at the time of request
+    Bitmap *Image;
+};
+
+// The request queue and the list of decoded sprites are shared with the
+// background thread, and are protected by the mutex. The sprite cache itself,
+// including its MRU list, is only changed on the game thread: the engine
+// keeps pointers to the cached bitmaps while drawing, so sprites may only be
+// added or evicted between the frame updates.
+static Mutex prefetchMutex;
+static std::deque<SpritePrefetchItem> prefetchQueue;
+static std::vector<SpritePrefetchItem> prefetchDone;
+// Following are only used by the background thread while it runs
+static Thread prefetchThread;
+static Stream *prefetchStream = NULL;
+static std::vector<unsigned char> prefetchDataBuf;
+static std::vector<unsigned char> prefetchPixelBuf;
+static bool prefetchRunning = false;
+// Statistics, for the game thread only
+static int prefetchNumAdded = 0;
+static int prefetchNumDropped = 0;
+
+static void sprite_prefetch_thread()
+{
+    SpritePrefetchItem item;
+    {
+        MutexLock lock(prefetchMutex);
+        if (prefetchQueue.empty())
+        {
+            item.Index = -1;
+        }
+        else
+        {
+            item = prefetchQueue.front();
+            prefetchQueue.pop_front();
+        }
+    }
+
+    if (item.Index < 0)
+    {
+        platform->Delay(SPRITE_PREFETCH_IDLE_DELAY);
+        return;
+    }
+
+    bool is_empty;
+    prefetchStream->Seek(item.Offset, kSeekBegin);
+    item.Image = spriteset.readSprite(prefetchStream, item.Index, is_empty, prefetchDataBuf, prefetchPixelBuf);
+    if (item.Image)
+    {
+        MutexLock lock(prefetchMutex);
+        prefetchDone.push_back(item);
+    }
+}
+
+void init_sprite_prefetch(const char *sprite_file)
+{
+    if (prefetchRunning)
+        return;
+    prefetchStream = AssetManager::OpenAsset(sprite_file);
+    if (!prefetchStream)
+    {
+        Debug::Printf(kDbgMsg_Init, "Sprite prefetch disabled: failed to open %s", sprite_file);
+        return;
+    }
+    prefetchRunning = prefetchThread.CreateAndStart(sprite_prefetch_thread, true);
+    if (!prefetchRunning)
+    {
+        Debug::Printf(kDbgMsg_Init, "Sprite prefetch disabled: failed to start the thread");
+        delete prefetchStream;
+        prefetchStream = NULL;
+        return;
+    }
+    Debug::Printf(kDbgMsg_Init, "Sprite prefetch thread started");
+}
+
+void shutdown_sprite_prefetch()
+{
+    if (!prefetchRunning)
+        return;
+    prefetchThread.Stop();
+    prefetchRunning = false;
+    delete prefetchStream;
+    prefetchStream = NULL;
+
+    prefetchQueue.clear();
+    for (size_t i = 0; i < prefetchDone.size(); ++i)
+        delete prefetchDone[i].Image;
+    prefetchDone.clear();
+    Debug::Printf(kDbgMsg_Init, "Sprite prefetch: %d sprites added to cache, %d dropped",
+        prefetchNumAdded, prefetchNumDropped);
+}
+
+void prefetch_sprites(const int *slots, int count)
+{
+    if (!prefetchRunning)
+        return;
+    MutexLock lock(prefetchMutex);
+    for (int i = 0; i < count && prefetchQueue.size() < SPRITE_PREFETCH_MAX_QUEUE; ++i)
+    {
+        const int index = slots[i];
+        if (!spriteset.needsLoading(index))
+            continue;
+        bool is_queued = false;
+        for (size_t q = 0; q < prefetchQueue.size() && !is_queued; ++q)
+            is_queued = prefetchQueue[q].Index == index;
+        for (size_t d = 0; d < prefetchDone.size() && !is_queued; ++d)
+            is_queued = prefetchDone[d].Index == index;
+        if (is_queued)
+            continue;
+
+        SpritePrefetchItem item;
+        item.Index = index;
+        item.Offset = spriteset.offsets[index];
+        item.Image = NULL;
+        prefetchQueue.push_back(item);
+    }
+}
+
+void prefetch_view_loop(int view, int loop)
+{
+    if (!prefetchRunning || view < 0 || view >= game.numviews ||
+        loop < 0 || loop >= views[view].numLoops)
+        return;
+    const ViewLoopNew &vloop = views[view].loops[loop];
+    std::vector<int> slots(vloop.numFrames);
+    for (int i = 0; i < vloop.numFrames; ++i)
+        slots[i] = vloop.frames[i].pic;
+    if (!slots.empty())
+        prefetch_sprites(&slots[0], (int)slots.size());
+}
+
+void prefetch_view(int view)
+{
+    if (!prefetchRunning || view < 0 || view >= game.numviews)
+        return;
+    for (int loop = 0; loop < views[view].numLoops; ++loop)
+        prefetch_view_loop(view, loop);
+}
+
+void prefetch_room_sprites()
+{
+    if (!prefetchRunning)
+        return;
+    std::vector<int> slots;
+    for (int i = 0; i < croom->numobj; ++i)
+    {
+        if (croom->obj[i].on)
+            slots.push_back(croom->obj[i].num);
+    }
+    if (!slots.empty())
+        prefetch_sprites(&slots[0], (int)slots.size());
+
+    for (int i = 0; i < croom->numobj; ++i)
+    {
+        if (croom->obj[i].on && croom->obj[i].cycling)
+            prefetch_view_loop(croom->obj[i].view, croom->obj[i].loop);
+    }
+    for (int i = 0; i < game.numcharacters; ++i)
+    {
+        if (game.chars[i].room == displayed_room && game.chars[i].on)
+            prefetch_view_loop(game.chars[i].view, game.chars[i].loop);
+    }
+}
+
+void update_sprite_prefetch()
+{
+    if (!prefetchRunning)
+        return;
+    std::vector<SpritePrefetchItem> done;
+    {
+        MutexLock lock(prefetchMutex);
+        if (prefetchDone.empty())
+            return;
+        done.swap(prefetchDone);
+    }
+
+    for (size_t i = 0; i < done.size(); ++i)
+    {
+        if (spriteset.addPrefetchedSprite(done[i].Index, done[i].Offset, done[i].Image))
+        {
+            prefetchNumAdded++;
+        }
+        else
+        {
+            // the sprite was loaded by the game in the meantime, or its slot changed
+            delete done[i].Image;
+            prefetchNumDropped++;
+        }
+    }
+}
@@ -0,0 +1,41 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Sprite prefetching: a background thread reads and decodes sprites from
+// the sprite file ahead of their use, so that the game does not stall when
+// it draws them for the first time. Decoded sprites are put into the sprite
+// cache on the game thread, by update_sprite_prefetch().
+//
+//=============================================================================
+#ifndef __AGS_EE_AC__SPRITEPREFETCH_H
+#define __AGS_EE_AC__SPRITEPREFETCH_H
+
+// Opens the sprite file for the background thread and starts it
+void init_sprite_prefetch(const char *sprite_file);
+// Stops the thread and drops any unfinished requests; must be called
+// before the sprite cache is reset or reinitialized
+void shutdown_sprite_prefetch();
+// Requests the given sprite slots, in order
+void prefetch_sprites(const int *slots, int count);
+// Requests all the frames of the view loop
+void prefetch_view_loop(int view, int loop);
+// Requests all the frames of the view
+void prefetch_view(int view);
+// Requests the current sprites and animations of the room objects and
+// the characters in the room
+void prefetch_room_sprites();
+// Moves the sprites decoded by the background thread into the sprite cache
+void update_sprite_prefetch();
+
+#endif // __AGS_EE_AC__SPRITEPREFETCH_H
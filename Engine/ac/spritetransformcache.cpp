@@ -0,0 +1,153 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#include <limits.h>
+#include <list>
+#include <map>
+#include "ac/spritetransformcache.h"
+#include "debug/out.h"
+#include "gfx/bitmap.h"
+
+using namespace AGS::Common;
+
+bool SpriteTransform::operator <(const SpriteTransform &other) const
+{
+    if (Sprite != other.Sprite)
+        return Sprite < other.Sprite;
+    if (Width != other.Width)
+        return Width < other.Width;
+    if (Height != other.Height)
+        return Height < other.Height;
+    if (Mirrored != other.Mirrored)
+        return Mirrored < other.Mirrored;
+    if (Antialiased != other.Antialiased)
+        return Antialiased < other.Antialiased;
+    if (TintRed != other.TintRed)
+        return TintRed < other.TintRed;
+    if (TintGreen != other.TintGreen)
+        return TintGreen < other.TintGreen;
+    if (TintBlue != other.TintBlue)
+        return TintBlue < other.TintBlue;
+    if (TintAmount != other.TintAmount)
+        return TintAmount < other.TintAmount;
+    if (TintLight != other.TintLight)
+        return TintLight < other.TintLight;
+    return LightLevel < other.LightLevel;
+}
+
+struct TransformedSprite
+{
+    SpriteTransform Transform;
+    Bitmap         *Image;
+};
+
+typedef std::list<TransformedSprite> TransformedSpriteList;
+typedef std::map<SpriteTransform, TransformedSpriteList::iterator> TransformedSpriteMap;
+
+// Images in the order of use, the most recently used first
+static TransformedSpriteList transformList;
+static TransformedSpriteMap transformMap;
+static size_t transformCacheSize = 0;
+static size_t transformCacheMaxSize = DEFAULT_SPRITE_TRANSFORM_CACHE_SIZE;
+// Statistics
+static int transformNumHits = 0;
+static int transformNumMisses = 0;
+static int transformNumRemoved = 0;
+
+static void remove_transformed_sprite(TransformedSpriteList::iterator it)
+{
+    transformCacheSize -= it->Image->GetDataSize();
+    delete it->Image;
+    transformMap.erase(it->Transform);
+    transformList.erase(it);
+}
+
+static void free_sprite_transform_cache_space(size_t need_size)
+{
+    while (!transformList.empty() && transformCacheSize + need_size > transformCacheMaxSize)
+    {
+        remove_transformed_sprite(--transformList.end());
+        transformNumRemoved++;
+    }
+}
+
+void set_sprite_transform_cache_size(size_t max_size)
+{
+    transformCacheMaxSize = max_size;
+    free_sprite_transform_cache_space(0);
+}
+
+Bitmap *get_transformed_sprite(const SpriteTransform &transform)
+{
+    TransformedSpriteMap::iterator found = transformMap.find(transform);
+    if (found == transformMap.end())
+    {
+        transformNumMisses++;
+        return NULL;
+    }
+    transformNumHits++;
+    // move to the front of the list
+    transformList.splice(transformList.begin(), transformList, found->second);
+    return found->second->Image;
+}
+
+void put_transformed_sprite(const SpriteTransform &transform, Bitmap *image)
+{
+    const size_t size = image->GetDataSize();
+    if (size > transformCacheMaxSize)
+        return;
+    TransformedSpriteMap::iterator found = transformMap.find(transform);
+    if (found != transformMap.end())
+        remove_transformed_sprite(found->second);
+    free_sprite_transform_cache_space(size);
+
+    TransformedSprite item;
+    item.Transform = transform;
+    item.Image = BitmapHelper::CreateBitmapCopy(image);
+    if (!item.Image)
+        return;
+    transformList.push_front(item);
+    transformMap[transform] = transformList.begin();
+    transformCacheSize += size;
+}
+
+void invalidate_transformed_sprite(int sprite)
+{
+    SpriteTransform from = SpriteTransform();
+    from.Sprite = sprite;
+    from.Width = from.Height = INT_MIN;
+    TransformedSpriteMap::iterator it = transformMap.lower_bound(from);
+    while (it != transformMap.end() && it->first.Sprite == sprite)
+    {
+        TransformedSpriteList::iterator item = it->second;
+        ++it;
+        remove_transformed_sprite(item);
+    }
+}
+
+void clear_sprite_transform_cache()
+{
+    for (TransformedSpriteList::iterator it = transformList.begin(); it != transformList.end(); ++it)
+        delete it->Image;
+    transformList.clear();
+    transformMap.clear();
+    transformCacheSize = 0;
+}
+
+void shutdown_sprite_transform_cache()
+{
+    clear_sprite_transform_cache();
+    Debug::Printf(kDbgMsg_Init, "Sprite transform cache: %d hits, %d misses, %d images removed over the limit",
+        transformNumHits, transformNumMisses, transformNumRemoved);
+}
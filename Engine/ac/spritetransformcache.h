@@ -0,0 +1,66 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Cache of the sprites scaled, flipped, tinted or lit by the software
+// renderer. Unlike the per-character and per-object caches, which only
+// remember the last image of each, it is shared by everything drawn in the
+// room, so that the repeating animation frames and the characters using
+// same views are only transformed once. The least recently used images are
+// removed when the cache grows over its size limit.
+//
+//=============================================================================
+#ifndef __AGS_EE_AC__SPRITETRANSFORMCACHE_H
+#define __AGS_EE_AC__SPRITETRANSFORMCACHE_H
+
+#include <stddef.h>
+
+namespace AGS { namespace Common { class Bitmap; } }
+using namespace AGS; // FIXME later
+
+// Default size limit of the cache, in bytes
+#define DEFAULT_SPRITE_TRANSFORM_CACHE_SIZE (8 * 1024 * 1024)
+
+// Describes how the sprite was drawn
+struct SpriteTransform
+{
+    int  Sprite;
+    int  Width;
+    int  Height;
+    bool Mirrored;
+    bool Antialiased;
+    int  TintRed;
+    int  TintGreen;
+    int  TintBlue;
+    int  TintAmount;
+    int  TintLight;
+    int  LightLevel;
+
+    bool operator <(const SpriteTransform &other) const;
+};
+
+// Sets the size limit, in bytes, removing the images over it
+void set_sprite_transform_cache_size(size_t max_size);
+// Returns the cached image of the transformed sprite, or NULL if there's none;
+// the image is only valid until the next image is put into the cache
+Common::Bitmap *get_transformed_sprite(const SpriteTransform &transform);
+// Puts a copy of the transformed sprite into the cache
+void put_transformed_sprite(const SpriteTransform &transform, Common::Bitmap *image);
+// Removes the images made from the sprite, after the sprite is changed
+void invalidate_transformed_sprite(int sprite);
+// Removes all the images
+void clear_sprite_transform_cache();
+// Removes all the images and prints the cache statistics
+void shutdown_sprite_transform_cache();
+
+#endif // __AGS_EE_AC__SPRITETRANSFORMCACHE_H
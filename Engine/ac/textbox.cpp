@@ -37,7 +37,7 @@ void TextBox_SetText(GUITextBox *texbox, const char *newtex) {
 
     if (strcmp(texbox->text, newtex)) {
         strcpy(texbox->text, newtex);
-        guis_need_update = 1;
+        texbox->MarkChanged();
     }
 }
 
@@ -50,7 +50,7 @@ void TextBox_SetTextColor(GUITextBox *guit, int colr)
     if (guit->textcol != colr) 
     {
         guit->textcol = colr;
-        guis_need_update = 1;
+        guit->MarkChanged();
     }
 }
 
@@ -64,7 +64,7 @@ void TextBox_SetFont(GUITextBox *guit, int fontnum) {
 
     if (guit->font != fontnum) {
         guit->font = fontnum;
-        guis_need_update = 1;
+        guit->MarkChanged();
     }
 }
 
@@ -12,6 +12,8 @@
 //
 //=============================================================================
 
+#include <algorithm>
+#include <vector>
 #include "ac/common.h"
 #include "ac/object.h"
 #include "ac/roomstruct.h"
@@ -20,8 +22,10 @@
 #include "ac/gamestate.h"
 #include "ac/gamesetupstruct.h"
 #include "ac/object.h"
+#include "ac/roomindex.h"
 #include "ac/roomobject.h"
 #include "ac/roomstatus.h"
+#include "ac/route_finder.h"
 #include "ac/walkablearea.h"
 #include "gfx/bitmap.h"
 
@@ -56,6 +60,8 @@ void redo_walkable_areas() {
         }
     }
 
+    invalidate_room_navigation();
+    invalidate_blocking_areas();
 }
 
 int get_walkable_area_pixel(int x, int y)
@@ -140,63 +146,206 @@ int is_point_in_rect(int x, int y, int left, int top, int right, int bottom) {
     return 0;
 }
 
-Bitmap *prepare_walkable_areas (int sourceChar) {
-    // copy the walkable areas to the temp bitmap
-    walkable_areas_temp->Blit (thisroom.walls, 0,0,0,0,thisroom.walls->GetWidth(),thisroom.walls->GetHeight());
-    // if the character who's moving doesn't Bitmap *, don't bother checking
-    if (sourceChar < 0) ;
-    else if (game.chars[sourceChar].flags & CHF_NOBLOCKING)
-        return walkable_areas_temp;
+// Area removed from the walkable areas by a blocking character or object,
+// in the mask coordinates; empty if x2 < x1
+struct BlockingArea
+{
+    int x1, y1, x2, y2;
+};
+
+// The pathfinder's mask is kept between the route requests, and only the
+// blocking areas which have changed are redrawn on it. Each pixel counts the
+// blocking areas over it, so that they may overlap.
+static std::vector<BlockingArea> blocking_areas;   // characters, then objects
+static std::vector<unsigned short> blocking_count;
+static std::vector<int> blocking_excluded;         // areas let through for the last request
+static std::vector<int> blocking_chars;            // characters with the areas set
+static bool blocking_mask_valid = false;
+
+void invalidate_blocking_areas() {
+    blocking_mask_valid = false;
+}
+
+static BlockingArea make_blocking_area(int fromx, int cwidth, int starty, int endy) {
+    fromx = convert_to_low_res(fromx);
+    cwidth = convert_to_low_res(cwidth);
+    starty = convert_to_low_res(starty);
+    endy = convert_to_low_res(endy);
+
+    BlockingArea area;
+    area.x1 = std::max(fromx, 0);
+    area.x2 = std::min(fromx + cwidth, walkable_areas_temp->GetWidth()) - 1;
+    area.y1 = std::max(starty, 0);
+    area.y2 = std::min(endy, walkable_areas_temp->GetHeight() - 1);
+    if (area.y2 < area.y1)
+        area.x2 = area.x1 - 1;
+    return area;
+}
+
+static void stamp_blocking_area(const BlockingArea &area) {
+    const int width = walkable_areas_temp->GetWidth();
+    for (int y = area.y1; y <= area.y2; y++) {
+        uint8_t *scanline = walkable_areas_temp->GetScanLineForWriting(y);
+        unsigned short *count = &blocking_count[y * width];
+        for (int x = area.x1; x <= area.x2; x++) {
+            if (count[x]++ == 0)
+                scanline[x] = 0;
+        }
+    }
+}
+
+static void unstamp_blocking_area(const BlockingArea &area) {
+    const int width = walkable_areas_temp->GetWidth();
+    for (int y = area.y1; y <= area.y2; y++) {
+        uint8_t *scanline = walkable_areas_temp->GetScanLineForWriting(y);
+        const uint8_t *walls_scanline = thisroom.walls->GetScanLine(y);
+        unsigned short *count = &blocking_count[y * width];
+        for (int x = area.x1; x <= area.x2; x++) {
+            if (--count[x] == 0)
+                scanline[x] = walls_scanline[x];
+        }
+    }
+}
+
+static void set_blocking_area(int index, const BlockingArea &area) {
+    BlockingArea &old_area = blocking_areas[index];
+    if ((old_area.x1 == area.x1) && (old_area.x2 == area.x2) &&
+        (old_area.y1 == area.y1) && (old_area.y2 == area.y2))
+        return;
+    unstamp_blocking_area(old_area);
+    old_area = area;
+    stamp_blocking_area(old_area);
+}
+
+static bool is_blocking_area_empty(int index) {
+    return blocking_areas[index].x2 < blocking_areas[index].x1;
+}
+
+// Puts back the blocking areas let through for the previous request
+static void restore_excluded_blocking_areas() {
+    for (size_t i = 0; i < blocking_excluded.size(); i++)
+        stamp_blocking_area(blocking_areas[blocking_excluded[i]]);
+    blocking_excluded.clear();
+}
+
+void update_blocking_areas() {
+    const int num_areas = game.numcharacters + MAX_INIT_SPR;
+    BlockingArea no_area = { 0, 0, -1, -1 };
+
+    if (!blocking_mask_valid) {
+        walkable_areas_temp->Blit(thisroom.walls, 0,0,0,0,thisroom.walls->GetWidth(),thisroom.walls->GetHeight());
+        blocking_count.assign(walkable_areas_temp->GetWidth() * walkable_areas_temp->GetHeight(), 0);
+        blocking_areas.assign(num_areas, no_area);
+        blocking_excluded.clear();
+        blocking_chars.clear();
+        blocking_mask_valid = true;
+    }
+
+    restore_excluded_blocking_areas();
 
     int ww;
+    // clear the areas of the characters who have left the room
+    for (size_t i = 0; i < blocking_chars.size(); i++) {
+        if (game.chars[blocking_chars[i]].room != displayed_room)
+            set_blocking_area(blocking_chars[i], no_area);
+    }
+    blocking_chars.clear();
+
     // for each character in the current room, make the area under
     // them unwalkable
-    for (ww = 0; ww < game.numcharacters; ww++) {
-        if (game.chars[ww].on != 1) continue;
-        if (game.chars[ww].room != displayed_room) continue;
-        if (ww == sourceChar) continue;
-        if (game.chars[ww].flags & CHF_NOBLOCKING) continue;
-        if (convert_to_low_res(game.chars[ww].y) >= walkable_areas_temp->GetHeight()) continue;
-        if (convert_to_low_res(game.chars[ww].x) >= walkable_areas_temp->GetWidth()) continue;
-        if ((game.chars[ww].y < 0) || (game.chars[ww].x < 0)) continue;
-
+    const std::vector<int> &room_chars = get_room_characters();
+    for (size_t i = 0; i < room_chars.size(); i++) {
+        ww = room_chars[i];
         CharacterInfo *char1 = &game.chars[ww];
-        int cwidth, fromx;
-
-        if (is_char_on_another(sourceChar, ww, &fromx, &cwidth))
-            continue;
-        if ((sourceChar >= 0) && (is_char_on_another(ww, sourceChar, NULL, NULL)))
+        if ((char1->on != 1) || (char1->room != displayed_room) ||
+            (char1->flags & CHF_NOBLOCKING) ||
+            (convert_to_low_res(char1->y) >= walkable_areas_temp->GetHeight()) ||
+            (convert_to_low_res(char1->x) >= walkable_areas_temp->GetWidth()) ||
+            (char1->y < 0) || (char1->x < 0)) {
+            set_blocking_area(ww, no_area);
             continue;
+        }
 
-        remove_walkable_areas_from_temp(fromx, cwidth, char1->get_blocking_top(), char1->get_blocking_bottom());
+        int fromx, cwidth, y1, y2;
+        get_char_blocking_rect(ww, &fromx, &y1, &cwidth, &y2);
+        set_blocking_area(ww, make_blocking_area(fromx, cwidth, char1->get_blocking_top(), char1->get_blocking_bottom()));
+        if (!is_blocking_area_empty(ww))
+            blocking_chars.push_back(ww);
     }
 
     // check for any blocking objects in the room, and deal with them
     // as well
+    for (ww = 0; ww < MAX_INIT_SPR; ww++) {
+        if ((ww >= croom->numobj) || (objs[ww].on != 1) ||
+            ((objs[ww].flags & OBJF_SOLID) == 0) ||
+            (convert_to_low_res(objs[ww].y) >= walkable_areas_temp->GetHeight()) ||
+            (convert_to_low_res(objs[ww].x) >= walkable_areas_temp->GetWidth()) ||
+            (objs[ww].y < 0) || (objs[ww].x < 0)) {
+            set_blocking_area(game.numcharacters + ww, no_area);
+            continue;
+        }
+
+        int x1, y1, width, y2;
+        get_object_blocking_rect(ww, &x1, &y1, &width, &y2);
+        set_blocking_area(game.numcharacters + ww, make_blocking_area(x1, width, y1, y2));
+    }
+}
+
+// Lets the character through the blocking area for the current request
+static void exclude_blocking_area(int index) {
+    if (is_blocking_area_empty(index))
+        return;
+    unstamp_blocking_area(blocking_areas[index]);
+    blocking_excluded.push_back(index);
+}
+
+Bitmap *prepare_walkable_areas_for (int sourceChar) {
+    if (!blocking_mask_valid)
+        update_blocking_areas();
+    else
+        restore_excluded_blocking_areas();
+
+    if (sourceChar < 0)
+        return walkable_areas_temp;
+
+    int ww;
+    // if the character who's moving doesn't block, don't bother checking
+    if (game.chars[sourceChar].flags & CHF_NOBLOCKING) {
+        for (ww = 0; ww < (int)blocking_areas.size(); ww++)
+            exclude_blocking_area(ww);
+        return walkable_areas_temp;
+    }
+
+    for (size_t i = 0; i < blocking_chars.size(); i++) {
+        ww = blocking_chars[i];
+        if ((ww == sourceChar) ||
+            is_char_on_another(sourceChar, ww, NULL, NULL) ||
+            is_char_on_another(ww, sourceChar, NULL, NULL))
+            exclude_blocking_area(ww);
+    }
+
     for (ww = 0; ww < croom->numobj; ww++) {
-        if (objs[ww].on != 1) continue;
-        if ((objs[ww].flags & OBJF_SOLID) == 0)
+        if (is_blocking_area_empty(game.numcharacters + ww))
             continue;
-        if (convert_to_low_res(objs[ww].y) >= walkable_areas_temp->GetHeight()) continue;
-        if (convert_to_low_res(objs[ww].x) >= walkable_areas_temp->GetWidth()) continue;
-        if ((objs[ww].y < 0) || (objs[ww].x < 0)) continue;
 
         int x1, y1, width, y2;
         get_object_blocking_rect(ww, &x1, &y1, &width, &y2);
 
         // if the character is currently standing on the object, ignore
         // it so as to allow him to escape
-        if ((sourceChar >= 0) &&
-            (is_point_in_rect(game.chars[sourceChar].x, game.chars[sourceChar].y, 
-            x1, y1, x1 + width, y2)))
-            continue;
-
-        remove_walkable_areas_from_temp(x1, width, y1, y2);
+        if (is_point_in_rect(game.chars[sourceChar].x, game.chars[sourceChar].y, 
+            x1, y1, x1 + width, y2))
+            exclude_blocking_area(game.numcharacters + ww);
     }
 
     return walkable_areas_temp;
 }
 
+Bitmap *prepare_walkable_areas (int sourceChar) {
+    update_blocking_areas();
+    return prepare_walkable_areas_for(sourceChar);
+}
+
 // return the walkable area at the character's feet, taking into account
 // that he might just be off the edge of one
 int get_walkable_area_at_location(int xx, int yy) {
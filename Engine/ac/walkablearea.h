@@ -24,7 +24,16 @@ int   get_area_scaling (int onarea, int xx, int yy);
 void  scale_sprite_size(int sppic, int zoom_level, int *newwidth, int *newheight);
 void  remove_walkable_areas_from_temp(int fromx, int cwidth, int starty, int endy);
 int   is_point_in_rect(int x, int y, int left, int top, int right, int bottom);
+// Updates the blocking areas of characters and objects on the pathfinder's
+// mask, and returns the mask prepared for the given character
 Common::Bitmap *prepare_walkable_areas (int sourceChar);
+// Redraws the blocking areas of the characters and objects which have moved
+void  update_blocking_areas();
+// Returns the mask for the given character, without updating the blocking
+// areas; valid until the next call to either of the prepare functions
+Common::Bitmap *prepare_walkable_areas_for (int sourceChar);
+// Rebuilds the pathfinder's mask on the next request
+void  invalidate_blocking_areas();
 int   get_walkable_area_at_location(int xx, int yy);
 int   get_walkable_area_at_character (int charnum);
 
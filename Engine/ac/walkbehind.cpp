@@ -34,6 +34,7 @@ int *walkBehindStartY = NULL, *walkBehindEndY = NULL;
 char noWalkBehindsAtAll = 0;
 int walkBehindLeft[MAX_OBJ], walkBehindTop[MAX_OBJ];
 int walkBehindRight[MAX_OBJ], walkBehindBottom[MAX_OBJ];
+WalkBehindMask walkBehindMask[MAX_OBJ];
 IDriverDependantBitmap *walkBehindBitmap[MAX_OBJ];
 int walkBehindsCachedForBgNum = 0;
 WalkBehindMethodEnum walkBehindMethod = DrawOverCharSprite;
@@ -138,8 +139,38 @@ void recache_walk_behinds () {
     }
   }
 
+  // make the masks, so that the sprites could be cut by whole rows
+  for (ee = 0; ee < MAX_OBJ; ee++)
+  {
+    WalkBehindMask &mask = walkBehindMask[ee];
+    if ((ee == 0) || (walkBehindLeft[ee] == NO_WALK_BEHIND))
+    {
+      mask.Left = mask.Top = 0;
+      mask.Width = mask.Height = 0;
+      mask.Pixels.clear();
+      continue;
+    }
+    mask.Left = walkBehindLeft[ee];
+    mask.Top = walkBehindTop[ee];
+    mask.Width = (walkBehindRight[ee] - walkBehindLeft[ee]) + 1;
+    mask.Height = (walkBehindBottom[ee] - walkBehindTop[ee]) + 1;
+    mask.Pixels.resize(mask.Width * mask.Height);
+    for (rr = 0; rr < mask.Height; rr++)
+    {
+      const unsigned char *src = thisroom.object->GetScanLine(mask.Top + rr) + mask.Left;
+      unsigned char *dst = &mask.Pixels[rr * mask.Width];
+      for (int xx = 0; xx < mask.Width; xx++)
+        dst[xx] = (src[xx] == ee) ? 0xFF : 0;
+    }
+  }
+
   if (walkBehindMethod == DrawAsSeparateSprite)
   {
     update_walk_behind_images();
   }
 }
+
+const WalkBehindMask &get_walk_behind_mask(int area)
+{
+  return walkBehindMask[area];
+}
@@ -18,6 +18,8 @@
 #ifndef __AGS_EE_AC__WALKBEHIND_H
 #define __AGS_EE_AC__WALKBEHIND_H
 
+#include <vector>
+
 enum WalkBehindMethodEnum
 {
     DrawOverCharSprite,
@@ -25,7 +27,24 @@ enum WalkBehindMethodEnum
     DrawAsSeparateCharSprite
 };
 
+// Pixels of a walk-behind area within its bounding box, in the room
+// co-ordinates; 0xFF where the area is, and 0 elsewhere
+struct WalkBehindMask
+{
+    int Left, Top;
+    int Width, Height;
+    std::vector<unsigned char> Pixels;
+
+    inline const unsigned char *GetRow(int y) const
+    {
+        return &Pixels[(y - Top) * Width];
+    }
+};
+
 void update_walk_behind_images();
 void recache_walk_behinds ();
+// Returns the mask of the walk-behind area, which is empty if the area is
+// not present in the room
+const WalkBehindMask &get_walk_behind_mask(int area);
 
 #endif // __AGS_EE_AC__WALKBEHIND_H
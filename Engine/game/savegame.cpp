@@ -509,7 +509,7 @@ SavegameError DoAfterRestore(const PreservedParams &pp, const RestoredData &r_da
 
     recreate_overlay_ddbs();
 
-    guis_need_update = 1;
+    mark_all_guis_changed();
 
     play.ignore_user_input_until_time = 0;
     update_polled_stuff_if_runtime();
@@ -23,6 +23,7 @@
 #include "gfx/gfx_util.h"
 #include "main/main_allegro.h"
 #include "platform/base/agsplatformdriver.h"
+#include "util/math.h"
 
 #if defined(PSP_VERSION)
 // PSP: Includes for sceKernelDelayThread.
@@ -55,6 +56,7 @@ namespace ALSW
 {
 
 namespace BitmapHelper = AGS::Common::BitmapHelper;
+namespace Math = AGS::Common::Math;
 
 bool ALSoftwareGfxModeList::GetMode(int index, DisplayMode &mode) const
 {
@@ -78,6 +80,7 @@ ALSoftwareGraphicsDriver::ALSoftwareGraphicsDriver()
   _drawScreenCallback = NULL;
   _nullSpriteCallback = NULL;
   _initGfxCallback = NULL;
+  _restoreBgCallback = NULL;
   _tint_red = 0;
   _tint_green = 0;
   _tint_blue = 0;
@@ -89,6 +92,13 @@ ALSoftwareGraphicsDriver::ALSoftwareGraphicsDriver()
   dxGammaControl = NULL;
 #endif
   _allegroScreenWrapper = NULL;
+  _dirtyRectsEnabled = false;
+  _showDirtyRects = false;
+  _fullRedraw = true;
+  _presentFull = true;
+  _presentOffsetX = 0;
+  _presentOffsetY = 0;
+  _ddbStamp = 0;
 }
 
 bool ALSoftwareGraphicsDriver::IsModeSupported(const DisplayMode &mode)
@@ -234,6 +244,7 @@ void ALSoftwareGraphicsDriver::CreateVirtualScreen()
     return;
   BitmapHelper::SetScreenBitmap( _filter->InitVirtualScreen(BitmapHelper::GetScreenBitmap(), _srcRect.GetSize(), _dstRect) );
   virtualScreen = BitmapHelper::GetScreenBitmap();
+  _fullRedraw = true;
 }
 
 void ALSoftwareGraphicsDriver::ReleaseDisplayMode()
@@ -285,6 +296,7 @@ void ALSoftwareGraphicsDriver::ClearRectangle(int x1, int y1, int x2, int y2, RG
   if (colorToUse != NULL) 
     color = makecol_depth(_mode.ColorDepth, colorToUse->r, colorToUse->g, colorToUse->b);
   _filter->ClearRect(x1, y1, x2, y2, color);
+  _fullRedraw = true;
 }
 
 ALSoftwareGraphicsDriver::~ALSoftwareGraphicsDriver()
@@ -342,6 +354,7 @@ Bitmap *ALSoftwareGraphicsDriver::ConvertBitmapToSupportedColourDepth(Bitmap *bi
 IDriverDependantBitmap* ALSoftwareGraphicsDriver::CreateDDBFromBitmap(Bitmap *bitmap, bool hasAlpha, bool opaque)
 {
   ALSoftwareBitmap* newBitmap = new ALSoftwareBitmap(bitmap, opaque, hasAlpha);
+  newBitmap->_stamp = ++_ddbStamp;
   return newBitmap;
 }
 
@@ -350,6 +363,7 @@ void ALSoftwareGraphicsDriver::UpdateDDBFromBitmap(IDriverDependantBitmap* bitma
   ALSoftwareBitmap* alSwBmp = (ALSoftwareBitmap*)bitmapToUpdate;
   alSwBmp->_bmp = bitmap;
   alSwBmp->_hasAlpha = hasAlpha;
+  alSwBmp->_stamp = ++_ddbStamp;
 }
 
 void ALSoftwareGraphicsDriver::DestroyDDB(IDriverDependantBitmap* bitmap)
@@ -375,24 +389,8 @@ void ALSoftwareGraphicsDriver::ClearDrawList()
   numToDraw = 0;
 }
 
-void ALSoftwareGraphicsDriver::RenderToBackBuffer()
+void ALSoftwareGraphicsDriver::RenderSprite(ALSoftwareBitmap *bitmap, int drawAtX, int drawAtY)
 {
-  for (int i = 0; i < numToDraw; i++)
-  {
-    if (drawlist[i] == NULL)
-    {
-      if (_nullSpriteCallback)
-        _nullSpriteCallback(drawx[i], drawy[i]);
-      else
-        throw Ali3DException("Unhandled attempt to draw null sprite");
-
-      continue;
-    }
-
-    ALSoftwareBitmap* bitmap = drawlist[i];
-    int drawAtX = drawx[i];
-    int drawAtY = drawy[i];
-
     if ((bitmap->_opaque) && (bitmap->_bmp == virtualScreen))
     { }
     else if (bitmap->_opaque)
@@ -405,13 +403,24 @@ void ALSoftwareGraphicsDriver::RenderToBackBuffer()
     }
     else if (bitmap->_hasAlpha)
     {
+      // blend whole rows at once if possible, otherwise use the allegro blenders
       if (bitmap->_transparency == 0) // this means opaque
-        set_alpha_blender();
+      {
+        if (!GfxUtil::SpanBlendBlt(virtualScreen, bitmap->_bmp, drawAtX, drawAtY, kSpanBlend_Alpha, 0))
+        {
+          set_alpha_blender();
+          virtualScreen->TransBlendBlt(bitmap->_bmp, drawAtX, drawAtY);
+        }
+      }
       else
+      {
         // here _transparency is used as alpha (between 1 and 254)
-        set_blender_mode(NULL, NULL, _trans_alpha_blender32, 0, 0, 0, bitmap->_transparency);
-
-	  virtualScreen->TransBlendBlt(bitmap->_bmp, drawAtX, drawAtY);
+        if (!GfxUtil::SpanBlendBlt(virtualScreen, bitmap->_bmp, drawAtX, drawAtY, kSpanBlend_TransAlpha, bitmap->_transparency))
+        {
+          set_blender_mode(NULL, NULL, _trans_alpha_blender32, 0, 0, 0, bitmap->_transparency);
+          virtualScreen->TransBlendBlt(bitmap->_bmp, drawAtX, drawAtY);
+        }
+      }
     }
     else
     {
@@ -419,14 +428,35 @@ void ALSoftwareGraphicsDriver::RenderToBackBuffer()
       GfxUtil::DrawSpriteWithTransparency(virtualScreen, bitmap->_bmp, drawAtX, drawAtY,
           bitmap->_transparency ? bitmap->_transparency : 255);
     }
+}
+
+void ALSoftwareGraphicsDriver::RenderDrawList()
+{
+  for (int i = 0; i < numToDraw; i++)
+  {
+    if (drawlist[i] == NULL)
+    {
+      if (_nullSpriteCallback)
+        _nullSpriteCallback(drawx[i], drawy[i]);
+      else
+        throw Ali3DException("Unhandled attempt to draw null sprite");
+
+      continue;
+    }
+
+    RenderSprite(drawlist[i], drawx[i], drawy[i]);
   }
+}
 
-  if (((_tint_red > 0) || (_tint_green > 0) || (_tint_blue > 0))
-      && (_mode.ColorDepth > 8)) {
+void ALSoftwareGraphicsDriver::RenderScreenTint()
+{
     // Common::gl_ScreenBmp tint
     // This slows down the game no end, only experimental ATM
-    set_trans_blender(_tint_red, _tint_green, _tint_blue, 0);
-    virtualScreen->LitBlendBlt(virtualScreen, 0, 0, 128);
+    if (!GfxUtil::SpanTintBlt(virtualScreen, _tint_red, _tint_green, _tint_blue, 128))
+    {
+      set_trans_blender(_tint_red, _tint_green, _tint_blue, 0);
+      virtualScreen->LitBlendBlt(virtualScreen, 0, 0, 128);
+    }
 /*  This alternate method gives the correct (D3D-style) result, but is just too slow!
     if ((_spareTintingScreen != NULL) &&
         ((_spareTintingScreen->GetWidth() != virtualScreen->GetWidth()) || (_spareTintingScreen->GetHeight() != virtualScreen->GetHeight())))
@@ -440,6 +470,197 @@ void ALSoftwareGraphicsDriver::RenderToBackBuffer()
     }
     tint_image(virtualScreen, _spareTintingScreen, _tint_red, _tint_green, _tint_blue, 100, 255);
     Blit(_spareTintingScreen, virtualScreen, 0, 0, 0, 0, _spareTintingScreen->GetWidth(), _spareTintingScreen->GetHeight());*/
+}
+
+void ALSoftwareGraphicsDriver::SetCallbackToRestoreBackground(GFXDRV_CLIENTCALLBACKRESTOREBG callback)
+{
+  _restoreBgCallback = callback;
+  if (!callback)
+    EnableDirtyRects(false);
+}
+
+bool ALSoftwareGraphicsDriver::EnableDirtyRects(bool enabled)
+{
+  enabled &= (_restoreBgCallback != NULL);
+  if (enabled == _dirtyRectsEnabled)
+    return _dirtyRectsEnabled;
+  _dirtyRectsEnabled = enabled;
+  // the previous frame may have been drawn by other means
+  _fullRedraw = true;
+  _lastSprites.clear();
+  _invalidRects.clear();
+  _outlinedRects.clear();
+  return _dirtyRectsEnabled;
+}
+
+void ALSoftwareGraphicsDriver::InvalidateRect(const Rect &rc)
+{
+  if (!_dirtyRectsEnabled)
+    return;
+  if (_invalidRects.size() >= MAX_DIRTY_RECTS)
+    _fullRedraw = true;
+  else
+    _invalidRects.push_back(rc);
+}
+
+inline bool is_rect_overlapping(const Rect &r1, const Rect &r2)
+{
+  return r1.Left <= r2.Right && r2.Left <= r1.Right && r1.Top <= r2.Bottom && r2.Top <= r1.Bottom;
+}
+
+inline int get_rect_area(const Rect &rc)
+{
+  return rc.GetWidth() * rc.GetHeight();
+}
+
+void ALSoftwareGraphicsDriver::AddDirtyRect(const Rect &rc)
+{
+  Rect add(Math::Max(rc.Left, 0), Math::Max(rc.Top, 0),
+    Math::Min(rc.Right, virtualScreen->GetWidth() - 1), Math::Min(rc.Bottom, virtualScreen->GetHeight() - 1));
+  if (add.IsEmpty() || _fullRedraw)
+    return;
+  // merge with the rectangles, if the united one is not larger than both
+  // of them; this joins the overlapping and adjacent areas of a moving sprite
+  for (size_t i = 0; i < _dirtyRects.size();)
+  {
+    const Rect &r = _dirtyRects[i];
+    Rect u(Math::Min(r.Left, add.Left), Math::Min(r.Top, add.Top),
+      Math::Max(r.Right, add.Right), Math::Max(r.Bottom, add.Bottom));
+    if (get_rect_area(u) <= get_rect_area(r) + get_rect_area(add))
+    {
+      add = u;
+      _dirtyRects.erase(_dirtyRects.begin() + i);
+      i = 0;
+    }
+    else
+    {
+      i++;
+    }
+  }
+  if (_dirtyRects.size() >= MAX_DIRTY_RECTS)
+    _fullRedraw = true;
+  else
+    _dirtyRects.push_back(add);
+}
+
+void ALSoftwareGraphicsDriver::FindDirtyRects()
+{
+  _dirtyRects.clear();
+  // the sprites which are found on both frames, in the same order relative
+  // to each other, need not be redrawn unless something changed under them
+  size_t next = 0;
+  for (size_t i = 0; i < _sprites.size(); i++)
+  {
+    size_t j = next;
+    for (; j < _lastSprites.size() && !(_lastSprites[j] == _sprites[i]); j++);
+    if (j < _lastSprites.size())
+    {
+      for (; next < j; next++)
+        AddDirtyRect(_lastSprites[next].Area);
+      next = j + 1;
+    }
+    else
+    {
+      AddDirtyRect(_sprites[i].Area);
+    }
+  }
+  for (; next < _lastSprites.size(); next++)
+    AddDirtyRect(_lastSprites[next].Area);
+  for (size_t i = 0; i < _invalidRects.size(); i++)
+    AddDirtyRect(_invalidRects[i]);
+  for (size_t i = 0; i < _outlinedRects.size(); i++)
+    AddDirtyRect(_outlinedRects[i]);
+
+  int area = 0;
+  for (size_t i = 0; i < _dirtyRects.size(); i++)
+    area += get_rect_area(_dirtyRects[i]);
+  // redrawing the larger part of the screen in pieces is not worth it
+  if (_fullRedraw || area > virtualScreen->GetWidth() * virtualScreen->GetHeight() * 3 / 4)
+  {
+    _dirtyRects.clear();
+    _dirtyRects.push_back(RectWH(0, 0, virtualScreen->GetWidth(), virtualScreen->GetHeight()));
+    _presentFull = true;
+  }
+}
+
+void ALSoftwareGraphicsDriver::RenderDirtyRects()
+{
+  const Rect screen_rc = RectWH(0, 0, virtualScreen->GetWidth(), virtualScreen->GetHeight());
+  const bool tinted = ((_tint_red > 0) || (_tint_green > 0) || (_tint_blue > 0)) && (_mode.ColorDepth > 8);
+  _sprites.clear();
+  for (int i = 0; i < numToDraw; i++)
+  {
+    ALSoftwareBitmap *bitmap = drawlist[i];
+    DrawnSprite spr;
+    spr.Bmp = bitmap;
+    spr.Pixels = bitmap ? bitmap->_bmp : NULL;
+    spr.Stamp = bitmap ? bitmap->_stamp : 0;
+    spr.X = drawx[i];
+    spr.Y = drawy[i];
+    spr.Transparency = bitmap ? bitmap->_transparency : 0;
+    spr.Area = Rect(0, 0, -1, -1);
+    if (bitmap == NULL)
+    {
+      // plugins are not drawing on the screen when the dirty rectangles are
+      // enabled, so the hooks are run only once
+      if (_nullSpriteCallback)
+        _nullSpriteCallback(drawx[i], drawy[i]);
+      else
+        throw Ali3DException("Unhandled attempt to draw null sprite");
+    }
+    else if (bitmap->_opaque ? (bitmap->_bmp != virtualScreen) : (bitmap->_transparency < 255))
+    {
+      spr.Area = RectWH(drawx[i], drawy[i], bitmap->_bmp->GetWidth(), bitmap->_bmp->GetHeight());
+    }
+    _sprites.push_back(spr);
+  }
+
+  // the tint changes every pixel, and has to be cleared on the next frame
+  _fullRedraw |= tinted;
+  FindDirtyRects();
+  _fullRedraw = tinted;
+  _invalidRects.clear();
+
+  for (size_t i = 0; i < _dirtyRects.size(); i++)
+  {
+    const Rect &rc = _dirtyRects[i];
+    virtualScreen->SetClip(rc);
+    _restoreBgCallback(virtualScreen, rc);
+    for (size_t s = 0; s < _sprites.size(); s++)
+    {
+      if (!_sprites[s].Area.IsEmpty() && is_rect_overlapping(_sprites[s].Area, rc))
+        RenderSprite(_sprites[s].Bmp, _sprites[s].X, _sprites[s].Y);
+    }
+  }
+  virtualScreen->SetClip(screen_rc);
+
+  if (tinted)
+    RenderScreenTint();
+
+  _outlinedRects.clear();
+  if (_showDirtyRects)
+  {
+    color_t outline_color = makecol_depth(virtualScreen->GetColorDepth(), 0, 255, 0);
+    for (size_t i = 0; i < _dirtyRects.size(); i++)
+      virtualScreen->DrawRect(_dirtyRects[i], outline_color);
+    _outlinedRects = _dirtyRects;
+  }
+  _presentRects.insert(_presentRects.end(), _dirtyRects.begin(), _dirtyRects.end());
+  _lastSprites.swap(_sprites);
+}
+
+void ALSoftwareGraphicsDriver::RenderToBackBuffer()
+{
+  if (_dirtyRectsEnabled)
+  {
+    RenderDirtyRects();
+  }
+  else
+  {
+    RenderDrawList();
+    if (((_tint_red > 0) || (_tint_green > 0) || (_tint_blue > 0))
+        && (_mode.ColorDepth > 8))
+      RenderScreenTint();
   }
 
   ClearDrawList();
@@ -452,10 +673,24 @@ void ALSoftwareGraphicsDriver::Render(GlobalFlipType flip)
   if (_autoVsync)
     this->Vsync();
 
-  if (flip == kFlip_None)
-    _filter->RenderScreen(virtualScreen, _global_x_offset, _global_y_offset);
-  else
-    _filter->RenderScreenFlipped(virtualScreen, _global_x_offset, _global_y_offset, flip);
+  // present only the redrawn parts of the screen if the filter can do that
+  bool present_full = !_dirtyRectsEnabled || _presentFull || flip != kFlip_None ||
+    _global_x_offset != _presentOffsetX || _global_y_offset != _presentOffsetY;
+  for (size_t i = 0; i < _presentRects.size() && !present_full; i++)
+    present_full = !_filter->RenderScreenRect(virtualScreen, _global_x_offset, _global_y_offset, _presentRects[i]);
+
+  if (present_full)
+  {
+    if (flip == kFlip_None)
+      _filter->RenderScreen(virtualScreen, _global_x_offset, _global_y_offset);
+    else
+      _filter->RenderScreenFlipped(virtualScreen, _global_x_offset, _global_y_offset, flip);
+  }
+
+  _presentRects.clear();
+  _presentFull = false;
+  _presentOffsetX = _global_x_offset;
+  _presentOffsetY = _global_y_offset;
 }
 
 void ALSoftwareGraphicsDriver::Render()
@@ -604,6 +839,7 @@ void ALSoftwareGraphicsDriver::__fade_out_range(int speed, int from, int to, int
 
 void ALSoftwareGraphicsDriver::FadeOut(int speed, int targetColourRed, int targetColourGreen, int targetColourBlue) {
 
+  _fullRedraw = true;
   if (_mode.ColorDepth > 8) 
   {
     highcolor_fade_out(speed * 4, targetColourRed, targetColourGreen, targetColourBlue);
@@ -613,6 +849,7 @@ void ALSoftwareGraphicsDriver::FadeOut(int speed, int targetColourRed, int targe
 }
 
 void ALSoftwareGraphicsDriver::FadeIn(int speed, PALLETE p, int targetColourRed, int targetColourGreen, int targetColourBlue) {
+  _fullRedraw = true;
   if (_mode.ColorDepth > 8) {
 
     highcolor_fade_in(virtualScreen, speed * 4, targetColourRed, targetColourGreen, targetColourBlue);
@@ -654,6 +891,7 @@ void ALSoftwareGraphicsDriver::BoxOutEffect(bool blackingOut, int speed, int del
 
 bool ALSoftwareGraphicsDriver::PlayVideo(const char *filename, bool useAVISound, VideoSkipType skipType, bool stretchToFullScreen)
 {
+  _fullRedraw = true;
 #ifdef _WIN32
   int result = dxmedia_play_video(filename, useAVISound, skipType, stretchToFullScreen ? 1 : 0);
   return (result == 0);
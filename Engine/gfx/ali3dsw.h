@@ -19,6 +19,7 @@
 #ifndef __AGS_EE_GFX__ALI3DSW_H
 #define __AGS_EE_GFX__ALI3DSW_H
 
+#include <vector>
 #include "util/stdtr1compat.h"
 #include TR1INCLUDE(memory)
 #include <allegro.h>
@@ -69,6 +70,8 @@ public:
     bool _opaque;
     bool _hasAlpha;
     int _transparency;
+    // Changes each time the bitmap is assigned, to tell if the image has changed
+    unsigned int _stamp;
 
     ALSoftwareBitmap(Bitmap *bmp, bool opaque, bool hasAlpha)
     {
@@ -82,6 +85,7 @@ public:
         _transparency = 0;
         _opaque = opaque;
         _hasAlpha = hasAlpha;
+        _stamp = 0;
     }
 
     int GetWidthToRender() { return (_stretchToWidth > 0) ? _stretchToWidth : _width; }
@@ -120,6 +124,7 @@ private:
 
 
 #define MAX_DRAW_LIST_SIZE 200
+#define MAX_DIRTY_RECTS 32
 
 class ALSoftwareGraphicsDriver : public GraphicsDriverBase
 {
@@ -139,6 +144,10 @@ public:
     virtual void SetCallbackToDrawScreen(GFXDRV_CLIENTCALLBACK callback) { _drawScreenCallback = callback; }
     virtual void SetCallbackOnInit(GFXDRV_CLIENTCALLBACKINITGFX callback) { _initGfxCallback = callback; }
     virtual void SetCallbackForNullSprite(GFXDRV_CLIENTCALLBACKXY callback) { _nullSpriteCallback = callback; }
+    virtual void SetCallbackToRestoreBackground(GFXDRV_CLIENTCALLBACKRESTOREBG callback);
+    virtual bool EnableDirtyRects(bool enabled);
+    virtual void ShowDirtyRects(bool enabled) { _showDirtyRects = enabled; }
+    virtual void InvalidateRect(const Rect &rc);
     virtual void UnInit();
     virtual void ClearRectangle(int x1, int y1, int x2, int y2, RGB *colorToUse);
     virtual Bitmap *ConvertBitmapToSupportedColourDepth(Bitmap *bitmap);
@@ -165,7 +174,7 @@ public:
     virtual bool HasAcceleratedStretchAndFlip() { return false; }
     virtual bool UsesMemoryBackBuffer() { return true; }
     virtual Bitmap *GetMemoryBackBuffer() { return virtualScreen; }
-    virtual void SetMemoryBackBuffer(Bitmap *backBuffer) { virtualScreen = backBuffer; }
+    virtual void SetMemoryBackBuffer(Bitmap *backBuffer) { virtualScreen = backBuffer; _fullRedraw = true; }
     virtual void SetScreenTint(int red, int green, int blue) { 
         _tint_red = red; _tint_green = green; _tint_blue = blue; }
     virtual ~ALSoftwareGraphicsDriver();
@@ -188,6 +197,7 @@ private:
     GFXDRV_CLIENTCALLBACK _drawScreenCallback;
     GFXDRV_CLIENTCALLBACKXY _nullSpriteCallback;
     GFXDRV_CLIENTCALLBACKINITGFX _initGfxCallback;
+    GFXDRV_CLIENTCALLBACKRESTOREBG _restoreBgCallback;
     int _tint_red, _tint_green, _tint_blue;
 
     ALSoftwareBitmap* drawlist[MAX_DRAW_LIST_SIZE];
@@ -195,6 +205,43 @@ private:
     int numToDraw;
     GFX_MODE_LIST *_gfxModeList;
 
+    // Sprite as it was drawn on the frame, used to find what has changed
+    // between the frames when the dirty rectangles are enabled
+    struct DrawnSprite
+    {
+        ALSoftwareBitmap *Bmp;
+        Bitmap *Pixels;
+        unsigned int Stamp;
+        int X, Y;
+        int Transparency;
+        Rect Area; // part of the screen covered, empty if sprite is invisible
+
+        bool operator==(const DrawnSprite &other) const
+        {
+            return Bmp == other.Bmp && Pixels == other.Pixels && Stamp == other.Stamp &&
+                X == other.X && Y == other.Y && Transparency == other.Transparency;
+        }
+    };
+
+    bool _dirtyRectsEnabled;
+    bool _showDirtyRects;
+    // whole screen must be redrawn on the next frame
+    bool _fullRedraw;
+    // whole screen must be presented on the next Render
+    bool _presentFull;
+    int  _presentOffsetX, _presentOffsetY;
+    unsigned int _ddbStamp;
+    std::vector<DrawnSprite> _sprites;
+    std::vector<DrawnSprite> _lastSprites;
+    // parts of the screen where the client has changed the background
+    std::vector<Rect> _invalidRects;
+    // parts of the screen redrawn on the current frame
+    std::vector<Rect> _dirtyRects;
+    // parts of the screen redrawn since the last present
+    std::vector<Rect> _presentRects;
+    // parts of the screen outlined by the debug overlay on the last frame
+    std::vector<Rect> _outlinedRects;
+
 #ifdef _WIN32
     IDirectDrawGammaControl* dxGammaControl;
     // The gamma ramp is a lookup table for each possible R, G and B value
@@ -210,6 +257,19 @@ private:
     // Unset parameters and release resources related to the display mode
     void ReleaseDisplayMode();
 
+    // Draws the sprite over the virtual screen
+    void RenderSprite(ALSoftwareBitmap *bitmap, int x, int y);
+    // Draws all the sprites over the whole virtual screen
+    void RenderDrawList();
+    // Redraws the background and sprites only in the changed parts of the screen
+    void RenderDirtyRects();
+    // Compares the draw list with the previous one and finds the changed areas
+    void FindDirtyRects();
+    // Adds the area to the list of the changed ones, merging with the others
+    void AddDirtyRect(const Rect &rc);
+    // Applies the screen tint to the whole virtual screen
+    void RenderScreenTint();
+
     void highcolor_fade_out(int speed, int targetColourRed, int targetColourGreen, int targetColourBlue);
     void highcolor_fade_in(Bitmap *bmp_orig, int speed, int targetColourRed, int targetColourGreen, int targetColourBlue);
     void __fade_from_range(PALLETE source, PALLETE dest, int speed, int from, int to) ;
@@ -0,0 +1,401 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#include "gfx/blender_span.h"
+#include "gfx/blender.h"
+#include "util/wgt2allg.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AGS_SPAN_SSE2
+#include <emmintrin.h>
+// AVX2 functions are compiled for their own target, and only called if the
+// CPU reports the support at run time
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define AGS_SPAN_AVX2
+#define AGS_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#endif
+
+#define SPAN_MASK_COLOR ((uint32_t)MASK_COLOR_32)
+
+// How the pixels are blended by the rgb kernel
+enum RgbSpanOp
+{
+    kRgbSpan_SrcAlpha,  // by the source alpha, scaled by a multiplier
+    kRgbSpan_Const,     // by a constant factor
+    kRgbSpan_Tint       // constant colour over the destination by a constant factor
+};
+
+//-----------------------------------------------------------------------------
+// Scalar kernels
+//-----------------------------------------------------------------------------
+
+// Combines RGB proportionally to n (0 - 256), exactly as the Allegro's
+// blenders do it, including the result's alpha being zero
+static inline uint32_t blend_rgb_pixel(uint32_t x, uint32_t y, uint32_t n)
+{
+    uint32_t res = ((x & 0xFF00FF) - (y & 0xFF00FF)) * n / 256 + y;
+    uint32_t g = ((x & 0xFF00) - (y & 0xFF00)) * n / 256 + (y & 0xFF00);
+    return (res & 0xFF00FF) | (g & 0xFF00);
+}
+
+// Blender factor made of the pixel's alpha
+static inline uint32_t alpha_factor(uint32_t src, uint32_t mul)
+{
+    uint32_t n = ((src >> 24) * mul) >> 8;
+    return n ? n + 1 : 0;
+}
+
+template <RgbSpanOp Op>
+static void blend_span_rgb_scalar(uint32_t *dst, const uint32_t *src, int count, uint32_t mul, uint32_t n, uint32_t colour)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        const uint32_t d = dst[i];
+        if (Op == kRgbSpan_Tint)
+        {
+            if (d != SPAN_MASK_COLOR)
+                dst[i] = blend_rgb_pixel(colour, d, n);
+            continue;
+        }
+        const uint32_t s = src[i];
+        if (s == SPAN_MASK_COLOR)
+            continue;
+        dst[i] = blend_rgb_pixel(s, d, Op == kRgbSpan_SrcAlpha ? alpha_factor(s, mul) : n);
+    }
+}
+
+// The alpha over alpha blending involves division, so only the fully
+// transparent and opaque pixels are done here, and the rest by the blender
+static inline void blend_argb2argb_pixel(uint32_t *dst, uint32_t s, uint32_t mul, int alpha)
+{
+    if (s == SPAN_MASK_COLOR)
+        return;
+    const uint32_t sa = ((s >> 24) * mul) >> 8;
+    if (sa == 0)
+        return;
+    if (sa == 0xFF)
+        *dst = s;
+    else
+        *dst = (uint32_t)_argb2argb_blender(s, *dst, alpha);
+}
+
+static void blend_span_argb2argb_scalar(uint32_t *dst, const uint32_t *src, int count, uint32_t mul, int alpha)
+{
+    for (int i = 0; i < count; ++i)
+        blend_argb2argb_pixel(&dst[i], src[i], mul, alpha);
+}
+
+static void blend_span_rgb2argb(uint32_t *dst, const uint32_t *src, int count, int alpha)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (src[i] != SPAN_MASK_COLOR)
+            dst[i] = (uint32_t)_rgb2argb_blender(src[i], dst[i], alpha);
+    }
+}
+
+static void blend_span_opaque_alpha(uint32_t *dst, const uint32_t *src, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (src[i] != SPAN_MASK_COLOR)
+            dst[i] = src[i] | 0xFF000000;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// SSE2 kernels
+//-----------------------------------------------------------------------------
+#if defined (AGS_SPAN_SSE2)
+
+// SSE2 has no 32-bit multiplication keeping the low halves of the products
+static inline __m128i mullo_epi32_sse2(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+        _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline __m128i blend_rgb_sse2(__m128i x, __m128i y, __m128i n)
+{
+    const __m128i rb_mask = _mm_set1_epi32(0xFF00FF);
+    const __m128i g_mask = _mm_set1_epi32(0xFF00);
+    __m128i rb = _mm_sub_epi32(_mm_and_si128(x, rb_mask), _mm_and_si128(y, rb_mask));
+    rb = _mm_add_epi32(_mm_srli_epi32(mullo_epi32_sse2(rb, n), 8), y);
+    __m128i yg = _mm_and_si128(y, g_mask);
+    __m128i g = _mm_sub_epi32(_mm_and_si128(x, g_mask), yg);
+    g = _mm_add_epi32(_mm_srli_epi32(mullo_epi32_sse2(g, n), 8), yg);
+    return _mm_or_si128(_mm_and_si128(rb, rb_mask), _mm_and_si128(g, g_mask));
+}
+
+// Alpha scaled by the multiplier (up to 256), fits in 16 bits
+static inline __m128i scaled_alpha_sse2(__m128i src, __m128i mul)
+{
+    return _mm_srli_epi32(_mm_mullo_epi16(_mm_srli_epi32(src, 24), mul), 8);
+}
+
+static inline __m128i alpha_factor_sse2(__m128i src, __m128i mul)
+{
+    __m128i n = scaled_alpha_sse2(src, mul);
+    return _mm_add_epi32(n, _mm_andnot_si128(_mm_cmpeq_epi32(n, _mm_setzero_si128()), _mm_set1_epi32(1)));
+}
+
+template <RgbSpanOp Op>
+static void blend_span_rgb_sse2(uint32_t *dst, const uint32_t *src, int count, uint32_t mul, uint32_t n, uint32_t colour)
+{
+    const __m128i mask_col = _mm_set1_epi32(SPAN_MASK_COLOR);
+    const __m128i vmul = _mm_set1_epi32(mul);
+    const __m128i vn = _mm_set1_epi32(n);
+    const __m128i vcolour = _mm_set1_epi32(colour);
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i s = Op == kRgbSpan_Tint ? vcolour : _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i f = Op == kRgbSpan_SrcAlpha ? alpha_factor_sse2(s, vmul) : vn;
+        __m128i res = blend_rgb_sse2(s, d, f);
+        __m128i keep = _mm_cmpeq_epi32(Op == kRgbSpan_Tint ? d : s, mask_col);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_and_si128(keep, d), _mm_andnot_si128(keep, res)));
+    }
+    blend_span_rgb_scalar<Op>(dst + i, Op == kRgbSpan_Tint ? NULL : src + i, count - i, mul, n, colour);
+}
+
+static void blend_span_argb2argb_sse2(uint32_t *dst, const uint32_t *src, int count, uint32_t mul, int alpha)
+{
+    const __m128i mask_col = _mm_set1_epi32(SPAN_MASK_COLOR);
+    const __m128i vmul = _mm_set1_epi32(mul);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i opaque = _mm_set1_epi32(0xFF);
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i sa = scaled_alpha_sse2(s, vmul);
+        __m128i skip = _mm_or_si128(_mm_cmpeq_epi32(s, mask_col), _mm_cmpeq_epi32(sa, zero));
+        __m128i copy = _mm_andnot_si128(skip, _mm_cmpeq_epi32(sa, opaque));
+        if (_mm_movemask_epi8(_mm_or_si128(skip, copy)) == 0xFFFF)
+        {
+            __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_and_si128(copy, s), _mm_andnot_si128(copy, d)));
+            continue;
+        }
+        for (int j = i; j < i + 4; ++j)
+            blend_argb2argb_pixel(&dst[j], src[j], mul, alpha);
+    }
+    blend_span_argb2argb_scalar(dst + i, src + i, count - i, mul, alpha);
+}
+
+#endif // AGS_SPAN_SSE2
+
+//-----------------------------------------------------------------------------
+// AVX2 kernels
+//-----------------------------------------------------------------------------
+#if defined (AGS_SPAN_AVX2)
+
+AGS_TARGET_AVX2 static inline __m256i blend_rgb_avx2(__m256i x, __m256i y, __m256i n)
+{
+    const __m256i rb_mask = _mm256_set1_epi32(0xFF00FF);
+    const __m256i g_mask = _mm256_set1_epi32(0xFF00);
+    __m256i rb = _mm256_sub_epi32(_mm256_and_si256(x, rb_mask), _mm256_and_si256(y, rb_mask));
+    rb = _mm256_add_epi32(_mm256_srli_epi32(_mm256_mullo_epi32(rb, n), 8), y);
+    __m256i yg = _mm256_and_si256(y, g_mask);
+    __m256i g = _mm256_sub_epi32(_mm256_and_si256(x, g_mask), yg);
+    g = _mm256_add_epi32(_mm256_srli_epi32(_mm256_mullo_epi32(g, n), 8), yg);
+    return _mm256_or_si256(_mm256_and_si256(rb, rb_mask), _mm256_and_si256(g, g_mask));
+}
+
+AGS_TARGET_AVX2 static inline __m256i scaled_alpha_avx2(__m256i src, __m256i mul)
+{
+    return _mm256_srli_epi32(_mm256_mullo_epi16(_mm256_srli_epi32(src, 24), mul), 8);
+}
+
+AGS_TARGET_AVX2 static inline __m256i alpha_factor_avx2(__m256i src, __m256i mul)
+{
+    __m256i n = scaled_alpha_avx2(src, mul);
+    return _mm256_add_epi32(n, _mm256_andnot_si256(_mm256_cmpeq_epi32(n, _mm256_setzero_si256()), _mm256_set1_epi32(1)));
+}
+
+template <RgbSpanOp Op>
+AGS_TARGET_AVX2 static void blend_span_rgb_avx2(uint32_t *dst, const uint32_t *src, int count, uint32_t mul, uint32_t n, uint32_t colour)
+{
+    const __m256i mask_col = _mm256_set1_epi32(SPAN_MASK_COLOR);
+    const __m256i vmul = _mm256_set1_epi32(mul);
+    const __m256i vn = _mm256_set1_epi32(n);
+    const __m256i vcolour = _mm256_set1_epi32(colour);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i s = Op == kRgbSpan_Tint ? vcolour : _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i f = Op == kRgbSpan_SrcAlpha ? alpha_factor_avx2(s, vmul) : vn;
+        __m256i res = blend_rgb_avx2(s, d, f);
+        __m256i keep = _mm256_cmpeq_epi32(Op == kRgbSpan_Tint ? d : s, mask_col);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_blendv_epi8(res, d, keep));
+    }
+    blend_span_rgb_sse2<Op>(dst + i, Op == kRgbSpan_Tint ? NULL : src + i, count - i, mul, n, colour);
+}
+
+AGS_TARGET_AVX2 static void blend_span_argb2argb_avx2(uint32_t *dst, const uint32_t *src, int count, uint32_t mul, int alpha)
+{
+    const __m256i mask_col = _mm256_set1_epi32(SPAN_MASK_COLOR);
+    const __m256i vmul = _mm256_set1_epi32(mul);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i opaque = _mm256_set1_epi32(0xFF);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i sa = scaled_alpha_avx2(s, vmul);
+        __m256i skip = _mm256_or_si256(_mm256_cmpeq_epi32(s, mask_col), _mm256_cmpeq_epi32(sa, zero));
+        __m256i copy = _mm256_andnot_si256(skip, _mm256_cmpeq_epi32(sa, opaque));
+        if (_mm256_movemask_epi8(_mm256_or_si256(skip, copy)) == -1)
+        {
+            __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+            _mm256_storeu_si256((__m256i*)(dst + i), _mm256_blendv_epi8(d, s, copy));
+            continue;
+        }
+        for (int j = i; j < i + 8; ++j)
+            blend_argb2argb_pixel(&dst[j], src[j], mul, alpha);
+    }
+    blend_span_argb2argb_sse2(dst + i, src + i, count - i, mul, alpha);
+}
+
+#endif // AGS_SPAN_AVX2
+
+//-----------------------------------------------------------------------------
+// Dispatch
+//-----------------------------------------------------------------------------
+
+enum SpanBlenderImpl
+{
+    kSpanImpl_Scalar,
+    kSpanImpl_SSE2,
+    kSpanImpl_AVX2
+};
+
+static SpanBlenderImpl detect_span_blender_impl()
+{
+#if defined (AGS_SPAN_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return kSpanImpl_AVX2;
+#endif
+#if defined (AGS_SPAN_SSE2)
+    return kSpanImpl_SSE2;
+#else
+    return kSpanImpl_Scalar;
+#endif
+}
+
+static SpanBlenderImpl get_impl()
+{
+    static SpanBlenderImpl impl = detect_span_blender_impl();
+    return impl;
+}
+
+template <RgbSpanOp Op>
+static void blend_span_rgb(uint32_t *dst, const uint32_t *src, int count, uint32_t mul, uint32_t n, uint32_t colour)
+{
+    switch (get_impl())
+    {
+#if defined (AGS_SPAN_AVX2)
+    case kSpanImpl_AVX2:
+        blend_span_rgb_avx2<Op>(dst, src, count, mul, n, colour);
+        return;
+#endif
+#if defined (AGS_SPAN_SSE2)
+    case kSpanImpl_SSE2:
+        blend_span_rgb_sse2<Op>(dst, src, count, mul, n, colour);
+        return;
+#endif
+    default:
+        blend_span_rgb_scalar<Op>(dst, src, count, mul, n, colour);
+        return;
+    }
+}
+
+static void blend_span_argb2argb(uint32_t *dst, const uint32_t *src, int count, uint32_t mul, int alpha)
+{
+    switch (get_impl())
+    {
+#if defined (AGS_SPAN_AVX2)
+    case kSpanImpl_AVX2:
+        blend_span_argb2argb_avx2(dst, src, count, mul, alpha);
+        return;
+#endif
+#if defined (AGS_SPAN_SSE2)
+    case kSpanImpl_SSE2:
+        blend_span_argb2argb_sse2(dst, src, count, mul, alpha);
+        return;
+#endif
+    default:
+        blend_span_argb2argb_scalar(dst, src, count, mul, alpha);
+        return;
+    }
+}
+
+bool can_use_span_blenders()
+{
+    // the kernels take the alpha from the highest byte, while the order of
+    // colour components does not matter
+    return _rgb_a_shift_32 == 24;
+}
+
+void blend_span32(SpanBlendMode mode, uint32_t *dst, const uint32_t *src, int count, int alpha)
+{
+    // the source alpha multiplier for the blenders which apply alpha
+    // parameter to it, when not zero
+    const uint32_t alpha_mul = alpha > 0 ? (alpha & 0xFF) + 1 : 256;
+    switch (mode)
+    {
+    case kSpanBlend_Alpha:
+        blend_span_rgb<kRgbSpan_SrcAlpha>(dst, src, count, alpha_mul, 0, 0);
+        break;
+    case kSpanBlend_TransAlpha:
+        blend_span_rgb<kRgbSpan_SrcAlpha>(dst, src, count, alpha, 0, 0);
+        break;
+    case kSpanBlend_Trans:
+        blend_span_rgb<kRgbSpan_Const>(dst, src, count, 0, alpha ? alpha + 1 : 0, 0);
+        break;
+    case kSpanBlend_Argb2Argb:
+        blend_span_argb2argb(dst, src, count, alpha_mul, alpha);
+        break;
+    case kSpanBlend_Rgb2Argb:
+        blend_span_rgb2argb(dst, src, count, alpha);
+        break;
+    case kSpanBlend_OpaqueAlpha:
+        blend_span_opaque_alpha(dst, src, count);
+        break;
+    default:
+        break;
+    }
+}
+
+void tint_span32(uint32_t *dst, int count, uint32_t colour, int light)
+{
+    blend_span_rgb<kRgbSpan_Tint>(dst, NULL, count, 0, light ? light + 1 : 0, colour);
+}
+
+const char *get_span_blender_impl()
+{
+    switch (get_impl())
+    {
+    case kSpanImpl_AVX2: return "AVX2";
+    case kSpanImpl_SSE2: return "SSE2";
+    default: return "scalar";
+    }
+}
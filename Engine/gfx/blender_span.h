@@ -0,0 +1,55 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Span blenders, which blend a whole row of 32-bit pixels at once. They give
+// exactly the same result as the Allegro and AGS blenders used by
+// draw_trans_sprite, but do not call the blender function for every pixel,
+// and use SSE2 or AVX2 instructions where the CPU supports them.
+//
+//=============================================================================
+#ifndef __AGS_EE_GFX__BLENDERSPAN_H
+#define __AGS_EE_GFX__BLENDERSPAN_H
+
+#include "core/types.h"
+
+enum SpanBlendMode
+{
+    kSpanBlend_None = -1,
+    // Source alpha over opaque destination: Allegro's alpha blender,
+    // or _argb2rgb_blender
+    kSpanBlend_Alpha,
+    // Source alpha with overall transparency: _trans_alpha_blender32
+    kSpanBlend_TransAlpha,
+    // Constant transparency: Allegro's trans blender
+    kSpanBlend_Trans,
+    // Source alpha over destination alpha: _argb2argb_blender
+    kSpanBlend_Argb2Argb,
+    // Opaque source over destination alpha: _rgb2argb_blender
+    kSpanBlend_Rgb2Argb,
+    // Opaque source copied with the opaque alpha: _opaque_alpha_blender
+    kSpanBlend_OpaqueAlpha
+};
+
+// Tells whether the span blenders support current 32-bit pixel format
+bool can_use_span_blenders();
+// Blends the row of source pixels over the destination, skipping the ones of
+// mask colour; alpha is the blender's parameter, as given to set_blender_mode
+void blend_span32(SpanBlendMode mode, uint32_t *dst, const uint32_t *src, int count, int alpha);
+// Blends the colour over the row of pixels, same as draw_lit_sprite with the
+// trans blender does
+void tint_span32(uint32_t *dst, int count, uint32_t colour, int light);
+// Returns the name of the instruction set used by the span blenders
+const char *get_span_blender_impl();
+
+#endif // __AGS_EE_GFX__BLENDERSPAN_H
@@ -14,6 +14,7 @@
 
 #include "gfx/gfx_util.h"
 #include "gfx/blender.h"
+#include "util/math.h"
 
 // CHECKME: is this hack still relevant?
 #if defined(IOS_VERSION) || defined(ANDROID_VERSION) || defined(WINDOWS_VERSION)
@@ -52,6 +53,33 @@ static const BlendModeSetter BlendModeSets[kNumBlendModes] =
     // NOTE: add new modes here
 };
 
+// Span blenders, matching the blender setters above
+struct BlendModeSpans
+{
+    SpanBlendMode AllAlpha;
+    SpanBlendMode AlphaToOpaque;
+    SpanBlendMode OpaqueToAlpha;
+    SpanBlendMode OpaqueToAlphaNoTrans;
+    SpanBlendMode AllOpaque;
+};
+
+static const BlendModeSpans BlendModeSpanSets[kNumBlendModes] =
+{
+    { kSpanBlend_None, kSpanBlend_None, kSpanBlend_None, kSpanBlend_None, kSpanBlend_None }, // kBlendMode_NoAlpha
+    { kSpanBlend_Argb2Argb, kSpanBlend_Alpha, kSpanBlend_Rgb2Argb, kSpanBlend_OpaqueAlpha, kSpanBlend_None }, // kBlendMode_Alpha
+};
+
+SpanBlendMode GetSpanBlender(BlendMode blend_mode, bool dst_has_alpha, bool src_has_alpha, int blend_alpha)
+{
+    if (blend_mode < 0 || blend_mode >= kNumBlendModes)
+        return kSpanBlend_None;
+    const BlendModeSpans &set = BlendModeSpanSets[blend_mode];
+    if (dst_has_alpha)
+        return src_has_alpha ? set.AllAlpha :
+            (blend_alpha == 0xFF ? set.OpaqueToAlphaNoTrans : set.OpaqueToAlpha);
+    return src_has_alpha ? set.AlphaToOpaque : set.AllOpaque;
+}
+
 bool SetBlender(BlendMode blend_mode, bool dst_has_alpha, bool src_has_alpha, int blend_alpha)
 {
     if (blend_mode < 0 || blend_mode > kNumBlendModes)
@@ -78,17 +106,21 @@ void DrawSpriteBlend(Bitmap *ds, const Point &ds_at, Bitmap *sprite,
     if (blend_alpha <= 0)
         return; // do not draw 100% transparent image
 
-    if (// support only 32-bit blending at the moment
-        ds->GetColorDepth() == 32 && sprite->GetColorDepth() == 32 &&
-        // set blenders if applicable and tell if succeeded
-        SetBlender(blend_mode, dst_has_alpha, src_has_alpha, blend_alpha))
-    {
-        ds->TransBlendBlt(sprite, ds_at.X, ds_at.Y);
-    }
-    else
+    // support only 32-bit blending at the moment
+    if (ds->GetColorDepth() == 32 && sprite->GetColorDepth() == 32)
     {
-        GfxUtil::DrawSpriteWithTransparency(ds, sprite, ds_at.X, ds_at.Y, blend_alpha);
+        // blend whole rows at once if possible
+        if (SpanBlendBlt(ds, sprite, ds_at.X, ds_at.Y,
+                GetSpanBlender(blend_mode, dst_has_alpha, src_has_alpha, blend_alpha), blend_alpha))
+            return;
+        // set blenders if applicable and tell if succeeded
+        if (SetBlender(blend_mode, dst_has_alpha, src_has_alpha, blend_alpha))
+        {
+            ds->TransBlendBlt(sprite, ds_at.X, ds_at.Y);
+            return;
+        }
     }
+    GfxUtil::DrawSpriteWithTransparency(ds, sprite, ds_at.X, ds_at.Y, blend_alpha);
 }
 
 void DrawSpriteWithTransparency(Bitmap *ds, Bitmap *sprite, int x, int y, int alpha)
@@ -146,8 +178,11 @@ void DrawSpriteWithTransparency(Bitmap *ds, Bitmap *sprite, int x, int y, int al
     {
         if (alpha < 0xFF && surface_depth > 8 && sprite_depth > 8) 
         {
-            set_trans_blender(0, 0, 0, alpha);
-            ds->TransBlendBlt(sprite, x, y);
+            if (!SpanBlendBlt(ds, sprite, x, y, kSpanBlend_Trans, alpha))
+            {
+                set_trans_blender(0, 0, 0, alpha);
+                ds->TransBlendBlt(sprite, x, y);
+            }
         }
         else
         {
@@ -156,6 +191,60 @@ void DrawSpriteWithTransparency(Bitmap *ds, Bitmap *sprite, int x, int y, int al
     }
 }
 
+// Tells whether the bitmap's pixels may be blended by the span blenders
+static bool CanSpanBlend(Bitmap *bmp)
+{
+    return bmp->GetColorDepth() == 32 && bmp->IsMemoryBitmap() && can_use_span_blenders();
+}
+
+bool SpanBlendBlt(Bitmap *ds, Bitmap *sprite, int x, int y, SpanBlendMode mode, int alpha)
+{
+    if (mode == kSpanBlend_None || !CanSpanBlend(ds) || !CanSpanBlend(sprite))
+        return false;
+
+    // clip the same way draw_trans_sprite does
+    const Rect clip = ds->GetClip();
+    int src_x = 0;
+    int src_y = 0;
+    int width = sprite->GetWidth();
+    int height = sprite->GetHeight();
+    if (x < clip.Left)
+    {
+        src_x = clip.Left - x;
+        width -= src_x;
+        x = clip.Left;
+    }
+    if (y < clip.Top)
+    {
+        src_y = clip.Top - y;
+        height -= src_y;
+        y = clip.Top;
+    }
+    width = Math::Min(width, clip.Right + 1 - x);
+    height = Math::Min(height, clip.Bottom + 1 - y);
+
+    for (int row = 0; row < height && width > 0; ++row)
+    {
+        blend_span32(mode, (uint32_t*)ds->GetScanLineForWriting(y + row) + x,
+            (const uint32_t*)sprite->GetScanLine(src_y + row) + src_x, width, alpha);
+    }
+    return true;
+}
+
+bool SpanTintBlt(Bitmap *ds, int red, int green, int blue, int light)
+{
+    if (!CanSpanBlend(ds))
+        return false;
+    const Rect clip = ds->GetClip();
+    const uint32_t colour = makecol32(red, green, blue);
+    for (int y = clip.Top; y <= clip.Bottom; ++y)
+    {
+        tint_span32((uint32_t*)ds->GetScanLineForWriting(y) + clip.Left,
+            clip.Right + 1 - clip.Left, colour, light);
+    }
+    return true;
+}
+
 } // namespace GfxUtil
 
 } // namespace Engine
@@ -25,6 +25,7 @@
 #define __AGS_EE_GFX__GFXUTIL_H
 
 #include "gfx/bitmap.h"
+#include "gfx/blender_span.h"
 #include "gfx/gfx_def.h"
 
 namespace AGS
@@ -47,6 +48,15 @@ namespace GfxUtil
     // ignoring image's alpha channel, even if there's one;
     // does proper conversion depending on respected color depths.
     void DrawSpriteWithTransparency(Bitmap *ds, Bitmap *sprite, int x, int y, int alpha = 0xFF);
+
+    // Draws a 32-bit bitmap over another one using span blender, which gives
+    // the same result as TransBlendBlt with the matching Allegro blender set;
+    // returns false if the bitmaps are not supported by the span blenders.
+    bool SpanBlendBlt(Bitmap *ds, Bitmap *sprite, int x, int y, SpanBlendMode mode, int alpha);
+    // Blends the colour over a 32-bit bitmap, same as LitBlendBlt of the
+    // bitmap onto itself with the trans blender set would do;
+    // returns false if the bitmap is not supported by the span blenders.
+    bool SpanTintBlt(Bitmap *ds, int red, int green, int blue, int light);
 } // namespace GfxUtil
 
 } // namespace Engine
@@ -95,6 +95,32 @@ void AllegroGfxFilter::RenderScreen(Bitmap *toRender, int x, int y) {
     lastBlitY = y;
 }
 
+bool AllegroGfxFilter::RenderScreenRect(Bitmap *toRender, int x, int y, const Rect &rc) {
+
+    if (toRender == realScreen)
+        return true;
+
+    // the parts are scaled exactly as the whole screen only if the scaling
+    // factor is a whole number
+    const int width = _scaling.X.ScaleDistance(toRender->GetWidth());
+    const int height = _scaling.Y.ScaleDistance(toRender->GetHeight());
+    if (width % toRender->GetWidth() != 0 || height % toRender->GetHeight() != 0)
+        return false;
+    const int scale_x = width / toRender->GetWidth();
+    const int scale_y = height / toRender->GetHeight();
+    x = _scaling.X.ScalePt(x);
+    y = _scaling.Y.ScalePt(y);
+    if (scale_x == 1 && scale_y == 1)
+        realScreen->Blit(toRender, rc.Left, rc.Top, x + rc.Left, y + rc.Top, rc.GetWidth(), rc.GetHeight());
+    else
+        realScreen->StretchBlt(toRender, rc,
+            RectWH(x + rc.Left * scale_x, y + rc.Top * scale_y, rc.GetWidth() * scale_x, rc.GetHeight() * scale_y));
+    lastBlitFrom = toRender;
+    lastBlitX = x;
+    lastBlitY = y;
+    return true;
+}
+
 void AllegroGfxFilter::RenderScreenFlipped(Bitmap *toRender, int x, int y, GlobalFlipType flipType) {
 
     if (toRender == virtualScreen)
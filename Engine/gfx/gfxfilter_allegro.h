@@ -43,6 +43,9 @@ public:
     virtual Bitmap *ShutdownAndReturnRealScreen();
     virtual void RenderScreen(Bitmap *toRender, int x, int y);
     virtual void RenderScreenFlipped(Bitmap *toRender, int x, int y, GlobalFlipType flipType);
+    // Renders only the given part of the screen; returns false if the filter
+    // cannot do that, and the whole screen has to be rendered instead
+    virtual bool RenderScreenRect(Bitmap *toRender, int x, int y, const Rect &rc);
     virtual void ClearRect(int x1, int y1, int x2, int y2, int color);
     virtual void GetCopyOfScreenIntoBitmap(Bitmap *copyBitmap);
     virtual void GetCopyOfScreenIntoBitmap(Bitmap *copyBitmap, bool copy_with_yoffset);
@@ -39,6 +39,8 @@ public:
     virtual bool Initialize(const int color_depth, String &err_str);
     virtual Bitmap *InitVirtualScreen(Bitmap *screen, const Size src_size, const Rect dst_rect);
     virtual Bitmap *ShutdownAndReturnRealScreen();
+    // hqx scaling is done on the whole screen at once
+    virtual bool RenderScreenRect(Bitmap *toRender, int x, int y, const Rect &rc) { return false; }
 
     static const GfxFilterInfo FilterInfo;
 
@@ -55,6 +55,7 @@ enum VideoSkipType
 typedef void (*GFXDRV_CLIENTCALLBACK)();
 typedef bool (*GFXDRV_CLIENTCALLBACKXY)(int x, int y);
 typedef void (*GFXDRV_CLIENTCALLBACKINITGFX)(void *data);
+typedef void (*GFXDRV_CLIENTCALLBACKRESTOREBG)(Common::Bitmap *ds, const Rect &rc);
 
 class IGraphicsDriver
 {
@@ -85,6 +86,17 @@ public:
   // null sprite is encountered. You can use this to hook into the rendering
   // process.
   virtual void SetCallbackForNullSprite(GFXDRV_CLIENTCALLBACKXY callback) = 0;
+  // The RestoreBackground callback is called by the drivers which redraw only
+  // the changed parts of the screen, to draw the background in one of them
+  // before the sprites are drawn over it.
+  virtual void SetCallbackToRestoreBackground(GFXDRV_CLIENTCALLBACKRESTOREBG callback) = 0;
+  // Makes driver compare the draw list with the one of the previous frame and
+  // redraw only the changed parts of the screen; returns false if not supported
+  virtual bool EnableDirtyRects(bool enabled) = 0;
+  // Makes driver outline the parts of the screen it has redrawn
+  virtual void ShowDirtyRects(bool enabled) = 0;
+  // Tells that the background has changed in the given part of the screen
+  virtual void InvalidateRect(const Rect &rc) = 0;
   virtual void ClearRectangle(int x1, int y1, int x2, int y2, RGB *colorToUse) = 0;
   virtual Common::Bitmap *ConvertBitmapToSupportedColourDepth(Common::Bitmap *bitmap) = 0;
   virtual IDriverDependantBitmap* CreateDDBFromBitmap(Common::Bitmap *bitmap, bool hasAlpha, bool opaque = false) = 0;
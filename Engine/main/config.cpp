@@ -21,6 +21,7 @@
 #include "ac/global_translation.h"
 #include "ac/path_helper.h"
 #include "ac/spritecache.h"
+#include "ac/spritetransformcache.h"
 #include "debug/debug_log.h"
 #include "main/mainheader.h"
 #include "main/config.h"
@@ -332,9 +333,7 @@ void read_config(const ConfigTree &cfg)
             idx = MIDI_AUTODETECT;
         usetup.midicard = idx;
 #endif
-#if !defined (LINUX_VERSION)
         psp_audio_multithreaded = INIreadint(cfg, "sound", "threaded", psp_audio_multithreaded);
-#endif
 
         // Filter can also be set by command line
         // TODO: apply command line arguments to ConfigTree instead to override options read from config file
@@ -382,12 +381,17 @@ void read_config(const ConfigTree &cfg)
         usetup.Screen.DisplayMode.RefreshRate = INIreadint(cfg, "graphics", "refresh");
         usetup.Screen.DisplayMode.VSync = INIreadint(cfg, "graphics", "vsync") > 0;
         usetup.Screen.RenderAtScreenRes = INIreadint(cfg, "graphics", "render_at_screenres") > 0;
+        usetup.dirty_rects = INIreadint(cfg, "graphics", "dirty_rects", 1) != 0;
+        usetup.show_dirty_rects = INIreadint(cfg, "graphics", "show_dirty_rects") > 0;
 
         usetup.enable_antialiasing = INIreadint(cfg, "misc", "antialias") > 0;
         usetup.force_hicolor_mode = INIreadint(cfg, "misc", "notruecolor") > 0;
+        usetup.mmap_assets = INIreadint(cfg, "misc", "mmap_assets") > 0;
+        usetup.draw_threads = INIreadint(cfg, "misc", "draw_threads", -1);
 
         // This option is backwards (usevox is 0 if no_speech_pack)
         usetup.no_speech_pack = INIreadint(cfg, "sound", "usespeech", 1) == 0;
+        usetup.audio_load_latency = INIreadint(cfg, "sound", "load_latency", usetup.audio_load_latency);
 
         usetup.user_data_dir = INIreadstring(cfg, "misc", "user_data_dir");
 
@@ -397,6 +401,7 @@ void read_config(const ConfigTree &cfg)
 #if !defined(PSP_VERSION)
         // the config file specifies cache size in KB, here we convert it to bytes
         spriteset.maxCacheSize = INIreadint (cfg, "misc", "cachemax", DEFAULTCACHESIZE / 1024) * 1024;
+        set_sprite_transform_cache_size(INIreadint (cfg, "misc", "transformcachemax", DEFAULT_SPRITE_TRANSFORM_CACHE_SIZE / 1024) * 1024);
 #endif
 
         String repfile = INIreadstring(cfg, "misc", "replay");
@@ -35,6 +35,7 @@
 #include "ac/record.h"
 #include "ac/roomstatus.h"
 #include "ac/speech.h"
+#include "ac/spriteprefetch.h"
 #include "ac/translation.h"
 #include "ac/viewframe.h"
 #include "ac/dynobj/scriptobject.h"
@@ -53,6 +54,7 @@
 #include "main/main.h"
 #include "main/main_allegro.h"
 #include "media/audio/sound.h"
+#include "media/audio/soundpreload.h"
 #include "ac/spritecache.h"
 #include "util/filestream.h"
 #include "gfx/graphicsdriver.h"
@@ -365,6 +367,7 @@ bool engine_init_game_data()
 
     // initialize the data file
     initialise_game_file_name();
+    Common::AssetManager::SetMemoryMapping(usetup.mmap_assets);
     errcod = Common::AssetManager::SetDataFile(game_file_name);
 
     our_eip = -194;
@@ -945,6 +948,9 @@ int engine_init_sprites()
         return EXIT_NORMAL;
     }
 
+    init_sprite_prefetch("acsprset.spr");
+    init_draw_workers(usetup.draw_threads);
+
     return RETURN_CONTINUE;
 }
 
@@ -1223,13 +1229,16 @@ void engine_setup_scsystem_auxiliary()
 void engine_update_mp3_thread()
 {
   update_mp3_thread();
-  platform->Delay(50);
+  // short enough to apply the game's changes quickly and keep the stream
+  // buffers filled, regardless of how long the game's frames take
+  platform->Delay(10);
 }
 
 void engine_start_multithreaded_audio()
 {
   // PSP: Initialize the sound cache.
   clear_sound_cache();
+  init_sound_preload();
 
   // Create sound update thread. This is a workaround for sound stuttering.
   if (psp_audio_multithreaded)
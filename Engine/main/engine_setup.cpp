@@ -211,6 +211,8 @@ void engine_post_gfxmode_driver_setup()
     gfxDriver->SetCallbackForPolling(update_polled_stuff_if_runtime);
     gfxDriver->SetCallbackToDrawScreen(draw_screen_callback);
     gfxDriver->SetCallbackForNullSprite(GfxDriverNullSpriteCallback);
+    gfxDriver->SetCallbackToRestoreBackground(GfxDriverRestoreBgCallback);
+    gfxDriver->ShowDirtyRects(usetup.show_dirty_rects);
     gfxDriver->SetRenderOffset(play.viewport.Left, play.viewport.Top);
 }
 
@@ -220,6 +222,7 @@ void engine_pre_gfxmode_driver_cleanup()
     gfxDriver->SetCallbackForPolling(NULL);
     gfxDriver->SetCallbackToDrawScreen(NULL);
     gfxDriver->SetCallbackForNullSprite(NULL);
+    gfxDriver->SetCallbackToRestoreBackground(NULL);
     gfxDriver->SetMemoryBackBuffer(NULL);
 }
 
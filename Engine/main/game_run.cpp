@@ -20,6 +20,7 @@
 #include "ac/characterextras.h"
 #include "ac/characterinfo.h"
 #include "ac/draw.h"
+#include "ac/dynobj/managedobjectpool.h"
 #include "ac/event.h"
 #include "ac/game.h"
 #include "ac/gamesetup.h"
@@ -36,9 +37,11 @@
 #include "ac/overlay.h"
 #include "ac/record.h"
 #include "ac/room.h"
+#include "ac/roomindex.h"
 #include "ac/roomobject.h"
 #include "ac/roomstatus.h"
 #include "ac/roomstruct.h"
+#include "ac/spriteprefetch.h"
 #include "debug/debugger.h"
 #include "debug/debug_log.h"
 #include "gui/guiinv.h"
@@ -644,6 +647,9 @@ void UpdateGameOnce(bool checkControls, IDriverDependantBitmap *extraBitmap, int
     ccNotifyScriptStillAlive ();
     our_eip=1;
     timerloop=0;
+    // plugins may move the characters they have pointers to between rooms
+    if (pl_any_character_access())
+        invalidate_room_characters();
 
     game_loop_check_problems_at_start();
 
@@ -682,6 +688,9 @@ void UpdateGameOnce(bool checkControls, IDriverDependantBitmap *extraBitmap, int
 
     update_polled_audio_and_crossfade();
 
+    // put sprites read ahead by the prefetch thread into the cache before drawing
+    update_sprite_prefetch();
+
     game_loop_do_render_and_check_mouse(extraBitmap, extraX, extraY);
 
     our_eip=6;
@@ -693,6 +702,9 @@ void UpdateGameOnce(bool checkControls, IDriverDependantBitmap *extraBitmap, int
     //    if (mgetbutton()>NONE) break;
     update_polled_stuff_if_runtime();
 
+    // do a bit of garbage collection each frame, rather than all of it at once
+    pool.RunGarbageCollectionStep(GARBAGE_COLLECTION_SLOTS_PER_STEP);
+
     game_loop_update_background_animation();
 
     game_loop_update_loop_counter();
@@ -782,7 +794,7 @@ int UpdateWaitMode()
 
         if (restrict_until==0) {
             set_default_cursor();
-            guis_need_update = 1;
+            mark_all_guis_changed();
             play.disabled_user_interface--;
             /*      if (user_disabled_for==FOR_ANIMATION)
             run_animation((FullAnimation*)user_disabled_data2,user_disabled_data3);
@@ -823,7 +835,7 @@ int GameTick()
 
 void SetupLoopParameters(int untilwhat,long udata,int mousestuff) {
     play.disabled_user_interface++;
-    guis_need_update = 1;
+    mark_all_guis_changed();
     // Only change the mouse cursor if it hasn't been specifically changed first
     // (or if it's speech, always change it)
     if (((cur_cursor == cur_mode) || (untilwhat == UNTIL_NOOVERLAY)) &&
@@ -34,6 +34,7 @@
 #include "main/mainheader.h"
 #include "main/main.h"
 #include "platform/base/agsplatformdriver.h"
+#include "script/cc_options.h"
 #include "ac/route_finder.h"
 #include "core/assetmanager.h"
 #include "util/directory.h"
@@ -43,6 +44,10 @@
 #include "test/test_all.h"
 #endif
 
+#if defined (AGS_BENCHMARKS)
+#include "test/bench_all.h"
+#endif
+
 using namespace AGS::Common;
 using namespace AGS::Engine;
 
@@ -85,6 +90,9 @@ int datafile_argv=0, change_to_game_dir = 0, force_window = 0;
 int override_start_room = 0, force_16bit = 0;
 bool justDisplayHelp = false;
 bool justDisplayVersion = false;
+#if defined (AGS_BENCHMARKS)
+bool justRunBenchmarks = false;
+#endif
 bool justRunSetup = false;
 bool justRegisterGame = false;
 bool justUnRegisterGame = false;
@@ -215,6 +223,12 @@ int main_process_cmdline(int argc,char*argv[])
         }
         if (stricmp(argv[ee],"-v") == 0 || stricmp(argv[ee],"--version") == 0)
             justDisplayVersion = true;
+#if defined (AGS_BENCHMARKS)
+        else if (stricmp(argv[ee],"--benchmark") == 0)
+            justRunBenchmarks = true;
+#endif
+        else if (stricmp(argv[ee],"--script-op-stats") == 0)
+            ccSetOption(SCOPT_PROFILEOPS, 1);
         else if (stricmp(argv[ee],"-shelllaunch") == 0)
             change_to_game_dir = 1;
         else if (stricmp(argv[ee],"-updatereg") == 0)
@@ -490,6 +504,14 @@ int main(int argc,char*argv[]) {
         return 0;
     }
 
+#if defined (AGS_BENCHMARKS)
+    if (justRunBenchmarks)
+    {
+        Bench_DoAllBenchmarks();
+        return 0;
+    }
+#endif
+
     init_debug();
     Debug::Printf(kDbgMsg_Init, get_engine_string());
 
@@ -17,10 +17,14 @@
 //
 
 #include "ac/cdaudio.h"
+#include "ac/draw.h"
+#include "ac/dynobj/managedobjectpool.h"
 #include "ac/gamesetup.h"
 #include "ac/gamesetupstruct.h"
 #include "ac/record.h"
 #include "ac/roomstatus.h"
+#include "ac/spriteprefetch.h"
+#include "ac/spritetransformcache.h"
 #include "ac/translation.h"
 #include "debug/agseditordebugger.h"
 #include "debug/debug_log.h"
@@ -36,7 +40,10 @@
 #include "gfx/graphicsdriver.h"
 #include "gfx/bitmap.h"
 #include "core/assetmanager.h"
+#include "media/audio/soundpreload.h"
 #include "plugin/plugin_engine.h"
+#include "script/cc_instance.h"
+#include "script/cc_options.h"
 
 using namespace AGS::Common;
 using namespace AGS::Engine;
@@ -77,6 +84,12 @@ void quit_stop_cd()
 
 void quit_shutdown_scripts()
 {
+    if (ccGetOption(SCOPT_PROFILEOPS))
+        ccInstance::WriteOpPairStats("script_ops.log");
+    const ManagedPoolGCStats &gc_stats = pool.GetGCStats();
+    Debug::Printf(kDbgMsg_Init, "Managed objects GC: %u steps, %u full sweeps, %u objects freed, %u in cycles; pause last %u us, max %u us, total %u ms",
+        gc_stats.Steps, gc_stats.FullSweeps, gc_stats.ObjectsFreed, gc_stats.CycleObjectsFreed,
+        gc_stats.LastPauseUs, gc_stats.MaxPauseUs, (uint32_t)(gc_stats.TotalPauseUs / 1000));
     ccUnregisterAllObjects();
 }
 
@@ -123,6 +136,8 @@ void quit_shutdown_audio()
 
     // Quit the sound thread.
     audioThread.Stop();
+    psp_audio_multithreaded = 0;
+    shutdown_sound_preload();
 
     remove_sound();
 }
@@ -279,6 +294,10 @@ void quit(const char *quitmsg)
 
     quit_shutdown_audio();
     
+    shutdown_sprite_prefetch();
+    shutdown_sprite_transform_cache();
+    shutdown_draw_workers();
+
     our_eip = 9901;
 
     shutdown_font_renderer();
@@ -224,6 +224,7 @@ void update_character_move_and_anim(int &numSheep, int *followingAsSheep)
 
 	chi->UpdateMoveAndAnim(aa, chex, numSheep, followingAsSheep);
   }
+  walk_queued_characters();
 }
 
 void update_following_exactly_characters(int &numSheep, int *followingAsSheep)
@@ -24,7 +24,10 @@
 #include "ac/audioclip.h"
 #include "ac/gamesetup.h"
 #include "ac/path_helper.h"
+#include "media/audio/clip_mypending.h"
 #include "media/audio/sound.h"
+#include "media/audio/soundcache.h"
+#include "media/audio/soundpreload.h"
 #include "debug/debug_log.h"
 #include "debug/debugger.h"
 #include "ac/common.h"
@@ -34,6 +37,8 @@
 #include <math.h>
 #include "util/stream.h"
 #include "core/assetmanager.h"
+#include "platform/base/agsplatformdriver.h"
+#include "util/lockfree_queue.h"
 
 using namespace AGS::Common;
 
@@ -47,9 +52,11 @@ extern roomstruct thisroom;
 extern CharacterInfo*playerchar;
 
 extern volatile int switching_away_from_game;
+extern volatile unsigned long globalTimerCounter;
+extern int time_between_timers;
 
 #if !defined(IOS_VERSION) && !defined(PSP_VERSION) && !defined(ANDROID_VERSION)
-volatile int psp_audio_multithreaded = 0;
+volatile int psp_audio_multithreaded = 1;
 #endif
 
 ScriptAudioChannel scrAudioChannel[MAX_SOUND_CHANNELS + 1];
@@ -58,6 +65,20 @@ int reserved_channel_count = 0;
 
 AGS::Engine::Thread audioThread;
 
+// Max number of clip changes waiting for the audio thread
+#define AUDIO_COMMAND_QUEUE_SIZE 256
+
+struct AudioCommand
+{
+    AudioCommandType Type;
+    SOUNDCLIP       *Clip;
+    int              Value;
+};
+
+// Clip changes posted by the game thread; the audio thread is the only one
+// which takes them out
+static AGS::Engine::LockFreeQueue<AudioCommand, AUDIO_COMMAND_QUEUE_SIZE> audioCommands;
+
 void calculate_reserved_channel_count()
 {
     int reservedChannels = 0;
@@ -222,6 +243,107 @@ SOUNDCLIP *load_sound_clip(ScriptAudioClip *audioClip, bool repeat)
     return soundClip;
 }
 
+// Tells if the clip is read whole before playing, and so could be read in
+// background; gives the type of the clip it is loaded as
+static bool can_preload_audio_clip(ScriptAudioClip *audioClip, bool &is_wave, int &sound_type)
+{
+    if (!is_audiotype_allowed_to_play((AudioFileType)audioClip->fileType))
+        return false;
+    switch (audioClip->fileType)
+    {
+    case eAudioFileOGG:
+        is_wave = false;
+        sound_type = MUS_OGG;
+        return true;
+    case eAudioFileMP3:
+        is_wave = false;
+        sound_type = MUS_MP3;
+        return true;
+    case eAudioFileWAV:
+    case eAudioFileVOC:
+        is_wave = true;
+        sound_type = MUS_WAVE;
+        return true;
+    }
+    return false;
+}
+
+bool preload_audio_clip(ScriptAudioClip *audioClip)
+{
+    bool is_wave;
+    int sound_type;
+    if (!can_preload_audio_clip(audioClip, is_wave, sound_type))
+        return false;
+    return preload_sound(get_audio_clip_assetpath(audioClip->bundlingType, audioClip->fileName), is_wave);
+}
+
+bool is_audio_clip_preloaded(ScriptAudioClip *audioClip)
+{
+    bool is_wave;
+    int sound_type;
+    if (!can_preload_audio_clip(audioClip, is_wave, sound_type))
+        return false;
+    return is_sound_cached(get_audio_clip_assetpath(audioClip->bundlingType, audioClip->fileName));
+}
+
+SOUNDCLIP *load_sound_clip_async(ScriptAudioClip *audioClip, bool repeat)
+{
+    bool is_wave;
+    int sound_type;
+    if (usetup.audio_load_latency <= 0 || !is_sound_preload_running() ||
+        !can_preload_audio_clip(audioClip, is_wave, sound_type))
+        return NULL;
+    // the cached clips are loaded right away
+    AssetPath asset_name = get_audio_clip_assetpath(audioClip->bundlingType, audioClip->fileName);
+    if (is_sound_cached(asset_name) || !preload_sound(asset_name, is_wave))
+        return NULL;
+
+    update_clip_default_volume(audioClip);
+
+    SOUNDCLIP *soundClip = new MYPENDINGCLIP(sound_type, globalTimerCounter);
+    soundClip->repeat = repeat;
+    soundClip->set_volume_percent(audioClip->defaultVolume);
+    soundClip->soundType = audioClip->type;
+    soundClip->sourceClip = audioClip;
+    return soundClip;
+}
+
+// Puts the loaded clips in place of their stand-ins on the channels; the
+// clips which are read for too long are loaded right away
+static void start_pending_clips()
+{
+    update_sound_preload();
+
+    for (int i = 0; i <= MAX_SOUND_CHANNELS; ++i)
+    {
+        if ((channels[i] == NULL) || (channels[i]->done != 0) || !channels[i]->is_pending())
+            continue;
+
+        MYPENDINGCLIP *pending = (MYPENDINGCLIP*)channels[i];
+        ScriptAudioClip *audioClip = (ScriptAudioClip*)pending->sourceClip;
+        AssetPath asset_name = get_audio_clip_assetpath(audioClip->bundlingType, audioClip->fileName);
+        const unsigned long waited_ms = (globalTimerCounter - pending->requestTime) * time_between_timers;
+        if (!is_sound_cached(asset_name) && is_sound_preloading(asset_name) &&
+            (waited_ms < (unsigned long)usetup.audio_load_latency))
+            continue;
+
+        SOUNDCLIP *soundfx = load_sound_clip(audioClip, pending->repeat);
+        // the clips which fail to play take care of themselves
+        if ((soundfx != NULL) && (pending->start(soundfx) == 0))
+            soundfx = NULL;
+
+        AGS::Engine::MutexLock _lock(_audio_mutex);
+        if (soundfx == NULL)
+        {
+            debug_script_log("AudioClip.Play: unable to load sound file");
+            stop_and_destroy_channel_ex(i, false);
+            continue;
+        }
+        channels[i] = soundfx;
+        delete pending;
+    }
+}
+
 void audio_update_polled_stuff()
 {
     play.crossfade_step++;
@@ -404,7 +526,10 @@ ScriptAudioChannel* play_audio_clip(ScriptAudioClip *clip, int priority, int rep
         return NULL;
     }
 
-    return play_audio_clip_on_channel(channel, clip, priority, repeat, fromOffset);
+    // unless the clip is cached, it is read in background and starts
+    // playing when ready; its channel is given out right away
+    return play_audio_clip_on_channel(channel, clip, priority, repeat, fromOffset,
+        load_sound_clip_async(clip, (repeat != 0)));
 }
 
 ScriptAudioChannel* play_audio_clip_by_index(int audioClipIndex)
@@ -788,10 +913,67 @@ void apply_volume_drop_modifier(bool applyModifier)
 extern volatile char want_exit;
 extern int frames_per_second;
 
+bool audio_post_command(AudioCommandType type, SOUNDCLIP *clip, int value)
+{
+    if (!psp_audio_multithreaded || !clip->_playing || audioThread.IsCurrent())
+        return false;
+
+    AudioCommand cmd;
+    cmd.Type = type;
+    cmd.Clip = clip;
+    cmd.Value = value;
+    while (!audioCommands.Push(cmd))
+        AGSPlatformDriver::GetDriver()->YieldCPU();
+    return true;
+}
+
+// Applies the clip changes made by the game since the last update; must be
+// called with the audio lock held, so that no clip is polled meanwhile
+static void process_audio_commands()
+{
+    AudioCommand cmd;
+    while (audioCommands.Peek(cmd))
+    {
+        SOUNDCLIP *clip = cmd.Clip;
+        // the finished clips have released their decoders already
+        if (!clip->done)
+        {
+            switch (cmd.Type)
+            {
+            case kAudioCmd_SetVolume: clip->set_volume(cmd.Value); break;
+            case kAudioCmd_AdjustVolume: clip->adjust_volume(); break;
+            case kAudioCmd_SetPanning: clip->set_panning(cmd.Value); break;
+            case kAudioCmd_SetSpeed: clip->set_speed(cmd.Value); break;
+            case kAudioCmd_Seek: clip->seek(cmd.Value); break;
+            case kAudioCmd_Pause: clip->pause(); break;
+            case kAudioCmd_Resume: clip->resume(); break;
+            case kAudioCmd_Restart: clip->restart(); break;
+            }
+        }
+        audioCommands.Pop();
+    }
+}
+
+void audio_wait_for_commands()
+{
+    if (!psp_audio_multithreaded || audioThread.IsCurrent())
+        return;
+    // while the game thread holds the audio lock the audio thread cannot
+    // take the commands out, so they are applied here instead
+    if (_audio_doing_crossfade)
+    {
+        process_audio_commands();
+        return;
+    }
+    while (!audioCommands.IsEmpty())
+        AGSPlatformDriver::GetDriver()->YieldCPU();
+}
+
 void update_mp3_thread()
 {
 	while (switching_away_from_game) { }
 	AGS::Engine::MutexLock _lock(_audio_mutex);
+	process_audio_commands();
 	for (musicPollIterator = 0; musicPollIterator <= MAX_SOUND_CHANNELS; ++musicPollIterator)
 	{
 		if ((channels[musicPollIterator] != NULL) && (channels[musicPollIterator]->done == 0))
@@ -822,6 +1004,9 @@ void update_polled_audio_and_crossfade ()
 {
 	update_polled_stuff_if_runtime ();
 
+    // the clips are loaded before locking, not to hold up the audio thread
+    start_pending_clips();
+
 	AGS::Engine::MutexLock _lock(_audio_mutex);
 
     _audio_doing_crossfade = true;
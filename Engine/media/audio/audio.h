@@ -32,6 +32,15 @@ void        move_track_to_crossfade_channel(int currentChannel, int crossfadeSpe
 void        stop_or_fade_out_channel(int fadeOutChannel, int fadeInChannel = -1, ScriptAudioClip *newSound = NULL);
 int         find_free_audio_channel(ScriptAudioClip *clip, int priority, bool interruptEqualPriority);
 SOUNDCLIP*  load_sound_clip(ScriptAudioClip *audioClip, bool repeat);
+// Requests the clip's data to be read in background, and returns the
+// stand-in clip which plays it when ready; returns NULL if the clip has to
+// be loaded right away
+SOUNDCLIP*  load_sound_clip_async(ScriptAudioClip *audioClip, bool repeat);
+// Requests the clip's data to be read into the sound cache in background;
+// returns false if the clip is not cached, or could not be found
+bool        preload_audio_clip(ScriptAudioClip *audioClip);
+// Tells if the clip's data is in the sound cache
+bool        is_audio_clip_preloaded(ScriptAudioClip *audioClip);
 void        recache_queued_clips_after_loading_save_game();
 void        audio_update_polled_stuff();
 void        queue_audio_clip_to_play(ScriptAudioClip *clip, int priority, int repeat);
@@ -49,18 +49,23 @@ int MYMOD::poll()
 
 void MYMOD::adjust_volume()
 {
+    if (audio_post_command(kAudioCmd_AdjustVolume, this))
+        return;
     if (duhPlayer)
         al_duh_set_volume(duhPlayer, VOLUME_TO_DUMB_VOL(get_final_volume()));
 }
 
 void MYMOD::set_volume(int newvol)
 {
+    if (audio_post_command(kAudioCmd_SetVolume, this, newvol))
+        return;
     vol = newvol;
     adjust_volume();
 }
 
 void MYMOD::destroy()
 {
+    audio_wait_for_commands();
     if (duhPlayer) {
         al_stop_duh(duhPlayer);
         duhPlayer = NULL;
@@ -73,6 +78,8 @@ void MYMOD::destroy()
 
 void MYMOD::seek(int patnum)
 {
+    if (audio_post_command(kAudioCmd_Seek, this, patnum))
+        return;
     if ((!done) && (duhPlayer)) {
         al_stop_duh(duhPlayer);
         done = 0;
@@ -122,6 +129,8 @@ int MYMOD::get_length_ms()
 
 void MYMOD::restart()
 {
+    if (audio_post_command(kAudioCmd_Restart, this))
+        return;
     if (tune != NULL) {
         al_stop_duh(duhPlayer);
         done = 0;
@@ -136,12 +145,16 @@ int MYMOD::get_voice()
 }
 
 void MYMOD::pause() {
+    if (audio_post_command(kAudioCmd_Pause, this))
+        return;
     if (tune != NULL) {
         al_pause_duh(duhPlayer);
     }
 }
 
 void MYMOD::resume() {
+    if (audio_post_command(kAudioCmd_Resume, this))
+        return;
     if (tune != NULL) {
         al_resume_duh(duhPlayer);
     }
@@ -155,6 +168,7 @@ int MYMOD::play() {
     duhPlayer = al_start_duh(tune, 2, 0, 1.0, 8192, 22050);
     al_duh_set_loop(duhPlayer, repeat);
     set_volume(vol);
+    _playing = true;
 
     return 1;
 }  
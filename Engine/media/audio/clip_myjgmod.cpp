@@ -32,6 +32,8 @@ int MYMOD::poll()
 
 void MYMOD::set_volume(int newvol)
 {
+    if (audio_post_command(kAudioCmd_SetVolume, this, newvol))
+        return;
     vol = newvol;
     if (!done)
         set_mod_volume(newvol);
@@ -39,6 +41,7 @@ void MYMOD::set_volume(int newvol)
 
 void MYMOD::destroy()
 {
+    audio_wait_for_commands();
     stop_mod();
     destroy_mod(tune);
     tune = NULL;
@@ -46,6 +49,8 @@ void MYMOD::destroy()
 
 void MYMOD::seek(int patnum)
 {
+    if (audio_post_command(kAudioCmd_Seek, this, patnum))
+        return;
     if (is_mod_playing() != 0)
         goto_mod_track(patnum);
 }
@@ -69,6 +74,8 @@ int MYMOD::get_length_ms()
 
 void MYMOD::restart()
 {
+    if (audio_post_command(kAudioCmd_Restart, this))
+        return;
     if (tune != NULL) {
         stop_mod();
         done = 0;
@@ -88,6 +95,7 @@ int MYMOD::get_sound_type() {
 
 int MYMOD::play() {
     play_mod(tune, repeat);
+    _playing = true;
 
     return 1;
 }
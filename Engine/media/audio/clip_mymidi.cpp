@@ -33,17 +33,22 @@ int MYMIDI::poll()
 
 void MYMIDI::adjust_volume()
 {
+    if (audio_post_command(kAudioCmd_AdjustVolume, this))
+        return;
     ::set_volume(-1, get_final_volume());
 }
 
 void MYMIDI::set_volume(int newvol)
 {
+    if (audio_post_command(kAudioCmd_SetVolume, this, newvol))
+        return;
     vol = newvol;
     adjust_volume();
 }
 
 void MYMIDI::destroy()
 {
+    audio_wait_for_commands();
     stop_midi();
     destroy_midi(tune);
     tune = NULL;
@@ -51,6 +56,8 @@ void MYMIDI::destroy()
 
 void MYMIDI::seek(int pos)
 {
+    if (audio_post_command(kAudioCmd_Seek, this, pos))
+        return;
     midi_seek(pos);
 }
 
@@ -71,6 +78,8 @@ int MYMIDI::get_length_ms()
 
 void MYMIDI::restart()
 {
+    if (audio_post_command(kAudioCmd_Restart, this))
+        return;
     if (tune != NULL) {
         stop_midi();
         done = 0;
@@ -85,10 +94,14 @@ int MYMIDI::get_voice()
 }
 
 void MYMIDI::pause() {
+    if (audio_post_command(kAudioCmd_Pause, this))
+        return;
     midi_pause();
 }
 
 void MYMIDI::resume() {
+    if (audio_post_command(kAudioCmd_Resume, this))
+        return;
     midi_resume();
 }
 
@@ -103,6 +116,7 @@ int MYMIDI::play() {
         return 0;
     }
     initializing = false;
+    _playing = true;
 
     return 1;
 }
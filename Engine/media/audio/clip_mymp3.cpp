@@ -85,11 +85,15 @@ void MYMP3::adjust_stream()
 
 void MYMP3::adjust_volume()
 {
+    if (audio_post_command(kAudioCmd_AdjustVolume, this))
+        return;
     adjust_stream();
 }
 
 void MYMP3::set_volume(int newvol)
 {
+    if (audio_post_command(kAudioCmd_SetVolume, this, newvol))
+        return;
     // boost MP3 volume
     newvol += 20;
     if (newvol > 255)
@@ -101,6 +105,8 @@ void MYMP3::set_volume(int newvol)
 
 void MYMP3::set_speed(int new_speed)
 {
+    if (audio_post_command(kAudioCmd_SetSpeed, this, new_speed))
+        return;
     speed = new_speed;
     adjust_stream();
 }
@@ -130,6 +136,7 @@ void MYMP3::internal_destroy()
 
 void MYMP3::destroy()
 {
+	audio_wait_for_commands();
 	AGS::Engine::MutexLock _lock(_mutex);
 
     if (psp_audio_multithreaded && _playing && !_audio_doing_crossfade)
@@ -168,6 +175,8 @@ int MYMP3::get_length_ms()
 
 void MYMP3::restart()
 {
+    if (audio_post_command(kAudioCmd_Restart, this))
+        return;
     if (stream != NULL) {
         // need to reset file pointer for this to work
 		AGS::Engine::MutexLock _lockMp3(_mp3_mutex);
@@ -83,11 +83,15 @@ void MYOGG::adjust_stream()
 
 void MYOGG::adjust_volume()
 {
+    if (audio_post_command(kAudioCmd_AdjustVolume, this))
+        return;
     adjust_stream();
 }
 
 void MYOGG::set_volume(int newvol)
 {
+    if (audio_post_command(kAudioCmd_SetVolume, this, newvol))
+        return;
     // boost MP3 volume
     newvol += 20;
     if (newvol > 255)
@@ -98,6 +102,8 @@ void MYOGG::set_volume(int newvol)
 
 void MYOGG::set_speed(int new_speed)
 {
+    if (audio_post_command(kAudioCmd_SetSpeed, this, new_speed))
+        return;
     speed = new_speed;
     adjust_stream();
 }
@@ -120,6 +126,7 @@ void MYOGG::internal_destroy()
 
 void MYOGG::destroy()
 {
+	audio_wait_for_commands();
 	AGS::Engine::MutexLock _lock(_mutex);
 
     if (psp_audio_multithreaded && _playing && !_audio_doing_crossfade)
@@ -0,0 +1,137 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#include "util/wgt2allg.h"
+#include "media/audio/audiodefines.h"
+#include "media/audio/clip_mypending.h"
+#include "media/audio/audiointernaldefs.h"
+
+int MYPENDINGCLIP::poll()
+{
+    // nothing is played until the clip is loaded
+    return done;
+}
+
+void MYPENDINGCLIP::set_volume(int newvol)
+{
+    vol = newvol;
+}
+
+void MYPENDINGCLIP::set_speed(int new_speed)
+{
+    speed = new_speed;
+}
+
+void MYPENDINGCLIP::set_panning(int newPanning)
+{
+    panning = newPanning;
+}
+
+void MYPENDINGCLIP::adjust_volume()
+{
+    // the modifiers are applied when the clip starts
+}
+
+void MYPENDINGCLIP::destroy()
+{
+    // the sound being read is kept in the cache, for the next use
+}
+
+void MYPENDINGCLIP::seek(int pos)
+{
+    position = pos;
+}
+
+int MYPENDINGCLIP::get_pos()
+{
+    return position;
+}
+
+int MYPENDINGCLIP::get_pos_ms()
+{
+    return 0;
+}
+
+int MYPENDINGCLIP::get_length_ms()
+{
+    return 0;
+}
+
+void MYPENDINGCLIP::restart()
+{
+    position = 0;
+}
+
+int MYPENDINGCLIP::get_voice()
+{
+    return -1;
+}
+
+int MYPENDINGCLIP::get_sound_type()
+{
+    return pendingSoundType;
+}
+
+int MYPENDINGCLIP::play_from(int pos)
+{
+    position = pos;
+    return 1;
+}
+
+int MYPENDINGCLIP::play()
+{
+    return play_from(0);
+}
+
+void MYPENDINGCLIP::pause()
+{
+    paused = 1;
+}
+
+void MYPENDINGCLIP::resume()
+{
+    paused = 0;
+}
+
+int MYPENDINGCLIP::start(SOUNDCLIP *loaded)
+{
+    loaded->priority = priority;
+    loaded->xSource = xSource;
+    loaded->ySource = ySource;
+    loaded->maximumPossibleDistanceAway = maximumPossibleDistanceAway;
+    loaded->panningAsPercentage = panningAsPercentage;
+    loaded->set_volume_direct(volAsPercentage, vol);
+    if (muted)
+        loaded->set_mute(true);
+    loaded->apply_volume_modifier(volModifier);
+    loaded->apply_directional_modifier(directionalVolModifier);
+
+    if (loaded->play_from(position) == 0)
+        return 0;
+
+    // these need the clip to be playing
+    if (loaded->panning != panning)
+        loaded->set_panning(panning);
+    if (loaded->get_speed() != speed)
+        loaded->set_speed(speed);
+    if (paused)
+        loaded->pause();
+    return 1;
+}
+
+MYPENDINGCLIP::MYPENDINGCLIP(int sound_type, unsigned long request_time) {
+    requestTime = request_time;
+    position = 0;
+    pendingSoundType = sound_type;
+}
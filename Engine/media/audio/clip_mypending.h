@@ -0,0 +1,77 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#ifndef __AC_MYPENDINGCLIP_H
+#define __AC_MYPENDINGCLIP_H
+
+#include "media/audio/soundclip.h"
+
+// Stand-in for the clip which is being read in background: takes its place
+// on the channel and keeps all the changes made to it, until the loaded
+// clip is started with the same settings
+struct MYPENDINGCLIP:public SOUNDCLIP
+{
+    // game timer count at the time the clip was requested
+    unsigned long requestTime;
+    // the position the clip will start playing from
+    int position;
+
+    int poll();
+
+    void set_volume(int newvol);
+    void set_speed(int new_speed);
+    void set_panning(int newPanning);
+
+    void destroy();
+
+    void seek(int pos);
+
+    int get_pos();
+
+    int get_pos_ms();
+
+    int get_length_ms();
+
+    void restart();
+
+    int get_voice();
+
+    int get_sound_type();
+
+    virtual int play_from(int position);
+
+    int play();
+
+    virtual void pause();
+
+    virtual void resume();
+
+    virtual bool is_pending() const { return true; }
+
+    // Passes the settings onto the loaded clip and starts playing it;
+    // returns 0 if it failed to start, in which case the loaded clip may
+    // have been destroyed already, like with SOUNDCLIP::play_from()
+    int start(SOUNDCLIP *loaded);
+
+    MYPENDINGCLIP(int sound_type, unsigned long request_time);
+
+protected:
+    virtual void adjust_volume();
+
+private:
+    // type of the clip being loaded
+    int pendingSoundType;
+};
+
+#endif // __AC_MYPENDINGCLIP_H
@@ -76,17 +76,23 @@ void MYSTATICMP3::adjust_stream()
 
 void MYSTATICMP3::adjust_volume()
 {
+    if (audio_post_command(kAudioCmd_AdjustVolume, this))
+        return;
     adjust_stream();
 }
 
 void MYSTATICMP3::set_volume(int newvol)
 {
+    if (audio_post_command(kAudioCmd_SetVolume, this, newvol))
+        return;
     vol = newvol;
     adjust_stream();
 }
 
 void MYSTATICMP3::set_speed(int new_speed)
 {
+    if (audio_post_command(kAudioCmd_SetSpeed, this, new_speed))
+        return;
     speed = new_speed;
     adjust_stream();
 }
@@ -111,6 +117,7 @@ void MYSTATICMP3::internal_destroy()
 
 void MYSTATICMP3::destroy()
 {
+	audio_wait_for_commands();
 	AGS::Engine::MutexLock _lock(_mutex);
 
     if (psp_audio_multithreaded && _playing && !_audio_doing_crossfade)
@@ -129,6 +136,8 @@ void MYSTATICMP3::destroy()
 
 void MYSTATICMP3::seek(int pos)
 {
+    if (audio_post_command(kAudioCmd_Seek, this, pos))
+        return;
     AGS::Engine::MutexLock _lockMp3(_mp3_mutex);
     almp3_seek_abs_msecs_mp3(tune, pos);
 }
@@ -153,6 +162,8 @@ int MYSTATICMP3::get_length_ms()
 
 void MYSTATICMP3::restart()
 {
+    if (audio_post_command(kAudioCmd_Restart, this))
+        return;
     if (tune != NULL) {
         AGS::Engine::MutexLock _lockMp3(_mp3_mutex);
         almp3_stop_mp3(tune);
@@ -62,17 +62,23 @@ void MYSTATICOGG::adjust_stream()
 
 void MYSTATICOGG::adjust_volume()
 {
+    if (audio_post_command(kAudioCmd_AdjustVolume, this))
+        return;
     adjust_stream();
 }
 
 void MYSTATICOGG::set_volume(int newvol)
 {
+    if (audio_post_command(kAudioCmd_SetVolume, this, newvol))
+        return;
     vol = newvol;
     adjust_stream();
 }
 
 void MYSTATICOGG::set_speed(int new_speed)
 {
+    if (audio_post_command(kAudioCmd_SetSpeed, this, new_speed))
+        return;
     speed = new_speed;
     adjust_stream();
 }
@@ -96,6 +102,7 @@ void MYSTATICOGG::internal_destroy()
 
 void MYSTATICOGG::destroy()
 {
+	audio_wait_for_commands();
 	AGS::Engine::MutexLock _lock(_mutex);
 
     if (psp_audio_multithreaded && _playing && !_audio_doing_crossfade)
@@ -114,6 +121,8 @@ void MYSTATICOGG::destroy()
 
 void MYSTATICOGG::seek(int pos)
 {
+	if (audio_post_command(kAudioCmd_Seek, this, pos))
+		return;
 	AGS::Engine::MutexLock _lock;
     if (psp_audio_multithreaded)
 		_lock.Acquire(_mutex);
@@ -179,6 +188,8 @@ int MYSTATICOGG::get_length_ms()
 
 void MYSTATICOGG::restart()
 {
+    if (audio_post_command(kAudioCmd_Restart, this))
+        return;
     if (tune != NULL) {
         alogg_stop_ogg(tune);
         alogg_rewind_ogg(tune);
@@ -228,6 +239,8 @@ int MYSTATICOGG::play_from(int position)
     if (!psp_audio_multithreaded)
       poll();
 
+    _playing = true;
+
     return 1;
 }
 
@@ -59,12 +59,16 @@ int MYWAVE::poll()
 
 void MYWAVE::adjust_volume()
 {
+    if (audio_post_command(kAudioCmd_AdjustVolume, this))
+        return;
     if (voice >= 0)
         voice_set_volume(voice, get_final_volume());
 }
 
 void MYWAVE::set_volume(int newvol)
 {
+    if (audio_post_command(kAudioCmd_SetVolume, this, newvol))
+        return;
     vol = newvol;
     adjust_volume();
 }
@@ -82,6 +86,7 @@ void MYWAVE::internal_destroy()
 
 void MYWAVE::destroy()
 {
+    audio_wait_for_commands();
     AGS::Engine::MutexLock _lock(_mutex);
 
     if (psp_audio_multithreaded && _playing && !_audio_doing_crossfade)
@@ -97,6 +102,8 @@ void MYWAVE::destroy()
 
 void MYWAVE::seek(int pos)
 {
+    if (audio_post_command(kAudioCmd_Seek, this, pos))
+        return;
     voice_set_position(voice, pos);
 }
 
@@ -125,6 +132,8 @@ int MYWAVE::get_length_ms()
 
 void MYWAVE::restart()
 {
+    if (audio_post_command(kAudioCmd_Restart, this))
+        return;
     if (wave != NULL) {
         done = 0;
         paused = 0;
@@ -29,6 +29,13 @@ unsigned int sound_cache_counter = 0;
 
 AGS::Engine::Mutex _sound_cache_mutex;
 
+static void free_sound_data(char *data, bool is_wave)
+{
+    if (is_wave)
+        destroy_sample((SAMPLE*)data);
+    else
+        free(data);
+}
 
 void clear_sound_cache()
 {
@@ -84,117 +91,126 @@ void sound_cache_free(char* buffer, bool is_wave)
 
     // Sound is uncached
     if (i == psp_audio_cachesize)
-    {
-        if (is_wave)
-            destroy_sample((SAMPLE*)buffer);
-        else
-            free(buffer);
-    }
+        free_sound_data(buffer, is_wave);
 }
 
 
-char* get_cached_sound(const AssetPath &asset_name, bool is_wave, long* size)
+// Finds the cache slot of the sound, or returns -1; the cache must be locked
+static int find_cached_sound(const char *file_name)
 {
-	AGS::Engine::MutexLock _lock(_sound_cache_mutex);
-
-#ifdef SOUND_CACHE_DEBUG
-    Debug::Printf("get_cached_sound(%s %d)\n", filename, (unsigned int)is_wave);
-#endif
-
-    *size = 0;
-
-    int i;
-    for (i = 0; i < psp_audio_cachesize; i++)
+    for (int i = 0; i < psp_audio_cachesize; i++)
     {
         if (sound_cache_entries[i].data == NULL)
             continue;
-
-        if (strcmp(asset_name.second, sound_cache_entries[i].file_name) == 0)
-        {
-#ifdef SOUND_CACHE_DEBUG
-            Debug::Printf("..found in slot %d\n", i);
-#endif
-            sound_cache_entries[i].reference++;
-            sound_cache_entries[i].last_used = sound_cache_counter++;
-            *size = sound_cache_entries[i].size;
-
-            return sound_cache_entries[i].data;
-        }
-    }
-
-    // Not found
-    PACKFILE *mp3in = NULL;
-    SAMPLE* wave = NULL;
-
-    if (is_wave)
-    {
-        PACKFILE *wavin = PackfileFromAsset(asset_name);
-        if (wavin != NULL)
-        {
-            wave = load_wav_pf(wavin);
-            pack_fclose(wavin);
-        }
-    }  
-    else
-    {
-        mp3in = PackfileFromAsset(asset_name);
-        if (mp3in == NULL)
-        {
-            return NULL;
-        }
+        if (strcmp(file_name, sound_cache_entries[i].file_name) == 0)
+            return i;
     }
+    return -1;
+}
 
-    // Find free slot
+// Finds the slot for a new sound: an empty one, or the least recently used
+// of the sounds which are not played; returns -1 if all of them are played.
+// The cache must be locked
+static int find_free_sound_slot()
+{
+    int i;
     for (i = 0; i < psp_audio_cachesize; i++)
     {
         if (sound_cache_entries[i].data == NULL)
-            break;
+            return i;
     }
 
-    // No free slot?
-    if (i == psp_audio_cachesize)
-    {
-        unsigned int oldest = sound_cache_counter;
-        int index = -1;
+    unsigned int oldest = sound_cache_counter;
+    int index = -1;
 
-        for (i = 0; i < psp_audio_cachesize; i++)
+    for (i = 0; i < psp_audio_cachesize; i++)
+    {
+        if (sound_cache_entries[i].reference == 0)
         {
-            if (sound_cache_entries[i].reference == 0)
+            if (sound_cache_entries[i].last_used < oldest)
             {
-                if (sound_cache_entries[i].last_used < oldest)
-                {
-                    oldest = sound_cache_entries[i].last_used;
-                    index = i;
-                }
+                oldest = sound_cache_entries[i].last_used;
+                index = i;
             }
         }
-
-        i = index;
     }
+    return index;
+}
 
-    // Load new file
-    char* newdata;
+// Puts the sound into the slot, freeing the old sound first; the cache
+// must be locked
+static void put_sound_in_slot(int i, const char *file_name, char *data, long size, bool is_wave, int reference)
+{
+#ifdef SOUND_CACHE_DEBUG
+    Debug::Printf("..loading cached in slot %d\n", i);
+#endif
 
+    if (sound_cache_entries[i].data)
+        free_sound_data(sound_cache_entries[i].data, sound_cache_entries[i].is_wave);
+
+    sound_cache_entries[i].size = size;
+    sound_cache_entries[i].data = data;
+
+    if (sound_cache_entries[i].file_name)
+        free(sound_cache_entries[i].file_name);
+    sound_cache_entries[i].file_name = (char*)malloc(strlen(file_name) + 1);
+    strcpy(sound_cache_entries[i].file_name, file_name);
+    sound_cache_entries[i].reference = reference;
+    sound_cache_entries[i].last_used = sound_cache_counter++;
+    sound_cache_entries[i].is_wave = is_wave;
+}
+
+char *load_sound_data(PACKFILE *in, bool is_wave, long *size)
+{
+    char *newdata;
     if (is_wave)
     {
         *size = 0;
-        newdata = (char*)wave;
+        newdata = (char*)load_wav_pf(in);
     }
     else
     {
-        *size = mp3in->todo;
+        *size = in->todo;
         newdata = (char *)malloc(*size);
+        if (newdata != NULL)
+            pack_fread(newdata, *size, in);
+    }
+    pack_fclose(in);
+    return newdata;
+}
 
-        if (newdata == NULL)
-        {
-            pack_fclose(mp3in);
-            return NULL;
-        }
+char* get_cached_sound(const AssetPath &asset_name, bool is_wave, long* size)
+{
+	AGS::Engine::MutexLock _lock(_sound_cache_mutex);
 
-        pack_fread(newdata, *size, mp3in);
-        pack_fclose(mp3in);
+#ifdef SOUND_CACHE_DEBUG
+    Debug::Printf("get_cached_sound(%s %d)\n", filename, (unsigned int)is_wave);
+#endif
+
+    *size = 0;
+
+    int i = find_cached_sound(asset_name.second);
+    if (i >= 0)
+    {
+#ifdef SOUND_CACHE_DEBUG
+        Debug::Printf("..found in slot %d\n", i);
+#endif
+        sound_cache_entries[i].reference++;
+        sound_cache_entries[i].last_used = sound_cache_counter++;
+        *size = sound_cache_entries[i].size;
+
+        return sound_cache_entries[i].data;
     }
 
+    // Not found, load new file
+    PACKFILE *in = PackfileFromAsset(asset_name);
+    if (in == NULL)
+        return NULL;
+    char *newdata = load_sound_data(in, is_wave, size);
+    if (newdata == NULL)
+        return NULL;
+
+    i = find_free_sound_slot();
     if (i == -1)
     {
         // No cache slot empty, return uncached data
@@ -203,32 +219,31 @@ char* get_cached_sound(const AssetPath &asset_name, bool is_wave, long* size)
 #endif
         return newdata;  
     }
-    else
-    {
-        // Add to cache, free old sound first
-#ifdef SOUND_CACHE_DEBUG
-        Debug::Printf("..loading cached in slot %d\n", i);
-#endif	
 
-        if (sound_cache_entries[i].data) {
-            if (sound_cache_entries[i].is_wave)
-                destroy_sample((SAMPLE*)sound_cache_entries[i].data);
-            else
-                free(sound_cache_entries[i].data);
-	}
-	
-        sound_cache_entries[i].size = *size;
-        sound_cache_entries[i].data = newdata;
-
-        if (sound_cache_entries[i].file_name)
-            free(sound_cache_entries[i].file_name);
-        sound_cache_entries[i].file_name = (char*)malloc(strlen(asset_name.second) + 1);
-        strcpy(sound_cache_entries[i].file_name, asset_name.second);
-        sound_cache_entries[i].reference = 1;
-        sound_cache_entries[i].last_used = sound_cache_counter++;
-        sound_cache_entries[i].is_wave = is_wave;
+    put_sound_in_slot(i, asset_name.second, newdata, *size, is_wave, 1);
+    return newdata;
+}
 
-        return sound_cache_entries[i].data;	
-    }
+bool is_sound_cached(const AssetPath &asset_name)
+{
+    AGS::Engine::MutexLock _lock(_sound_cache_mutex);
+    return find_cached_sound(asset_name.second) >= 0;
+}
+
+bool add_cached_sound(const char *file_name, char *data, long size, bool is_wave)
+{
+    AGS::Engine::MutexLock _lock(_sound_cache_mutex);
 
+    int i = -1;
+    // the sound could be loaded by the game while it was read in background
+    if (find_cached_sound(file_name) < 0)
+        i = find_free_sound_slot();
+    if (i == -1)
+    {
+        free_sound_data(data, is_wave);
+        return false;
+    }
+    // not referenced until played, so may be replaced if not used for long
+    put_sound_in_slot(i, file_name, data, size, is_wave, 0);
+    return true;
 }
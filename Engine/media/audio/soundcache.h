@@ -49,6 +49,14 @@ extern int psp_midi_preload_patches;
 void clear_sound_cache();
 void sound_cache_free(char* buffer, bool is_wave);
 char* get_cached_sound(const AssetPath &asset_name, bool is_wave, long* size);
+// Tells if the sound is in the cache, so that it can be played without reading
+bool is_sound_cached(const AssetPath &asset_name);
+// Reads the whole sound from the stream and closes it; the wave sounds are
+// returned as SAMPLE. Does not use the cache, so may be called from any thread
+char* load_sound_data(PACKFILE *in, bool is_wave, long* size);
+// Puts the sound read ahead of its use into the cache; the data is freed if
+// there is no room for it, or if the sound is already there
+bool add_cached_sound(const char *file_name, char* data, long size, bool is_wave);
 
 
 #endif // __AC_SOUNDCACHE_H
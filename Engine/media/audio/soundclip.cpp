@@ -30,6 +30,8 @@ int SOUNDCLIP::play_from(int position)
 }
 
 void SOUNDCLIP::set_panning(int newPanning) {
+    if (audio_post_command(kAudioCmd_SetPanning, this, newPanning))
+        return;
     int voice = get_voice();
     if (voice >= 0) {
         voice_set_pan(voice, newPanning);
@@ -38,6 +40,8 @@ void SOUNDCLIP::set_panning(int newPanning) {
 }
 
 void SOUNDCLIP::pause() {
+    if (audio_post_command(kAudioCmd_Pause, this))
+        return;
     int voice = get_voice();
     if (voice >= 0) {
         voice_stop(voice);
@@ -45,6 +49,8 @@ void SOUNDCLIP::pause() {
     }
 }
 void SOUNDCLIP::resume() {
+    if (audio_post_command(kAudioCmd_Resume, this))
+        return;
     int voice = get_voice();
     if (voice >= 0)
         voice_start(voice);
@@ -26,6 +26,31 @@
 extern volatile int psp_audio_multithreaded;
 extern volatile bool _audio_doing_crossfade;
 
+struct SOUNDCLIP;
+
+// Changes of the playing clips, made by the game and applied on the audio thread
+enum AudioCommandType
+{
+    kAudioCmd_SetVolume,
+    kAudioCmd_AdjustVolume,
+    kAudioCmd_SetPanning,
+    kAudioCmd_SetSpeed,
+    kAudioCmd_Seek,
+    kAudioCmd_Pause,
+    kAudioCmd_Resume,
+    kAudioCmd_Restart
+};
+
+// Passes the change of a playing clip to the audio thread, which owns its
+// decoder; returns false if the change has to be applied by the caller
+// right away: when there is no audio thread, the clip has not started
+// yet, or the caller is the audio thread itself
+bool audio_post_command(AudioCommandType type, SOUNDCLIP *clip, int value = 0);
+// Waits until the audio thread applies all the posted changes, or applies
+// them itself if the caller holds the audio lock; must be called before
+// the clip is destroyed
+void audio_wait_for_commands();
+
 // TODO: one of the biggest problems with sound clips currently is that it
 // provides several methods of applying volume, which may ignore or override
 // each other, and does not shape a consistent interface.
@@ -81,6 +106,9 @@ struct SOUNDCLIP
     virtual void pause();
     virtual void resume();
 
+    // Tells if this is a stand-in for the clip being loaded in background
+    virtual bool is_pending() const { return false; }
+
     inline int get_speed() const
     {
         return speed;
@@ -149,7 +177,7 @@ struct SOUNDCLIP
     virtual void adjust_volume() = 0;
 
     SOUNDCLIP();
-    ~SOUNDCLIP();
+    virtual ~SOUNDCLIP();
 
 protected:
     // mute mode overrides the volume; if set, any volume assigned is stored
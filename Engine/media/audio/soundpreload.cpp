@@ -0,0 +1,218 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#include <string.h>
+#include <deque>
+#include <vector>
+#include "util/wgt2allg.h"
+#include "ac/runtime_defines.h"
+#include "core/assetmanager.h"
+#include "debug/out.h"
+#include "media/audio/soundcache.h"
+#include "media/audio/soundpreload.h"
+#include "platform/base/agsplatformdriver.h"
+#include "util/mutex.h"
+#include "util/mutex_lock.h"
+#include "util/thread.h"
+
+using namespace AGS::Common;
+using namespace AGS::Engine;
+
+extern AGSPlatformDriver *platform;
+
+// Max number of sounds waiting to be read
+#define SOUND_PRELOAD_MAX_QUEUE     64
+// Time the thread sleeps when there is nothing to read, in milliseconds
+#define SOUND_PRELOAD_IDLE_DELAY    5
+
+// The names are kept in plain arrays, so that the items could be passed
+// between the threads without sharing any string buffers
+struct SoundPreloadItem
+{
+    char  AssetName[MAX_PATH];  // name of the sound in the cache
+    char  FileName[MAX_PATH];   // file which has the sound's data
+    int   Offset;
+    int   Size;
+    bool  IsWave;
+    char *Data;
+    long  DataSize;
+};
+
+// The request queue, the item being read and the list of read sounds are
+// shared with the background thread, and are protected by the mutex. The
+// thread never touches the sound cache itself: the cached sounds may be
+// replaced only when they are not played, which is decided on the game
+// thread.
+static Mutex preloadMutex;
+static std::deque<SoundPreloadItem> preloadQueue;
+static SoundPreloadItem preloadCurrent;
+static bool preloadReading = false;
+static std::vector<SoundPreloadItem> preloadDone;
+static Thread preloadThread;
+static bool preloadRunning = false;
+// Statistics, for the game thread only
+static int preloadNumAdded = 0;
+static int preloadNumDropped = 0;
+
+static void sound_preload_thread()
+{
+    {
+        MutexLock lock(preloadMutex);
+        if (!preloadQueue.empty())
+        {
+            preloadCurrent = preloadQueue.front();
+            preloadQueue.pop_front();
+            preloadReading = true;
+        }
+    }
+
+    if (!preloadReading)
+    {
+        platform->Delay(SOUND_PRELOAD_IDLE_DELAY);
+        return;
+    }
+
+    SoundPreloadItem &item = preloadCurrent;
+    item.Data = NULL;
+    item.DataSize = 0;
+    PACKFILE *in = PackfileFromLocation(item.FileName, item.Offset, item.Size);
+    if (in)
+        item.Data = load_sound_data(in, item.IsWave, &item.DataSize);
+
+    MutexLock lock(preloadMutex);
+    if (item.Data)
+        preloadDone.push_back(item);
+    preloadReading = false;
+}
+
+void init_sound_preload()
+{
+    if (preloadRunning)
+        return;
+    preloadRunning = preloadThread.CreateAndStart(sound_preload_thread, true);
+    if (!preloadRunning)
+    {
+        Debug::Printf(kDbgMsg_Init, "Sound preload disabled: failed to start the thread");
+        return;
+    }
+    Debug::Printf(kDbgMsg_Init, "Sound preload thread started");
+}
+
+void shutdown_sound_preload()
+{
+    if (!preloadRunning)
+        return;
+    preloadThread.Stop();
+    preloadRunning = false;
+
+    preloadQueue.clear();
+    for (size_t i = 0; i < preloadDone.size(); ++i)
+    {
+        if (preloadDone[i].IsWave)
+            destroy_sample((SAMPLE*)preloadDone[i].Data);
+        else
+            free(preloadDone[i].Data);
+    }
+    preloadDone.clear();
+    Debug::Printf(kDbgMsg_Init, "Sound preload: %d sounds added to cache, %d dropped",
+        preloadNumAdded, preloadNumDropped);
+}
+
+bool is_sound_preload_running()
+{
+    return preloadRunning;
+}
+
+// Tells if the sound is in the queue or being read; the mutex must be locked
+static bool is_sound_requested(const char *asset_name)
+{
+    if (preloadReading && strcmp(preloadCurrent.AssetName, asset_name) == 0)
+        return true;
+    for (size_t q = 0; q < preloadQueue.size(); ++q)
+    {
+        if (strcmp(preloadQueue[q].AssetName, asset_name) == 0)
+            return true;
+    }
+    for (size_t d = 0; d < preloadDone.size(); ++d)
+    {
+        if (strcmp(preloadDone[d].AssetName, asset_name) == 0)
+            return true;
+    }
+    return false;
+}
+
+bool preload_sound(const AssetPath &asset_name, bool is_wave)
+{
+    if (!preloadRunning || asset_name.second.GetLength() >= MAX_PATH)
+        return false;
+    if (is_sound_cached(asset_name))
+        return true;
+
+    {
+        MutexLock lock(preloadMutex);
+        if (is_sound_requested(asset_name.second))
+            return true;
+        if (preloadQueue.size() >= SOUND_PRELOAD_MAX_QUEUE)
+            return false;
+    }
+
+    // the asset is found on the game thread, because the asset manager may
+    // switch between the libraries while searching
+    AssetLocation loc;
+    if (!LocateAsset(asset_name, loc) || loc.FileName.GetLength() >= MAX_PATH)
+        return false;
+
+    SoundPreloadItem item;
+    strcpy(item.AssetName, asset_name.second);
+    strcpy(item.FileName, loc.FileName);
+    item.Offset = loc.Offset;
+    item.Size = loc.Size;
+    item.IsWave = is_wave;
+    item.Data = NULL;
+    item.DataSize = 0;
+    MutexLock lock(preloadMutex);
+    preloadQueue.push_back(item);
+    return true;
+}
+
+bool is_sound_preloading(const AssetPath &asset_name)
+{
+    if (!preloadRunning)
+        return false;
+    MutexLock lock(preloadMutex);
+    return is_sound_requested(asset_name.second);
+}
+
+void update_sound_preload()
+{
+    if (!preloadRunning)
+        return;
+    std::vector<SoundPreloadItem> done;
+    {
+        MutexLock lock(preloadMutex);
+        if (preloadDone.empty())
+            return;
+        done.swap(preloadDone);
+    }
+
+    for (size_t i = 0; i < done.size(); ++i)
+    {
+        if (add_cached_sound(done[i].AssetName, done[i].Data, done[i].DataSize, done[i].IsWave))
+            preloadNumAdded++;
+        else
+            // the sound was loaded by the game in the meantime, or all the
+            // cached sounds are being played
+            preloadNumDropped++;
+    }
+}
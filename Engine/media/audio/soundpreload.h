@@ -0,0 +1,40 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Sound preloading: a background thread reads the whole sounds ahead of
+// their use, so that the game does not stall when it starts playing them.
+// The read sounds are put into the sound cache on the game thread, by
+// update_sound_preload().
+//
+//=============================================================================
+#ifndef __AGS_EE_MEDIA__SOUNDPRELOAD_H
+#define __AGS_EE_MEDIA__SOUNDPRELOAD_H
+
+#include "ac/asset_helper.h"
+
+// Starts the background thread; the sound cache must be initialized first
+void init_sound_preload();
+// Stops the thread and drops any unfinished requests
+void shutdown_sound_preload();
+// Tells if the sounds can be read in background
+bool is_sound_preload_running();
+// Requests the sound to be read into the cache; returns false if the sound
+// was not found or cannot be requested now
+bool preload_sound(const AssetPath &asset_name, bool is_wave);
+// Tells if the sound was requested and has not been put into the cache yet
+bool is_sound_preloading(const AssetPath &asset_name);
+// Puts the sounds read by the background thread into the sound cache
+void update_sound_preload();
+
+#endif // __AGS_EE_MEDIA__SOUNDPRELOAD_H
@@ -182,6 +182,10 @@ public:
     virtual void SetCallbackToDrawScreen(GFXDRV_CLIENTCALLBACK callback) { _drawScreenCallback = callback; }
     virtual void SetCallbackOnInit(GFXDRV_CLIENTCALLBACKINITGFX callback) { _initGfxCallback = callback; }
     virtual void SetCallbackForNullSprite(GFXDRV_CLIENTCALLBACKXY callback) { _nullSpriteCallback = callback; }
+    virtual void SetCallbackToRestoreBackground(GFXDRV_CLIENTCALLBACKRESTOREBG callback) { }
+    virtual bool EnableDirtyRects(bool enabled) { return false; }
+    virtual void ShowDirtyRects(bool enabled) { }
+    virtual void InvalidateRect(const Rect &rc) { }
     virtual void UnInit();
     virtual void ClearRectangle(int x1, int y1, int x2, int y2, RGB *colorToUse);
     virtual Bitmap *ConvertBitmapToSupportedColourDepth(Bitmap *bitmap);
@@ -27,6 +27,7 @@
 #include "ac/global_audio.h"
 #include "ac/global_plugin.h"
 #include "ac/global_walkablearea.h"
+#include "ac/gui.h"
 #include "ac/keycode.h"
 #include "ac/mouse.h"
 #include "ac/movelist.h"
@@ -34,8 +35,11 @@
 #include "ac/parser.h"
 #include "ac/path_helper.h"
 #include "ac/record.h"
+#include "ac/roomindex.h"
 #include "ac/roomstatus.h"
+#include "ac/route_finder.h"
 #include "ac/string.h"
+#include "ac/walkablearea.h"
 #include "font/fonts.h"
 #include "util/string_utils.h"
 #include "debug/debug_log.h"
@@ -51,6 +55,7 @@
 #include "script/script.h"
 #include "script/script_runtime.h"
 #include "ac/spritecache.h"
+#include "ac/spritetransformcache.h"
 #include "util/stream.h"
 #include "gfx/bitmap.h"
 #include "gfx/graphicsdriver.h"
@@ -155,6 +160,8 @@ struct EnginePlugin {
 #define MAXPLUGINS 20
 EnginePlugin plugins[MAXPLUGINS];
 int numPlugins = 0;
+// set once any plugin gets a pointer to a character
+bool plugin_character_access = false;
 int pluginsWantingDebugHooks = 0;
 
 std::vector<InbuiltPluginDetails> _registered_builtin_plugins;
@@ -364,6 +371,8 @@ AGSCharacter* IAGSEngine::GetCharacter (int32 charnum) {
     if (charnum >= game.numcharacters)
         quit("!AGSEngine::GetCharacter: invalid character request");
 
+    plugin_character_access = true;
+    invalidate_room_characters();
     return (AGSCharacter*)&game.chars[charnum];
 }
 AGSGameOptions* IAGSEngine::GetGameOptions () {
@@ -419,7 +428,12 @@ BITMAP *IAGSEngine::GetSpriteGraphic (int32 num) {
 }
 BITMAP *IAGSEngine::GetRoomMask (int32 index) {
     if (index == MASK_WALKABLE)
+    {
+        // the plugin may draw on the mask
+        invalidate_room_navigation();
+        invalidate_blocking_areas();
         return (BITMAP*)thisroom.walls->GetAllegroBitmap();
+    }
     else if (index == MASK_WALKBEHIND)
         return (BITMAP*)thisroom.object->GetAllegroBitmap();
     else if (index == MASK_HOTSPOT)
@@ -617,6 +631,8 @@ int IAGSEngine::CallGameScriptFunction(const char *name, int32 globalScript, int
 
 void IAGSEngine::NotifySpriteUpdated(int32 slot) {
     int ff;
+    invalidate_transformed_sprite(slot);
+    mark_guis_using_sprite_changed(slot);
     // wipe the character cache when we change rooms
     for (ff = 0; ff < game.numcharacters; ff++) {
         if ((charcache[ff].inUse) && (charcache[ff].sppic == slot)) {
@@ -786,6 +802,7 @@ void pl_stop_plugins() {
         }
     }
     numPlugins = 0;
+    plugin_character_access = false;
 }
 
 void pl_startup_plugins() {
@@ -808,6 +825,18 @@ int pl_run_plugin_hooks (int event, long data) {
     return 0;
 }
 
+bool pl_any_want_hook (int event) {
+    for (int i = 0; i < numPlugins; i++) {
+        if (plugins[i].wantHook & event)
+            return true;
+    }
+    return false;
+}
+
+bool pl_any_character_access() {
+    return plugin_character_access;
+}
+
 int pl_run_plugin_debug_hooks (const char *scriptfile, int linenum) {
     int i, retval = 0;
     for (i = 0; i < numPlugins; i++) {
@@ -31,6 +31,11 @@ using namespace AGS; // FIXME later
 void pl_stop_plugins();
 void pl_startup_plugins();
 int  pl_run_plugin_hooks (int event, long data);
+// Tells if any plugin has requested any of the given events
+bool pl_any_want_hook (int event);
+// Tells if any plugin has got a direct pointer to a character, through
+// which it may change the character's room
+bool pl_any_character_access();
 void pl_run_plugin_init_gfx_hooks(const char *driverName, void *data);
 int  pl_run_plugin_debug_hooks (const char *scriptfile, int linenum);
 // Tries to register plugins, either by loading dynamic libraries, or getting any kind of replacement
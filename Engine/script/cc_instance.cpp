@@ -14,6 +14,9 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
+#include <functional>
+#include <vector>
 #include "ac/common.h"
 #include "ac/event.h"
 #include "ac/mouse.h"
@@ -60,7 +63,26 @@ enum ScriptOpArgIsReg
     kScOpArg3IsReg      = 0x0004,
     kScOpOneArgIsReg    = kScOpArg1IsReg,
     kScOpTwoArgsAreReg  = kScOpArg1IsReg | kScOpArg2IsReg,
-    kScOpTreeArgsAreReg = kScOpArg1IsReg | kScOpArg2IsReg | kScOpArg3IsReg
+    kScOpTreeArgsAreReg = kScOpArg1IsReg | kScOpArg2IsReg | kScOpArg3IsReg,
+    kScOpSecondArgIsReg = kScOpArg2IsReg,
+    kScOpFirstAndThirdArgsAreReg = kScOpArg1IsReg | kScOpArg3IsReg
+};
+
+// Engine-only superinstructions, which are sequences of common instructions
+// fused together by ccInstance::LinkCodeOperations(). These are never written
+// to the compiled scripts. Fused operation takes arguments of all the original
+// instructions, and its ArgCount covers all their code cells.
+enum ScriptFusedCommand
+{
+    SCMD_X_LITTOREG_PUSHREG = CC_NUM_SCCMDS, // reg1 = arg2; push reg[arg3]
+    SCMD_X_LOADSPOFFS_MEMREAD,  // MAR = SP - arg1; reg2 = m[MAR]
+    SCMD_X_ISEQUAL_JZ,          // reg1 = reg1 == reg2; jump by arg3 if ax == 0
+    SCMD_X_NOTEQUAL_JZ,         // reg1 = reg1 != reg2; jump by arg3 if ax == 0
+    SCMD_X_GREATER_JZ,          // reg1 = reg1 > reg2; jump by arg3 if ax == 0
+    SCMD_X_LESSTHAN_JZ,         // reg1 = reg1 < reg2; jump by arg3 if ax == 0
+    SCMD_X_GTE_JZ,              // reg1 = reg1 >= reg2; jump by arg3 if ax == 0
+    SCMD_X_LTE_JZ,              // reg1 = reg1 <= reg2; jump by arg3 if ax == 0
+    CC_NUM_LINKED_SCCMDS
 };
 
 struct ScriptCommandInfo
@@ -81,7 +103,7 @@ struct ScriptCommandInfo
     bool                ArgIsReg[3];
 };
 
-const ScriptCommandInfo sccmd_info[CC_NUM_SCCMDS] =
+const ScriptCommandInfo sccmd_info[CC_NUM_LINKED_SCCMDS] =
 {
     ScriptCommandInfo( 0                    , "NULL"              , 0, kScOpNoArgIsReg ),
     ScriptCommandInfo( SCMD_ADD             , "add"               , 2, kScOpOneArgIsReg ),
@@ -157,6 +179,14 @@ const ScriptCommandInfo sccmd_info[CC_NUM_SCCMDS] =
     ScriptCommandInfo( SCMD_DYNAMICBOUNDS   , "dynamicbounds"     , 1, kScOpOneArgIsReg ),
     ScriptCommandInfo( SCMD_NEWARRAY        , "newarray"          , 3, kScOpOneArgIsReg ),
     ScriptCommandInfo( SCMD_NEWUSEROBJECT   , "newuserobject"     , 2, kScOpOneArgIsReg ),
+    ScriptCommandInfo( SCMD_X_LITTOREG_PUSHREG  , "x.mov.push"    , 3, kScOpFirstAndThirdArgsAreReg ),
+    ScriptCommandInfo( SCMD_X_LOADSPOFFS_MEMREAD, "x.load.sp.offs.memread", 2, kScOpSecondArgIsReg ),
+    ScriptCommandInfo( SCMD_X_ISEQUAL_JZ    , "x.cmp.jz"          , 3, kScOpTwoArgsAreReg ),
+    ScriptCommandInfo( SCMD_X_NOTEQUAL_JZ   , "x.ncmp.jz"         , 3, kScOpTwoArgsAreReg ),
+    ScriptCommandInfo( SCMD_X_GREATER_JZ    , "x.gt.jz"           , 3, kScOpTwoArgsAreReg ),
+    ScriptCommandInfo( SCMD_X_LESSTHAN_JZ   , "x.lt.jz"           , 3, kScOpTwoArgsAreReg ),
+    ScriptCommandInfo( SCMD_X_GTE_JZ        , "x.gte.jz"          , 3, kScOpTwoArgsAreReg ),
+    ScriptCommandInfo( SCMD_X_LTE_JZ        , "x.lte.jz"          , 3, kScOpTwoArgsAreReg ),
 };
 
 const char *regnames[] = { "null", "sp", "mar", "ax", "bx", "cx", "op", "dx" };
@@ -164,6 +194,10 @@ const char *regnames[] = { "null", "sp", "mar", "ax", "bx", "cx", "op", "dx" };
 const char *fixupnames[] = { "null", "fix_gldata", "fix_func", "fix_string", "fix_import", "fix_datadata", "fix_stack" };
 
 ccInstance *current_instance;
+// Number of times each instruction was executed right after another one,
+// gathered when SCOPT_PROFILEOPS is set; first index is the previous instruction
+// code, or 0 if the instruction was first to run in the current call
+static uint32_t op_pair_counts[CC_NUM_LINKED_SCCMDS][CC_NUM_LINKED_SCCMDS];
 // [IKM] 2012-10-21:
 // NOTE: This is temporary solution (*sigh*, one of many) which allows certain
 // exported functions return value as a RuntimeScriptValue object;
@@ -242,6 +276,9 @@ ccInstance::ccInstance()
     returnValue         = 0;
 
     code_fixups         = NULL;
+    code_ops            = NULL;
+    code_op_index       = NULL;
+    numcodeops          = 0;
 }
 
 ccInstance::~ccInstance()
@@ -481,6 +518,109 @@ int ccInstance::PrepareTextScript(const char**tsname) {
     line_number = callStackLineNumber[callStackSize];\
     currentline = line_number
 
+inline const ScriptOperation *ccInstance::FetchOperation(ccInstance *code_inst, ScriptOperation &fixed_op)
+{
+    const int32_t op_index = (pc >= 0 && pc < code_inst->codesize) ? code_inst->code_op_index[pc] : -1;
+    if (op_index < 0)
+    {
+        cc_error("invalid instruction found in code stream at %d", pc);
+        return NULL;
+    }
+
+    const ScriptOperation *linked_op = &code_inst->code_ops[op_index];
+    if (!linked_op->NeedsRuntimeFixup)
+    {
+        return linked_op;
+    }
+
+    fixed_op = *linked_op;
+    for (int i = 0; i < fixed_op.ArgCount; ++i)
+    {
+        switch (fixed_op.ArgFixup[i])
+        {
+        case 0:
+            break;
+        case FIXUP_IMPORT:
+            {
+                const ScriptImport *import = simp.getByIndex(fixed_op.Args[i].IValue);
+                if (!import)
+                {
+                    cc_error("cannot resolve import, key = %d", fixed_op.Args[i].IValue);
+                    return NULL;
+                }
+                fixed_op.Args[i] = import->Value;
+            }
+            break;
+        case FIXUP_STACK:
+            fixed_op.Args[i] = GetStackPtrOffsetFw(fixed_op.Args[i].IValue);
+            break;
+        default:
+            cc_error("internal fixup type error: %d", fixed_op.ArgFixup[i]);
+            return NULL;
+        }
+    }
+    return &fixed_op;
+}
+
+// Fetches next operation and prepares quick access to its arguments
+#define SCRIPT_FETCH_OP \
+    codeOp = FetchOperation(codeInst, fixedOp); \
+    if (!codeOp) \
+        return -1; \
+    reg1_ptr = &registers[arg1.IValue >= 0 && arg1.IValue < CC_NUM_REGISTERS ? arg1.IValue : 0]; \
+    reg2_ptr = &registers[arg2.IValue >= 0 && arg2.IValue < CC_NUM_REGISTERS ? arg2.IValue : 0]; \
+    if (debug_ops) \
+    { \
+        if (write_debug_dump) \
+            DumpInstruction(*codeOp); \
+        if (profile_ops) \
+        { \
+            op_pair_counts[prev_op_code][codeOp->Instruction.Code]++; \
+            prev_op_code = codeOp->Instruction.Code; \
+        } \
+    }
+
+// Threaded dispatch relies on "labels as values" extension supported by GCC
+// and Clang; define AGS_SCRIPT_SWITCH_DISPATCH to build with plain switch instead
+#if defined (__GNUC__) && !defined (AGS_SCRIPT_SWITCH_DISPATCH)
+#define AGS_SCRIPT_THREADED_DISPATCH
+#endif
+
+// Instruction handlers are written once and are either placed under switch
+// cases, or, with threaded dispatch, each handler jumps directly to the next
+// one's label, which lets CPU predict every such jump separately.
+// SCMD_NEXT proceeds to the operation following current one, SCMD_JUMP
+// runs the operation at pc, which was already set by the handler.
+#if defined (AGS_SCRIPT_THREADED_DISPATCH)
+#define SCMD_CASE(cmd)  op_##cmd
+#define SCMD_DEFAULT    op_default
+#define SCMD_DISPATCH \
+    do { \
+        SCRIPT_FETCH_OP; \
+        goto *dispatch_table[codeOp->Instruction.Code]; \
+    } while (0)
+#define SCMD_NEXT \
+    do { \
+        if (flags & INSTF_ABORTED) \
+            return 0; \
+        pc += codeOp->ArgCount + 1; \
+        SCMD_DISPATCH; \
+    } while (0)
+#define SCMD_JUMP       SCMD_DISPATCH
+#else
+#define SCMD_CASE(cmd)  case cmd
+#define SCMD_DEFAULT    default
+#define SCMD_NEXT       break
+#define SCMD_JUMP       continue
+#endif
+
+// Quick access to the arguments of current operation and registers they refer to
+#define arg1 (codeOp->Args[0])
+#define arg2 (codeOp->Args[1])
+#define arg3 (codeOp->Args[2])
+#define reg1 (*reg1_ptr)
+#define reg2 (*reg2_ptr)
+
 #define MAXNEST 50  // number of recursive function calls allowed
 int ccInstance::Run(int32_t curpc)
 {
@@ -504,127 +644,67 @@ int ccInstance::Run(int32_t curpc)
     current_instance = this;
     ccInstance *codeInst = runningInst;
     int write_debug_dump = ccGetOption(SCOPT_DEBUGRUN);
-	ScriptOperation codeOp;
+    int profile_ops = ccGetOption(SCOPT_PROFILEOPS);
+    bool debug_ops = write_debug_dump || profile_ops;
+    int32_t prev_op_code = 0;
+    // operation being executed, and its local copy which is used
+    // only if some of the arguments must be resolved at runtime
+    const ScriptOperation *codeOp;
+    ScriptOperation fixedOp;
+    // registers referenced by the first two arguments
+    RuntimeScriptValue *reg1_ptr;
+    RuntimeScriptValue *reg2_ptr;
+
+    const char *direct_ptr1;
+    const char *direct_ptr2;
 
     FunctionCallStack func_callstack;
 
+#if defined (AGS_SCRIPT_THREADED_DISPATCH)
+    // Handler addresses, in the order of instruction codes
+    static const void *const dispatch_table[CC_NUM_LINKED_SCCMDS] =
+    {
+        &&op_default,           &&op_SCMD_ADD,          &&op_SCMD_SUB,          &&op_SCMD_REGTOREG,
+        &&op_SCMD_WRITELIT,     &&op_SCMD_RET,          &&op_SCMD_LITTOREG,     &&op_SCMD_MEMREAD,
+        &&op_SCMD_MEMWRITE,     &&op_SCMD_MULREG,       &&op_SCMD_DIVREG,       &&op_SCMD_ADDREG,
+        &&op_SCMD_SUBREG,       &&op_SCMD_BITAND,       &&op_SCMD_BITOR,        &&op_SCMD_ISEQUAL,
+        &&op_SCMD_NOTEQUAL,     &&op_SCMD_GREATER,      &&op_SCMD_LESSTHAN,     &&op_SCMD_GTE,
+        &&op_SCMD_LTE,          &&op_SCMD_AND,          &&op_SCMD_OR,           &&op_SCMD_CALL,
+        &&op_SCMD_MEMREADB,     &&op_SCMD_MEMREADW,     &&op_SCMD_MEMWRITEB,    &&op_SCMD_MEMWRITEW,
+        &&op_SCMD_JZ,           &&op_SCMD_PUSHREG,      &&op_SCMD_POPREG,       &&op_SCMD_JMP,
+        &&op_SCMD_MUL,          &&op_SCMD_CALLEXT,      &&op_SCMD_PUSHREAL,     &&op_SCMD_SUBREALSTACK,
+        &&op_SCMD_LINENUM,      &&op_SCMD_CALLAS,       &&op_SCMD_THISBASE,     &&op_SCMD_NUMFUNCARGS,
+        &&op_SCMD_MODREG,       &&op_SCMD_XORREG,       &&op_SCMD_NOTREG,       &&op_SCMD_SHIFTLEFT,
+        &&op_SCMD_SHIFTRIGHT,   &&op_SCMD_CALLOBJ,      &&op_SCMD_CHECKBOUNDS,  &&op_SCMD_MEMWRITEPTR,
+        &&op_SCMD_MEMREADPTR,   &&op_SCMD_MEMZEROPTR,   &&op_SCMD_MEMINITPTR,   &&op_SCMD_LOADSPOFFS,
+        &&op_SCMD_CHECKNULL,    &&op_SCMD_FADD,         &&op_SCMD_FSUB,         &&op_SCMD_FMULREG,
+        &&op_SCMD_FDIVREG,      &&op_SCMD_FADDREG,      &&op_SCMD_FSUBREG,      &&op_SCMD_FGREATER,
+        &&op_SCMD_FLESSTHAN,    &&op_SCMD_FGTE,         &&op_SCMD_FLTE,         &&op_SCMD_ZEROMEMORY,
+        &&op_SCMD_CREATESTRING, &&op_SCMD_STRINGSEQUAL, &&op_SCMD_STRINGSNOTEQ, &&op_SCMD_CHECKNULLREG,
+        &&op_SCMD_LOOPCHECKOFF, &&op_SCMD_MEMZEROPTRND, &&op_SCMD_JNZ,          &&op_SCMD_DYNAMICBOUNDS,
+        &&op_SCMD_NEWARRAY,     &&op_SCMD_NEWUSEROBJECT,
+        // superinstructions
+        &&op_SCMD_X_LITTOREG_PUSHREG,   &&op_SCMD_X_LOADSPOFFS_MEMREAD,
+        &&op_SCMD_X_ISEQUAL_JZ, &&op_SCMD_X_NOTEQUAL_JZ, &&op_SCMD_X_GREATER_JZ,
+        &&op_SCMD_X_LESSTHAN_JZ,&&op_SCMD_X_GTE_JZ,     &&op_SCMD_X_LTE_JZ
+    };
+
+    SCMD_DISPATCH;
+    {
+#else
     while (1) {
 
-        /*
-		if (!codeInst->ReadOperation(codeOp, pc))
-        {
-            return -1;
-        }
-        */
-        /* ReadOperation */
-        //=====================================================================
-        codeOp.Instruction.Code			= codeInst->code[pc];
-        codeOp.Instruction.InstanceId	= (codeOp.Instruction.Code >> INSTANCE_ID_SHIFT) & INSTANCE_ID_MASK;
-        codeOp.Instruction.Code		   &= INSTANCE_ID_REMOVEMASK; // now this is pure instruction code
+        SCRIPT_FETCH_OP;
 
-        if (codeOp.Instruction.Code < 0 || codeOp.Instruction.Code >= CC_NUM_SCCMDS)
-        {
-            cc_error("invalid instruction %d found in code stream", codeOp.Instruction.Code);
-            return -1;
-        }
-
-        codeOp.ArgCount = sccmd_info[codeOp.Instruction.Code].ArgCount;
-        if (pc + codeOp.ArgCount >= codeInst->codesize)
-        {
-            cc_error("unexpected end of code data (%d; %d)", pc + codeOp.ArgCount, codeInst->codesize);
-            return -1;
-        }
-
-        int pc_at = pc + 1;
-        for (int i = 0; i < codeOp.ArgCount; ++i, ++pc_at)
-        {
-            char fixup = codeInst->code_fixups[pc_at];
-            if (fixup > 0)
-            {
-                // could be relative pointer or import address
-                /*
-                if (!FixupArgument(code[pc], fixup, codeOp.Args[i]))
-                {
-                    return -1;
-                }
-                */
-                /* FixupArgument */
-                //=====================================================================
-                switch (fixup)
-                {
-                case FIXUP_GLOBALDATA:
-                    {
-                        ScriptVariable *gl_var = (ScriptVariable*)codeInst->code[pc_at];
-                        codeOp.Args[i].SetGlobalVar(&gl_var->RValue);
-                    }
-                    break;
-                case FIXUP_FUNCTION:
-                    // originally commented -- CHECKME: could this be used in very old versions of AGS?
-                    //      code[fixup] += (long)&code[0];
-                    // This is a program counter value, presumably will be used as SCMD_CALL argument
-                    codeOp.Args[i].SetInt32((int32_t)codeInst->code[pc_at]);
-                    break;
-                case FIXUP_STRING:
-                    codeOp.Args[i].SetStringLiteral(&codeInst->strings[0] + codeInst->code[pc_at]);
-                    break;
-                case FIXUP_IMPORT:
-                    {
-                        const ScriptImport *import = simp.getByIndex((int32_t)codeInst->code[pc_at]);
-                        if (import)
-                        {
-                            codeOp.Args[i] = import->Value;
-                        }
-                        else
-                        {
-                            cc_error("cannot resolve import, key = %ld", codeInst->code[pc_at]);
-                            return -1;
-                        }
-                    }
-                    break;
-                case FIXUP_STACK:
-                    codeOp.Args[i] = GetStackPtrOffsetFw((int32_t)codeInst->code[pc_at]);
-                    break;
-                default:
-                    cc_error("internal fixup type error: %d", fixup);
-                    return -1;
-                }
-                /* End FixupArgument */
-                //=====================================================================
-            }
-            else
-            {
-                // should be a numeric literal (int32 or float)
-                codeOp.Args[i].SetInt32( (int32_t)codeInst->code[pc_at] );
-            }
-        }
-        /* End ReadOperation */
-        //=====================================================================
-
-        // save the arguments for quick access
-        RuntimeScriptValue &arg1 = codeOp.Args[0];
-        RuntimeScriptValue &arg2 = codeOp.Args[1];
-        RuntimeScriptValue &arg3 = codeOp.Args[2];
-        RuntimeScriptValue &reg1 = 
-            registers[arg1.IValue >= 0 && arg1.IValue < CC_NUM_REGISTERS ? arg1.IValue : 0];
-        RuntimeScriptValue &reg2 = 
-            registers[arg2.IValue >= 0 && arg2.IValue < CC_NUM_REGISTERS ? arg2.IValue : 0];
-
-        const char *direct_ptr1;
-        const char *direct_ptr2;
-
-        if (write_debug_dump)
-        {
-            DumpInstruction(codeOp);
-        }
-
-        switch (codeOp.Instruction.Code) {
-      case SCMD_LINENUM:
+        switch (codeOp->Instruction.Code) {
+#endif
+      SCMD_CASE(SCMD_LINENUM):
           line_number = arg1.IValue;
           currentline = arg1.IValue;
           if (new_line_hook)
               new_line_hook(this, currentline);
-          break;
-      case SCMD_ADD:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_ADD):
           // If the the register is SREG_SP, we are allocating new variable on the stack
           if (arg1.IValue == SREG_SP)
           {
@@ -649,8 +729,8 @@ int ccInstance::Run(int32_t curpc)
           {
             reg1.IValue += arg2.IValue;
           }
-          break;
-      case SCMD_SUB:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_SUB):
           if (reg1.Type == kScValStackPtr)
           {
             // If this is SREG_SP, this is stack pop, which frees local variables;
@@ -676,11 +756,11 @@ int ccInstance::Run(int32_t curpc)
           {
             reg1.IValue -= arg2.IValue;
           }
-          break;
-      case SCMD_REGTOREG:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_REGTOREG):
           reg2 = reg1;
-          break;
-      case SCMD_WRITELIT:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_WRITELIT):
           // Take the data address from reg[MAR] and copy there arg1 bytes from arg2 address
           //
           // NOTE: since it reads directly from arg2 (which originally was
@@ -703,8 +783,8 @@ int ccInstance::Run(int32_t curpc)
               cc_error("unexpected data size for WRITELIT op: %d", arg1.IValue);
               break;
           }
-          break;
-      case SCMD_RET:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_RET):
           {
           if (loopIterationCheckDisabled > 0)
               loopIterationCheckDisabled--;
@@ -720,90 +800,90 @@ int ccInstance::Run(int32_t curpc)
           }
           current_instance = this;
           POP_CALL_STACK;
-          continue; // continue so that the PC doesn't get overwritten
+          SCMD_JUMP; // continue so that the PC doesn't get overwritten
           }
-      case SCMD_LITTOREG:
+      SCMD_CASE(SCMD_LITTOREG):
           reg1 = arg2;
-          break;
-      case SCMD_MEMREAD:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_MEMREAD):
           // Take the data address from reg[MAR] and copy int32_t to reg[arg1]
           reg1 = registers[SREG_MAR].ReadValue();
-          break;
-      case SCMD_MEMWRITE:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_MEMWRITE):
           // Take the data address from reg[MAR] and copy there int32_t from reg[arg1]
           registers[SREG_MAR].WriteValue(reg1);
-          break;
-      case SCMD_LOADSPOFFS:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_LOADSPOFFS):
           registers[SREG_MAR] = GetStackPtrOffsetRw(arg1.IValue);
           if (ccError)
           {
               return -1;
           }
-          break;
+          SCMD_NEXT;
 
           // 64 bit: Force 32 bit math
-      case SCMD_MULREG:
+      SCMD_CASE(SCMD_MULREG):
           reg1.SetInt32(reg1.IValue * reg2.IValue);
-          break;
-      case SCMD_DIVREG:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_DIVREG):
           if (reg2.IValue == 0) {
               cc_error("!Integer divide by zero");
               return -1;
           } 
           reg1.SetInt32(reg1.IValue / reg2.IValue);
-          break;
-      case SCMD_ADDREG:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_ADDREG):
           // This may be pointer arithmetics, in which case IValue stores offset from base pointer
           reg1.IValue += reg2.IValue;
-          break;
-      case SCMD_SUBREG:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_SUBREG):
           // This may be pointer arithmetics, in which case IValue stores offset from base pointer
           reg1.IValue -= reg2.IValue;
-          break;
-      case SCMD_BITAND:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_BITAND):
           reg1.SetInt32(reg1.IValue & reg2.IValue);
-          break;
-      case SCMD_BITOR:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_BITOR):
           reg1.SetInt32(reg1.IValue | reg2.IValue);
-          break;
-      case SCMD_ISEQUAL:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_ISEQUAL):
           reg1.SetInt32AsBool(reg1 == reg2);
-          break;
-      case SCMD_NOTEQUAL:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_NOTEQUAL):
           reg1.SetInt32AsBool(reg1 != reg2);
-          break;
-      case SCMD_GREATER:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_GREATER):
           reg1.SetInt32AsBool(reg1.IValue > reg2.IValue);
-          break;
-      case SCMD_LESSTHAN:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_LESSTHAN):
           reg1.SetInt32AsBool(reg1.IValue < reg2.IValue);
-          break;
-      case SCMD_GTE:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_GTE):
           reg1.SetInt32AsBool(reg1.IValue >= reg2.IValue);
-          break;
-      case SCMD_LTE:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_LTE):
           reg1.SetInt32AsBool(reg1.IValue <= reg2.IValue);
-          break;
-      case SCMD_AND:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_AND):
           reg1.SetInt32AsBool(reg1.IValue && reg2.IValue);
-          break;
-      case SCMD_OR:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_OR):
           reg1.SetInt32AsBool(reg1.IValue || reg2.IValue);
-          break;
-      case SCMD_XORREG:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_XORREG):
           reg1.SetInt32(reg1.IValue ^ reg2.IValue);
-          break;
-      case SCMD_MODREG:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_MODREG):
           if (reg2.IValue == 0) {
               cc_error("!Integer divide by zero");
               return -1;
           } 
           reg1.SetInt32(reg1.IValue % reg2.IValue);
-          break;
-      case SCMD_NOTREG:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_NOTREG):
           reg1 = !(reg1);
-          break;
-      case SCMD_CALL:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_CALL):
           // CallScriptFunction another function within same script, just save PC
           // and continue from there
           if (curnest >= MAXNEST - 1) {
@@ -814,7 +894,7 @@ int ccInstance::Run(int32_t curpc)
           PUSH_CALL_STACK;
 
           ASSERT_STACK_SPACE_AVAILABLE(1);
-          PushValueToStack(RuntimeScriptValue().SetInt32(pc + codeOp.ArgCount + 1));
+          PushValueToStack(RuntimeScriptValue().SetInt32(pc + codeOp->ArgCount + 1));
           if (ccError)
           {
               return -1;
@@ -835,32 +915,32 @@ int ccInstance::Run(int32_t curpc)
           curnest++;
           thisbase[curnest] = 0;
           funcstart[curnest] = pc;
-          continue; // continue so that the PC doesn't get overwritten
-      case SCMD_MEMREADB:
+          SCMD_JUMP; // continue so that the PC doesn't get overwritten
+      SCMD_CASE(SCMD_MEMREADB):
           // Take the data address from reg[MAR] and copy byte to reg[arg1]
           reg1.SetUInt8(registers[SREG_MAR].ReadByte());
-          break;
-      case SCMD_MEMREADW:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_MEMREADW):
           // Take the data address from reg[MAR] and copy int16_t to reg[arg1]
           reg1.SetInt16(registers[SREG_MAR].ReadInt16());
-          break;
-      case SCMD_MEMWRITEB:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_MEMWRITEB):
           // Take the data address from reg[MAR] and copy there byte from reg[arg1]
           registers[SREG_MAR].WriteByte(reg1.IValue);
-          break;
-      case SCMD_MEMWRITEW:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_MEMWRITEW):
           // Take the data address from reg[MAR] and copy there int16_t from reg[arg1]
           registers[SREG_MAR].WriteInt16(reg1.IValue);
-          break;
-      case SCMD_JZ:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_JZ):
           if (registers[SREG_AX].IsNull())
               pc += arg1.IValue;
-          break;
-      case SCMD_JNZ:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_JNZ):
           if (!registers[SREG_AX].IsNull())
               pc += arg1.IValue;
-          break;
-      case SCMD_PUSHREG:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_PUSHREG):
           // Script code analysis shows that statistically there's a moderate
           // chance (10-30% depending on game) that a PUSHREG instruction will be
           // immediately followed by POPREG.
@@ -871,7 +951,7 @@ int ccInstance::Run(int32_t curpc)
           {
               registers[codeInst->code[pc + 3]] = reg1;
               pc += 2;
-              break;
+              SCMD_NEXT;
           }
           // Push reg[arg1] value to the stack
           ASSERT_STACK_SPACE_AVAILABLE(1);
@@ -880,12 +960,12 @@ int ccInstance::Run(int32_t curpc)
           {
               return -1;
           }
-          break;
-      case SCMD_POPREG:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_POPREG):
           ASSERT_STACK_SIZE(1);
           reg1 = PopValueFromStack();
-          break;
-      case SCMD_JMP:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_JMP):
           pc += arg1.IValue;
 
           if ((arg1.IValue < 0) && (maxWhileLoops > 0) && (loopIterationCheckDisabled == 0)) {
@@ -900,18 +980,18 @@ int ccInstance::Run(int32_t curpc)
                   return -1;
               }
           }
-          break;
-      case SCMD_MUL:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_MUL):
           reg1.IValue *= arg2.IValue;
-          break;
-      case SCMD_CHECKBOUNDS:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_CHECKBOUNDS):
           if ((reg1.IValue < 0) ||
               (reg1.IValue >= arg2.IValue)) {
                   cc_error("!Array index out of bounds (index: %d, bounds: 0..%d)", reg1.IValue, arg2.IValue - 1);
                   return -1;
           }
-          break;
-      case SCMD_DYNAMICBOUNDS:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_DYNAMICBOUNDS):
           {
               // TODO: test reg[MAR] type here;
               // That might be dynamic object, but also a non-managed dynamic array, "allocated"
@@ -924,12 +1004,12 @@ int ccInstance::Run(int32_t curpc)
                       cc_error("!Array index out of bounds (index: %d, bounds: 0..%d)", reg1.IValue / elementSize, upperBound - 1);
                       return -1;
               }
-              break;
+              SCMD_NEXT;
           }
 
           // 64 bit: Handles are always 32 bit values. They are not C pointer.
 
-      case SCMD_MEMREADPTR: {
+      SCMD_CASE(SCMD_MEMREADPTR): {
           ccError = 0;
 
           int32_t handle = registers[SREG_MAR].ReadInt32();
@@ -948,8 +1028,8 @@ int ccInstance::Run(int32_t curpc)
           // if error occurred, cc_error will have been set
           if (ccError)
               return -1;
-          break; }
-      case SCMD_MEMWRITEPTR: {
+          SCMD_NEXT; }
+      SCMD_CASE(SCMD_MEMWRITEPTR): {
 
           int32_t handle = registers[SREG_MAR].ReadInt32();
           char *address = NULL;
@@ -983,9 +1063,9 @@ int ccInstance::Run(int32_t curpc)
               ccAddObjectReference(newHandle);
               registers[SREG_MAR].WriteInt32(newHandle);
           }
-          break;
+          SCMD_NEXT;
                              }
-      case SCMD_MEMINITPTR: { 
+      SCMD_CASE(SCMD_MEMINITPTR): { 
           char *address = NULL;
 
           if (reg1.Type == kScValStaticArray && reg1.StcArr->GetDynamicManager())
@@ -1014,15 +1094,15 @@ int ccInstance::Run(int32_t curpc)
 
           ccAddObjectReference(newHandle);
           registers[SREG_MAR].WriteInt32(newHandle);
-          break;
+          SCMD_NEXT;
                             }
-      case SCMD_MEMZEROPTR: {
+      SCMD_CASE(SCMD_MEMZEROPTR): {
           int32_t handle = registers[SREG_MAR].ReadInt32();
           ccReleaseObjectReference(handle);
           registers[SREG_MAR].WriteInt32(0);
-          break;
+          SCMD_NEXT;
                             }
-      case SCMD_MEMZEROPTRND: {
+      SCMD_CASE(SCMD_MEMZEROPTRND): {
           int32_t handle = registers[SREG_MAR].ReadInt32();
 
           // don't do the Dispose check for the object being returned -- this is
@@ -1034,24 +1114,24 @@ int ccInstance::Run(int32_t curpc)
           ccReleaseObjectReference(handle);
           pool.disableDisposeForObject = NULL;
           registers[SREG_MAR].WriteInt32(0);
-          break;
+          SCMD_NEXT;
                               }
-      case SCMD_CHECKNULL:
+      SCMD_CASE(SCMD_CHECKNULL):
           if (registers[SREG_MAR].IsNull()) {
               cc_error("!Null pointer referenced");
               return -1;
           }
-          break;
-      case SCMD_CHECKNULLREG:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_CHECKNULLREG):
           if (reg1.IsNull()) {
               cc_error("!Null string referenced");
               return -1;
           }
-          break;
-      case SCMD_NUMFUNCARGS:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_NUMFUNCARGS):
           num_args_to_func = arg1.IValue;
-          break;
-      case SCMD_CALLAS:{
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_CALLAS):{
           PUSH_CALL_STACK;
 
           // CallScriptFunction to a function in another script
@@ -1082,7 +1162,7 @@ int ccInstance::Run(int32_t curpc)
           ccInstance *wasRunning = runningInst;
 
           // extract the instance ID
-          int32_t instId = codeOp.Instruction.InstanceId;
+          int32_t instId = codeOp->Instruction.InstanceId;
           // determine the offset into the code of the instance we want
           runningInst = loadedInstances[instId];
           intptr_t callAddr = reg1.Ptr - (char*)&runningInst->code[0];
@@ -1111,9 +1191,9 @@ int ccInstance::Run(int32_t curpc)
           was_just_callas = func_callstack.Count;
           num_args_to_func = -1;
           POP_CALL_STACK;
-          break;
+          SCMD_NEXT;
                        }
-      case SCMD_CALLEXT: {
+      SCMD_CASE(SCMD_CALLEXT): {
           // CallScriptFunction to a real 'C' code function
           was_just_callas = -1;
           if (num_args_to_func < 0)
@@ -1190,12 +1270,12 @@ int ccInstance::Run(int32_t curpc)
           current_instance = this;
           next_call_needs_object = 0;
           num_args_to_func = -1;
-          break;
+          SCMD_NEXT;
                          }
-      case SCMD_PUSHREAL:
+      SCMD_CASE(SCMD_PUSHREAL):
           PushToFuncCallStack(func_callstack, reg1);
-          break;
-      case SCMD_SUBREALSTACK:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_SUBREALSTACK):
           PopFromFuncCallStack(func_callstack, arg1.IValue);
           if (was_just_callas >= 0)
           {
@@ -1203,8 +1283,8 @@ int ccInstance::Run(int32_t curpc)
               PopValuesFromStack(arg1.IValue);
               was_just_callas = -1;
           }
-          break;
-      case SCMD_CALLOBJ:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_CALLOBJ):
           // set the OP register
           if (reg1.IsNull()) {
               cc_error("!Null pointer referenced");
@@ -1238,17 +1318,17 @@ int ccInstance::Run(int32_t curpc)
               return -1;
           }
           next_call_needs_object = 1;
-          break;
-      case SCMD_SHIFTLEFT:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_SHIFTLEFT):
           reg1.SetInt32(reg1.IValue << reg2.IValue);
-          break;
-      case SCMD_SHIFTRIGHT:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_SHIFTRIGHT):
           reg1.SetInt32(reg1.IValue >> reg2.IValue);
-          break;
-      case SCMD_THISBASE:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_THISBASE):
           thisbase[curnest] = arg1.IValue;
-          break;
-      case SCMD_NEWARRAY:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_NEWARRAY):
           {
               int numElements = reg1.IValue;
               if ((numElements < 1) || (numElements > 1000000))
@@ -1258,9 +1338,9 @@ int ccInstance::Run(int32_t curpc)
               }
               int32_t handle = globalDynamicArray.Create(numElements, arg2.IValue, arg3.GetAsBool());
               reg1.SetDynamicObject((void*)ccGetObjectAddressFromHandle(handle), &globalDynamicArray);
-              break;
+              SCMD_NEXT;
           }
-      case SCMD_NEWUSEROBJECT:
+      SCMD_CASE(SCMD_NEWUSEROBJECT):
           {
               const int32_t size = arg2.IValue;
               if (size < 0)
@@ -1270,43 +1350,43 @@ int ccInstance::Run(int32_t curpc)
               }
               ScriptUserObject *suo = ScriptUserObject::CreateManaged(size);
               reg1.SetDynamicObject(suo, suo);
-              break;
+              SCMD_NEXT;
           }
-      case SCMD_FADD:
+      SCMD_CASE(SCMD_FADD):
           reg1.SetFloat(reg1.FValue + arg2.IValue); // arg2 was used as int here originally
-          break;
-      case SCMD_FSUB:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_FSUB):
           reg1.SetFloat(reg1.FValue - arg2.IValue); // arg2 was used as int here originally
-          break;
-      case SCMD_FMULREG:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_FMULREG):
           reg1.SetFloat(reg1.FValue * reg2.FValue);
-          break;
-      case SCMD_FDIVREG:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_FDIVREG):
           if (reg2.FValue == 0.0) {
               cc_error("!Floating point divide by zero");
               return -1;
           } 
           reg1.SetFloat(reg1.FValue / reg2.FValue);
-          break;
-      case SCMD_FADDREG:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_FADDREG):
           reg1.SetFloat(reg1.FValue + reg2.FValue);
-          break;
-      case SCMD_FSUBREG:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_FSUBREG):
           reg1.SetFloat(reg1.FValue - reg2.FValue);
-          break;
-      case SCMD_FGREATER:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_FGREATER):
           reg1.SetFloatAsBool(reg1.FValue > reg2.FValue);
-          break;
-      case SCMD_FLESSTHAN:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_FLESSTHAN):
           reg1.SetFloatAsBool(reg1.FValue < reg2.FValue);
-          break;
-      case SCMD_FGTE:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_FGTE):
           reg1.SetFloatAsBool(reg1.FValue >= reg2.FValue);
-          break;
-      case SCMD_FLTE:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_FLTE):
           reg1.SetFloatAsBool(reg1.FValue <= reg2.FValue);
-          break;
-      case SCMD_ZEROMEMORY:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_ZEROMEMORY):
           // Check if we are zeroing at stack tail
           if (registers[SREG_MAR] == registers[SREG_SP]) {
               // creating a local variable -- check the stack to ensure no mem overrun
@@ -1330,8 +1410,8 @@ int ccInstance::Run(int32_t curpc)
 				registers[SREG_MAR].Type);
             return -1;
           }
-          break;
-      case SCMD_CREATESTRING:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_CREATESTRING):
           if (stringClassImpl == NULL) {
               cc_error("No string class implementation set, but opcode was used");
               return -1;
@@ -1340,8 +1420,8 @@ int ccInstance::Run(int32_t curpc)
           reg1.SetDynamicObject(
               (void*)stringClassImpl->CreateString(direct_ptr1),
               &myScriptStringImpl);
-          break;
-      case SCMD_STRINGSEQUAL:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_STRINGSEQUAL):
           if ((reg1.IsNull()) || (reg2.IsNull())) {
               cc_error("!Null pointer referenced");
               return -1;
@@ -1350,8 +1430,8 @@ int ccInstance::Run(int32_t curpc)
           direct_ptr2 = (const char*)reg2.GetDirectPtr();
           reg1.SetInt32AsBool(strcmp(direct_ptr1, direct_ptr2) == 0);
           
-          break;
-      case SCMD_STRINGSNOTEQ:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_STRINGSNOTEQ):
           if ((reg1.IsNull()) || (reg2.IsNull())) {
               cc_error("!Null pointer referenced");
               return -1;
@@ -1359,23 +1439,80 @@ int ccInstance::Run(int32_t curpc)
           direct_ptr1 = (const char*)reg1.GetDirectPtr();
           direct_ptr2 = (const char*)reg2.GetDirectPtr();
           reg1.SetInt32AsBool(strcmp(direct_ptr1, direct_ptr2) != 0 );
-          break;
-      case SCMD_LOOPCHECKOFF:
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_LOOPCHECKOFF):
           if (loopIterationCheckDisabled == 0)
               loopIterationCheckDisabled++;
-          break;
-      default:
-          cc_error("instruction %d is not implemented", codeOp.Instruction.Code);
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_X_LITTOREG_PUSHREG):
+          reg1 = arg2;
+          ASSERT_STACK_SPACE_AVAILABLE(1);
+          PushValueToStack(registers[arg3.IValue]);
+          if (ccError)
+          {
+              return -1;
+          }
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_X_LOADSPOFFS_MEMREAD):
+          registers[SREG_MAR] = GetStackPtrOffsetRw(arg1.IValue);
+          if (ccError)
+          {
+              return -1;
+          }
+          reg2 = registers[SREG_MAR].ReadValue();
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_X_ISEQUAL_JZ):
+          reg1.SetInt32AsBool(reg1 == reg2);
+          if (registers[SREG_AX].IsNull())
+              pc += arg3.IValue;
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_X_NOTEQUAL_JZ):
+          reg1.SetInt32AsBool(reg1 != reg2);
+          if (registers[SREG_AX].IsNull())
+              pc += arg3.IValue;
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_X_GREATER_JZ):
+          reg1.SetInt32AsBool(reg1.IValue > reg2.IValue);
+          if (registers[SREG_AX].IsNull())
+              pc += arg3.IValue;
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_X_LESSTHAN_JZ):
+          reg1.SetInt32AsBool(reg1.IValue < reg2.IValue);
+          if (registers[SREG_AX].IsNull())
+              pc += arg3.IValue;
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_X_GTE_JZ):
+          reg1.SetInt32AsBool(reg1.IValue >= reg2.IValue);
+          if (registers[SREG_AX].IsNull())
+              pc += arg3.IValue;
+          SCMD_NEXT;
+      SCMD_CASE(SCMD_X_LTE_JZ):
+          reg1.SetInt32AsBool(reg1.IValue <= reg2.IValue);
+          if (registers[SREG_AX].IsNull())
+              pc += arg3.IValue;
+          SCMD_NEXT;
+      SCMD_DEFAULT:
+          cc_error("instruction %d is not implemented", codeOp->Instruction.Code);
           return -1;
+#if defined (AGS_SCRIPT_THREADED_DISPATCH)
+    }
+#else
         }
 
         if (flags & INSTF_ABORTED)
             return 0;
 
-        pc += codeOp.ArgCount + 1;
+        pc += codeOp->ArgCount + 1;
     }
+#endif
 }
 
+#undef arg1
+#undef arg2
+#undef arg3
+#undef reg1
+#undef reg2
+
 int ccInstance::RunScriptFunctionIfExists(const char*tsname, int numParam, const RuntimeScriptValue *params) {
     int oldRestoreCount = gameHasBeenRestored;
     // First, save the current ccError state
@@ -1478,7 +1615,7 @@ int ccInstance::RunTextScript2IParam(const char*tsname, const RuntimeScriptValue
 
     // response to a button click, better update guis
     if (strnicmp(tsname, "interface_click", 15) == 0)
-        guis_need_update = 1;
+        mark_all_guis_changed();
 
     int toret = RunScriptFunctionIfExists(tsname, 2, params);
 
@@ -1659,6 +1796,9 @@ bool ccInstance::_Create(PScript scri, ccInstance * joined)
     {
         resolved_imports = joined->resolved_imports;
         code_fixups = joined->code_fixups;
+        code_ops = joined->code_ops;
+        code_op_index = joined->code_op_index;
+        numcodeops = joined->numcodeops;
     }
     else
     {
@@ -1760,9 +1900,14 @@ void ccInstance::Free()
     {
         delete [] resolved_imports;
         delete [] code_fixups;
+        delete [] code_ops;
+        delete [] code_op_index;
     }
     resolved_imports = NULL;
     code_fixups = NULL;
+    code_ops = NULL;
+    code_op_index = NULL;
+    numcodeops = 0;
 }
 
 bool ccInstance::ResolveScriptImports(PScript scri)
@@ -1951,9 +2096,209 @@ bool ccInstance::CreateRuntimeCodeFixups(PScript scri)
             return false;
         }
     }
+    return LinkCodeOperations();
+}
+
+bool ccInstance::LinkCodeOperations()
+{
+    // First pass: count the operations and find out where the valid code ends.
+    // If an invalid instruction is met, the rest of the code cannot be decoded;
+    // this is not an error unless the script actually tries to run it.
+    int32_t linked_size = 0;
+    numcodeops = 0;
+    while (linked_size < codesize)
+    {
+        int32_t cmd = (int32_t)(code[linked_size] & INSTANCE_ID_REMOVEMASK);
+        if (cmd < 0 || cmd >= CC_NUM_SCCMDS)
+        {
+            Debug::Printf(kDbgMsg_Warn, "WARNING: invalid instruction %d found in code stream at %d", cmd, linked_size);
+            break;
+        }
+        int32_t arg_count = sccmd_info[cmd].ArgCount;
+        if (linked_size + arg_count >= codesize)
+        {
+            Debug::Printf(kDbgMsg_Warn, "WARNING: unexpected end of code data (%d; %d)", linked_size + arg_count, codesize);
+            break;
+        }
+        numcodeops++;
+        linked_size += arg_count + 1;
+    }
+
+    code_ops = new ScriptOperation[numcodeops];
+    code_op_index = new int32_t[codesize];
+    for (int32_t i = 0; i < codesize; ++i)
+    {
+        code_op_index[i] = -1;
+    }
+
+    // Second pass: decode operations and resolve everything that
+    // won't change during instance's lifetime
+    int32_t pc_at = 0;
+    for (int32_t op_index = 0; op_index < numcodeops; ++op_index)
+    {
+        ScriptOperation &op = code_ops[op_index];
+        code_op_index[pc_at] = op_index;
+        op.Instruction.Code       = (int32_t)code[pc_at];
+        op.Instruction.InstanceId = (op.Instruction.Code >> INSTANCE_ID_SHIFT) & INSTANCE_ID_MASK;
+        op.Instruction.Code      &= INSTANCE_ID_REMOVEMASK;
+        op.ArgCount = sccmd_info[op.Instruction.Code].ArgCount;
+
+        pc_at++;
+        for (int i = 0; i < op.ArgCount; ++i, ++pc_at)
+        {
+            switch (code_fixups[pc_at])
+            {
+            case 0:
+                // should be a numeric literal (int32 or float)
+                op.Args[i].SetInt32((int32_t)code[pc_at]);
+                break;
+            case FIXUP_GLOBALDATA:
+                {
+                    ScriptVariable *gl_var = (ScriptVariable*)code[pc_at];
+                    op.Args[i].SetGlobalVar(&gl_var->RValue);
+                }
+                break;
+            case FIXUP_FUNCTION:
+                // This is a program counter value, presumably will be used as SCMD_CALL argument
+                op.Args[i].SetInt32((int32_t)code[pc_at]);
+                break;
+            case FIXUP_STRING:
+                op.Args[i].SetStringLiteral(&strings[0] + code[pc_at]);
+                break;
+            case FIXUP_IMPORT:
+                {
+                    // System imports are registered before any script is linked,
+                    // but the functions and variables exported by other scripts
+                    // may be replaced if that script gets reloaded
+                    const ScriptImport *import = simp.getByIndex((int32_t)code[pc_at]);
+                    if (!import)
+                    {
+                        cc_error("cannot resolve import, key = %ld", code[pc_at]);
+                        return false;
+                    }
+                    if (import->InstancePtr == NULL)
+                    {
+                        op.Args[i] = import->Value;
+                        break;
+                    }
+                }
+                // fallthrough
+            case FIXUP_STACK:
+                // stack address depends on the current state of the stack
+                op.Args[i].SetInt32((int32_t)code[pc_at]);
+                op.ArgFixup[i] = code_fixups[pc_at];
+                op.NeedsRuntimeFixup = true;
+                break;
+            default:
+                cc_error("internal fixup type error: %d", code_fixups[pc_at]);
+                return false;
+            }
+        }
+    }
+
+    // Instruction pairs are not fused when profiling, for the statistics
+    // to show what the real compiled code consists of
+    if (!ccGetOption(SCOPT_PROFILEOPS))
+    {
+        FuseCodeOperations();
+    }
     return true;
 }
 
+void ccInstance::FuseCodeOperations()
+{
+    // Each fused operation replaces the first instruction in sequence; the
+    // following ones are kept as they are, in case there's a jump to them.
+    for (int32_t op_index = 0; op_index < numcodeops - 1; ++op_index)
+    {
+        ScriptOperation &op = code_ops[op_index];
+        const ScriptOperation &next_op = code_ops[op_index + 1];
+        if (op.NeedsRuntimeFixup || next_op.NeedsRuntimeFixup)
+        {
+            continue;
+        }
+
+        int32_t fused_code = 0;
+        switch (op.Instruction.Code)
+        {
+        case SCMD_LITTOREG:
+            if (next_op.Instruction.Code == SCMD_PUSHREG &&
+                next_op.Args[0].IValue >= 0 && next_op.Args[0].IValue < CC_NUM_REGISTERS)
+            {
+                fused_code = SCMD_X_LITTOREG_PUSHREG;
+                op.Args[2] = next_op.Args[0];
+            }
+            break;
+        case SCMD_LOADSPOFFS:
+            if (next_op.Instruction.Code == SCMD_MEMREAD)
+            {
+                fused_code = SCMD_X_LOADSPOFFS_MEMREAD;
+                op.Args[1] = next_op.Args[0];
+            }
+            break;
+        case SCMD_ISEQUAL:
+        case SCMD_NOTEQUAL:
+        case SCMD_GREATER:
+        case SCMD_LESSTHAN:
+        case SCMD_GTE:
+        case SCMD_LTE:
+            if (next_op.Instruction.Code == SCMD_JZ)
+            {
+                switch (op.Instruction.Code)
+                {
+                case SCMD_ISEQUAL:  fused_code = SCMD_X_ISEQUAL_JZ; break;
+                case SCMD_NOTEQUAL: fused_code = SCMD_X_NOTEQUAL_JZ; break;
+                case SCMD_GREATER:  fused_code = SCMD_X_GREATER_JZ; break;
+                case SCMD_LESSTHAN: fused_code = SCMD_X_LESSTHAN_JZ; break;
+                case SCMD_GTE:      fused_code = SCMD_X_GTE_JZ; break;
+                case SCMD_LTE:      fused_code = SCMD_X_LTE_JZ; break;
+                }
+                op.Args[2] = next_op.Args[0];
+            }
+            break;
+        }
+
+        if (fused_code != 0)
+        {
+            op.Instruction.Code = fused_code;
+            op.ArgCount += next_op.ArgCount + 1;
+        }
+    }
+}
+
+void ccInstance::WriteOpPairStats(const char *filename)
+{
+    std::vector< std::pair<uint32_t, int32_t> > pairs;
+    for (int32_t prev = 0; prev < CC_NUM_LINKED_SCCMDS; ++prev)
+    {
+        for (int32_t next = 0; next < CC_NUM_LINKED_SCCMDS; ++next)
+        {
+            if (op_pair_counts[prev][next] > 0)
+            {
+                pairs.push_back(std::make_pair(op_pair_counts[prev][next], prev * CC_NUM_LINKED_SCCMDS + next));
+            }
+        }
+    }
+    std::sort(pairs.begin(), pairs.end(), std::greater< std::pair<uint32_t, int32_t> >());
+
+    Stream *out = ci_fopen(filename, kFile_CreateAlways, kFile_Write);
+    if (!out)
+    {
+        return;
+    }
+    TextStreamWriter writer(out);
+    writer.WriteLine("Executed instruction pairs (count, first, second); first 0 means start of a call");
+    for (size_t i = 0; i < pairs.size(); ++i)
+    {
+        const int32_t prev = pairs[i].second / CC_NUM_LINKED_SCCMDS;
+        const int32_t next = pairs[i].second % CC_NUM_LINKED_SCCMDS;
+        writer.WriteFormat("%10u  %2d %-16s %2d %s", pairs[i].first,
+            prev, sccmd_info[prev].CmdName, next, sccmd_info[next].CmdName);
+        writer.WriteLineBreak();
+    }
+    // the writer will delete data stream internally
+}
+
 /*
 bool ccInstance::ReadOperation(ScriptOperation &op, int32_t at_pc)
 {
@@ -65,11 +65,21 @@ struct ScriptOperation
 	ScriptOperation()
 	{
 		ArgCount = 0;
+		NeedsRuntimeFixup = false;
+		for (int i = 0; i < MAX_SCMD_ARGS; ++i)
+		{
+			ArgFixup[i] = 0;
+		}
 	}
 
 	ScriptInstruction   Instruction;
 	RuntimeScriptValue	Args[MAX_SCMD_ARGS];
-	int				    ArgCount;
+	int				    ArgCount;   // number of code cells following the instruction
+	// Fixup types of the arguments which could not be resolved when the
+	// code was linked (stack offsets and imports exported by other scripts);
+	// such arguments keep raw code value in IValue until the op is executed
+	char                ArgFixup[MAX_SCMD_ARGS];
+	bool                NeedsRuntimeFixup;
 };
 
 struct ScriptVariable
@@ -146,12 +156,19 @@ public:
     int  numimports;
 
     char *code_fixups;
+    // code pre-decoded into operations with already resolved arguments;
+    // code_op_index maps code position to the operation which starts there, or -1
+    ScriptOperation *code_ops;
+    int32_t *code_op_index;
+    int32_t numcodeops;
 
     // returns the currently executing instance, or NULL if none
     static ccInstance *GetCurrentInstance(void);
     // create a runnable instance of the supplied script
     static ccInstance *CreateFromScript(PScript script);
     static ccInstance *CreateEx(PScript scri, ccInstance * joined);
+    // write statistics of executed instruction pairs, gathered with SCOPT_PROFILEOPS
+    static void WriteOpPairStats(const char *filename);
 
     ccInstance();
     ~ccInstance();
@@ -190,6 +207,13 @@ protected:
     bool    AddGlobalVar(const ScriptVariable &glvar);
     ScriptVariable *FindGlobalVar(int32_t var_addr);
     bool    CreateRuntimeCodeFixups(PScript scri);
+    // decodes the whole code into the array of operations, resolving arguments
+    bool    LinkCodeOperations();
+    // replaces common instruction sequences with engine-only superinstructions
+    void    FuseCodeOperations();
+    // returns operation at the current pc, resolving arguments that depend on
+    // runtime state into fixed_op if necessary; returns NULL on error
+    const ScriptOperation *FetchOperation(ccInstance *code_inst, ScriptOperation &fixed_op);
 	//bool    ReadOperation(ScriptOperation &op, int32_t at_pc);
 
     // Runtime fixups
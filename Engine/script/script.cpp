@@ -34,6 +34,7 @@
 #include "ac/invwindow.h"
 #include "ac/mouse.h"
 #include "ac/room.h"
+#include "ac/roomindex.h"
 #include "ac/roomobject.h"
 #include "script/cc_error.h"
 #include "script/cc_options.h"
@@ -603,6 +604,7 @@ int run_interaction_commandlist (InteractionCommandList *nicl, int *timesrun, in
           if (!is_valid_character(IPARAM1))
               quit("!Move NPC to different room: invalid character specified");
           game.chars[IPARAM1].room = IPARAM2;
+          invalidate_room_characters();
           break;
       case 27: // Set character view
           SetCharacterView (IPARAM1, IPARAM2);
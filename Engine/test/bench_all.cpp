@@ -0,0 +1,43 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#if defined (AGS_BENCHMARKS)
+
+#include <stdio.h>
+#include "test/bench_all.h"
+#include "util/perf_timer.h"
+
+void Bench_DoAllBenchmarks()
+{
+    Bench_ScriptInterpreter();
+    Bench_SpriteDecoding();
+    Bench_Pathfinding();
+    Bench_Blending();
+    Bench_TextLayout();
+    Bench_TextRender();
+}
+
+void Bench_Report(const char *name, int iterations, double elapsed_ms)
+{
+    printf("%-40s %10d iterations %10.2f ms %10.4f us/iteration\n",
+        name, iterations, elapsed_ms, iterations > 0 ? elapsed_ms * 1000.0 / iterations : 0.0);
+}
+
+double Bench_GetTimeMs()
+{
+    // wall clock time, for the benchmarks which include file reading
+    return (double)AGS::Engine::GetPerfTimeUs() / 1000.0;
+}
+
+#endif // AGS_BENCHMARKS
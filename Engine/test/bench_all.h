@@ -0,0 +1,40 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Performance benchmarks, built only with AGS_BENCHMARKS defined and run
+// by starting the engine with "--benchmark" command line option.
+//
+//=============================================================================
+
+#if defined (AGS_BENCHMARKS)
+
+void Bench_DoAllBenchmarks();
+// Prints the result of a timed benchmark run
+void Bench_Report(const char *name, int iterations, double elapsed_ms);
+// Returns current time in milliseconds
+double Bench_GetTimeMs();
+// Pathfinding over walkable areas
+void Bench_Pathfinding();
+// Script interpreter
+void Bench_ScriptInterpreter();
+// Sprite file loading
+void Bench_SpriteDecoding();
+// Software renderer's sprite blending
+void Bench_Blending();
+// Word wrapping of the long text
+void Bench_TextLayout();
+// Text drawing with the cached glyphs
+void Bench_TextRender();
+
+#endif // AGS_BENCHMARKS
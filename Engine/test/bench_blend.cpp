@@ -0,0 +1,153 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#if defined (AGS_BENCHMARKS)
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <allegro.h>
+#include "gfx/bitmap.h"
+#include "gfx/blender.h"
+#include "gfx/gfx_util.h"
+#include "test/bench_all.h"
+
+using namespace AGS::Common;
+namespace GfxUtil = AGS::Engine::GfxUtil;
+
+extern unsigned long _trans_alpha_blender32(unsigned long x, unsigned long y, unsigned long n);
+
+#define BENCH_BLEND_SCREEN_WIDTH    640
+#define BENCH_BLEND_SCREEN_HEIGHT   400
+#define BENCH_BLEND_SPRITE_WIDTH    320
+#define BENCH_BLEND_SPRITE_HEIGHT   200
+#define BENCH_BLEND_NUM             200
+
+// Fills 32-bit bitmap with the mix of transparent, opaque and translucent
+// pixels, typical for the anti-aliased character sprites
+static void BenchBlend_FillBitmap(Bitmap *bmp, unsigned int seed)
+{
+    for (int y = 0; y < bmp->GetHeight(); ++y)
+    {
+        unsigned int *line = (unsigned int*)bmp->GetScanLineForWriting(y);
+        for (int x = 0; x < bmp->GetWidth(); ++x)
+        {
+            seed = seed * 1103515245 + 12345;
+            const int edge = (x + y) % 64;
+            if (edge < 16)
+                line[x] = MASK_COLOR_32;
+            else if (edge < 20)
+                line[x] = ((seed >> 8) & 0x00FFFFFF) | ((edge * 60) << 24);
+            else
+                line[x] = 0xFF000000 | (seed >> 8);
+        }
+    }
+}
+
+// Blends the sprite over the screen at the changing positions
+static void BenchBlend_Run(const char *name, Bitmap *screen, Bitmap *sprite,
+                           SpanBlendMode mode, int alpha, bool span)
+{
+    double start = Bench_GetTimeMs();
+    for (int i = 0; i < BENCH_BLEND_NUM; ++i)
+    {
+        const int x = (i * 7) % (BENCH_BLEND_SCREEN_WIDTH - BENCH_BLEND_SPRITE_WIDTH);
+        const int y = (i * 3) % (BENCH_BLEND_SCREEN_HEIGHT - BENCH_BLEND_SPRITE_HEIGHT);
+        if (span)
+        {
+            GfxUtil::SpanBlendBlt(screen, sprite, x, y, mode, alpha);
+            continue;
+        }
+        switch (mode)
+        {
+        case kSpanBlend_Alpha: set_alpha_blender(); break;
+        case kSpanBlend_TransAlpha: set_blender_mode(NULL, NULL, _trans_alpha_blender32, 0, 0, 0, alpha); break;
+        case kSpanBlend_Trans: set_trans_blender(0, 0, 0, alpha); break;
+        case kSpanBlend_Argb2Argb: set_blender_mode(NULL, NULL, _argb2argb_blender, 0, 0, 0, alpha); break;
+        default: break;
+        }
+        screen->TransBlendBlt(sprite, x, y);
+    }
+    double elapsed = Bench_GetTimeMs() - start;
+    Bench_Report(name, BENCH_BLEND_NUM, elapsed);
+}
+
+// Tells if the span and Allegro blenders gave different results
+static void BenchBlend_CheckSame(Bitmap *screen, Bitmap *screen_copy)
+{
+    for (int y = 0; y < screen->GetHeight(); ++y)
+    {
+        if (memcmp(screen->GetScanLine(y), screen_copy->GetScanLine(y), screen->GetLineLength()) != 0)
+        {
+            printf("%-40s results differ at line %d\n", "", y);
+            return;
+        }
+    }
+}
+
+// Compares the span blenders with the Allegro blenders
+static void BenchBlend_Compare(const char *name, Bitmap *screen, Bitmap *screen_copy, Bitmap *sprite,
+                               SpanBlendMode mode, int alpha)
+{
+    char test_name[64];
+    BenchBlend_FillBitmap(screen, 2);
+    BenchBlend_FillBitmap(screen_copy, 2);
+    sprintf(test_name, "Blend: %s, allegro", name);
+    BenchBlend_Run(test_name, screen, sprite, mode, alpha, false);
+    sprintf(test_name, "Blend: %s, span", name);
+    BenchBlend_Run(test_name, screen_copy, sprite, mode, alpha, true);
+    BenchBlend_CheckSame(screen, screen_copy);
+}
+
+void Bench_Blending()
+{
+    install_allegro(SYSTEM_NONE, &errno, atexit);
+    if (!can_use_span_blenders())
+    {
+        printf("Blend benchmark skipped, pixel format not supported\n");
+        return;
+    }
+    printf("Span blenders use %s\n", get_span_blender_impl());
+
+    Bitmap *screen = BitmapHelper::CreateBitmap(BENCH_BLEND_SCREEN_WIDTH, BENCH_BLEND_SCREEN_HEIGHT, 32);
+    Bitmap *screen_copy = BitmapHelper::CreateBitmap(BENCH_BLEND_SCREEN_WIDTH, BENCH_BLEND_SCREEN_HEIGHT, 32);
+    Bitmap *sprite = BitmapHelper::CreateBitmap(BENCH_BLEND_SPRITE_WIDTH, BENCH_BLEND_SPRITE_HEIGHT, 32);
+    if (screen && screen_copy && sprite)
+    {
+        BenchBlend_FillBitmap(sprite, 1);
+        BenchBlend_Compare("alpha over opaque", screen, screen_copy, sprite, kSpanBlend_Alpha, 0);
+        BenchBlend_Compare("alpha with transparency", screen, screen_copy, sprite, kSpanBlend_TransAlpha, 128);
+        BenchBlend_Compare("constant transparency", screen, screen_copy, sprite, kSpanBlend_Trans, 128);
+        BenchBlend_Compare("alpha over alpha", screen, screen_copy, sprite, kSpanBlend_Argb2Argb, 0);
+
+        double start = Bench_GetTimeMs();
+        for (int i = 0; i < BENCH_BLEND_NUM; ++i)
+        {
+            set_trans_blender(20, 40, 60, 0);
+            screen->LitBlendBlt(screen, 0, 0, 128);
+        }
+        Bench_Report("Blend: screen tint, allegro", BENCH_BLEND_NUM, Bench_GetTimeMs() - start);
+        start = Bench_GetTimeMs();
+        for (int i = 0; i < BENCH_BLEND_NUM; ++i)
+            GfxUtil::SpanTintBlt(screen_copy, 20, 40, 60, 128);
+        Bench_Report("Blend: screen tint, span", BENCH_BLEND_NUM, Bench_GetTimeMs() - start);
+        BenchBlend_CheckSame(screen, screen_copy);
+    }
+    delete screen;
+    delete screen_copy;
+    delete sprite;
+}
+
+#endif // AGS_BENCHMARKS
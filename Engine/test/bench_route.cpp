@@ -0,0 +1,149 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#if defined (AGS_BENCHMARKS)
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <allegro.h>
+#include "ac/movelist.h"
+#include "ac/route_finder.h"
+#include "gfx/bitmap.h"
+#include "test/bench_all.h"
+#include "util/file.h"
+
+using namespace AGS::Common;
+
+extern MoveList *mls;
+
+// Walkable areas mask to benchmark, if present in the working directory:
+// an 8-bit image, exported from the room's walkable areas; otherwise
+// a room-sized mask with generated obstacles is used instead
+#define BENCH_ROUTE_MASK_FILE   "benchwalk.bmp"
+#define BENCH_ROUTE_WIDTH       1280
+#define BENCH_ROUTE_HEIGHT      720
+#define BENCH_ROUTE_NUM         200
+
+// Generates the mask of a large room: two walkable areas, a number of
+// solid obstacles, and walls with the gaps which make up the corridors
+static Bitmap *BenchRoute_CreateMask()
+{
+    Bitmap *mask = BitmapHelper::CreateBitmap(BENCH_ROUTE_WIDTH, BENCH_ROUTE_HEIGHT, 8);
+    if (!mask)
+        return NULL;
+    mask->Clear(0);
+    mask->FillRect(Rect(0, BENCH_ROUTE_HEIGHT / 3, BENCH_ROUTE_WIDTH - 1, BENCH_ROUTE_HEIGHT - 1), 1);
+    mask->FillRect(Rect(BENCH_ROUTE_WIDTH / 2, BENCH_ROUTE_HEIGHT / 3, BENCH_ROUTE_WIDTH - 1, BENCH_ROUTE_HEIGHT - 1), 2);
+
+    unsigned int seed = 1;
+    for (int i = 0; i < 60; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        int x = (seed >> 8) % BENCH_ROUTE_WIDTH;
+        seed = seed * 1103515245 + 12345;
+        int y = BENCH_ROUTE_HEIGHT / 3 + (seed >> 8) % (BENCH_ROUTE_HEIGHT * 2 / 3);
+        int size = 10 + (seed >> 4) % 50;
+        mask->FillRect(Rect(x, y, x + size, y + size / 2), 0);
+    }
+    for (int i = 1; i < 8; ++i)
+    {
+        int x = i * BENCH_ROUTE_WIDTH / 8;
+        int gap_y = BENCH_ROUTE_HEIGHT / 3 + (i % 2 == 0 ? 20 : BENCH_ROUTE_HEIGHT * 2 / 3 - 60);
+        mask->FillRect(Rect(x, BENCH_ROUTE_HEIGHT / 3, x + 8, BENCH_ROUTE_HEIGHT - 1), 0);
+        mask->FillRect(Rect(x, gap_y, x + 8, gap_y + 40), i % 2 + 1);
+    }
+    return mask;
+}
+
+static bool BenchRoute_FindWalkable(Bitmap *mask, int &x, int &y, unsigned int &seed)
+{
+    for (int tries = 0; tries < 10000; ++tries)
+    {
+        seed = seed * 1103515245 + 12345;
+        x = (seed >> 8) % mask->GetWidth();
+        seed = seed * 1103515245 + 12345;
+        y = (seed >> 8) % mask->GetHeight();
+        if (mask->GetPixel(x, y) > 0)
+            return true;
+    }
+    return false;
+}
+
+static void BenchRoute_Run(Bitmap *mask, const char *name)
+{
+    int from_x[BENCH_ROUTE_NUM], from_y[BENCH_ROUTE_NUM];
+    int to_x[BENCH_ROUTE_NUM], to_y[BENCH_ROUTE_NUM];
+    unsigned int seed = 1;
+    for (int i = 0; i < BENCH_ROUTE_NUM; ++i)
+    {
+        if (!BenchRoute_FindWalkable(mask, from_x[i], from_y[i], seed) ||
+            !BenchRoute_FindWalkable(mask, to_x[i], to_y[i], seed))
+        {
+            printf("%s failed: no walkable areas\n", name);
+            return;
+        }
+    }
+
+    int found = 0;
+    double start = Bench_GetTimeMs();
+    for (int i = 0; i < BENCH_ROUTE_NUM; ++i)
+    {
+        if (find_route(from_x[i], from_y[i], to_x[i], to_y[i], mask, 1) != 0)
+            found++;
+    }
+    double elapsed = Bench_GetTimeMs() - start;
+    Bench_Report(name, BENCH_ROUTE_NUM, elapsed);
+    printf("%-40s %10d routes found\n", "", found);
+}
+
+void Bench_Pathfinding()
+{
+    // the walkable masks are allegro bitmaps
+    install_allegro(SYSTEM_NONE, &errno, atexit);
+    init_pathfinder();
+    set_route_move_speed(3, 3);
+    // find_route returns the used move list, which must be nonzero on success
+    MoveList *old_mls = mls;
+    mls = (MoveList*)calloc(2, sizeof(MoveList));
+
+    Bitmap *mask = BenchRoute_CreateMask();
+    if (mask)
+    {
+        BenchRoute_Run(mask, "Route: generated 1280x720 room");
+        set_room_navigation_mask(mask);
+        BenchRoute_Run(mask, "Route: generated room, navigation data");
+        set_room_navigation_mask(NULL);
+        delete mask;
+    }
+    if (File::TestReadFile(BENCH_ROUTE_MASK_FILE))
+    {
+        mask = BitmapHelper::LoadFromFile(BENCH_ROUTE_MASK_FILE);
+        if (mask && mask->GetColorDepth() == 8)
+        {
+            BenchRoute_Run(mask, "Route: " BENCH_ROUTE_MASK_FILE);
+            set_room_navigation_mask(mask);
+            BenchRoute_Run(mask, "Route: " BENCH_ROUTE_MASK_FILE ", navigation data");
+            set_room_navigation_mask(NULL);
+        }
+        else
+            printf("Route benchmark failed to load %s as 8-bit image\n", BENCH_ROUTE_MASK_FILE);
+        delete mask;
+    }
+
+    free(mls);
+    mls = old_mls;
+}
+
+#endif // AGS_BENCHMARKS
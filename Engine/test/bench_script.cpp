@@ -0,0 +1,266 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#if defined (AGS_BENCHMARKS)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "script/cc_error.h"
+#include "script/cc_instance.h"
+#include "script/script_api.h"
+#include "script/script_runtime.h"
+#include "test/bench_all.h"
+
+// Number of loop iterations made by each benchmark script function
+#define BENCH_SCRIPT_LOOPS 1000000
+
+// Assembles bytecode of a script, the way compiler would have written it
+class BenchScriptBuilder
+{
+public:
+    // Appends instruction with its arguments
+    void Op(int32_t cmd)
+    {
+        _code.push_back(cmd);
+    }
+    void Op(int32_t cmd, intptr_t arg1)
+    {
+        _code.push_back(cmd);
+        _code.push_back(arg1);
+    }
+    void Op(int32_t cmd, intptr_t arg1, intptr_t arg2)
+    {
+        _code.push_back(cmd);
+        _code.push_back(arg1);
+        _code.push_back(arg2);
+    }
+    // Appends instruction with the second argument requiring a fixup
+    void OpFixup(int32_t cmd, intptr_t arg1, char fixup_type, intptr_t arg2)
+    {
+        _code.push_back(cmd);
+        _code.push_back(arg1);
+        _fixups.push_back((int32_t)_code.size());
+        _fixuptypes.push_back(fixup_type);
+        _code.push_back(arg2);
+    }
+    // Appends relative jump to the given code position
+    void Jump(int32_t cmd, int32_t to_pc)
+    {
+        _code.push_back(cmd);
+        _code.push_back(to_pc - ((int32_t)_code.size() + 1));
+    }
+    // Appends jump which target is not known yet; returns position to patch
+    int32_t JumpForward(int32_t cmd)
+    {
+        _code.push_back(cmd);
+        _code.push_back(0);
+        return (int32_t)_code.size() - 1;
+    }
+    void PatchJump(int32_t at)
+    {
+        _code[at] = (int32_t)_code.size() - (at + 1);
+    }
+    int32_t Pos() const
+    {
+        return (int32_t)_code.size();
+    }
+    int32_t AddString(const char *str)
+    {
+        int32_t offset = (int32_t)_strings.size();
+        _strings.insert(_strings.end(), str, str + strlen(str) + 1);
+        return offset;
+    }
+    int32_t AddImport(const char *name)
+    {
+        _imports.push_back(name);
+        return (int32_t)_imports.size() - 1;
+    }
+    void AddFunctionExport(const char *name)
+    {
+        _exports.push_back(name);
+        _export_addr.push_back((EXPORT_FUNCTION << 24) | Pos());
+    }
+
+    PScript Build() const
+    {
+        ccScript *scri = new ccScript();
+        scri->codesize = (int32_t)_code.size();
+        scri->code = (intptr_t*)malloc(_code.size() * sizeof(intptr_t));
+        memcpy(scri->code, &_code[0], _code.size() * sizeof(intptr_t));
+        if (!_strings.empty())
+        {
+            scri->stringssize = (int32_t)_strings.size();
+            scri->strings = (char*)malloc(_strings.size());
+            memcpy(scri->strings, &_strings[0], _strings.size());
+        }
+        scri->numfixups = (int)_fixups.size();
+        if (scri->numfixups > 0)
+        {
+            scri->fixups = (int32_t*)malloc(_fixups.size() * sizeof(int32_t));
+            memcpy(scri->fixups, &_fixups[0], _fixups.size() * sizeof(int32_t));
+            scri->fixuptypes = (char*)malloc(_fixuptypes.size());
+            memcpy(scri->fixuptypes, &_fixuptypes[0], _fixuptypes.size());
+        }
+        scri->numimports = scri->importsCapacity = (int)_imports.size();
+        scri->imports = (char**)malloc(_imports.size() * sizeof(char*));
+        for (size_t i = 0; i < _imports.size(); ++i)
+            scri->imports[i] = strdup(_imports[i]);
+        scri->numexports = scri->exportsCapacity = (int)_exports.size();
+        scri->exports = (char**)malloc(_exports.size() * sizeof(char*));
+        scri->export_addr = (int32_t*)malloc(_exports.size() * sizeof(int32_t));
+        for (size_t i = 0; i < _exports.size(); ++i)
+        {
+            scri->exports[i] = strdup(_exports[i]);
+            scri->export_addr[i] = _export_addr[i];
+        }
+        return PScript(scri);
+    }
+
+private:
+    std::vector<intptr_t>       _code;
+    std::vector<int32_t>        _fixups;
+    std::vector<char>           _fixuptypes;
+    std::vector<char>           _strings;
+    std::vector<const char*>    _imports;
+    std::vector<const char*>    _exports;
+    std::vector<int32_t>        _export_addr;
+};
+
+RuntimeScriptValue Sc_BenchExternalFunction(const RuntimeScriptValue *params, int32_t param_count)
+{
+    return RuntimeScriptValue().SetInt32(params[0].IValue + params[1].IValue);
+}
+
+// Writes loop header: "while (bx < BENCH_SCRIPT_LOOPS)", returns jump to patch at the loop end
+static int32_t BenchScript_BeginLoop(BenchScriptBuilder &b, int32_t &loop_start)
+{
+    b.Op(SCMD_LITTOREG, SREG_BX, 0);
+    b.Op(SCMD_LITTOREG, SREG_CX, 0);
+    loop_start = b.Pos();
+    b.Op(SCMD_REGTOREG, SREG_BX, SREG_AX);
+    b.Op(SCMD_LITTOREG, SREG_DX, BENCH_SCRIPT_LOOPS);
+    b.Op(SCMD_LESSTHAN, SREG_AX, SREG_DX);
+    return b.JumpForward(SCMD_JZ);
+}
+
+// Writes loop footer: "bx++", jump back, and return cx
+static void BenchScript_EndLoop(BenchScriptBuilder &b, int32_t loop_start, int32_t exit_jump)
+{
+    b.Op(SCMD_ADD, SREG_BX, 1);
+    b.Jump(SCMD_JMP, loop_start);
+    b.PatchJump(exit_jump);
+    b.Op(SCMD_REGTOREG, SREG_CX, SREG_AX);
+    b.Op(SCMD_RET);
+}
+
+static PScript BenchScript_Create()
+{
+    BenchScriptBuilder b;
+    int32_t loop_start;
+    int32_t exit_jump;
+    const int32_t import_fn = b.AddImport("BenchExternalFunction");
+    const int32_t str_a = b.AddString("Hello, world!");
+    const int32_t str_b = b.AddString("Hello, world?");
+
+    // Integer arithmetics: cx += (bx * 3) ^ bx
+    b.AddFunctionExport("BenchArithmetic$0");
+    b.Op(SCMD_LOOPCHECKOFF);
+    exit_jump = BenchScript_BeginLoop(b, loop_start);
+    b.Op(SCMD_LINENUM, 1);
+    b.Op(SCMD_REGTOREG, SREG_BX, SREG_AX);
+    b.Op(SCMD_MUL, SREG_AX, 3);
+    b.Op(SCMD_XORREG, SREG_AX, SREG_BX);
+    b.Op(SCMD_ADDREG, SREG_CX, SREG_AX);
+    BenchScript_EndLoop(b, loop_start, exit_jump);
+
+    // Engine API calls: cx += BenchExternalFunction(bx, 1)
+    b.AddFunctionExport("BenchCallExt$0");
+    b.Op(SCMD_LOOPCHECKOFF);
+    exit_jump = BenchScript_BeginLoop(b, loop_start);
+    b.Op(SCMD_LINENUM, 2);
+    b.Op(SCMD_LITTOREG, SREG_AX, 1);
+    b.Op(SCMD_PUSHREAL, SREG_AX);
+    b.Op(SCMD_PUSHREAL, SREG_BX);
+    b.Op(SCMD_NUMFUNCARGS, 2);
+    b.OpFixup(SCMD_LITTOREG, SREG_AX, FIXUP_IMPORT, import_fn);
+    b.Op(SCMD_CALLEXT, SREG_AX);
+    b.Op(SCMD_SUBREALSTACK, 2);
+    b.Op(SCMD_ADDREG, SREG_CX, SREG_AX);
+    BenchScript_EndLoop(b, loop_start, exit_jump);
+
+    // String comparison: cx += (str_a == str_b) + (str_a != str_b)
+    b.AddFunctionExport("BenchStringCompare$0");
+    b.Op(SCMD_LOOPCHECKOFF);
+    exit_jump = BenchScript_BeginLoop(b, loop_start);
+    b.Op(SCMD_LINENUM, 3);
+    b.OpFixup(SCMD_LITTOREG, SREG_AX, FIXUP_STRING, str_a);
+    b.OpFixup(SCMD_LITTOREG, SREG_DX, FIXUP_STRING, str_b);
+    b.Op(SCMD_STRINGSEQUAL, SREG_AX, SREG_DX);
+    b.Op(SCMD_ADDREG, SREG_CX, SREG_AX);
+    b.OpFixup(SCMD_LITTOREG, SREG_AX, FIXUP_STRING, str_a);
+    b.Op(SCMD_STRINGSNOTEQ, SREG_AX, SREG_DX);
+    b.Op(SCMD_ADDREG, SREG_CX, SREG_AX);
+    BenchScript_EndLoop(b, loop_start, exit_jump);
+
+    return b.Build();
+}
+
+static void BenchScript_Run(ccInstance *inst, const char *name, const char *funcname, int expect_result)
+{
+    double start = Bench_GetTimeMs();
+    int result = inst->CallScriptFunction(funcname, 0, NULL);
+    double elapsed = Bench_GetTimeMs() - start;
+    if (result != 0)
+    {
+        printf("%s failed: %s\n", name, ccErrorString);
+        return;
+    }
+    if (inst->returnValue != expect_result)
+    {
+        printf("%s failed: result %d, expected %d\n", name, inst->returnValue, expect_result);
+        return;
+    }
+    Bench_Report(name, BENCH_SCRIPT_LOOPS, elapsed);
+}
+
+void Bench_ScriptInterpreter()
+{
+    ccAddExternalStaticFunction("BenchExternalFunction", Sc_BenchExternalFunction);
+    PScript script = BenchScript_Create();
+    ccInstance *inst = ccInstance::CreateFromScript(script);
+    if (!inst)
+    {
+        printf("Script benchmark failed to create instance: %s\n", ccErrorString);
+        return;
+    }
+
+    // script integers wrap on overflow
+    uint32_t expect_arith = 0;
+    uint32_t expect_callext = 0;
+    for (int i = 0; i < BENCH_SCRIPT_LOOPS; ++i)
+    {
+        expect_arith += (i * 3) ^ i;
+        expect_callext += i + 1;
+    }
+    BenchScript_Run(inst, "Script: arithmetic loop", "BenchArithmetic", (int)expect_arith);
+    BenchScript_Run(inst, "Script: SCMD_CALLEXT loop", "BenchCallExt", (int)expect_callext);
+    BenchScript_Run(inst, "Script: string compare loop", "BenchStringCompare", BENCH_SCRIPT_LOOPS);
+
+    delete inst;
+    ccRemoveExternalSymbol("BenchExternalFunction");
+}
+
+#endif // AGS_BENCHMARKS
@@ -0,0 +1,281 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#if defined (AGS_BENCHMARKS)
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "test/bench_all.h"
+#include "util/compress.h"
+#include "util/file.h"
+#include "util/lz4block.h"
+#include "util/memorystream.h"
+#include "util/stream.h"
+
+using namespace AGS::Common;
+
+// Sprite file to benchmark, if present in the working directory; otherwise
+// a file with generated sprites is written and used instead
+#define BENCH_SPRITE_FILE       "acsprset.spr"
+#define BENCH_SPRITE_TEMP_FILE  "benchspr.tmp"
+#define BENCH_SPRITE_NUM        200
+#define BENCH_SPRITE_WIDTH      320
+#define BENCH_SPRITE_HEIGHT     200
+
+static const char *BenchSprite_FileSig = " Sprite File ";
+
+// Generates a line of 32-bit sprite with a mix of flat and noisy areas
+static void BenchSprite_GenerateLine(unsigned int *line, int sprite, int y, unsigned int &seed)
+{
+    for (int x = 0; x < BENCH_SPRITE_WIDTH; ++x)
+    {
+        seed = seed * 1103515245 + 12345;
+        // left part is transparent, then alternating runs and gradients
+        if (x < BENCH_SPRITE_WIDTH / 4)
+            line[x] = 0xFF00FF;
+        else if ((x / 16) % 2 == 0)
+            line[x] = 0xFF000000 | (y << 8) | sprite;
+        else
+            line[x] = 0xFF000000 | (seed >> 8);
+    }
+}
+
+// Writes RLE compressed 32-bit sprites in the version 6 format
+static bool BenchSprite_CreateFile(const char *filename)
+{
+    Stream *out = File::CreateFile(filename);
+    if (!out)
+        return false;
+    out->WriteInt16(6);
+    out->Write(BenchSprite_FileSig, 13);
+    out->WriteInt8(1); // compressed
+    out->WriteInt32(0); // file ID
+    out->WriteInt16(BENCH_SPRITE_NUM - 1);
+
+    std::vector<unsigned int> line(BENCH_SPRITE_WIDTH);
+    unsigned int seed = 1;
+    for (int i = 0; i < BENCH_SPRITE_NUM; ++i)
+    {
+        out->WriteInt16(4);
+        out->WriteInt16(BENCH_SPRITE_WIDTH);
+        out->WriteInt16(BENCH_SPRITE_HEIGHT);
+        size_t lenloc = out->GetPosition();
+        out->WriteInt32(0);
+        for (int y = 0; y < BENCH_SPRITE_HEIGHT; ++y)
+        {
+            BenchSprite_GenerateLine(&line[0], i, y, seed);
+            cpackbitl32(&line[0], BENCH_SPRITE_WIDTH, out);
+        }
+        size_t endloc = out->GetPosition();
+        out->Seek(lenloc, kSeekBegin);
+        out->WriteInt32((endloc - lenloc) - 4);
+        out->Seek(0, kSeekEnd);
+    }
+    delete out;
+    return true;
+}
+
+// Opens sprite file and positions stream at the first sprite, if the file
+// has a supported format; returns number of sprite slots
+static Stream *BenchSprite_OpenFile(const char *filename, int &num_sprites)
+{
+    Stream *in = File::OpenFileRead(filename);
+    if (!in)
+        return NULL;
+    char sig[14];
+    int vers = in->ReadInt16();
+    in->Read(sig, 13);
+    sig[13] = 0;
+    bool compressed = vers == 5;
+    if (vers >= 6)
+    {
+        compressed = in->ReadInt8() == 1;
+        in->ReadInt32(); // file ID
+    }
+    if (strcmp(sig, BenchSprite_FileSig) != 0 || vers < 5 || vers > 6 || !compressed)
+    {
+        delete in;
+        return NULL;
+    }
+    num_sprites = in->ReadInt16() + 1;
+    return in;
+}
+
+// Decodes all of the sprites in the file, either using the legacy per-byte
+// stream reading, or reading each sprite's data at once; returns number of
+// sprites decoded
+static int BenchSprite_DecodeFile(const char *filename, bool buffered)
+{
+    int num_sprites = 0;
+    Stream *in = BenchSprite_OpenFile(filename, num_sprites);
+    if (!in)
+        return 0;
+
+    std::vector<unsigned char> line;
+    std::vector<unsigned char> buffer;
+    int decoded = 0;
+    for (int i = 0; i < num_sprites && !in->EOS(); ++i)
+    {
+        int coldep = in->ReadInt16();
+        if (coldep == 0)
+            continue;
+        int width = in->ReadInt16();
+        int height = in->ReadInt16();
+        int32_t data_size = in->ReadInt32();
+        if (line.size() < (size_t)(width * coldep))
+            line.resize(width * coldep);
+
+        if (buffered)
+        {
+            if (buffer.size() < (size_t)data_size)
+                buffer.resize(data_size);
+            const unsigned char *src = &buffer[0];
+            const unsigned char *src_end = src + in->Read(&buffer[0], data_size);
+            for (int y = 0; y < height; ++y)
+            {
+                if (coldep == 1)
+                    cunpackbitl(&line[0], width, src, src_end);
+                else if (coldep == 2)
+                    cunpackbitl16((unsigned short*)&line[0], width, src, src_end);
+                else
+                    cunpackbitl32((unsigned int*)&line[0], width, src, src_end);
+            }
+        }
+        else
+        {
+            for (int y = 0; y < height; ++y)
+            {
+                if (coldep == 1)
+                    cunpackbitl(&line[0], width, in);
+                else if (coldep == 2)
+                    cunpackbitl16((unsigned short*)&line[0], width, in);
+                else
+                    cunpackbitl32((unsigned int*)&line[0], width, in);
+            }
+        }
+        decoded++;
+    }
+    delete in;
+    return decoded;
+}
+
+// Compares sprite file codecs on the generated sprites held in memory:
+// reports the packed size and the time it takes to decode them all
+static void BenchSprite_CompareCodecs()
+{
+    const size_t line_size = BENCH_SPRITE_WIDTH * 4;
+    const size_t image_size = line_size * BENCH_SPRITE_HEIGHT;
+    std::vector<unsigned char> image(image_size);
+    std::vector<unsigned char> lz4_packed(lz4block_compress_bound(image_size));
+    std::vector<unsigned char> rle_data;
+    std::vector<unsigned char> lz4_data;
+    std::vector<unsigned char> delta_data;
+    std::vector<size_t> rle_offs, lz4_offs, delta_offs;
+    VectorStream rle_out(rle_data);
+    unsigned int seed = 1;
+    for (int i = 0; i < BENCH_SPRITE_NUM; ++i)
+    {
+        for (int y = 0; y < BENCH_SPRITE_HEIGHT; ++y)
+        {
+            unsigned int *line = (unsigned int*)&image[y * line_size];
+            BenchSprite_GenerateLine(line, i, y, seed);
+            cpackbitl32(line, BENCH_SPRITE_WIDTH, &rle_out);
+        }
+        rle_offs.push_back(rle_data.size());
+        size_t packed_size = lz4block_compress(&image[0], image_size, &lz4_packed[0], lz4_packed.size());
+        lz4_data.insert(lz4_data.end(), lz4_packed.begin(), lz4_packed.begin() + packed_size);
+        lz4_offs.push_back(lz4_data.size());
+        for (int y = 0; y < BENCH_SPRITE_HEIGHT; ++y)
+        {
+            unsigned char *line = &image[y * line_size];
+            for (size_t x = line_size - 1; x >= 4; --x)
+                line[x] -= line[x - 4];
+        }
+        packed_size = lz4block_compress(&image[0], image_size, &lz4_packed[0], lz4_packed.size());
+        delta_data.insert(delta_data.end(), lz4_packed.begin(), lz4_packed.begin() + packed_size);
+        delta_offs.push_back(delta_data.size());
+    }
+    printf("Sprites: packed size RLE %u, LZ4 %u, delta LZ4 %u (raw %u)\n",
+        (unsigned)rle_data.size(), (unsigned)lz4_data.size(), (unsigned)delta_data.size(),
+        (unsigned)(image_size * BENCH_SPRITE_NUM));
+
+    double start = Bench_GetTimeMs();
+    const unsigned char *src = &rle_data[0];
+    const unsigned char *src_end = src + rle_data.size();
+    for (int i = 0; i < BENCH_SPRITE_NUM; ++i)
+    {
+        for (int y = 0; y < BENCH_SPRITE_HEIGHT; ++y)
+            cunpackbitl32((unsigned int*)&image[y * line_size], BENCH_SPRITE_WIDTH, src, src_end);
+    }
+    Bench_Report("Sprites: RLE decoder from memory", BENCH_SPRITE_NUM, Bench_GetTimeMs() - start);
+
+    start = Bench_GetTimeMs();
+    for (int i = 0; i < BENCH_SPRITE_NUM; ++i)
+    {
+        size_t from = i > 0 ? lz4_offs[i - 1] : 0;
+        lz4block_decompress(&lz4_data[from], lz4_offs[i] - from, &image[0], image_size);
+    }
+    Bench_Report("Sprites: LZ4 decoder", BENCH_SPRITE_NUM, Bench_GetTimeMs() - start);
+
+    start = Bench_GetTimeMs();
+    for (int i = 0; i < BENCH_SPRITE_NUM; ++i)
+    {
+        size_t from = i > 0 ? delta_offs[i - 1] : 0;
+        lz4block_decompress(&delta_data[from], delta_offs[i] - from, &image[0], image_size);
+        for (int y = 0; y < BENCH_SPRITE_HEIGHT; ++y)
+        {
+            unsigned char *line = &image[y * line_size];
+            for (size_t x = 4; x < line_size; ++x)
+                line[x] += line[x - 4];
+        }
+    }
+    Bench_Report("Sprites: delta LZ4 decoder", BENCH_SPRITE_NUM, Bench_GetTimeMs() - start);
+}
+
+void Bench_SpriteDecoding()
+{
+    const char *filename = BENCH_SPRITE_FILE;
+    int num_sprites = 0;
+    Stream *test = BenchSprite_OpenFile(filename, num_sprites);
+    const bool use_temp_file = (test == NULL);
+    delete test;
+    if (use_temp_file)
+    {
+        filename = BENCH_SPRITE_TEMP_FILE;
+        if (!BenchSprite_CreateFile(filename))
+        {
+            printf("Sprite benchmark failed to create %s\n", filename);
+            return;
+        }
+    }
+
+    // first pass to have the file in the system cache for both tests
+    BenchSprite_DecodeFile(filename, true);
+
+    double start = Bench_GetTimeMs();
+    int decoded = BenchSprite_DecodeFile(filename, false);
+    Bench_Report("Sprites: stream RLE decoder", decoded, Bench_GetTimeMs() - start);
+
+    start = Bench_GetTimeMs();
+    decoded = BenchSprite_DecodeFile(filename, true);
+    Bench_Report("Sprites: buffered RLE decoder", decoded, Bench_GetTimeMs() - start);
+
+    if (use_temp_file)
+        File::DeleteFile(filename);
+
+    BenchSprite_CompareCodecs();
+}
+
+#endif // AGS_BENCHMARKS
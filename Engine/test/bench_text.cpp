@@ -0,0 +1,270 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#if defined (AGS_BENCHMARKS)
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <allegro.h>
+#include "font/agsfontrenderer.h"
+#include "font/fonts.h"
+#include "font/glyphcache.h"
+#include "font/textlayout.h"
+#include "gui/guidefines.h"
+#include "test/bench_all.h"
+#include "util/string_utils.h"
+
+using namespace AGS::Common;
+
+extern int wgettextwidth_compensate(const char *tex, int font);
+extern char lines[MAXLINE][200];
+extern int  numlines;
+
+#define BENCH_TEXT_FONT         0
+#define BENCH_TEXT_WIDTH        300
+#define BENCH_TEXT_NUM          200
+#define BENCH_TEXT_BUFFER_SIZE  3000
+#define BENCH_GLYPH_WIDTH       8
+#define BENCH_GLYPH_HEIGHT      10
+#define BENCH_GLYPH_ROW_BYTES   ((BENCH_GLYPH_WIDTH + 7) / 8)
+
+// Measures the text the way a bitmap font does: sums up the widths of each
+// character, so the cost of measuring grows with the text length
+class BenchTextRenderer : public IAGSFontRenderer
+{
+public:
+    virtual bool LoadFromDisk(int fontNumber, int fontSize) { return true; }
+    virtual void FreeMemory(int fontNumber) { }
+    virtual bool SupportsExtendedCharacters(int fontNumber) { return false; }
+    virtual int GetTextWidth(const char *text, int fontNumber)
+    {
+        int width = 0;
+        for (; *text; ++text)
+            width += (*text == ' ') ? 3 : 4 + (*text % 5);
+        return width;
+    }
+    virtual int GetTextHeight(const char *text, int fontNumber) { return 10; }
+    virtual void RenderText(const char *text, int fontNumber, BITMAP *destination, int x, int y, int colour) { }
+    virtual void AdjustYCoordinateForFont(int *ycoord, int fontNumber) { }
+    virtual void EnsureTextValidForFont(char *text, int fontNumber) { }
+};
+
+// Long dialogue line, with a forced line break in the middle
+static const char *BenchTextSentence =
+    "Well, I was walking down the pier, minding my own business, when this "
+    "enormous seagull swooped down and stole my sandwich right out of my hand. ";
+
+// Breaks up the text the way split_lines did, by measuring the whole line
+// again after every added character
+static void BenchText_SplitLegacy(const char *todis, int wii, int fonnt)
+{
+    int i = 0;
+    int nextCharWas;
+    int splitAt;
+    char textCopyBuffer[BENCH_TEXT_BUFFER_SIZE];
+    strcpy(textCopyBuffer, todis);
+    char *theline = textCopyBuffer;
+    unescape(theline);
+
+    while (1) {
+        splitAt = -1;
+        if (theline[i] == 0) {
+            if (i > 0) {
+                strcpy(lines[numlines], theline);
+                numlines++;
+            }
+            break;
+        }
+        nextCharWas = theline[i + 1];
+        theline[i + 1] = 0;
+        if (theline[i] == '\n')
+            splitAt = i;
+        else if (wgettextwidth_compensate(theline, fonnt) >= wii) {
+            int endline = i;
+            while ((theline[endline] != ' ') && (endline > 0))
+                endline--;
+            if (endline == 0)
+                endline = i - 1;
+            splitAt = endline;
+        }
+        theline[i + 1] = nextCharWas;
+        if (splitAt >= 0) {
+            nextCharWas = theline[splitAt];
+            theline[splitAt] = 0;
+            strcpy(lines[numlines], theline);
+            numlines++;
+            theline[splitAt] = nextCharWas;
+            if (numlines >= MAXLINE) {
+                strcat(lines[numlines-1], "...");
+                break;
+            }
+            theline += splitAt;
+            if ((theline[0] == ' ') || (theline[0] == '\n'))
+                theline++;
+            i = -1;
+        }
+        i++;
+    }
+}
+
+// Tells if the layout made the same lines as the legacy wrapping
+static void BenchText_CheckSame(const TextLayout &layout)
+{
+    numlines = 0;
+    BenchText_SplitLegacy(layout.GetText(), BENCH_TEXT_WIDTH, BENCH_TEXT_FONT);
+    bool same = (size_t)numlines == layout.GetLineCount() && !layout.IsTruncated();
+    for (size_t i = 0; same && i < layout.GetLineCount(); ++i)
+    {
+        const TextLine &line = layout.GetLine(i);
+        same = strlen(lines[i]) == line.Length &&
+            strncmp(lines[i], layout.GetText() + line.Offset, line.Length) == 0;
+    }
+    if (!same)
+        printf("%-40s layout differs from the legacy wrapping\n", "");
+}
+
+void Bench_TextLayout()
+{
+    BenchTextRenderer renderer;
+    IAGSFontRenderer *old_renderer = font_replace_renderer(BENCH_TEXT_FONT, &renderer, true);
+
+    std::vector<char> text;
+    for (int i = 0; i < 12; ++i)
+    {
+        text.insert(text.end(), BenchTextSentence, BenchTextSentence + strlen(BenchTextSentence));
+        if (i == 6)
+            text.push_back('[');
+    }
+    text.push_back(0);
+
+    double start = Bench_GetTimeMs();
+    for (int i = 0; i < BENCH_TEXT_NUM; ++i)
+    {
+        numlines = 0;
+        BenchText_SplitLegacy(&text.front(), BENCH_TEXT_WIDTH, BENCH_TEXT_FONT);
+    }
+    Bench_Report("Text: wrap, legacy", BENCH_TEXT_NUM, Bench_GetTimeMs() - start);
+
+    TextLayout layout;
+    start = Bench_GetTimeMs();
+    for (int i = 0; i < BENCH_TEXT_NUM; ++i)
+        layout.Layout(&text.front(), BENCH_TEXT_WIDTH, BENCH_TEXT_FONT, MAXLINE);
+    Bench_Report("Text: wrap, layout", BENCH_TEXT_NUM, Bench_GetTimeMs() - start);
+
+    start = Bench_GetTimeMs();
+    for (int i = 0; i < BENCH_TEXT_NUM; ++i)
+        get_text_layout(&text.front(), BENCH_TEXT_WIDTH, BENCH_TEXT_FONT, MAXLINE);
+    Bench_Report("Text: wrap, cached layout", BENCH_TEXT_NUM, Bench_GetTimeMs() - start);
+
+    BenchText_CheckSame(layout);
+    font_replace_renderer(BENCH_TEXT_FONT, old_renderer);
+}
+
+// Makes up the 1-bit image of a character, the way they are stored in the
+// bitmap fonts
+static void BenchText_MakeGlyph(unsigned char ch, unsigned char *bits)
+{
+    for (int h = 0; h < BENCH_GLYPH_HEIGHT; ++h)
+        bits[h] = (ch == ' ') ? 0 : (unsigned char)((ch * (h + 3)) | 0x81);
+}
+
+// Draws the text pixel by pixel, testing each bit of the character images
+static void BenchText_DrawLegacy(BITMAP *ds, const char *text, int x, int y, int colour)
+{
+    unsigned char bits[BENCH_GLYPH_HEIGHT * BENCH_GLYPH_ROW_BYTES];
+    for (; *text; ++text)
+    {
+        BenchText_MakeGlyph(*text, bits);
+        for (int h = 0; h < BENCH_GLYPH_HEIGHT; ++h)
+        {
+            for (int w = 0; w < BENCH_GLYPH_WIDTH; ++w)
+            {
+                if ((bits[h * BENCH_GLYPH_ROW_BYTES + (w / 8)] & (0x80 >> (w % 8))) != 0)
+                    putpixel(ds, x + w, y + h, colour);
+            }
+        }
+        x += BENCH_GLYPH_WIDTH;
+    }
+}
+
+void Bench_TextRender()
+{
+    GlyphCache mono_glyphs;
+    GlyphCache aa_glyphs;
+    unsigned char bits[BENCH_GLYPH_HEIGHT * BENCH_GLYPH_ROW_BYTES];
+    unsigned char pixels[BENCH_GLYPH_HEIGHT * BENCH_GLYPH_WIDTH];
+    for (int ch = 0; ch < 256; ++ch)
+    {
+        BenchText_MakeGlyph(ch, bits);
+        for (int h = 0; h < BENCH_GLYPH_HEIGHT; ++h)
+        {
+            for (int w = 0; w < BENCH_GLYPH_WIDTH; ++w)
+            {
+                const bool set = (bits[h * BENCH_GLYPH_ROW_BYTES + (w / 8)] & (0x80 >> (w % 8))) != 0;
+                pixels[h * BENCH_GLYPH_WIDTH + w] = set ? (unsigned char)(64 + (w * 32) % 192) : 0;
+            }
+        }
+        mono_glyphs.BeginGlyph(ch, BENCH_GLYPH_WIDTH, BENCH_GLYPH_HEIGHT);
+        mono_glyphs.AddImage(0, 0, BENCH_GLYPH_WIDTH, BENCH_GLYPH_HEIGHT, pixels, BENCH_GLYPH_WIDTH, false);
+        aa_glyphs.BeginGlyph(ch, BENCH_GLYPH_WIDTH, BENCH_GLYPH_HEIGHT);
+        aa_glyphs.AddImage(0, 0, BENCH_GLYPH_WIDTH, BENCH_GLYPH_HEIGHT, pixels, BENCH_GLYPH_WIDTH, true);
+    }
+
+    const char *text = BenchTextSentence;
+    BITMAP *ds = create_bitmap_ex(32, 640, 400);
+    clear_to_color(ds, 0);
+
+    double start = Bench_GetTimeMs();
+    for (int i = 0; i < BENCH_TEXT_NUM; ++i)
+        BenchText_DrawLegacy(ds, text, -(i % 100), i % 390, 0xFFFFFF);
+    Bench_Report("Text: draw, per pixel", BENCH_TEXT_NUM, Bench_GetTimeMs() - start);
+
+    start = Bench_GetTimeMs();
+    for (int i = 0; i < BENCH_TEXT_NUM; ++i)
+        mono_glyphs.DrawText(ds, text, -(i % 100), i % 390, 0xFFFFFF);
+    Bench_Report("Text: draw, glyph spans", BENCH_TEXT_NUM, Bench_GetTimeMs() - start);
+
+    start = Bench_GetTimeMs();
+    for (int i = 0; i < BENCH_TEXT_NUM; ++i)
+        aa_glyphs.DrawTextAntiAliased(ds, text, -(i % 100), i % 390, 0xFFFFFF);
+    Bench_Report("Text: draw, anti-aliased glyph spans", BENCH_TEXT_NUM, Bench_GetTimeMs() - start);
+
+    // the automatic outline, drawn as eight shifted copies and the text
+    start = Bench_GetTimeMs();
+    for (int i = 0; i < BENCH_TEXT_NUM; ++i)
+    {
+        const int x = -(i % 100) + 1;
+        const int y = i % 390 + 1;
+        aa_glyphs.DrawTextAntiAliased(ds, text, x - 1, y, 0);
+        aa_glyphs.DrawTextAntiAliased(ds, text, x + 1, y, 0);
+        aa_glyphs.DrawTextAntiAliased(ds, text, x, y + 1, 0);
+        aa_glyphs.DrawTextAntiAliased(ds, text, x, y - 1, 0);
+        aa_glyphs.DrawTextAntiAliased(ds, text, x - 1, y - 1, 0);
+        aa_glyphs.DrawTextAntiAliased(ds, text, x - 1, y + 1, 0);
+        aa_glyphs.DrawTextAntiAliased(ds, text, x + 1, y + 1, 0);
+        aa_glyphs.DrawTextAntiAliased(ds, text, x + 1, y - 1, 0);
+        aa_glyphs.DrawTextAntiAliased(ds, text, x, y, 0xFFFFFF);
+    }
+    Bench_Report("Text: outline, nine passes", BENCH_TEXT_NUM, Bench_GetTimeMs() - start);
+
+    start = Bench_GetTimeMs();
+    for (int i = 0; i < BENCH_TEXT_NUM; ++i)
+        aa_glyphs.DrawTextOutlined(ds, text, -(i % 100) + 1, i % 390 + 1, 0xFFFFFF, 0, 1, 1, true);
+    Bench_Report("Text: outline, single pass", BENCH_TEXT_NUM, Bench_GetTimeMs() - start);
+
+    destroy_bitmap(ds);
+}
+
+#endif // AGS_BENCHMARKS
@@ -26,6 +26,8 @@ void Test_DoAllTests()
     Test_Version();
     Test_File();
     Test_IniFile();
+    Test_ManagedObjectPool();
+    Test_LockFreeQueue();
 
     Test_Gfx();
 }
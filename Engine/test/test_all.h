@@ -24,6 +24,10 @@ void Test_IniFile();
 void Test_Gfx();
 // Memory / bit-byte operations
 void Test_Memory();
+// Script runtime
+void Test_ManagedObjectPool();
+// Threading
+void Test_LockFreeQueue();
 // String tests
 void Test_ScriptSprintf();
 void Test_String();
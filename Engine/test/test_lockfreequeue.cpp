@@ -0,0 +1,76 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#ifdef _DEBUG
+
+#include "util/lockfree_queue.h"
+#include "util/thread.h"
+#include "debug/assert.h"
+
+using namespace AGS::Engine;
+
+#define TEST_QUEUE_SIZE     8
+#define TEST_QUEUE_ITEMS    100000
+
+static LockFreeQueue<int, TEST_QUEUE_SIZE> test_queue;
+
+// Pushes the numbers in order, waiting whenever the queue is full
+static void Test_QueueProducer()
+{
+    for (int i = 0; i < TEST_QUEUE_ITEMS; ++i)
+    {
+        while (!test_queue.Push(i));
+    }
+}
+
+void Test_LockFreeQueue()
+{
+    LockFreeQueue<int, TEST_QUEUE_SIZE> queue;
+    int item = -1;
+    assert(queue.IsEmpty());
+    assert(!queue.Peek(item));
+
+    // one slot is always kept free
+    for (int i = 0; i < TEST_QUEUE_SIZE - 1; ++i)
+        assert(queue.Push(i));
+    assert(!queue.Push(100));
+    assert(!queue.IsEmpty());
+
+    assert(queue.Peek(item) && item == 0);
+    assert(queue.Peek(item) && item == 0);
+    queue.Pop();
+    assert(queue.Push(100));
+    for (int i = 1; i < TEST_QUEUE_SIZE - 1; ++i)
+    {
+        assert(queue.Peek(item) && item == i);
+        queue.Pop();
+    }
+    assert(queue.Peek(item) && item == 100);
+    queue.Pop();
+    assert(queue.IsEmpty());
+
+    // the items pushed by the other thread come out whole and in order
+    Thread producer;
+    assert(producer.CreateAndStart(Test_QueueProducer, false));
+    for (int i = 0; i < TEST_QUEUE_ITEMS; ++i)
+    {
+        while (!test_queue.Peek(item));
+        assert(item == i);
+        test_queue.Pop();
+    }
+    producer.Stop();
+    assert(test_queue.IsEmpty());
+}
+
+#endif // _DEBUG
@@ -0,0 +1,186 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#ifdef _DEBUG
+
+#include <string.h>
+#include "ac/dynobj/cc_agsdynamicobject.h"
+#include "ac/dynobj/cc_dynamicarray.h"
+#include "ac/dynobj/managedobjectpool.h"
+#include "debug/assert.h"
+
+struct TestManagedObject : AGSCCDynamicObject
+{
+    int Disposed;
+
+    TestManagedObject() : Disposed(0) {}
+    virtual int Dispose(const char *address, bool force)
+    {
+        Disposed++;
+        return 1;
+    }
+    virtual const char *GetType() { return "TestManagedObject"; }
+    virtual int Serialize(const char *address, char *buffer, int bufsize) { return 0; }
+    virtual void Unserialize(int index, const char *serializedData, int dataSize) {}
+};
+
+// Creates array of managed handles the way CCDynamicArray does, but in the test pool
+static int32_t Test_CreateManagedArray(ManagedObjectPool &test_pool, int num_elements, int32_t *&elements)
+{
+    char *new_array = new char[num_elements * sizeof(int32_t) + 8];
+    memset(new_array, 0, num_elements * sizeof(int32_t) + 8);
+    int32_t *header = (int32_t*)new_array;
+    header[0] = num_elements | ARRAY_MANAGED_TYPE_FLAG;
+    header[1] = num_elements * sizeof(int32_t);
+    elements = (int32_t*)&new_array[8];
+    return test_pool.AddObject(&new_array[8], &globalDynamicArray, false);
+}
+
+// Stores reference to the object in array element
+static void Test_SetArrayElement(ManagedObjectPool &test_pool, int32_t *elements, int index, int32_t handle)
+{
+    elements[index] = handle;
+    test_pool.AddRef(handle);
+}
+
+void Test_ManagedObjectPool()
+{
+    const int NUM_OBJECTS = 1000;
+    static char object_data[NUM_OBJECTS];
+    TestManagedObject manager;
+    ManagedObjectPool test_pool;
+
+    // Registering objects and finding them by address
+    int32_t handles[NUM_OBJECTS];
+    for (int i = 0; i < NUM_OBJECTS; ++i)
+    {
+        handles[i] = test_pool.AddObject(&object_data[i], &manager, false);
+        assert(handles[i] == i + 1);
+    }
+    for (int i = 0; i < NUM_OBJECTS; ++i)
+    {
+        assert(test_pool.AddressToHandle(&object_data[i]) == handles[i]);
+        assert(test_pool.HandleToAddress(handles[i]) == &object_data[i]);
+    }
+    assert(test_pool.AddressToHandle(NULL) == 0);
+
+    // Disposing objects, and reusing their slots
+    test_pool.AddRef(handles[10]);
+    test_pool.SubRef(handles[10]);
+    assert(manager.Disposed == 1);
+    assert(test_pool.AddressToHandle(&object_data[10]) == 0);
+    assert(test_pool.HandleToAddress(handles[10]) == NULL);
+    assert(test_pool.RemoveObject(&object_data[20]) == 1);
+    assert(test_pool.RemoveObject(&object_data[20]) == 0);
+    assert(manager.Disposed == 2);
+
+    int32_t handle = test_pool.AddObject(&object_data[20], &manager, false);
+    assert(handle == handles[20]);
+    handle = test_pool.AddObject(&object_data[10], &manager, false);
+    assert(handle == handles[10]);
+    handle = test_pool.AddObject(&object_data[0] + NUM_OBJECTS, &manager, false);
+    assert(handle == NUM_OBJECTS + 1);
+
+    // Restoring objects into the explicitly given slots
+    test_pool.reset();
+    assert(test_pool.AddressToHandle(&object_data[0]) == 0);
+    assert(test_pool.AddObject(&object_data[5], &manager, false, 5) == 5);
+    assert(test_pool.AddressToHandle(&object_data[5]) == 5);
+    for (int i = 1; i < 5; ++i)
+    {
+        handle = test_pool.AddObject(&object_data[i], &manager, false);
+        assert(handle >= 1 && handle < 5);
+    }
+    assert(test_pool.AddObject(&object_data[6], &manager, false) == 6);
+    test_pool.reset();
+
+    // Collecting arrays that only refer to each other
+    int32_t *elems_a, *elems_b, *elems_c;
+    const int32_t arr_a = Test_CreateManagedArray(test_pool, 2, elems_a);
+    const int32_t arr_b = Test_CreateManagedArray(test_pool, 1, elems_b);
+    const int32_t arr_c = Test_CreateManagedArray(test_pool, 1, elems_c);
+    const int32_t obj = test_pool.AddObject(&object_data[0], &manager, false);
+    Test_SetArrayElement(test_pool, elems_a, 0, arr_b);
+    Test_SetArrayElement(test_pool, elems_b, 0, arr_a);
+    Test_SetArrayElement(test_pool, elems_a, 1, obj);
+    Test_SetArrayElement(test_pool, elems_c, 0, obj);
+    test_pool.AddRef(arr_c); // referenced by script variable
+    manager.Disposed = 0;
+    assert(test_pool.CollectCycles() == 2);
+    assert(test_pool.HandleToAddress(arr_a) == NULL);
+    assert(test_pool.HandleToAddress(arr_b) == NULL);
+    assert(test_pool.HandleToAddress(arr_c) != NULL);
+    assert(test_pool.HandleToAddress(obj) == &object_data[0]);
+    assert(manager.Disposed == 0);
+    assert(test_pool.CollectCycles() == 0);
+
+    // Incremental collection reaches the slots after the first step's worth
+    // of live objects, and makes full sweeps
+    test_pool.reset();
+    const int NUM_LIVE = GARBAGE_COLLECTION_SLOTS_PER_STEP + 144;
+    const int NUM_GARBAGE = 100;
+    for (int i = 0; i < NUM_LIVE; ++i)
+        test_pool.AddRef(test_pool.AddObject(&object_data[i], &manager, false));
+    for (int i = NUM_LIVE; i < NUM_LIVE + NUM_GARBAGE; ++i)
+        test_pool.AddObject(&object_data[i], &manager, false);
+    manager.Disposed = 0;
+    const uint32_t sweeps = test_pool.GetGCStats().FullSweeps;
+    // creating more objects lets the collector make another step
+    int next_data = NUM_LIVE + NUM_GARBAGE;
+    for (int step = 0; step < 4; ++step)
+    {
+        for (int i = 0; i <= GARBAGE_COLLECTION_INTERVAL; ++i)
+            test_pool.AddRef(test_pool.AddObject(&object_data[next_data++], &manager, false));
+        test_pool.RunGarbageCollectionIfAppropriate();
+    }
+    assert(manager.Disposed == NUM_GARBAGE);
+    for (int i = 0; i < NUM_LIVE; ++i)
+        assert(test_pool.AddressToHandle(&object_data[i]) != 0);
+    for (int i = NUM_LIVE; i < NUM_LIVE + NUM_GARBAGE; ++i)
+        assert(test_pool.AddressToHandle(&object_data[i]) == 0);
+    assert(test_pool.GetGCStats().FullSweeps > sweeps);
+
+    // Cycle collection spread over several steps keeps the objects which
+    // references were changed by script in the middle of the pass
+    test_pool.reset();
+    int32_t *elems_p, *elems_q, *elems_x, *elems_y;
+    const int32_t arr_p = Test_CreateManagedArray(test_pool, 1, elems_p);
+    const int32_t arr_q = Test_CreateManagedArray(test_pool, 1, elems_q);
+    const int32_t arr_x = Test_CreateManagedArray(test_pool, 1, elems_x);
+    const int32_t arr_y = Test_CreateManagedArray(test_pool, 1, elems_y);
+    Test_SetArrayElement(test_pool, elems_p, 0, arr_q);
+    Test_SetArrayElement(test_pool, elems_q, 0, arr_p);
+    Test_SetArrayElement(test_pool, elems_x, 0, arr_y);
+    test_pool.AddRef(arr_x); // referenced by script variables
+    test_pool.AddRef(arr_y);
+    const uint32_t cycles_freed = test_pool.GetGCStats().CycleObjectsFreed;
+    // sweep all the slots and begin the pass
+    test_pool.RunGarbageCollectionStep(GARBAGE_COLLECTION_SLOTS_PER_STEP);
+    // count the references held by the four single element arrays
+    test_pool.RunGarbageCollectionStep(8);
+    // script removes the reference from the array, but keeps its own one
+    elems_x[0] = 0;
+    test_pool.SubRef(arr_y);
+    for (int step = 0; step < 100; ++step)
+        test_pool.RunGarbageCollectionStep(1);
+    assert(test_pool.GetGCStats().CycleObjectsFreed == cycles_freed + 2);
+    assert(test_pool.HandleToAddress(arr_p) == NULL);
+    assert(test_pool.HandleToAddress(arr_q) == NULL);
+    assert(test_pool.HandleToAddress(arr_x) != NULL);
+    assert(test_pool.HandleToAddress(arr_y) != NULL);
+
+    test_pool.reset();
+}
+
+#endif // _DEBUG
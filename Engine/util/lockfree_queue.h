@@ -0,0 +1,99 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Fixed-size queue for passing items from one thread to another without
+// locking. Only one thread may push the items, and only one other thread
+// may take them out.
+//
+//=============================================================================
+#ifndef __AGS_EE_UTIL__LOCKFREE_QUEUE_H
+#define __AGS_EE_UTIL__LOCKFREE_QUEUE_H
+
+#include <stddef.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#pragma intrinsic(_ReadWriteBarrier)
+// x86 keeps the order of stores and of loads, only the compiler has to
+#define AGS_MEMORY_BARRIER() _ReadWriteBarrier()
+#else
+#define AGS_MEMORY_BARRIER() __sync_synchronize()
+#endif
+
+namespace AGS
+{
+namespace Engine
+{
+
+template <typename T, size_t Capacity>
+class LockFreeQueue
+{
+public:
+    LockFreeQueue()
+        : _head(0)
+        , _tail(0)
+    {
+    }
+
+    // Producer: adds the item to the end, returns false if the queue is full
+    bool Push(const T &item)
+    {
+        const size_t tail = _tail;
+        const size_t next = (tail + 1) % Capacity;
+        if (next == _head)
+            return false;
+        _items[tail] = item;
+        // the item must be complete before the consumer can see it
+        AGS_MEMORY_BARRIER();
+        _tail = next;
+        return true;
+    }
+
+    // Consumer: gets the first item without removing it, returns false if
+    // the queue is empty
+    bool Peek(T &item) const
+    {
+        const size_t head = _head;
+        if (head == _tail)
+            return false;
+        AGS_MEMORY_BARRIER();
+        item = _items[head];
+        return true;
+    }
+
+    // Consumer: removes the first item, after it has been dealt with
+    void Pop()
+    {
+        AGS_MEMORY_BARRIER();
+        _head = (_head + 1) % Capacity;
+    }
+
+    // Tells if all the pushed items were popped
+    inline bool IsEmpty() const
+    {
+        return _head == _tail;
+    }
+
+private:
+    T _items[Capacity];
+    // next item to pop, changed only by the consumer
+    volatile size_t _head;
+    // next free slot, changed only by the producer
+    volatile size_t _tail;
+};
+
+} // namespace Engine
+} // namespace AGS
+
+#endif // __AGS_EE_UTIL__LOCKFREE_QUEUE_H
@@ -0,0 +1,65 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// High resolution timer, for measuring durations of engine tasks
+//
+//=============================================================================
+#ifndef __AGS_EE_UTIL__PERF_TIMER_H
+#define __AGS_EE_UTIL__PERF_TIMER_H
+
+#include "core/types.h"
+
+#if defined(WINDOWS_VERSION)
+#include <windows.h>
+#elif defined(LINUX_VERSION) \
+   || defined(MAC_VERSION) \
+   || defined(IOS_VERSION) \
+   || defined(ANDROID_VERSION)
+#include <sys/time.h>
+#else
+#include <time.h>
+#endif
+
+namespace AGS
+{
+namespace Engine
+{
+
+// Returns current time in microseconds, counted from unspecified moment
+inline int64_t GetPerfTimeUs()
+{
+#if defined(WINDOWS_VERSION)
+  static LARGE_INTEGER frequency = { 0 };
+  if (frequency.QuadPart == 0)
+    QueryPerformanceFrequency(&frequency);
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  return (int64_t)(counter.QuadPart * 1000000.0 / frequency.QuadPart);
+#elif defined(LINUX_VERSION) \
+   || defined(MAC_VERSION) \
+   || defined(IOS_VERSION) \
+   || defined(ANDROID_VERSION)
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+#else
+  return (int64_t)clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+
+} // namespace Engine
+} // namespace AGS
+
+#endif // __AGS_EE_UTIL__PERF_TIMER_H
@@ -37,6 +37,8 @@ public:
   virtual bool Create(AGSThreadEntry entryPoint, bool looping) = 0;
   virtual bool Start() = 0;
   virtual bool Stop() = 0;
+  // Tells if the caller is running on this thread
+  virtual bool IsCurrent() = 0;
 
   inline bool CreateAndStart(AGSThreadEntry entryPoint, bool looping)
   {
@@ -83,6 +83,11 @@ public:
     }
   }
 
+  inline bool IsCurrent()
+  {
+    return _running && (sceKernelGetThreadId() == _thread);
+  }
+
 private:
   SceUID _thread;
   bool   _running;
@@ -79,6 +79,11 @@ public:
     }
   }
 
+  inline bool IsCurrent()
+  {
+    return _running && pthread_equal(pthread_self(), _thread);
+  }
+
 private:
   pthread_t _thread;
   bool      _running;
@@ -79,6 +79,11 @@ public:
     }
   }
 
+  inline bool IsCurrent()
+  {
+    return _running && (LWP_GetSelf() == _thread);
+  }
+
 private:
   lwp_t     _thread;
   bool      _running;
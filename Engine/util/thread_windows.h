@@ -33,6 +33,7 @@ public:
   WindowsThread()
   {
     _thread = NULL;
+    _threadId = 0;
     _running = false;
   }
 
@@ -45,7 +46,7 @@ public:
   {
     _looping = looping;
     _entry = entryPoint;
-    _thread = CreateThread(NULL, 0, _thread_start, this, CREATE_SUSPENDED, NULL);
+    _thread = CreateThread(NULL, 0, _thread_start, this, CREATE_SUSPENDED, &_threadId);
 
     return (_thread != NULL);
   }
@@ -87,8 +88,14 @@ public:
     }
   }
 
+  inline bool IsCurrent()
+  {
+    return _running && (GetCurrentThreadId() == _threadId);
+  }
+
 private:
   HANDLE _thread;
+  DWORD  _threadId;
   bool   _running;
   bool   _looping;
 
@@ -0,0 +1,101 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Pool of threads running a batch of independent jobs. The calling thread
+// takes part in the work, and waits until all the jobs are done. On the
+// platforms without the pool implementation the jobs are run one by one.
+//
+//=============================================================================
+#ifndef __AGS_EE_UTIL__WORKERPOOL_H
+#define __AGS_EE_UTIL__WORKERPOOL_H
+
+namespace AGS
+{
+namespace Engine
+{
+
+
+class BaseWorkerPool
+{
+public:
+  // Job is given the batch data and its own index in the batch
+  typedef void(* AGSWorkerJob)(void *data, int index);
+
+  BaseWorkerPool()
+  {
+  };
+
+  virtual ~BaseWorkerPool()
+  {
+  };
+
+  // Starts the given number of threads, in addition to the calling one
+  virtual bool Start(int numThreads) = 0;
+  virtual void Stop() = 0;
+  // Returns the number of started threads
+  virtual int  GetThreadCount() const = 0;
+  // Runs job with indexes from 0 to count - 1, returns when all are done
+  virtual void Run(AGSWorkerJob job, void *data, int count) = 0;
+};
+
+
+class SerialWorkerPool : public BaseWorkerPool
+{
+public:
+  inline bool Start(int numThreads)
+  {
+    return false;
+  }
+
+  inline void Stop()
+  {
+  }
+
+  inline int GetThreadCount() const
+  {
+    return 0;
+  }
+
+  inline void Run(AGSWorkerJob job, void *data, int count)
+  {
+    for (int i = 0; i < count; ++i)
+    {
+      job(data, i);
+    }
+  }
+
+  static inline int GetProcessorCount()
+  {
+    return 1;
+  }
+};
+
+
+} // namespace Engine
+} // namespace AGS
+
+
+#if defined(LINUX_VERSION) \
+   || defined(MAC_VERSION) \
+   || defined(IOS_VERSION) \
+   || defined(ANDROID_VERSION)
+#include "workerpool_pthread.h"
+
+#else
+namespace AGS { namespace Engine { typedef SerialWorkerPool WorkerPool; } }
+
+#endif
+
+
+#endif // __AGS_EE_UTIL__WORKERPOOL_H
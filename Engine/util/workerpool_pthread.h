@@ -0,0 +1,187 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+
+#ifndef __AGS_EE_PLATFORM__WORKERPOOL_PTHREAD_H
+#define __AGS_EE_PLATFORM__WORKERPOOL_PTHREAD_H
+
+#include <pthread.h>
+#include <unistd.h>
+#include <vector>
+
+namespace AGS
+{
+namespace Engine
+{
+
+
+class PThreadWorkerPool : public BaseWorkerPool
+{
+public:
+  PThreadWorkerPool()
+  {
+    pthread_mutex_init(&_mutex, NULL);
+    pthread_cond_init(&_wakeCond, NULL);
+    pthread_cond_init(&_doneCond, NULL);
+    _stopping = false;
+    _batch = 0;
+    _job = NULL;
+    _data = NULL;
+    _count = 0;
+    _next = 0;
+    _pending = 0;
+  }
+
+  ~PThreadWorkerPool()
+  {
+    Stop();
+    pthread_cond_destroy(&_doneCond);
+    pthread_cond_destroy(&_wakeCond);
+    pthread_mutex_destroy(&_mutex);
+  }
+
+  bool Start(int numThreads)
+  {
+    Stop();
+    _stopping = false;
+    for (int i = 0; i < numThreads; ++i)
+    {
+      pthread_t thread;
+      if (pthread_create(&thread, NULL, _thread_start, this) != 0)
+        break;
+      _threads.push_back(thread);
+    }
+    return !_threads.empty();
+  }
+
+  void Stop()
+  {
+    if (_threads.empty())
+      return;
+    pthread_mutex_lock(&_mutex);
+    _stopping = true;
+    pthread_cond_broadcast(&_wakeCond);
+    pthread_mutex_unlock(&_mutex);
+    for (size_t i = 0; i < _threads.size(); ++i)
+      pthread_join(_threads[i], NULL);
+    _threads.clear();
+  }
+
+  inline int GetThreadCount() const
+  {
+    return (int)_threads.size();
+  }
+
+  void Run(AGSWorkerJob job, void *data, int count)
+  {
+    if (_threads.empty() || count < 2)
+    {
+      for (int i = 0; i < count; ++i)
+        job(data, i);
+      return;
+    }
+
+    pthread_mutex_lock(&_mutex);
+    _job = job;
+    _data = data;
+    _count = count;
+    _next = 0;
+    _pending = count;
+    _batch++;
+    pthread_cond_broadcast(&_wakeCond);
+    pthread_mutex_unlock(&_mutex);
+
+    RunJobs();
+
+    pthread_mutex_lock(&_mutex);
+    while (_pending > 0)
+      pthread_cond_wait(&_doneCond, &_mutex);
+    pthread_mutex_unlock(&_mutex);
+  }
+
+  static inline int GetProcessorCount()
+  {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+  }
+
+private:
+  std::vector<pthread_t> _threads;
+  pthread_mutex_t _mutex;
+  pthread_cond_t  _wakeCond;
+  pthread_cond_t  _doneCond;
+  bool            _stopping;
+  // Current batch, protected by the mutex
+  unsigned        _batch;
+  AGSWorkerJob    _job;
+  void           *_data;
+  int             _count;
+  int             _next;
+  int             _pending;
+
+  // Takes the jobs of the current batch until there are none left
+  void RunJobs()
+  {
+    for (;;)
+    {
+      pthread_mutex_lock(&_mutex);
+      if (_next >= _count)
+      {
+        pthread_mutex_unlock(&_mutex);
+        return;
+      }
+      int index = _next++;
+      AGSWorkerJob job = _job;
+      void *data = _data;
+      pthread_mutex_unlock(&_mutex);
+
+      job(data, index);
+
+      pthread_mutex_lock(&_mutex);
+      if (--_pending == 0)
+        pthread_cond_signal(&_doneCond);
+      pthread_mutex_unlock(&_mutex);
+    }
+  }
+
+  static void *_thread_start(void *arg)
+  {
+    PThreadWorkerPool *pool = (PThreadWorkerPool *)arg;
+    pthread_mutex_lock(&pool->_mutex);
+    unsigned batch = pool->_batch;
+    for (;;)
+    {
+      while (!pool->_stopping && pool->_batch == batch)
+        pthread_cond_wait(&pool->_wakeCond, &pool->_mutex);
+      if (pool->_stopping)
+        break;
+      batch = pool->_batch;
+      pthread_mutex_unlock(&pool->_mutex);
+
+      pool->RunJobs();
+
+      pthread_mutex_lock(&pool->_mutex);
+    }
+    pthread_mutex_unlock(&pool->_mutex);
+    return NULL;
+  }
+};
+
+
+typedef PThreadWorkerPool WorkerPool;
+
+
+} // namespace Engine
+} // namespace AGS
+
+#endif // __AGS_EE_PLATFORM__WORKERPOOL_PTHREAD_H